@@ -32,6 +32,8 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkGeneralTransform.h>
+#include <vtkIntArray.h>
+#include <vtkMatrix4x4.h>
 #include <vtkTransform.h>
 
 // STD includes
@@ -92,6 +94,47 @@ vtkSlicerIECTransformLogic::~vtkSlicerIECTransformLogic()
   this->IecTransforms.clear();
 }
 
+//---------------------------------------------------------------------------
+void vtkSlicerIECTransformLogic::SetMRMLSceneInternal(vtkMRMLScene* newScene)
+{
+  // Transform nodes of the previous scene are not used any more
+  for (auto& transformNodePair : this->TransformNodes)
+  {
+    vtkMRMLLinearTransformNode* transformNode = transformNodePair.second;
+    if (transformNode)
+    {
+      vtkUnObserveMRMLNodeMacro(transformNode);
+    }
+  }
+  this->TransformNodes.clear();
+  this->FrameMatricesCache.clear();
+
+  Superclass::SetMRMLSceneInternal(newScene);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIECTransformLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  Superclass::ProcessMRMLNodesEvents(caller, event, callData);
+
+  if (event != vtkMRMLTransformableNode::TransformModifiedEvent)
+  {
+    return;
+  }
+
+  // Invalidate cached matrices of the child frame of the modified transform and the frames below it
+  // (transforms that are not edges of the hierarchy, such as FixedReference to RAS, are not cached)
+  for (auto& transformNodePair : this->TransformNodes)
+  {
+    CoordinateSystemIdentifier parentFrame;
+    if ( transformNodePair.second.GetPointer() == caller
+      && this->GetParentFrame(transformNodePair.first.first, parentFrame) && parentFrame == transformNodePair.first.second )
+    {
+      this->InvalidateFrameMatrices(transformNodePair.first.first);
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerIECTransformLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -132,9 +175,9 @@ void vtkSlicerIECTransformLogic::BuildIECTransformHierarchy()
   // Create transform nodes if they do not exist
   for (auto& transformPair : this->IecTransforms)
   {
-    std::string transformNodeName = this->GetTransformNodeNameBetween(transformPair.first, transformPair.second);
-    if (!this->GetMRMLScene()->GetFirstNodeByName(transformNodeName.c_str()))
+    if (!this->GetTransformNodeBetween(transformPair.first, transformPair.second))
     {
+      std::string transformNodeName = this->GetTransformNodeNameBetween(transformPair.first, transformPair.second);
       vtkSmartPointer<vtkMRMLLinearTransformNode> transformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::New();
       transformNode->SetName(transformNodeName.c_str());
       transformNode->SetHideFromEditors(1);
@@ -205,20 +248,11 @@ void vtkSlicerIECTransformLogic::UpdateBeamTransform(vtkMRMLRTBeamNode* beamNode
   // Dynamic transform from Collimator to RAS
   // Transformation path:
   // Collimator -> Gantry -> FixedReference -> PatientSupport -> TableTopEccentricRotation -> TableTop -> Patient -> RAS
-  vtkSmartPointer<vtkGeneralTransform> beamGeneralTransform = vtkSmartPointer<vtkGeneralTransform>::New();
-  if (this->GetTransformBetween(Collimator, RAS, beamGeneralTransform))
+  vtkNew<vtkMatrix4x4> beamMatrix;
+  if (this->GetTransformMatrixBetween(Collimator, RAS, beamMatrix))
   {
-    // Convert general transform to linear
-    // This call also makes hard copy of the transform so that it doesn't change when other beam transforms change
-    vtkSmartPointer<vtkTransform> beamLinearTransform = vtkSmartPointer<vtkTransform>::New();
-    if (!vtkMRMLTransformNode::IsGeneralTransformLinear(beamGeneralTransform, beamLinearTransform))
-    {
-      vtkErrorMacro("UpdateBeamTransform: Unable to set transform with non-linear components to beam " << beamNode->GetName());
-      return;
-    }
-
-    // Set transform to beam node
-    beamTransformNode->SetAndObserveTransformToParent(beamLinearTransform);
+    // Set transform to beam node (the matrix is copied, so it doesn't change when other beam transforms change)
+    beamTransformNode->SetMatrixTransformToParent(beamMatrix);
 
     // Update the name of the transform node too
     // (the user may have renamed the beam, but it's very expensive to update the transform name on every beam modified event)
@@ -252,20 +286,11 @@ void vtkSlicerIECTransformLogic::UpdateBeamTransform(vtkMRMLRTBeamNode* beamNode
   // Dynamic transform from Collimator to RAS
   // Transformation path:
   // Collimator -> Gantry -> FixedReference -> PatientSupport -> TableTopEccentricRotation -> TableTop -> Patient -> RAS
-  vtkSmartPointer<vtkGeneralTransform> beamGeneralTransform = vtkSmartPointer<vtkGeneralTransform>::New();
-  if (this->GetTransformBetween(Collimator, RAS, beamGeneralTransform))
+  vtkNew<vtkMatrix4x4> beamMatrix;
+  if (this->GetTransformMatrixBetween(Collimator, RAS, beamMatrix))
   {
-    // Convert general transform to linear
-    // This call also makes hard copy of the transform so that it doesn't change when other beam transforms change
-    vtkSmartPointer<vtkTransform> beamLinearTransform = vtkSmartPointer<vtkTransform>::New();
-    if (!vtkMRMLTransformNode::IsGeneralTransformLinear(beamGeneralTransform, beamLinearTransform))
-    {
-      vtkErrorMacro("UpdateBeamTransform: Unable to set transform with non-linear components to beam " << beamNode->GetName());
-      return;
-    }
-
-    // Set transform to beam node
-    beamTransformNode->SetAndObserveTransformToParent(beamLinearTransform);
+    // Set transform to beam node (the matrix is copied, so it doesn't change when other beam transforms change)
+    beamTransformNode->SetMatrixTransformToParent(beamMatrix);
 
     // Update the name of the transform node too
     // (the user may have renamed the beam, but it's very expensive to update the transform name on every beam modified event)
@@ -396,8 +421,29 @@ vtkMRMLLinearTransformNode* vtkSlicerIECTransformLogic::GetTransformNodeBetween(
     return nullptr;
   }
 
-  return vtkMRMLLinearTransformNode::SafeDownCast(
+  std::pair< CoordinateSystemIdentifier, CoordinateSystemIdentifier > framePair(fromFrame, toFrame);
+  auto transformNodeIt = this->TransformNodes.find(framePair);
+  if ( transformNodeIt != this->TransformNodes.end() && transformNodeIt->second
+    && transformNodeIt->second->GetScene() == this->GetMRMLScene() )
+  {
+    return transformNodeIt->second;
+  }
+
+  vtkMRMLLinearTransformNode* transformNode = vtkMRMLLinearTransformNode::SafeDownCast(
     this->GetMRMLScene()->GetFirstNodeByName(this->GetTransformNodeNameBetween(fromFrame, toFrame).c_str() ) );
+  if ( transformNode
+    && std::find(this->IecTransforms.begin(), this->IecTransforms.end(), framePair) != this->IecTransforms.end() )
+  {
+    // Cache and observe IEC transform node so that cached matrices are invalidated when it changes
+    this->TransformNodes[framePair] = transformNode;
+    vtkSmartPointer<vtkIntArray> events = vtkSmartPointer<vtkIntArray>::New();
+    events->InsertNextValue(vtkMRMLTransformableNode::TransformModifiedEvent);
+    vtkObserveMRMLNodeEventsMacro(transformNode, events);
+
+    this->InvalidateFrameMatrices(fromFrame);
+  }
+
+  return transformNode;
 }
 
 //-----------------------------------------------------------------------------
@@ -409,90 +455,156 @@ bool vtkSlicerIECTransformLogic::GetTransformBetween(CoordinateSystemIdentifier
     vtkErrorMacro("GetTransformBetween: Invalid output transform node");
     return false;
   }
-  if (!this->GetMRMLScene())
+
+  vtkNew<vtkMatrix4x4> matrix;
+  if (!this->GetTransformMatrixBetween(fromFrame, toFrame, matrix, transformForBeam))
   {
-    vtkErrorMacro("GetTransformBetween: Invalid MRML scene");
     return false;
   }
 
-  CoordinateSystemsList fromFramePath, toFramePath;
-  if (this->GetPathToRoot(fromFrame, fromFramePath) && this->GetPathFromRoot(toFrame, toFramePath))
+  outputTransform->Identity();
+  outputTransform->PostMultiply();
+  outputTransform->Concatenate(matrix);
+  outputTransform->Modified();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerIECTransformLogic::GetTransformMatrixBetween(CoordinateSystemIdentifier fromFrame, CoordinateSystemIdentifier toFrame, 
+  vtkMatrix4x4* outputMatrix, bool transformForBeam/* = true*/)
+{
+  if (!outputMatrix)
+  {
+    vtkErrorMacro("GetTransformMatrixBetween: Invalid output matrix");
+    return false;
+  }
+  if (!this->GetMRMLScene())
   {
-    std::vector< CoordinateSystemIdentifier > toFrameVector(toFramePath.size());
-    std::vector< CoordinateSystemIdentifier > fromFrameVector(fromFramePath.size());
+    vtkErrorMacro("GetTransformMatrixBetween: Invalid MRML scene");
+    return false;
+  }
 
-    std::copy(toFramePath.begin(), toFramePath.end(), toFrameVector.begin());
-    std::copy(fromFramePath.begin(), fromFramePath.end(), fromFrameVector.begin());
+  if (!this->UpdateFrameMatrices(fromFrame) || !this->UpdateFrameMatrices(toFrame))
+  {
+    vtkErrorMacro("GetTransformMatrixBetween: Failed to get transform " << this->GetTransformNodeNameBetween(fromFrame, toFrame));
+    return false;
+  }
 
-    outputTransform->Identity();
-    outputTransform->PostMultiply();
-    for (size_t i = 0; i < fromFrameVector.size() - 1; ++i)
-    {
-      CoordinateSystemIdentifier parent, child;
-      child = fromFrameVector[i];
-      parent = fromFrameVector[i + 1];
+  // fromFrame -> FixedReference -> toFrame
+  const FrameMatrices& fromFrameMatrices = this->FrameMatricesCache[fromFrame];
+  const FrameMatrices& toFrameMatrices = this->FrameMatricesCache[toFrame];
+  const double* rootToFrameMatrix = (transformForBeam ? toFrameMatrices.BeamFromRoot.data() : toFrameMatrices.FromRoot.data());
+  vtkMatrix4x4::Multiply4x4(rootToFrameMatrix, fromFrameMatrices.ToRoot.data(), outputMatrix->GetData());
+  outputMatrix->Modified();
+  return true;
+}
 
-      if (child == parent)
-      {
-        continue;
-      }
+//-----------------------------------------------------------------------------
+bool vtkSlicerIECTransformLogic::GetTransformMatricesForBeam( vtkMRMLRTBeamNode* beamNode, 
+  TransformMatrixMap& matrices, bool transformForBeam/* = true*/, double* isocenter/* = nullptr*/)
+{
+  matrices.clear();
+  if (!beamNode)
+  {
+    vtkErrorMacro("GetTransformMatricesForBeam: Invalid beam node");
+    return false;
+  }
 
-      vtkMRMLLinearTransformNode* fromTransform = this->GetTransformNodeBetween(child, parent);
-      if (fromTransform)
-      {
-        vtkNew<vtkMatrix4x4> mat;
-        fromTransform->GetMatrixTransformToParent(mat);
-        outputTransform->Concatenate(mat);
+  // Update transforms in IEC logic from beam node parameters
+  this->UpdateIECTransformsFromBeam( beamNode, isocenter);
 
-        vtkDebugMacro("GetTransformBetween: Transform node \"" << fromTransform->GetName() << "\" is valid");
-      }
-      else
+  for (auto& fromFramePair : this->CoordinateSystemsMap)
+  {
+    for (auto& toFramePair : this->CoordinateSystemsMap)
+    {
+      vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      if (!this->GetTransformMatrixBetween(fromFramePair.first, toFramePair.first, matrix, transformForBeam))
       {
-        vtkErrorMacro("GetTransformBetween: Transform node is invalid");
+        matrices.clear();
         return false;
       }
+      matrices[std::make_pair(fromFramePair.first, toFramePair.first)] = matrix;
     }
+  }
 
-    for (size_t i = 0; i < toFrameVector.size() - 1; ++i)
-    {
-      CoordinateSystemIdentifier parent, child;
-      parent = toFrameVector[i];
-      child = toFrameVector[i + 1];
+  return true;
+}
 
-      if (child == parent)
-      {
-        continue;
-      }
+//-----------------------------------------------------------------------------
+bool vtkSlicerIECTransformLogic::UpdateFrameMatrices(CoordinateSystemIdentifier frame)
+{
+  FrameMatrices& frameMatrices = this->FrameMatricesCache[frame];
+  if (frameMatrices.Valid)
+  {
+    return true;
+  }
 
-      vtkMRMLLinearTransformNode* toTransform = this->GetTransformNodeBetween(child, parent);
-      if (toTransform)
-      {
-        vtkNew<vtkMatrix4x4> mat;
-        if (transformForBeam) // calculation for beam transformation
-        {
-          toTransform->GetMatrixTransformFromParent(mat);
-        }
-        else // calculation for a treatment room models transformations
-        {
-          toTransform->GetMatrixTransformToParent(mat);
-        }
-        mat->Invert();
-        outputTransform->Concatenate(mat);
+  if (frame == FixedReference)
+  {
+    vtkMatrix4x4::Identity(frameMatrices.ToRoot.data());
+    vtkMatrix4x4::Identity(frameMatrices.FromRoot.data());
+    vtkMatrix4x4::Identity(frameMatrices.BeamFromRoot.data());
+    frameMatrices.Valid = true;
+    return true;
+  }
 
-        vtkDebugMacro("GetTransformBetween: Transform node \"" << toTransform->GetName() << "\" is valid");
-      }
-      else
-      {
-        vtkErrorMacro("GetTransformBetween: Transform node is invalid");
-        return false;
-      }
-    }
+  CoordinateSystemIdentifier parentFrame;
+  if (!this->GetParentFrame(frame, parentFrame))
+  {
+    vtkErrorMacro("UpdateFrameMatrices: Coordinate system " << this->CoordinateSystemsMap[frame] << " is not part of the IEC hierarchy");
+    return false;
+  }
 
-    outputTransform->Modified();
-    return true;
+  vtkMRMLLinearTransformNode* transformNode = this->GetTransformNodeBetween(frame, parentFrame);
+  if (!transformNode)
+  {
+    vtkErrorMacro("UpdateFrameMatrices: Transform node is invalid");
+    return false;
+  }
+  if (!this->UpdateFrameMatrices(parentFrame))
+  {
+    return false;
+  }
+
+  vtkNew<vtkMatrix4x4> toParentMatrix;
+  transformNode->GetMatrixTransformToParent(toParentMatrix);
+
+  const FrameMatrices& parentFrameMatrices = this->FrameMatricesCache[parentFrame];
+  vtkMatrix4x4::Multiply4x4(parentFrameMatrices.ToRoot.data(), toParentMatrix->GetData(), frameMatrices.ToRoot.data());
+  vtkMatrix4x4::Invert(frameMatrices.ToRoot.data(), frameMatrices.FromRoot.data());
+  vtkMatrix4x4::Multiply4x4(toParentMatrix->GetData(), parentFrameMatrices.BeamFromRoot.data(), frameMatrices.BeamFromRoot.data());
+  frameMatrices.Valid = true;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerIECTransformLogic::InvalidateFrameMatrices(CoordinateSystemIdentifier frame)
+{
+  this->FrameMatricesCache[frame].Valid = false;
+
+  auto childrenIt = this->CoordinateSystemsHierarchy.find(frame);
+  if (childrenIt == this->CoordinateSystemsHierarchy.end())
+  {
+    return;
+  }
+  for (CoordinateSystemIdentifier childFrame : childrenIt->second)
+  {
+    this->InvalidateFrameMatrices(childFrame);
   }
+}
 
-  vtkErrorMacro("GetTransformBetween: Failed to get transform " << this->GetTransformNodeNameBetween(fromFrame, toFrame));
+//-----------------------------------------------------------------------------
+bool vtkSlicerIECTransformLogic::GetParentFrame(CoordinateSystemIdentifier frame, CoordinateSystemIdentifier& parentFrame)
+{
+  for (auto& pair : this->CoordinateSystemsHierarchy)
+  {
+    const std::list< CoordinateSystemIdentifier >& children = pair.second;
+    if (std::find(children.begin(), children.end(), frame) != children.end())
+    {
+      parentFrame = pair.first;
+      return true;
+    }
+  }
   return false;
 }
 
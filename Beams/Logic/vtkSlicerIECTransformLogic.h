@@ -27,12 +27,18 @@
 // Slicer includes
 #include "vtkMRMLAbstractLogic.h"
 
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
 // STD includes
+#include <array>
 #include <map>
 #include <vector>
 #include <list>
 
 class vtkGeneralTransform;
+class vtkMatrix4x4;
 class vtkMRMLRTBeamNode;
 class vtkMRMLLinearTransformNode;
 
@@ -114,6 +120,8 @@ public:
     LastIECCoordinateFrame // Last index used for adding more coordinate systems externally
   };
   typedef std::list< CoordinateSystemIdentifier > CoordinateSystemsList;
+  /// Transform matrices between coordinate frames, key is the (fromFrame, toFrame) pair
+  typedef std::map< std::pair< CoordinateSystemIdentifier, CoordinateSystemIdentifier >, vtkSmartPointer<vtkMatrix4x4> > TransformMatrixMap;
 
 public:
   static vtkSlicerIECTransformLogic *New();
@@ -138,6 +146,23 @@ public:
   /// \return Success flag (false on any error)
   bool GetTransformBetween(CoordinateSystemIdentifier fromFrame, CoordinateSystemIdentifier toFrame, 
     vtkGeneralTransform* outputTransform, bool transformForBeam = true);
+
+  /// Get transform matrix from one coordinate frame to another. See \sa GetTransformBetween for the parameters.
+  /// The matrix of each coordinate frame relative to the root (FixedReference) frame is cached, and only
+  /// recomputed when a transform above it in the hierarchy changes, so repeated queries between unchanged
+  /// frames cost a single matrix multiplication.
+  /// \return Success flag (false on any error)
+  bool GetTransformMatrixBetween(CoordinateSystemIdentifier fromFrame, CoordinateSystemIdentifier toFrame, 
+    vtkMatrix4x4* outputMatrix, bool transformForBeam = true);
+
+  /// Update IEC transforms according to beam node, and get the transform matrices between all pairs
+  /// of IEC coordinate frames in one call
+  /// @param matrices - output matrices for each (fromFrame, toFrame) pair
+  /// @param transformForBeam - see \sa GetTransformBetween
+  /// @param isocenter - see \sa UpdateIECTransformsFromBeam
+  /// \return Success flag (false on any error)
+  bool GetTransformMatricesForBeam( vtkMRMLRTBeamNode* beamNode, TransformMatrixMap& matrices, 
+    bool transformForBeam = true, double* isocenter = nullptr);
   
   /// Update parent transform node of a given beam from the IEC transform hierarchy and the beam parameters
   void UpdateBeamTransform(vtkMRMLRTBeamNode* beamNode);
@@ -162,6 +187,22 @@ protected:
   /// Root system = FixedReference system, see IEC 61217:2011 hierarchy
   bool GetPathFromRoot( CoordinateSystemIdentifier frame, CoordinateSystemsList& path);
 
+  /// Get parent coordinate system of a frame in the IEC hierarchy
+  /// \return False if the frame is the root or not part of the hierarchy
+  bool GetParentFrame( CoordinateSystemIdentifier frame, CoordinateSystemIdentifier& parentFrame);
+
+  /// Recompute the cached matrices of a frame (and its ancestors) if they are invalid
+  bool UpdateFrameMatrices(CoordinateSystemIdentifier frame);
+
+  /// Invalidate the cached matrices of a frame and all frames below it in the hierarchy
+  void InvalidateFrameMatrices(CoordinateSystemIdentifier frame);
+
+  /// Invalidate cached matrices when an observed IEC transform node changes
+  void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData) override;
+
+  /// Reset cached transform nodes and matrices when the scene changes
+  void SetMRMLSceneInternal(vtkMRMLScene* newScene) override;
+
 protected:
   /// Map from \sa CoordinateSystemIdentifier to coordinate system name. Used for getting transforms
   std::map<CoordinateSystemIdentifier, std::string> CoordinateSystemsMap;
@@ -173,6 +214,24 @@ protected:
   /// Map of IEC coordinate systems hierarchy
   std::map< CoordinateSystemIdentifier, std::list< CoordinateSystemIdentifier > > CoordinateSystemsHierarchy;
 
+  /// Cached matrices of a coordinate frame relative to the root (FixedReference) frame
+  struct FrameMatrices
+  {
+    /// Frame to root transform (to parent matrices from the frame up to the root)
+    std::array< double, 16 > ToRoot;
+    /// Root to frame transform (inverse of ToRoot)
+    std::array< double, 16 > FromRoot;
+    /// Root to frame transform for beams (to parent matrices applied from the root down to the frame)
+    std::array< double, 16 > BeamFromRoot;
+    /// Flag indicating whether the matrices are up-to-date
+    bool Valid{ false };
+  };
+  /// Cached matrices for each coordinate frame of the hierarchy
+  std::map< CoordinateSystemIdentifier, FrameMatrices > FrameMatricesCache;
+
+  /// IEC transform nodes, cached so that they are not looked up by name in the scene on every query
+  std::map< std::pair< CoordinateSystemIdentifier, CoordinateSystemIdentifier >, vtkWeakPointer<vtkMRMLLinearTransformNode> > TransformNodes;
+
 protected:
   vtkSlicerIECTransformLogic();
   ~vtkSlicerIECTransformLogic() override;
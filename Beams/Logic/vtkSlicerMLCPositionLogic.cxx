@@ -79,6 +79,8 @@
 #include <vtkTransform.h>
 #include <vtkMatrix4x4.h>
 #include <vtkMath.h> // cross, dot vector operations
+#include <vtkCellArray.h>
+#include <vtkSMPTools.h>
 
 // SlicerRtCommon includes
 #include <vtkSlicerRtCommon.h>
@@ -86,6 +88,10 @@
 
 // STD includes
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
 
 namespace
 {
@@ -93,6 +99,214 @@ namespace
 const char* MLCX_BOUNDARYANDPOSITION = "MLCX_BoundaryAndPosition";
 const char* MLCY_BOUNDARYANDPOSITION = "MLCY_BoundaryAndPosition";
 
+typedef std::array< double, 3 > PolygonPoint;
+
+/// Clip polygon with the half space where point[axis] >= value (keepGreater) or point[axis] <= value
+void ClipPolygonWithAxisPlane( const std::vector<PolygonPoint>& polygon, int axis, double value, 
+  bool keepGreater, std::vector<PolygonPoint>& clippedPolygon)
+{
+  clippedPolygon.clear();
+  size_t nofPoints = polygon.size();
+  for ( size_t i = 0; i < nofPoints; ++i)
+  {
+    const PolygonPoint& current = polygon[i];
+    const PolygonPoint& next = polygon[(i + 1) % nofPoints];
+    double currentDistance = keepGreater ? (current[axis] - value) : (value - current[axis]);
+    double nextDistance = keepGreater ? (next[axis] - value) : (value - next[axis]);
+    if (currentDistance >= 0.)
+    {
+      clippedPolygon.push_back(current);
+    }
+    if ((currentDistance >= 0.) != (nextDistance >= 0.))
+    {
+      // edge crosses the plane
+      double t = currentDistance / (currentDistance - nextDistance);
+      PolygonPoint intersection;
+      for ( int j = 0; j < 3; ++j)
+      {
+        intersection[j] = current[j] + t * (next[j] - current[j]);
+      }
+      intersection[axis] = value;
+      clippedPolygon.push_back(intersection);
+    }
+  }
+}
+
+/// Distance by which a rounded leaf end is retracted (in isocenter plane) so that
+/// the ray from the source tangent to the leaf end arc passes through the given position
+double GetRoundedLeafEndOffset( double position, double leafEndRadius, double sad, double sourceToMLCDistance)
+{
+  if (leafEndRadius <= 0. || sad <= 0. || sourceToMLCDistance <= 0.)
+  {
+    return 0.;
+  }
+  // 1 / cos(theta) - 1, where theta is the angle of the ray from the central axis
+  double tanTheta = position / sad;
+  double offsetMLC = leafEndRadius * (std::sqrt(1. + tanTheta * tanTheta) - 1.);
+  return offsetMLC * sad / sourceToMLCDistance;
+}
+
+/// Target polygons extracted from poly data, for thread safe access
+struct TargetPolygons
+{
+  std::vector<PolygonPoint> Points;
+  /// Start index of each polygon in Points, with an extra element at the end
+  std::vector<size_t> Offsets;
+};
+
+/// Extract polygons of the target poly data, transformed with the given matrix
+void GetTargetPolygons( vtkPolyData* targetPoly, const double transformMatrix[16], TargetPolygons& polygons)
+{
+  polygons.Points.clear();
+  polygons.Offsets.assign( 1, 0);
+  vtkCellArray* polys = targetPoly->GetPolys();
+  if (!polys)
+  {
+    return;
+  }
+  polygons.Points.reserve(polys->GetNumberOfConnectivityIds());
+  polygons.Offsets.reserve(polys->GetNumberOfCells() + 1);
+
+  vtkIdType nofPoints = 0;
+  const vtkIdType* pointIds = nullptr;
+  double point[4] = { 0., 0., 0., 1. };
+  double transformedPoint[4] = { 0., 0., 0., 1. };
+  for ( polys->InitTraversal(); polys->GetNextCell( nofPoints, pointIds); )
+  {
+    if (nofPoints < 3)
+    {
+      continue;
+    }
+    for ( vtkIdType i = 0; i < nofPoints; ++i)
+    {
+      targetPoly->GetPoint( pointIds[i], point);
+      vtkMatrix4x4::MultiplyPoint( transformMatrix, point, transformedPoint);
+      polygons.Points.push_back({ transformedPoint[0], transformedPoint[1], transformedPoint[2] });
+    }
+    polygons.Offsets.push_back(polygons.Points.size());
+  }
+}
+
+/// Parameters of beam's eye view leaf fitting
+struct LeafFittingParameters
+{
+  /// Leaf pair boundaries on the isocenter plane
+  const std::vector<double>* Boundaries{ nullptr };
+  bool TypeMLCX{ true };
+  double SAD{ 0. };
+  double SourceToMLCDistance{ 0. };
+  double Margin{ 0. };
+  double LeafEndRadius{ 0. };
+  bool ParallelBeam{ true };
+};
+
+/// Fit leaf pairs to the beam's eye view projection of the target.
+/// The target polygons are projected onto the isocenter plane, and clipped with the strip of
+/// each leaf pair they overlap (scanline per leaf pair). Leaf pairs not covering the target
+/// are closed in the middle of the target projection.
+/// @param targetToBeam - transform from the frame of the target polygons to the beam frame
+/// @return false if the target projection doesn't overlap with the MLC
+bool FitLeafPairs( const TargetPolygons& targetPolygons, const double targetToBeam[16], 
+  const LeafFittingParameters& parameters, std::vector<double>& side1, std::vector<double>& side2)
+{
+  const std::vector<double>& boundaries = *parameters.Boundaries;
+  int nofLeafPairs = int(boundaries.size()) - 1;
+  int leafAxis = parameters.TypeMLCX ? 0 : 1; // axis of leaf movement
+  int boundaryAxis = parameters.TypeMLCX ? 1 : 0; // axis across the leaves
+  double margin = parameters.Margin;
+  double sad = parameters.SAD;
+  double isocenterToMLCDistance = sad - parameters.SourceToMLCDistance;
+
+  // Opening of each leaf pair: minimum and maximum position of the projected target within the leaf pair strip
+  std::vector<double> openingMin( nofLeafPairs, VTK_DOUBLE_MAX);
+  std::vector<double> openingMax( nofLeafPairs, VTK_DOUBLE_MIN);
+
+  std::vector<PolygonPoint> polygon, clippedPolygon, stripPolygon;
+  for ( size_t polygonIndex = 0; polygonIndex + 1 < targetPolygons.Offsets.size(); ++polygonIndex)
+  {
+    size_t begin = targetPolygons.Offsets[polygonIndex];
+    size_t end = targetPolygons.Offsets[polygonIndex + 1];
+    polygon.resize(end - begin);
+    for ( size_t i = begin; i < end; ++i)
+    {
+      const PolygonPoint& point = targetPolygons.Points[i];
+      for ( int j = 0; j < 3; ++j)
+      {
+        polygon[i - begin][j] = targetToBeam[4 * j] * point[0] + targetToBeam[4 * j + 1] * point[1]
+          + targetToBeam[4 * j + 2] * point[2] + targetToBeam[4 * j + 3];
+      }
+    }
+
+    // Only the part of the target between the MLC planes is seen by the leaves
+    if (isocenterToMLCDistance > 0.)
+    {
+      ClipPolygonWithAxisPlane( polygon, 2, -1. * isocenterToMLCDistance, true, clippedPolygon);
+      ClipPolygonWithAxisPlane( clippedPolygon, 2, isocenterToMLCDistance, false, polygon);
+      if (polygon.size() < 3)
+      {
+        continue;
+      }
+    }
+
+    // Project onto the isocenter plane
+    double boundaryMin = VTK_DOUBLE_MAX;
+    double boundaryMax = VTK_DOUBLE_MIN;
+    for ( PolygonPoint& point : polygon)
+    {
+      if (!parameters.ParallelBeam && sad > point[2])
+      {
+        double scale = sad / (sad - point[2]);
+        point[0] *= scale;
+        point[1] *= scale;
+      }
+      point[2] = 0.;
+      boundaryMin = std::min( boundaryMin, point[boundaryAxis]);
+      boundaryMax = std::max( boundaryMax, point[boundaryAxis]);
+    }
+
+    // Leaf pairs whose strip (extended by the margin) overlaps the projected polygon
+    int firstLeafPair = int(std::upper_bound( boundaries.begin(), boundaries.end(), boundaryMin - margin) - boundaries.begin()) - 1;
+    int lastLeafPair = int(std::lower_bound( boundaries.begin(), boundaries.end(), boundaryMax + margin) - boundaries.begin()) - 1;
+    firstLeafPair = std::max( firstLeafPair, 0);
+    lastLeafPair = std::min( lastLeafPair, nofLeafPairs - 1);
+
+    // Scanline pass: clip the polygon with each leaf pair strip
+    for ( int leafPair = firstLeafPair; leafPair <= lastLeafPair; ++leafPair)
+    {
+      ClipPolygonWithAxisPlane( polygon, boundaryAxis, boundaries[leafPair] - margin, true, clippedPolygon);
+      ClipPolygonWithAxisPlane( clippedPolygon, boundaryAxis, boundaries[leafPair + 1] + margin, false, stripPolygon);
+      for ( const PolygonPoint& point : stripPolygon)
+      {
+        openingMin[leafPair] = std::min( openingMin[leafPair], point[leafAxis]);
+        openingMax[leafPair] = std::max( openingMax[leafPair], point[leafAxis]);
+      }
+    }
+  }
+
+  // Closed leaf pairs are placed in the middle of the target projection
+  double targetMin = *std::min_element( openingMin.begin(), openingMin.end());
+  double targetMax = *std::max_element( openingMax.begin(), openingMax.end());
+  if (targetMin > targetMax)
+  {
+    return false;
+  }
+  double closedPosition = (targetMin + targetMax) / 2.;
+
+  side1.assign( nofLeafPairs, closedPosition);
+  side2.assign( nofLeafPairs, closedPosition);
+  for ( int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+  {
+    if (openingMin[leafPair] <= openingMax[leafPair])
+    {
+      double position1 = openingMin[leafPair] - margin;
+      double position2 = openingMax[leafPair] + margin;
+      side1[leafPair] = position1 - GetRoundedLeafEndOffset( position1, parameters.LeafEndRadius, sad, parameters.SourceToMLCDistance);
+      side2[leafPair] = position2 + GetRoundedLeafEndOffset( position2, parameters.LeafEndRadius, sad, parameters.SourceToMLCDistance);
+    }
+  }
+  return true;
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -1004,6 +1218,269 @@ bool vtkSlicerMLCPositionLogic::CalculateMultiLeafCollimatorPosition( vtkMRMLRTB
   return true;
 }
 
+//---------------------------------------------------------------------------
+bool vtkSlicerMLCPositionLogic::CalculateMultiLeafCollimatorPositionBeamsEyeView( vtkMRMLRTBeamNode* beamNode, 
+  vtkMRMLTableNode* mlcTableNode, vtkPolyData* targetPoly, double margin, double leafEndRadius, bool parallelBeam)
+{
+  if (!beamNode)
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionBeamsEyeView: invalid beam node");
+    return false;
+  }
+  if (!targetPoly)
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionBeamsEyeView: invalid target polydata");
+    return false;
+  }
+
+  int nofLeafPairs = 0;
+  if (mlcTableNode)
+  {
+    nofLeafPairs = mlcTableNode->GetNumberOfRows() - 1;
+  }
+  if (nofLeafPairs <= 0 || mlcTableNode->GetNumberOfColumns() != 3)
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionBeamsEyeView: invalid number of MLC leaf pairs or table columns");
+    return false;
+  }
+  vtkTable* table = mlcTableNode->GetTable();
+
+  vtkMRMLTransformNode* beamTransformNode = beamNode->GetParentTransformNode();
+  vtkNew<vtkMatrix4x4> beamInverseMatrix;
+  if (beamTransformNode)
+  {
+    beamTransformNode->GetMatrixTransformToWorld(beamInverseMatrix);
+    beamInverseMatrix->Invert();
+  }
+
+  const char* mlcName = mlcTableNode->GetName();
+  bool typeMLCX = strncmp( "MLCY", mlcName, strlen("MLCY")) != 0; // MLCX by default
+
+  std::vector<double> boundaries(nofLeafPairs + 1);
+  for ( int row = 0; row <= nofLeafPairs; ++row)
+  {
+    boundaries[row] = table->GetValue( row, 0).ToDouble();
+  }
+
+  // target polygons in beam frame
+  TargetPolygons targetPolygons;
+  GetTargetPolygons( targetPoly, beamInverseMatrix->GetData(), targetPolygons);
+
+  LeafFittingParameters parameters;
+  parameters.Boundaries = &boundaries;
+  parameters.TypeMLCX = typeMLCX;
+  parameters.SAD = beamNode->GetSAD();
+  parameters.SourceToMLCDistance = beamNode->GetSourceToMultiLeafCollimatorDistance();
+  parameters.Margin = margin;
+  parameters.LeafEndRadius = leafEndRadius;
+  parameters.ParallelBeam = parallelBeam;
+
+  double identity[16] = {};
+  vtkMatrix4x4::Identity(identity);
+  std::vector<double> side1, side2;
+  if (!FitLeafPairs( targetPolygons, identity, parameters, side1, side2))
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionBeamsEyeView: Target projection doesn't overlap with the MLC");
+    return false;
+  }
+
+  for ( int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+  {
+    table->SetValue( leafPair, 1, side1[leafPair]);
+    table->SetValue( leafPair, 2, side2[leafPair]);
+  }
+  table->Modified();
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerMLCPositionLogic::CalculateMultiLeafCollimatorPositionsForControlPoints( vtkMRMLRTBeamNode* beamNode, 
+  vtkPolyData* targetPoly, const std::vector<double>& gantryAngles, const std::vector<double>& collimatorAngles, 
+  vtkMRMLTableNode* leafPositionsTableNode, double margin, double leafEndRadius, bool parallelBeam, 
+  std::vector<int>* failedControlPoints)
+{
+  if (failedControlPoints)
+  {
+    failedControlPoints->clear();
+  }
+  if (!beamNode || !targetPoly || !leafPositionsTableNode)
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionsForControlPoints: invalid beam node, target polydata or output table node");
+    return false;
+  }
+  if (gantryAngles.empty() || gantryAngles.size() != collimatorAngles.size())
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionsForControlPoints: number of gantry and collimator angles must be the same and non-zero");
+    return false;
+  }
+
+  vtkMRMLTableNode* mlcTableNode = beamNode->GetMultiLeafCollimatorTableNode();
+  int nofLeafPairs = 0;
+  if (mlcTableNode)
+  {
+    nofLeafPairs = mlcTableNode->GetNumberOfRows() - 1;
+  }
+  if (nofLeafPairs <= 0 || mlcTableNode->GetNumberOfColumns() != 3)
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionsForControlPoints: beam has no valid MLC boundary data table");
+    return false;
+  }
+  vtkTable* mlcTable = mlcTableNode->GetTable();
+
+  vtkMRMLTransformNode* beamTransformNode = beamNode->GetParentTransformNode();
+  if (!beamTransformNode)
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionsForControlPoints: Beam transform node is invalid");
+    return false;
+  }
+
+  // Beam to RAS transform is FixedReferenceToRAS * GantryToFixedReference(gantry) * CollimatorToGantry(collimator),
+  // see vtkSlicerIECTransformLogic. Only the last two change between the control points, so the target is
+  // transformed once into the fixed reference frame (without the gantry and collimator rotations of the beam).
+  vtkNew<vtkTransform> beamRotationTransform;
+  beamRotationTransform->RotateY(beamNode->GetGantryAngle());
+  beamRotationTransform->RotateZ(beamNode->GetCollimatorAngle());
+  vtkNew<vtkMatrix4x4> rasToFixedReferenceMatrix;
+  beamTransformNode->GetMatrixTransformToWorld(rasToFixedReferenceMatrix);
+  vtkMatrix4x4::Multiply4x4( rasToFixedReferenceMatrix, beamRotationTransform->GetLinearInverse()->GetMatrix(), rasToFixedReferenceMatrix);
+  rasToFixedReferenceMatrix->Invert();
+
+  TargetPolygons targetPolygons;
+  GetTargetPolygons( targetPoly, rasToFixedReferenceMatrix->GetData(), targetPolygons);
+
+  const char* mlcName = mlcTableNode->GetName();
+  std::vector<double> boundaries(nofLeafPairs + 1);
+  for ( int row = 0; row <= nofLeafPairs; ++row)
+  {
+    boundaries[row] = mlcTable->GetValue( row, 0).ToDouble();
+  }
+
+  LeafFittingParameters parameters;
+  parameters.Boundaries = &boundaries;
+  parameters.TypeMLCX = strncmp( "MLCY", mlcName, strlen("MLCY")) != 0; // MLCX by default
+  parameters.SAD = beamNode->GetSAD();
+  parameters.SourceToMLCDistance = beamNode->GetSourceToMultiLeafCollimatorDistance();
+  parameters.Margin = margin;
+  parameters.LeafEndRadius = leafEndRadius;
+  parameters.ParallelBeam = parallelBeam;
+
+  // Fit the leaves for all control points in parallel
+  vtkIdType nofControlPoints = static_cast<vtkIdType>(gantryAngles.size());
+  std::vector< std::vector<double> > side1Positions(nofControlPoints);
+  std::vector< std::vector<double> > side2Positions(nofControlPoints);
+  std::vector<char> fittingSucceeded( nofControlPoints, 0);
+  vtkSMPTools::For( 0, nofControlPoints, [&](vtkIdType begin, vtkIdType end)
+  {
+    vtkNew<vtkTransform> fixedReferenceToBeamTransform;
+    for ( vtkIdType controlPoint = begin; controlPoint < end; ++controlPoint)
+    {
+      fixedReferenceToBeamTransform->Identity();
+      fixedReferenceToBeamTransform->RotateZ(-1. * collimatorAngles[controlPoint]);
+      fixedReferenceToBeamTransform->RotateY(-1. * gantryAngles[controlPoint]);
+      fittingSucceeded[controlPoint] = FitLeafPairs( targetPolygons, fixedReferenceToBeamTransform->GetMatrix()->GetData(),
+        parameters, side1Positions[controlPoint], side2Positions[controlPoint]);
+    }
+  });
+
+  // Output table: one row per control point.
+  // The table is only rebuilt if it doesn't have the layout of the leaf positions of this MLC and control points.
+  vtkTable* table = leafPositionsTableNode->GetTable();
+  bool tableLayoutMatches = (table->GetNumberOfColumns() == 2 + 2 * nofLeafPairs && table->GetNumberOfRows() == nofControlPoints);
+  if (!tableLayoutMatches)
+  {
+    table->Initialize();
+    vtkNew<vtkDoubleArray> gantryAngleArray;
+    gantryAngleArray->SetName("Gantry angle");
+    table->AddColumn(gantryAngleArray);
+    vtkNew<vtkDoubleArray> collimatorAngleArray;
+    collimatorAngleArray->SetName("Collimator angle");
+    table->AddColumn(collimatorAngleArray);
+    for ( int side = 1; side <= 2; ++side)
+    {
+      for ( int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+      {
+        vtkNew<vtkDoubleArray> positionArray;
+        positionArray->SetName((std::to_string(side) + "_" + std::to_string(leafPair)).c_str());
+        table->AddColumn(positionArray);
+      }
+    }
+    table->SetNumberOfRows(nofControlPoints);
+  }
+
+  int nofFailedControlPoints = 0;
+  for ( vtkIdType controlPoint = 0; controlPoint < nofControlPoints; ++controlPoint)
+  {
+    if (!fittingSucceeded[controlPoint])
+    {
+      ++nofFailedControlPoints;
+      if (failedControlPoints)
+      {
+        failedControlPoints->push_back(static_cast<int>(controlPoint));
+      }
+      if (tableLayoutMatches)
+      {
+        // Leave the previously calculated positions of the control point untouched
+        continue;
+      }
+      // New row: the leaves stay where they are in the MLC table of the beam
+      for ( int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+      {
+        side1Positions[controlPoint].push_back(mlcTable->GetValue( leafPair, 1).ToDouble());
+        side2Positions[controlPoint].push_back(mlcTable->GetValue( leafPair, 2).ToDouble());
+      }
+    }
+    table->SetValue( controlPoint, 0, gantryAngles[controlPoint]);
+    table->SetValue( controlPoint, 1, collimatorAngles[controlPoint]);
+    for ( int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+    {
+      table->SetValue( controlPoint, 2 + leafPair, side1Positions[controlPoint][leafPair]);
+      table->SetValue( controlPoint, 2 + nofLeafPairs + leafPair, side2Positions[controlPoint][leafPair]);
+    }
+  }
+  leafPositionsTableNode->SetUseColumnNameAsColumnHeader(true);
+  leafPositionsTableNode->Modified();
+  if (nofFailedControlPoints > 0)
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPositionsForControlPoints: Target projection doesn't overlap with the MLC at "
+      << nofFailedControlPoints << " of " << nofControlPoints << " control points");
+    return false;
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerMLCPositionLogic::SetMultiLeafCollimatorPositionsFromControlPoint( 
+  vtkMRMLTableNode* leafPositionsTableNode, int controlPointIndex, vtkMRMLTableNode* mlcTableNode)
+{
+  if (!leafPositionsTableNode || !mlcTableNode)
+  {
+    vtkErrorMacro("SetMultiLeafCollimatorPositionsFromControlPoint: invalid table nodes");
+    return false;
+  }
+  vtkTable* positionsTable = leafPositionsTableNode->GetTable();
+  vtkTable* mlcTable = mlcTableNode->GetTable();
+  int nofLeafPairs = mlcTable->GetNumberOfRows() - 1;
+  if ( nofLeafPairs <= 0 || mlcTable->GetNumberOfColumns() != 3
+    || positionsTable->GetNumberOfColumns() != 2 + 2 * nofLeafPairs )
+  {
+    vtkErrorMacro("SetMultiLeafCollimatorPositionsFromControlPoint: number of leaf pairs doesn't match");
+    return false;
+  }
+  if (controlPointIndex < 0 || controlPointIndex >= positionsTable->GetNumberOfRows())
+  {
+    vtkErrorMacro("SetMultiLeafCollimatorPositionsFromControlPoint: invalid control point index " << controlPointIndex);
+    return false;
+  }
+
+  for ( int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+  {
+    mlcTable->SetValue( leafPair, 1, positionsTable->GetValue( controlPointIndex, 2 + leafPair));
+    mlcTable->SetValue( leafPair, 2, positionsTable->GetValue( controlPointIndex, 2 + nofLeafPairs + leafPair));
+  }
+  mlcTableNode->Modified();
+  return true;
+}
+
 //---------------------------------------------------------------------------
 bool vtkSlicerMLCPositionLogic::FindLeafAndTargetCollision( vtkMRMLRTBeamNode* vtkNotUsed(beamNode), 
   vtkPolyData* leafPolyData, vtkPolyData* targetPolyData,
@@ -29,6 +29,9 @@
 // Slicer includes
 #include "vtkMRMLAbstractLogic.h"
 
+// STD includes
+#include <vector>
+
 class vtkPolyData;
 class vtkMRMLMarkupsCurveNode;
 class vtkMRMLRTBeamNode;
@@ -100,6 +103,52 @@ public:
   bool CalculateMultiLeafCollimatorPosition( vtkMRMLRTBeamNode* beamNode, 
     vtkMRMLTableNode* mlcTableNode, vtkPolyData* targetPoly);
 
+  /// Calculate MLC table position by projecting the target onto the isocenter plane
+  /// of IEC BEAM LIMITING DEVICE coordinate system (beam's eye view).
+  /// Target polygons are projected once, and each one is clipped with the strips of the leaf pairs
+  /// it overlaps, so the opening of every leaf pair is found in a single pass without collision queries.
+  /// As in the collision based calculation, only the part of the target between the MLC planes
+  /// on both sides of the isocenter is considered. Leaf pairs not covering the target are closed.
+  /// @param beamNode - beam node
+  /// @param mlcTableNode - table node with MLC boundary data, positions are updated
+  /// @param targetPoly - poly data of the target region
+  /// @param margin - margin around the projected target in mm, both along and across the leaves
+  /// @param leafEndRadius - radius of the rounded leaf ends in mm, zero for flat leaf ends.
+  ///   Rounded leaf ends are retracted so that their tangent ray from the source touches the projected target.
+  /// @param parallelBeam - flag if beam is parallel, otherwise the target is projected from the source
+  /// @return true if position calculation is successfull, false otherwise
+  bool CalculateMultiLeafCollimatorPositionBeamsEyeView( vtkMRMLRTBeamNode* beamNode, 
+    vtkMRMLTableNode* mlcTableNode, vtkPolyData* targetPoly, double margin = 0.0, 
+    double leafEndRadius = 0.0, bool parallelBeam = true);
+
+  /// Calculate MLC positions for multiple control points of a beam (e.g. arc), using beam's eye view projection.
+  /// Only the gantry and collimator angles differ between the control points; the isocenter, couch angle,
+  /// source distances and the MLC boundary data are taken from the beam node and its MLC table.
+  /// The target is transformed into the fixed reference frame once, and the control points are fitted in parallel.
+  /// \sa CalculateMultiLeafCollimatorPositionBeamsEyeView
+  /// @param beamNode - beam node with parent transform and MLC table node with boundary data
+  /// @param targetPoly - closed surface poly data of the target region
+  /// @param gantryAngles - gantry angles of the control points in degrees
+  /// @param collimatorAngles - collimator angles of the control points in degrees, same number as gantry angles
+  /// @param leafPositionsTableNode - output table with one row per control point. Columns are the gantry angle,
+  ///   the collimator angle, then the positions of side "1" ("1_<leaf pair index>") and side "2" ("2_<leaf pair index>").
+  ///   If the table already has this layout, the rows of the control points that can't be fitted are left untouched,
+  ///   otherwise the table is rebuilt and those rows get the current leaf positions of the MLC table of the beam.
+  /// @param failedControlPoints - optional output, indices of the control points where the target projection
+  ///   doesn't overlap with the MLC
+  /// @return true if the leaves are fitted at all control points, false otherwise (the fitted control points are still updated)
+  bool CalculateMultiLeafCollimatorPositionsForControlPoints( vtkMRMLRTBeamNode* beamNode, vtkPolyData* targetPoly,
+    const std::vector<double>& gantryAngles, const std::vector<double>& collimatorAngles,
+    vtkMRMLTableNode* leafPositionsTableNode, double margin = 0.0, double leafEndRadius = 0.0, bool parallelBeam = true,
+    std::vector<int>* failedControlPoints = nullptr);
+
+  /// Set leaf positions of an MLC table from a control point of a leaf positions table
+  /// created by \sa CalculateMultiLeafCollimatorPositionsForControlPoints
+  /// @param mlcTableNode - MLC table with boundary data, positions are updated
+  /// @return true if successfull, false otherwise
+  bool SetMultiLeafCollimatorPositionsFromControlPoint( vtkMRMLTableNode* leafPositionsTableNode, 
+    int controlPointIndex, vtkMRMLTableNode* mlcTableNode);
+
   /// Calculate MLC position opening area, for statistic purposes.
   /// @return positive area value is successfull, negative value otherwise 
   double CalculateMultiLeafCollimatorPositionArea(vtkMRMLRTBeamNode* beamNode);
@@ -45,6 +45,14 @@
 #include <vtkTable.h>
 #include <vtkCellArray.h>
 #include <vtkAppendPolyData.h>
+#include <vtkDoubleArray.h>
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 
 //------------------------------------------------------------------------------
 const char* vtkMRMLRTBeamNode::NEW_BEAM_NODE_NAME_PREFIX = "NewBeam_";
@@ -55,6 +63,37 @@ static const char* MLC_BOUNDARY_POSITION_REFERENCE_ROLE = "MLCBoundaryAndPositio
 static const char* DRR_REFERENCE_ROLE = "DRRRef";
 static const char* CONTOUR_BEV_REFERENCE_ROLE = "contourBEVRef";
 
+//------------------------------------------------------------------------------
+namespace
+{
+
+/// Write values as a space separated list, with enough digits to read back the same values
+std::string ValuesToString(const std::vector<double>& values)
+{
+  std::stringstream ss;
+  ss << std::setprecision(std::numeric_limits<double>::max_digits10);
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    ss << (i > 0 ? " " : "") << values[i];
+  }
+  return ss.str();
+}
+
+/// Read space separated list of values
+std::vector<double> StringToValues(const char* str)
+{
+  std::vector<double> values;
+  std::stringstream ss(str);
+  double value;
+  while (ss >> value)
+  {
+    values.push_back(value);
+  }
+  return values;
+}
+
+} // namespace
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLRTBeamNode);
 
@@ -76,9 +115,14 @@ vtkMRMLRTBeamNode::vtkMRMLRTBeamNode()
 
   this->SAD = 2000.0;
 
+  this->NumberOfControlPointLeafPositions = 0;
+  this->CurrentControlPointIndex = -1;
+
   this->SourceToJawsDistanceX = 500.;
   this->SourceToJawsDistanceY = 500.;
   this->SourceToMultiLeafCollimatorDistance = 400.;
+
+  this->DefaultBeamPolyDataMTime = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -109,6 +153,17 @@ void vtkMRMLRTBeamNode::WriteXML(ostream& of, int nIndent)
   vtkMRMLWriteXMLFloatMacro( CollimatorAngle, CollimatorAngle);
   vtkMRMLWriteXMLFloatMacro( CouchAngle, CouchAngle);
   vtkMRMLWriteXMLEndMacro();
+
+  // Control point store
+  if (this->GetNumberOfControlPoints() > 0)
+  {
+    of << " CurrentControlPointIndex=\"" << this->CurrentControlPointIndex << "\"";
+    of << " NumberOfControlPointLeafPositions=\"" << this->NumberOfControlPointLeafPositions << "\"";
+    of << " ControlPointAngles=\"" << ValuesToString(this->ControlPointAngles) << "\"";
+    of << " ControlPointJawPositions=\"" << ValuesToString(this->ControlPointJawPositions) << "\"";
+    of << " ControlPointCumulativeMetersetWeights=\"" << ValuesToString(this->ControlPointCumulativeMetersetWeights) << "\"";
+    of << " ControlPointLeafPositions=\"" << ValuesToString(this->ControlPointLeafPositions) << "\"";
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -133,6 +188,60 @@ void vtkMRMLRTBeamNode::ReadXMLAttributes(const char** atts)
   vtkMRMLReadXMLFloatMacro( CollimatorAngle, CollimatorAngle);
   vtkMRMLReadXMLFloatMacro( CouchAngle, CouchAngle);
   vtkMRMLReadXMLEndMacro();
+
+  // Control point store. The current control point is not set to the beam again,
+  // as its geometry has been read with the beam parameters and the MLC table
+  this->RemoveAllControlPoints();
+  int currentControlPointIndex = -1;
+  vtkIdType numberOfLeafPositions = 0;
+  std::vector<double> angles, jawPositions, cumulativeMetersetWeights, leafPositions;
+  for (const char** attribute = atts; *attribute != nullptr; attribute += 2)
+  {
+    const char* attName = attribute[0];
+    const char* attValue = attribute[1];
+    if (!strcmp(attName, "CurrentControlPointIndex"))
+    {
+      currentControlPointIndex = atoi(attValue);
+    }
+    else if (!strcmp(attName, "NumberOfControlPointLeafPositions"))
+    {
+      numberOfLeafPositions = static_cast<vtkIdType>(atoi(attValue));
+    }
+    else if (!strcmp(attName, "ControlPointAngles"))
+    {
+      angles = StringToValues(attValue);
+    }
+    else if (!strcmp(attName, "ControlPointJawPositions"))
+    {
+      jawPositions = StringToValues(attValue);
+    }
+    else if (!strcmp(attName, "ControlPointCumulativeMetersetWeights"))
+    {
+      cumulativeMetersetWeights = StringToValues(attValue);
+    }
+    else if (!strcmp(attName, "ControlPointLeafPositions"))
+    {
+      leafPositions = StringToValues(attValue);
+    }
+  }
+  size_t numberOfControlPoints = cumulativeMetersetWeights.size();
+  if (numberOfControlPoints == 0)
+  {
+    return;
+  }
+  if ( angles.size() != 3 * numberOfControlPoints || jawPositions.size() != 4 * numberOfControlPoints
+    || numberOfLeafPositions < 0 || leafPositions.size() != static_cast<size_t>(numberOfLeafPositions) * numberOfControlPoints
+    || currentControlPointIndex >= static_cast<int>(numberOfControlPoints) )
+  {
+    vtkErrorMacro("ReadXMLAttributes: Inconsistent control point store, it is not loaded");
+    return;
+  }
+  this->ControlPointAngles = angles;
+  this->ControlPointJawPositions = jawPositions;
+  this->ControlPointCumulativeMetersetWeights = cumulativeMetersetWeights;
+  this->ControlPointLeafPositions = leafPositions;
+  this->NumberOfControlPointLeafPositions = numberOfLeafPositions;
+  this->CurrentControlPointIndex = currentControlPointIndex;
 }
 
 //----------------------------------------------------------------------------
@@ -180,6 +289,8 @@ void vtkMRMLRTBeamNode::Copy(vtkMRMLNode *anode)
   vtkMRMLCopyFloatMacro(CouchAngle);
   vtkMRMLCopyEndMacro();
 
+  this->CopyControlPoints(node);
+
   this->EndModify(disabledModify);
 
   this->InvokePendingModifiedEvent();
@@ -212,6 +323,23 @@ void vtkMRMLRTBeamNode::CopyContent(vtkMRMLNode *anode, bool deepCopy/*=true*/)
   vtkMRMLCopyFloatMacro(CollimatorAngle);
   vtkMRMLCopyFloatMacro(CouchAngle);
   vtkMRMLCopyEndMacro();
+
+  this->CopyControlPoints(node);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::CopyControlPoints(vtkMRMLRTBeamNode* node)
+{
+  if (!node)
+  {
+    return;
+  }
+  this->ControlPointAngles = node->ControlPointAngles;
+  this->ControlPointJawPositions = node->ControlPointJawPositions;
+  this->ControlPointCumulativeMetersetWeights = node->ControlPointCumulativeMetersetWeights;
+  this->ControlPointLeafPositions = node->ControlPointLeafPositions;
+  this->NumberOfControlPointLeafPositions = node->NumberOfControlPointLeafPositions;
+  this->CurrentControlPointIndex = node->CurrentControlPointIndex;
 }
 
 //----------------------------------------------------------------------------
@@ -255,6 +383,9 @@ void vtkMRMLRTBeamNode::PrintSelf(ostream& os, vtkIndent indent)
   vtkMRMLPrintFloatMacro(CollimatorAngle);
   vtkMRMLPrintFloatMacro(CouchAngle);
   vtkMRMLPrintEndMacro();
+
+  os << indent << "NumberOfControlPoints: " << this->GetNumberOfControlPoints() << "\n";
+  os << indent << "CurrentControlPointIndex: " << this->CurrentControlPointIndex << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -420,6 +551,10 @@ bool vtkMRMLRTBeamNode::GetSourcePosition(double source[3])
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetX1Jaw(double x1Jaw)
 {
+  if (this->X1Jaw == x1Jaw)
+  {
+    return;
+  }
   this->X1Jaw = x1Jaw;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -428,6 +563,10 @@ void vtkMRMLRTBeamNode::SetX1Jaw(double x1Jaw)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetX2Jaw(double x2Jaw)
 {
+  if (this->X2Jaw == x2Jaw)
+  {
+    return;
+  }
   this->X2Jaw = x2Jaw;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -436,6 +575,10 @@ void vtkMRMLRTBeamNode::SetX2Jaw(double x2Jaw)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetY1Jaw(double y1Jaw)
 {
+  if (this->Y1Jaw == y1Jaw)
+  {
+    return;
+  }
   this->Y1Jaw = y1Jaw;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -444,14 +587,147 @@ void vtkMRMLRTBeamNode::SetY1Jaw(double y1Jaw)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetY2Jaw(double y2Jaw)
 {
+  if (this->Y2Jaw == y2Jaw)
+  {
+    return;
+  }
   this->Y2Jaw = y2Jaw;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::SetJawPositions(double x1Jaw, double x2Jaw, double y1Jaw, double y2Jaw)
+{
+  // Beam geometry modified event is invoked only once at the end of the block
+  MRMLNodeModifyBlocker blocker(this);
+  this->SetX1Jaw(x1Jaw);
+  this->SetX2Jaw(x2Jaw);
+  this->SetY1Jaw(y1Jaw);
+  this->SetY2Jaw(y2Jaw);
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLRTBeamNode::AddControlPoint( double gantryAngle, double collimatorAngle, double couchAngle,
+  const double jawPositions[4], double cumulativeMetersetWeight, const std::vector<double>& leafPositions)
+{
+  int numberOfControlPoints = this->GetNumberOfControlPoints();
+  vtkIdType numberOfLeafPositions = static_cast<vtkIdType>(leafPositions.size());
+  if (numberOfControlPoints == 0)
+  {
+    this->NumberOfControlPointLeafPositions = numberOfLeafPositions;
+  }
+  else if (numberOfLeafPositions > 0 && numberOfLeafPositions != this->NumberOfControlPointLeafPositions)
+  {
+    vtkErrorMacro("AddControlPoint: Number of leaf positions (" << numberOfLeafPositions
+      << ") differs from that of the first control point (" << this->NumberOfControlPointLeafPositions << ")");
+    return -1;
+  }
+
+  this->ControlPointAngles.push_back(gantryAngle);
+  this->ControlPointAngles.push_back(collimatorAngle);
+  this->ControlPointAngles.push_back(couchAngle);
+  this->ControlPointJawPositions.insert( this->ControlPointJawPositions.end(), jawPositions, jawPositions + 4);
+  this->ControlPointCumulativeMetersetWeights.push_back(cumulativeMetersetWeight);
+  if (numberOfLeafPositions > 0)
+  {
+    this->ControlPointLeafPositions.insert( this->ControlPointLeafPositions.end(),
+      leafPositions.begin(), leafPositions.end());
+  }
+  else if (this->NumberOfControlPointLeafPositions > 0)
+  {
+    // Leaves did not move since the previous control point
+    size_t previousBegin = this->ControlPointLeafPositions.size() - this->NumberOfControlPointLeafPositions;
+    for (vtkIdType leaf = 0; leaf < this->NumberOfControlPointLeafPositions; ++leaf)
+    {
+      this->ControlPointLeafPositions.push_back(this->ControlPointLeafPositions[previousBegin + leaf]);
+    }
+  }
+
+  return numberOfControlPoints;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::RemoveAllControlPoints()
+{
+  this->ControlPointAngles.clear();
+  this->ControlPointJawPositions.clear();
+  this->ControlPointCumulativeMetersetWeights.clear();
+  this->ControlPointLeafPositions.clear();
+  this->NumberOfControlPointLeafPositions = 0;
+  this->CurrentControlPointIndex = -1;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLRTBeamNode::GetControlPointCumulativeMetersetWeight(int controlPointIndex) const
+{
+  if (controlPointIndex < 0 || controlPointIndex >= this->GetNumberOfControlPoints())
+  {
+    return -1.;
+  }
+  return this->ControlPointCumulativeMetersetWeights[controlPointIndex];
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLRTBeamNode::SetCurrentControlPointIndex(int controlPointIndex)
+{
+  if (controlPointIndex < 0 || controlPointIndex >= this->GetNumberOfControlPoints())
+  {
+    vtkErrorMacro("SetCurrentControlPointIndex: Invalid control point index " << controlPointIndex
+      << ", number of control points is " << this->GetNumberOfControlPoints());
+    return false;
+  }
+
+  // Transform and geometry modified events are invoked only once at the end of the block
+  MRMLNodeModifyBlocker blocker(this);
+
+  const double* angles = this->ControlPointAngles.data() + 3 * controlPointIndex;
+  this->SetGantryAngle(angles[0]);
+  this->SetCollimatorAngle(angles[1]);
+  this->SetCouchAngle(angles[2]);
+
+  const double* jaws = this->ControlPointJawPositions.data() + 4 * controlPointIndex;
+  this->SetJawPositions( jaws[0], jaws[1], jaws[2], jaws[3]);
+
+  vtkMRMLTableNode* mlcTableNode = this->GetMultiLeafCollimatorTableNode();
+  if (mlcTableNode && this->NumberOfControlPointLeafPositions > 0)
+  {
+    vtkIdType numberOfLeafPairs = this->NumberOfControlPointLeafPositions / 2;
+    vtkTable* table = mlcTableNode->GetTable();
+    vtkDoubleArray* side1 = vtkDoubleArray::SafeDownCast(table->GetColumn(1));
+    vtkDoubleArray* side2 = vtkDoubleArray::SafeDownCast(table->GetColumn(2));
+    if (side1 && side2 && table->GetNumberOfRows() == numberOfLeafPairs + 1)
+    {
+      // Update leaf positions of the MLC table in place (last row holds the last boundary only)
+      const double* leafPositions = this->ControlPointLeafPositions.data()
+        + this->NumberOfControlPointLeafPositions * controlPointIndex;
+      for (vtkIdType leafPair = 0; leafPair < numberOfLeafPairs; ++leafPair)
+      {
+        side1->SetValue( leafPair, leafPositions[leafPair]);
+        side2->SetValue( leafPair, leafPositions[leafPair + numberOfLeafPairs]);
+      }
+      side1->Modified();
+      side2->Modified();
+      mlcTableNode->Modified();
+      this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
+    }
+    else
+    {
+      vtkWarningMacro("SetCurrentControlPointIndex: MLC table node does not match the leaf positions of the control points, leaves are not updated");
+    }
+  }
+
+  this->CurrentControlPointIndex = controlPointIndex;
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetSourceToJawsDistanceX(double distance)
 {
+  if (this->SourceToJawsDistanceX == distance)
+  {
+    return;
+  }
   this->SourceToJawsDistanceX = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -460,6 +736,10 @@ void vtkMRMLRTBeamNode::SetSourceToJawsDistanceX(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetSourceToJawsDistanceY(double distance)
 {
+  if (this->SourceToJawsDistanceY == distance)
+  {
+    return;
+  }
   this->SourceToJawsDistanceY = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -468,6 +748,10 @@ void vtkMRMLRTBeamNode::SetSourceToJawsDistanceY(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetSourceToMultiLeafCollimatorDistance(double distance)
 {
+  if (this->SourceToMultiLeafCollimatorDistance == distance)
+  {
+    return;
+  }
   this->SourceToMultiLeafCollimatorDistance = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -476,6 +760,10 @@ void vtkMRMLRTBeamNode::SetSourceToMultiLeafCollimatorDistance(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetGantryAngle(double angle)
 {
+  if (this->GantryAngle == angle)
+  {
+    return;
+  }
   this->GantryAngle = angle;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamTransformModified);
@@ -484,6 +772,10 @@ void vtkMRMLRTBeamNode::SetGantryAngle(double angle)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetCollimatorAngle(double angle)
 {
+  if (this->CollimatorAngle == angle)
+  {
+    return;
+  }
   this->CollimatorAngle = angle;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamTransformModified);
@@ -492,6 +784,10 @@ void vtkMRMLRTBeamNode::SetCollimatorAngle(double angle)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetCouchAngle(double angle)
 {
+  if (this->CouchAngle == angle)
+  {
+    return;
+  }
   this->CouchAngle = angle;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamTransformModified);
@@ -500,6 +796,10 @@ void vtkMRMLRTBeamNode::SetCouchAngle(double angle)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetSAD(double sad)
 {
+  if (this->SAD == sad)
+  {
+    return;
+  }
   this->SAD = sad;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -727,6 +1027,7 @@ void vtkMRMLRTBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=null
     {
       append->Update();
       beamModelPolyData->DeepCopy(append->GetOutput());
+      this->DefaultBeamPolyDataMTime = 0;
     }
   }
   if (polydataAppended)
@@ -736,6 +1037,24 @@ void vtkMRMLRTBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=null
   }
  
   // Default beam polydata (no MLC)
+  // If the beam's own polydata is the default pyramid created below and has not been changed since,
+  // then only the source and the corner vertices are moved (jaws or SAD changed), the cells are kept
+  if ( beamModelPolyData == this->GetPolyData() && this->DefaultBeamPolyDataMTime == beamModelPolyData->GetMTime()
+    && beamModelPolyData->GetPoints() && beamModelPolyData->GetNumberOfPoints() == 5 )
+  {
+    vtkPoints* beamPoints = beamModelPolyData->GetPoints();
+    beamPoints->SetPoint(0, 0, 0, this->SAD);
+    beamPoints->SetPoint(1, 2*this->X1Jaw, 2*this->Y1Jaw, -this->SAD );
+    beamPoints->SetPoint(2, 2*this->X1Jaw, 2*this->Y2Jaw, -this->SAD );
+    beamPoints->SetPoint(3, 2*this->X2Jaw, 2*this->Y2Jaw, -this->SAD );
+    beamPoints->SetPoint(4, 2*this->X2Jaw, 2*this->Y1Jaw, -this->SAD );
+    beamPoints->Modified();
+    beamModelPolyData->Modified();
+
+    this->DefaultBeamPolyDataMTime = beamModelPolyData->GetMTime();
+    return;
+  }
+
   vtkNew<vtkPoints> points;
   vtkNew<vtkCellArray> cellArray;
 
@@ -774,6 +1093,11 @@ void vtkMRMLRTBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=null
 
   beamModelPolyData->SetPoints(points);
   beamModelPolyData->SetPolys(cellArray);
+
+  if (beamModelPolyData == this->GetPolyData())
+  {
+    this->DefaultBeamPolyDataMTime = beamModelPolyData->GetMTime();
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -37,6 +37,10 @@ class vtkMRMLSegmentationNode;
 class vtkMRMLLinearTransformNode;
 
 /// \ingroup SlicerRt_QtModules_Beams
+///
+/// Geometry setters (jaws, SAD, angles, MLC table) invoke \sa BeamGeometryModified or \sa BeamTransformModified,
+/// which trigger re-generation of the beam model and transform. To change several parameters at once, wrap the
+/// calls in StartModify/EndModify (or use MRMLNodeModifyBlocker), so that each event is invoked only once at the end.
 class VTK_SLICER_BEAMS_MODULE_MRML_EXPORT vtkMRMLRTBeamNode : public vtkMRMLModelNode
 {
 public:
@@ -163,6 +167,9 @@ public:
   /// Set Y2 jaw position. Triggers \sa BeamGeometryModified event and re-generation of beam model
   void SetY2Jaw(double y2Jaw);
 
+  /// Set all jaw positions at once. Triggers \sa BeamGeometryModified event and re-generation of beam model only once
+  void SetJawPositions(double x1Jaw, double x2Jaw, double y1Jaw, double y2Jaw);
+
   /// Get source-axis distance
   vtkGetMacro(SAD, double);
   /// Set source-axis distance. Triggers \sa BeamGeometryModified event and re-generation of beam model
@@ -203,11 +210,42 @@ public:
   /// Set source to multi-leaf collimator distance. Triggers \sa BeamTransformModified event and re-generation of beam model
   void SetSourceToMultiLeafCollimatorDistance(double distance);
 
+// Control points
+public:
+  /// Add control point to the control point store of a dynamic (e.g. VMAT) beam.
+  /// The store keeps the geometry of each control point in flat arrays, so that a beam with
+  /// many control points is represented by a single beam node. The geometry of a control point
+  /// is only set to the beam when it is selected by \sa SetCurrentControlPointIndex
+  /// \param jawPositions Jaw positions X1, X2, Y1, Y2
+  /// \param leafPositions Raw DICOM leaf positions (side "1" leaves followed by side "2" leaves).
+  ///   If empty, then the leaf positions of the previous control point are used
+  /// \return Index of the added control point, -1 on failure
+  int AddControlPoint( double gantryAngle, double collimatorAngle, double couchAngle,
+    const double jawPositions[4], double cumulativeMetersetWeight, const std::vector<double>& leafPositions);
+  /// Remove all control points from the control point store
+  void RemoveAllControlPoints();
+  /// Get number of control points in the control point store
+  int GetNumberOfControlPoints() const { return static_cast<int>(this->ControlPointCumulativeMetersetWeights.size()); };
+  /// Get cumulative meterset weight of a control point
+  /// \return Cumulative meterset weight, -1 if the index is invalid
+  double GetControlPointCumulativeMetersetWeight(int controlPointIndex) const;
+
+  /// Get index of the control point whose geometry is set to the beam, -1 if none
+  vtkGetMacro(CurrentControlPointIndex, int);
+  /// Set geometry (angles, jaws and leaf positions) of a control point to the beam.
+  /// Leaf positions are written into the referenced MLC table node if its number of leaf pairs matches.
+  /// Triggers \sa BeamTransformModified and \sa BeamGeometryModified events only once
+  /// \return Success flag
+  bool SetCurrentControlPointIndex(int controlPointIndex);
+
 protected:
   /// Create beam model from beam parameters, supporting MLC leaves
   /// \param beamModelPolyData Output polydata. If none given then the beam node's own polydata is used
   virtual void CreateBeamPolyData(vtkPolyData* beamModelPolyData=nullptr);
 
+  /// Copy control point store from another beam node
+  void CopyControlPoints(vtkMRMLRTBeamNode* node);
+
 protected:
   vtkMRMLRTBeamNode();
   ~vtkMRMLRTBeamNode();
@@ -248,6 +286,23 @@ protected:
   /// Couch angle
   double CouchAngle;
 
+  /// Modified time of the beam polydata when it was last created as the default (no MLC) beam model.
+  /// If unchanged, the default beam model is updated by moving its vertices instead of re-creating it.
+  vtkMTimeType DefaultBeamPolyDataMTime;
+
+  /// Control point store: gantry, collimator and couch angles of each control point
+  std::vector<double> ControlPointAngles;
+  /// Control point store: jaw positions (X1, X2, Y1, Y2) of each control point
+  std::vector<double> ControlPointJawPositions;
+  /// Control point store: cumulative meterset weight of each control point
+  std::vector<double> ControlPointCumulativeMetersetWeights;
+  /// Control point store: leaf positions of each control point in raw DICOM order
+  std::vector<double> ControlPointLeafPositions;
+  /// Number of leaf positions per control point in \sa ControlPointLeafPositions
+  vtkIdType NumberOfControlPointLeafPositions;
+  /// Index of the control point whose geometry is set to the beam
+  int CurrentControlPointIndex;
+
 protected:
   /// Visible multi-leaf collimator points
   typedef std::vector< std::pair< double, double > > MLCVisiblePointVector;
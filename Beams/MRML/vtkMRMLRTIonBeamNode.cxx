@@ -47,6 +47,14 @@
 #include <vtkCellArray.h>
 #include <vtkAppendPolyData.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
 //------------------------------------------------------------------------------
 namespace
 {
@@ -54,6 +62,79 @@ namespace
 const char* const SCANSPOT_REFERENCE_ROLE = "ScanSpotRef";
 double FWHM_TO_SIGMA = 1. / (2. * sqrt(2. * log(2.)));
 
+/// Write values as a space separated list, with enough digits to read back the same values
+template<typename T>
+std::string ValuesToString(const std::vector<T>& values)
+{
+  std::stringstream ss;
+  ss << std::setprecision(std::numeric_limits<T>::max_digits10);
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    ss << (i > 0 ? " " : "") << values[i];
+  }
+  return ss.str();
+}
+
+/// Read space separated list of values
+template<typename T>
+std::vector<T> StringToValues(const char* str)
+{
+  std::vector<T> values;
+  std::stringstream ss(str);
+  T value;
+  while (ss >> value)
+  {
+    values.push_back(value);
+  }
+  return values;
+}
+
+/// Join scan spot tune IDs with ';' separators. '%' and ';' in the IDs are percent-encoded
+std::string TuneIdsToString(const std::vector<std::string>& tuneIds)
+{
+  std::string str;
+  for (size_t i = 0; i < tuneIds.size(); ++i)
+  {
+    if (i > 0)
+    {
+      str += ";";
+    }
+    for (char c : tuneIds[i])
+    {
+      str += (c == '%' ? std::string("%25") : (c == ';' ? std::string("%3B") : std::string(1, c)));
+    }
+  }
+  return str;
+}
+
+/// Split and decode scan spot tune IDs joined by \sa TuneIdsToString
+std::vector<std::string> StringToTuneIds(const char* str)
+{
+  std::vector<std::string> tuneIds(1);
+  for (const char* c = str; *c; ++c)
+  {
+    if (*c == ';')
+    {
+      tuneIds.emplace_back();
+    }
+    else if (*c == '%' && !strncmp(c, "%25", 3))
+    {
+      tuneIds.back() += '%';
+      c += 2;
+    }
+    else if (*c == '%' && !strncmp(c, "%3B", 3))
+    {
+      tuneIds.back() += ';';
+      c += 2;
+    }
+    else
+    {
+      tuneIds.back() += *c;
+    }
+  }
+  return tuneIds;
+}
+
 } // namespace
 
 //------------------------------------------------------------------------------
@@ -76,6 +157,11 @@ vtkMRMLRTIonBeamNode::vtkMRMLRTIonBeamNode()
   this->IsocenterToMultiLeafCollimatorDistance = 2500.;
   this->ScanningSpotSize[0] = 15.0f;
   this->ScanningSpotSize[1] = 15.0f;
+
+  // Observe the scan spot table node, so that the scan spot map follows the edits of the table
+  vtkNew<vtkIntArray> scanSpotTableEvents;
+  scanSpotTableEvents->InsertNextValue(vtkCommand::ModifiedEvent);
+  this->AddNodeReferenceRole(SCANSPOT_REFERENCE_ROLE, nullptr, scanSpotTableEvents);
 }
 
 //----------------------------------------------------------------------------
@@ -99,6 +185,24 @@ void vtkMRMLRTIonBeamNode::WriteXML(ostream& of, int nIndent)
   vtkMRMLWriteXMLFloatMacro( IsocenterToRangeShifterDistance, IsocenterToRangeShifterDistance);
   vtkMRMLWriteXMLVectorMacro( ScanningSpotSize, ScanningSpotSize, float, 2);
   vtkMRMLWriteXMLEndMacro();
+
+  // Energy layers of the scan spot map. The scan spots are saved in the scan spot table node,
+  // and they are set to the map from the table when it is read
+  if (!this->ScanSpotEnergyLayers.empty())
+  {
+    std::vector<double> energies;
+    std::vector<vtkIdType> numbersOfSpots;
+    std::vector<std::string> tuneIds;
+    for (const ScanSpotEnergyLayer& layer : this->ScanSpotEnergyLayers)
+    {
+      energies.push_back(layer.NominalBeamEnergy);
+      numbersOfSpots.push_back(layer.NumberOfSpots);
+      tuneIds.push_back(layer.ScanSpotTuneId);
+    }
+    of << " ScanSpotEnergyLayerEnergies=\"" << ValuesToString(energies) << "\"";
+    of << " ScanSpotEnergyLayerNumberOfSpots=\"" << ValuesToString(numbersOfSpots) << "\"";
+    of << " ScanSpotEnergyLayerTuneIds=\"" << this->XMLAttributeEncodeString(TuneIdsToString(tuneIds)) << "\"";
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -115,6 +219,64 @@ void vtkMRMLRTIonBeamNode::ReadXMLAttributes(const char** atts)
   vtkMRMLReadXMLFloatMacro( IsocenterToRangeShifterDistance, IsocenterToRangeShifterDistance);
   vtkMRMLReadXMLVectorMacro( ScanningSpotSize, ScanningSpotSize, float, 2);
   vtkMRMLReadXMLEndMacro();
+
+  // Energy layers of the scan spot map
+  std::vector<double> energies;
+  std::vector<vtkIdType> numbersOfSpots;
+  std::vector<std::string> tuneIds;
+  for (const char** attribute = atts; *attribute != nullptr; attribute += 2)
+  {
+    const char* attName = attribute[0];
+    const char* attValue = attribute[1];
+    if (!strcmp(attName, "ScanSpotEnergyLayerEnergies"))
+    {
+      energies = StringToValues<double>(attValue);
+    }
+    else if (!strcmp(attName, "ScanSpotEnergyLayerNumberOfSpots"))
+    {
+      numbersOfSpots = StringToValues<vtkIdType>(attValue);
+    }
+    else if (!strcmp(attName, "ScanSpotEnergyLayerTuneIds"))
+    {
+      tuneIds = StringToTuneIds(attValue);
+    }
+  }
+
+  this->ScanSpotPositionsX.clear();
+  this->ScanSpotPositionsY.clear();
+  this->ScanSpotMetersetWeights.clear();
+  this->ScanSpotEnergyLayers.clear();
+  if (energies.empty())
+  {
+    return;
+  }
+  if (numbersOfSpots.size() != energies.size() || tuneIds.size() != energies.size())
+  {
+    vtkErrorMacro("ReadXMLAttributes: Inconsistent scan spot energy layers, they are not loaded");
+    return;
+  }
+  for (size_t layerIndex = 0; layerIndex < energies.size(); ++layerIndex)
+  {
+    ScanSpotEnergyLayer layer;
+    layer.NominalBeamEnergy = energies[layerIndex];
+    layer.ScanSpotTuneId = tuneIds[layerIndex];
+    layer.FirstSpotIndex = (layerIndex > 0 ? this->ScanSpotEnergyLayers.back().FirstSpotIndex + this->ScanSpotEnergyLayers.back().NumberOfSpots : 0);
+    layer.NumberOfSpots = numbersOfSpots[layerIndex];
+    this->ScanSpotEnergyLayers.push_back(layer);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLRTIonBeamNode::ProcessMRMLEvents(vtkObject* caller, unsigned long eventID, void* callData)
+{
+  Superclass::ProcessMRMLEvents(caller, eventID, callData);
+
+  vtkMRMLTableNode* scanSpotTableNode = this->GetScanSpotTableNode();
+  if ( eventID == vtkCommand::ModifiedEvent && scanSpotTableNode && caller == scanSpotTableNode
+    && !this->UpdatingScanSpotTableNode )
+  {
+    this->UpdateScanSpotMapFromTableNode(scanSpotTableNode);
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -167,6 +329,14 @@ void vtkMRMLRTIonBeamNode::Copy(vtkMRMLNode *anode)
   vtkMRMLCopyFloatMacro(CouchAngle);
   vtkMRMLCopyEndMacro();
 
+  this->CopyControlPoints(node);
+
+  // Copy scan spot map
+  this->ScanSpotPositionsX = node->ScanSpotPositionsX;
+  this->ScanSpotPositionsY = node->ScanSpotPositionsY;
+  this->ScanSpotMetersetWeights = node->ScanSpotMetersetWeights;
+  this->ScanSpotEnergyLayers = node->ScanSpotEnergyLayers;
+
   this->EndModify(disabledModify);
   
   this->InvokePendingModifiedEvent();
@@ -203,6 +373,12 @@ void vtkMRMLRTIonBeamNode::CopyContent(vtkMRMLNode *anode, bool deepCopy/*=true*
   vtkMRMLCopyFloatMacro(CollimatorAngle);
   vtkMRMLCopyFloatMacro(CouchAngle);
   vtkMRMLCopyEndMacro();
+
+  // Copy scan spot map
+  this->ScanSpotPositionsX = node->ScanSpotPositionsX;
+  this->ScanSpotPositionsY = node->ScanSpotPositionsY;
+  this->ScanSpotMetersetWeights = node->ScanSpotMetersetWeights;
+  this->ScanSpotEnergyLayers = node->ScanSpotEnergyLayers;
 }
 
 //----------------------------------------------------------------------------
@@ -225,6 +401,9 @@ void vtkMRMLRTIonBeamNode::PrintSelf(ostream& os, vtkIndent indent)
   vtkMRMLPrintFloatMacro(IsocenterToRangeShifterDistance);
   vtkMRMLPrintVectorMacro( ScanningSpotSize, float, 2);
   vtkMRMLPrintEndMacro();
+
+  os << indent << "NumberOfScanSpotEnergyLayers: " << this->ScanSpotEnergyLayers.size() << "\n";
+  os << indent << "NumberOfScanSpots: " << this->ScanSpotMetersetWeights.size() << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -238,6 +417,16 @@ void vtkMRMLRTIonBeamNode::SetAndObserveScanSpotTableNode(vtkMRMLTableNode* node
 
   this->SetNodeReferenceID( SCANSPOT_REFERENCE_ROLE, (node ? node->GetID() : nullptr));
 
+  // Synchronize the table and the scan spot map
+  if (node && !this->ScanSpotMetersetWeights.empty())
+  {
+    this->UpdateScanSpotTableNode(node);
+  }
+  else if (node)
+  {
+    this->UpdateScanSpotMapFromTableNode(node);
+  }
+
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
 }
 
@@ -247,6 +436,210 @@ vtkMRMLTableNode* vtkMRMLRTIonBeamNode::GetScanSpotTableNode()
   return vtkMRMLTableNode::SafeDownCast( this->GetNodeReference(SCANSPOT_REFERENCE_ROLE) );
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLRTIonBeamNode::AddScanSpotEnergyLayer( double nominalBeamEnergy, const char* scanSpotTuneId,
+  const std::vector<float>& positionMap, const std::vector<float>& metersetWeights)
+{
+  if (positionMap.size() != 2 * metersetWeights.size())
+  {
+    vtkErrorMacro("AddScanSpotEnergyLayer: Number of scan spot positions (" << positionMap.size() / 2
+      << ") and meterset weights (" << metersetWeights.size() << ") differ");
+    return -1;
+  }
+
+  ScanSpotEnergyLayer layer;
+  layer.NominalBeamEnergy = nominalBeamEnergy;
+  layer.ScanSpotTuneId = (scanSpotTuneId ? scanSpotTuneId : "");
+  layer.FirstSpotIndex = static_cast<vtkIdType>(this->ScanSpotMetersetWeights.size());
+  layer.NumberOfSpots = static_cast<vtkIdType>(metersetWeights.size());
+
+  // De-interleave the position map into the position columns
+  size_t numberOfSpots = this->ScanSpotMetersetWeights.size() + metersetWeights.size();
+  this->ScanSpotPositionsX.reserve(numberOfSpots);
+  this->ScanSpotPositionsY.reserve(numberOfSpots);
+  for (size_t spot = 0; spot < metersetWeights.size(); ++spot)
+  {
+    this->ScanSpotPositionsX.push_back(positionMap[2 * spot]);
+    this->ScanSpotPositionsY.push_back(positionMap[2 * spot + 1]);
+  }
+  this->ScanSpotMetersetWeights.insert( this->ScanSpotMetersetWeights.end(),
+    metersetWeights.begin(), metersetWeights.end());
+  this->ScanSpotEnergyLayers.push_back(layer);
+
+  if (this->GetScanSpotTableNode())
+  {
+    this->UpdateScanSpotTableNode(this->GetScanSpotTableNode());
+  }
+  this->Modified();
+  this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
+  return static_cast<int>(this->ScanSpotEnergyLayers.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLRTIonBeamNode::RemoveAllScanSpots()
+{
+  if (this->ScanSpotEnergyLayers.empty() && this->ScanSpotMetersetWeights.empty())
+  {
+    return;
+  }
+
+  this->ScanSpotPositionsX.clear();
+  this->ScanSpotPositionsY.clear();
+  this->ScanSpotMetersetWeights.clear();
+  this->ScanSpotEnergyLayers.clear();
+
+  if (this->GetScanSpotTableNode())
+  {
+    this->UpdateScanSpotTableNode(this->GetScanSpotTableNode());
+  }
+  this->Modified();
+  this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
+}
+
+//----------------------------------------------------------------------------
+const vtkMRMLRTIonBeamNode::ScanSpotEnergyLayer* vtkMRMLRTIonBeamNode::GetScanSpotEnergyLayer(int layerIndex) const
+{
+  if (layerIndex < 0 || layerIndex >= static_cast<int>(this->ScanSpotEnergyLayers.size()))
+  {
+    vtkErrorMacro("GetScanSpotEnergyLayer: Invalid energy layer index " << layerIndex);
+    return nullptr;
+  }
+  return &this->ScanSpotEnergyLayers[layerIndex];
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLRTIonBeamNode::FindScanSpotEnergyLayer(double nominalBeamEnergy, double tolerance/*=1.e-3*/) const
+{
+  for (size_t layerIndex = 0; layerIndex < this->ScanSpotEnergyLayers.size(); ++layerIndex)
+  {
+    if (std::fabs(this->ScanSpotEnergyLayers[layerIndex].NominalBeamEnergy - nominalBeamEnergy) <= tolerance)
+    {
+      return static_cast<int>(layerIndex);
+    }
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLRTIonBeamNode::UpdateScanSpotTableNode(vtkMRMLTableNode* tableNode)
+{
+  if (!tableNode || !tableNode->GetTable())
+  {
+    vtkErrorMacro("UpdateScanSpotTableNode: Invalid table node");
+    return false;
+  }
+
+  vtkIdType numberOfSpots = this->GetNumberOfScanSpots();
+
+  // Fill typed columns directly, without going through variants
+  vtkNew<vtkDoubleArray> posX;
+  posX->SetName("X");
+  posX->SetNumberOfValues(numberOfSpots);
+  vtkNew<vtkDoubleArray> posY;
+  posY->SetName("Y");
+  posY->SetNumberOfValues(numberOfSpots);
+  vtkNew<vtkDoubleArray> msWeights;
+  msWeights->SetName("Weight");
+  msWeights->SetNumberOfValues(numberOfSpots);
+  for (vtkIdType spot = 0; spot < numberOfSpots; ++spot)
+  {
+    posX->SetValue( spot, this->ScanSpotPositionsX[spot]);
+    posY->SetValue( spot, this->ScanSpotPositionsY[spot]);
+    msWeights->SetValue( spot, this->ScanSpotMetersetWeights[spot]);
+  }
+
+  // The modified event of the table must not update the scan spot map from the table
+  bool wasUpdatingScanSpotTableNode = this->UpdatingScanSpotTableNode;
+  this->UpdatingScanSpotTableNode = true;
+  {
+    MRMLNodeModifyBlocker blocker(tableNode);
+    vtkTable* table = tableNode->GetTable();
+    table->Initialize();
+    table->AddColumn(posX);
+    table->AddColumn(posY);
+    table->AddColumn(msWeights);
+    tableNode->SetUseColumnNameAsColumnHeader(true);
+    tableNode->SetColumnDescription( "X", "Scan spot positions X");
+    tableNode->SetColumnDescription( "Y", "Scan spot positions Y");
+    tableNode->SetColumnDescription( "Weight", "Scan spot meterset weights");
+    tableNode->Modified();
+  }
+  this->UpdatingScanSpotTableNode = wasUpdatingScanSpotTableNode;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLRTIonBeamNode::UpdateScanSpotMapFromTableNode(vtkMRMLTableNode* tableNode)
+{
+  if (!tableNode || !tableNode->GetTable())
+  {
+    vtkErrorMacro("UpdateScanSpotMapFromTableNode: Invalid table node");
+    return false;
+  }
+  vtkTable* table = tableNode->GetTable();
+  vtkIdType numberOfSpots = table->GetNumberOfRows();
+  if (numberOfSpots <= 0)
+  {
+    return true;
+  }
+  if (table->GetNumberOfColumns() < 3)
+  {
+    vtkErrorMacro("UpdateScanSpotMapFromTableNode: Scan spot table must have X, Y and weight columns");
+    return false;
+  }
+
+  std::vector<float> positionsX(numberOfSpots);
+  std::vector<float> positionsY(numberOfSpots);
+  std::vector<float> metersetWeights(numberOfSpots);
+  for (vtkIdType spot = 0; spot < numberOfSpots; ++spot)
+  {
+    positionsX[spot] = table->GetValue( spot, 0).ToFloat();
+    positionsY[spot] = table->GetValue( spot, 1).ToFloat();
+    metersetWeights[spot] = table->GetValue( spot, 2).ToFloat();
+  }
+  if ( positionsX == this->ScanSpotPositionsX && positionsY == this->ScanSpotPositionsY
+    && metersetWeights == this->ScanSpotMetersetWeights )
+  {
+    return true;
+  }
+
+  // The energy layers are kept (also when only the layers have been read from the scene, and the spots
+  // are set from the table). Rows appended to the table are added to the last layer. Removing rows is
+  // rejected, as the layers the removed spots belonged to are not known.
+  vtkIdType numberOfLayerSpots = 0;
+  for (const ScanSpotEnergyLayer& layer : this->ScanSpotEnergyLayers)
+  {
+    numberOfLayerSpots += layer.NumberOfSpots;
+  }
+  if (this->ScanSpotEnergyLayers.empty())
+  {
+    ScanSpotEnergyLayer layer;
+    layer.NumberOfSpots = numberOfSpots;
+    this->ScanSpotEnergyLayers.push_back(layer);
+  }
+  else if (numberOfSpots > numberOfLayerSpots)
+  {
+    this->ScanSpotEnergyLayers.back().NumberOfSpots += numberOfSpots - numberOfLayerSpots;
+  }
+  else if (numberOfSpots < numberOfLayerSpots)
+  {
+    vtkErrorMacro("UpdateScanSpotMapFromTableNode: Scan spots cannot be removed from the table, as their energy layers "
+      "would not be known. The table is restored from the scan spot map");
+    if (!this->ScanSpotMetersetWeights.empty())
+    {
+      this->UpdateScanSpotTableNode(tableNode);
+    }
+    return false;
+  }
+  this->ScanSpotPositionsX.swap(positionsX);
+  this->ScanSpotPositionsY.swap(positionsY);
+  this->ScanSpotMetersetWeights.swap(metersetWeights);
+
+  this->Modified();
+  this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLRTIonBeamNode::CreateDefaultDisplayNodes()
 {
@@ -361,9 +754,19 @@ void vtkMRMLRTIonBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=n
   vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
   vtkSmartPointer<vtkCellArray> cellArray = vtkSmartPointer<vtkCellArray>::New();
 
-  // Scan spot position map & meterset weights
+  // Scan spot position map & meterset weights. The columnar scan spot map
+  // of the node is used if available, the table node otherwise
+  bool scanSpotMapAvailable = !this->ScanSpotMetersetWeights.empty();
   vtkMRMLTableNode* scanSpotTableNode = this->GetScanSpotTableNode();
-  if (scanSpotTableNode)
+  if (scanSpotTableNode && scanSpotTableNode->GetNumberOfRows() <= 0)
+  {
+    scanSpotTableNode = nullptr;
+  }
+  if (scanSpotMapAvailable)
+  {
+    vtkDebugMacro("CreateBeamPolyData: Valid scan spot map, number of scan spots = " << this->ScanSpotMetersetWeights.size());
+  }
+  else if (scanSpotTableNode)
   {
     vtkDebugMacro("CreateBeamPolyData: Valid scan spot parameters table node");
   }
@@ -409,19 +812,38 @@ void vtkMRMLRTIonBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=n
   bool yOpened = !vtkSlicerRtCommon::AreEqualWithTolerance( this->Y2Jaw, this->Y1Jaw);
 
   // Scanning spot beam
-  if (scanSpotTableNode)
-  {
-    std::vector<double> positionX, positionY;
-    vtkIdType rows = scanSpotTableNode->GetNumberOfRows();
-    positionX.resize(rows);
-    positionY.resize(rows);
-    // copy scan scot map data for processing
-    for (vtkIdType row = 0; row < rows; row++)
+  if (scanSpotMapAvailable || scanSpotTableNode)
+  {
+    double borderMinX = 0., borderMaxX = 0., borderMinY = 0., borderMaxY = 0.;
+    if (scanSpotMapAvailable)
+    {
+      // Position columns are contiguous, no copy is needed
+      auto rangeX = std::minmax_element( this->ScanSpotPositionsX.begin(), this->ScanSpotPositionsX.end());
+      auto rangeY = std::minmax_element( this->ScanSpotPositionsY.begin(), this->ScanSpotPositionsY.end());
+      borderMinX = *rangeX.first;
+      borderMaxX = *rangeX.second;
+      borderMinY = *rangeY.first;
+      borderMaxY = *rangeY.second;
+    }
+    else
     {
+      std::vector<double> positionX, positionY;
+      vtkIdType rows = scanSpotTableNode->GetNumberOfRows();
+      positionX.resize(rows);
+      positionY.resize(rows);
+      // copy scan scot map data for processing
       vtkTable* table = scanSpotTableNode->GetTable();
-      positionX[row] = table->GetValue( row, 0).ToDouble();
-      positionY[row] = table->GetValue( row, 1).ToDouble();
+      for (vtkIdType row = 0; row < rows; row++)
+      {
+        positionX[row] = table->GetValue( row, 0).ToDouble();
+        positionY[row] = table->GetValue( row, 1).ToDouble();
+      }
+      borderMinX = *std::min_element( positionX.begin(), positionX.end());
+      borderMaxX = *std::max_element( positionX.begin(), positionX.end());
+      borderMinY = *std::min_element( positionY.begin(), positionY.end());
+      borderMaxY = *std::max_element( positionY.begin(), positionY.end());
     }
+
     double beamTopCap = std::min( this->VSADx, this->VSADy);
     double beamBottomCap = -beamTopCap;
 
@@ -434,11 +856,6 @@ void vtkMRMLRTIonBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=n
     double sigmaX = this->ScanningSpotSize[0] * FWHM_TO_SIGMA;
     double sigmaY = this->ScanningSpotSize[1] * FWHM_TO_SIGMA;
 
-    double borderMinX = *std::min_element( positionX.begin(), positionX.end());
-    double borderMaxX = *std::max_element( positionX.begin(), positionX.end());
-    double borderMinY = *std::min_element( positionY.begin(), positionY.end());
-    double borderMaxY = *std::max_element( positionY.begin(), positionY.end());
-
     double sigmaX1 = M1x * sigmaX;
     double sigmaY1 = M1y * sigmaY;
 
@@ -28,7 +28,19 @@
 // MRML includes
 #include "vtkMRMLRTBeamNode.h"
 
+// STD includes
+#include <string>
+#include <vector>
+
 /// \ingroup SlicerRt_QtModules_Beams
+/// \brief Ion beam node
+///
+/// The scan spot map of a modulated beam is stored in the node in columnar form: the X and Y
+/// positions and the meterset weights of all the spots are kept in contiguous float arrays,
+/// ordered by energy layer, with a small index of energy layers (nominal energy, tune ID and
+/// spot range) next to them. The map is saved in the scene. The referenced scan spot table node
+/// is kept in sync with the map in both directions: changes of the map are written to the table,
+/// and edits of the table replace the spots of the map.
 class VTK_SLICER_BEAMS_MODULE_MRML_EXPORT vtkMRMLRTIonBeamNode : public vtkMRMLRTBeamNode
 {
 
@@ -46,6 +58,9 @@ public:
   /// Write this node's information to a MRML file in XML format. 
   void WriteXML(ostream& of, int indent) override;
 
+  /// Update the scan spot map from the scan spot table node when the table is edited
+  void ProcessMRMLEvents(vtkObject* caller, unsigned long eventID, void* callData) override;
+
   /// Copy the node's attributes to this object 
   void Copy(vtkMRMLNode *node) override;
 
@@ -115,12 +130,70 @@ public:
   /// Set isocenter to multi-leaf collimator distance. Triggers \sa BeamTransformModified event and re-generation of beam model
   void SetIsocenterToMultiLeafCollimatorDistance(double distance);
 
-  /// Set and observe scan spot position map & meterset weights table node
+  /// Set and observe scan spot position map & meterset weights table node.
+  /// If the scan spot map is not empty then the table is filled from it, otherwise the map is set from the table.
   /// Triggers \sa BeamGeometryModified event and re-generation of beam model
   void SetAndObserveScanSpotTableNode(vtkMRMLTableNode* node);
   /// Get scan spot position map & meterset weights table node
   vtkMRMLTableNode* GetScanSpotTableNode();
 
+public:
+  /// Energy layer of the scan spot map. The spots of the layer are stored
+  /// contiguously in the scan spot arrays starting from FirstSpotIndex
+  struct ScanSpotEnergyLayer
+  {
+    /// Nominal beam energy of the layer (MeV/u)
+    double NominalBeamEnergy{ 0. };
+    /// Scan spot tune ID of the layer
+    std::string ScanSpotTuneId;
+    /// Index of the first spot of the layer in the scan spot arrays
+    vtkIdType FirstSpotIndex{ 0 };
+    /// Number of spots in the layer
+    vtkIdType NumberOfSpots{ 0 };
+  };
+
+  /// Add energy layer to the scan spot map
+  /// Triggers \sa BeamGeometryModified event and re-generation of beam model
+  /// \param positionMap Scan spot positions as in DICOM ScanSpotPositionMap (x0, y0, x1, y1, ...)
+  /// \param metersetWeights Scan spot meterset weights, one for each position
+  /// \return Index of the added energy layer, -1 on failure
+  int AddScanSpotEnergyLayer( double nominalBeamEnergy, const char* scanSpotTuneId,
+    const std::vector<float>& positionMap, const std::vector<float>& metersetWeights);
+  /// Remove all energy layers and scan spots from the scan spot map
+  /// Triggers \sa BeamGeometryModified event and re-generation of beam model
+  void RemoveAllScanSpots();
+
+  /// Get number of energy layers in the scan spot map
+  int GetNumberOfScanSpotEnergyLayers() const { return static_cast<int>(this->ScanSpotEnergyLayers.size()); };
+  /// Get energy layer of the scan spot map
+  /// \return Energy layer, nullptr if the index is invalid
+  const ScanSpotEnergyLayer* GetScanSpotEnergyLayer(int layerIndex) const;
+  /// Find energy layer of the scan spot map by nominal beam energy
+  /// \return Index of the energy layer, -1 if not found
+  int FindScanSpotEnergyLayer(double nominalBeamEnergy, double tolerance=1.e-3) const;
+
+  /// Get number of scan spots in all energy layers
+  vtkIdType GetNumberOfScanSpots() const { return static_cast<vtkIdType>(this->ScanSpotMetersetWeights.size()); };
+  /// Get scan spot X positions of all energy layers (\sa GetNumberOfScanSpots values)
+  const float* GetScanSpotPositionsX() const { return this->ScanSpotPositionsX.data(); };
+  /// Get scan spot Y positions of all energy layers (\sa GetNumberOfScanSpots values)
+  const float* GetScanSpotPositionsY() const { return this->ScanSpotPositionsY.data(); };
+  /// Get scan spot meterset weights of all energy layers (\sa GetNumberOfScanSpots values)
+  const float* GetScanSpotMetersetWeights() const { return this->ScanSpotMetersetWeights.data(); };
+
+  /// Fill table node with the scan spot map (columns "X", "Y" and "Weight").
+  /// Only edits of the table referenced by \sa SetAndObserveScanSpotTableNode change the scan spot map.
+  /// \return Success flag
+  bool UpdateScanSpotTableNode(vtkMRMLTableNode* tableNode);
+
+  /// Set the spots of the scan spot map from a table node (columns X, Y and weight).
+  /// Energy layers are kept. Rows appended to the table are added to the last energy layer,
+  /// and removing rows is rejected. An empty table (e.g. not loaded yet) does not change the map.
+  /// Only the energy layers are saved in the scene, the spots are set from the table when it is loaded.
+  /// Triggers \sa BeamGeometryModified event and re-generation of beam model
+  /// \return Success flag
+  bool UpdateScanSpotMapFromTableNode(vtkMRMLTableNode* tableNode);
+
 protected:
   /// Create beam model from beam parameters, supporting MLC leaves, jaws
   /// and scan spot map for modulated scan mode
@@ -153,6 +226,17 @@ protected:
   double IsocenterToRangeShifterDistance;
 
   float ScanningSpotSize[2];
+
+  /// Scan spot X positions of all energy layers
+  std::vector<float> ScanSpotPositionsX;
+  /// Scan spot Y positions of all energy layers
+  std::vector<float> ScanSpotPositionsY;
+  /// Scan spot meterset weights of all energy layers
+  std::vector<float> ScanSpotMetersetWeights;
+  /// Energy layers of the scan spot map
+  std::vector<ScanSpotEnergyLayer> ScanSpotEnergyLayers;
+  /// Flag indicating that the scan spot table node is being filled from the map, so its modification is ignored
+  bool UpdatingScanSpotTableNode{ false };
 };
 
 #endif // __vtkMRMLRTIonBeamNode_h
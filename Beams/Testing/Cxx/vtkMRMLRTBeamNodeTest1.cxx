@@ -0,0 +1,342 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Beams includes
+#include "vtkMRMLRTBeamNode.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  void CountEvent(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+  {
+    ++(*static_cast<int*>(clientData));
+  }
+
+  //---------------------------------------------------------------------------
+  /// Count the event and update the beam model, as the beams logic does on beam geometry modified
+  void CountEventAndUpdateGeometry(vtkObject* caller, unsigned long eid, void* clientData, void* callData)
+  {
+    CountEvent(caller, eid, clientData, callData);
+    vtkMRMLRTBeamNode::SafeDownCast(caller)->UpdateGeometry();
+  }
+
+  //---------------------------------------------------------------------------
+  /// Check that two poly data have the same points and polygons
+  bool ArePolyDataEqual(vtkPolyData* polyData1, vtkPolyData* polyData2)
+  {
+    if ( polyData1->GetNumberOfPoints() != polyData2->GetNumberOfPoints()
+      || polyData1->GetNumberOfPolys() != polyData2->GetNumberOfPolys() )
+    {
+      return false;
+    }
+    for (vtkIdType pointId = 0; pointId < polyData1->GetNumberOfPoints(); ++pointId)
+    {
+      double point1[3] = { 0.0, 0.0, 0.0 };
+      double point2[3] = { 0.0, 0.0, 0.0 };
+      polyData1->GetPoint(pointId, point1);
+      polyData2->GetPoint(pointId, point2);
+      if (point1[0] != point2[0] || point1[1] != point2[1] || point1[2] != point2[2])
+      {
+        return false;
+      }
+    }
+    vtkCellArray* polys1 = polyData1->GetPolys();
+    vtkCellArray* polys2 = polyData2->GetPolys();
+    vtkNew<vtkIdList> pointIds1;
+    vtkNew<vtkIdList> pointIds2;
+    polys2->InitTraversal();
+    for (polys1->InitTraversal(); polys1->GetNextCell(pointIds1); )
+    {
+      if (!polys2->GetNextCell(pointIds2) || pointIds1->GetNumberOfIds() != pointIds2->GetNumberOfIds())
+      {
+        return false;
+      }
+      for (vtkIdType index = 0; index < pointIds1->GetNumberOfIds(); ++index)
+      {
+        if (pointIds1->GetId(index) != pointIds2->GetId(index))
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  /// Check that the geometry of the beam is that of the expected control point
+  bool IsBeamGeometry(vtkMRMLRTBeamNode* beamNode, vtkMRMLTableNode* mlcTableNode,
+    double gantryAngle, double collimatorAngle, const double jaws[4], const std::vector<double>& leafPositions)
+  {
+    if ( beamNode->GetGantryAngle() != gantryAngle || beamNode->GetCollimatorAngle() != collimatorAngle
+      || beamNode->GetX1Jaw() != jaws[0] || beamNode->GetX2Jaw() != jaws[1]
+      || beamNode->GetY1Jaw() != jaws[2] || beamNode->GetY2Jaw() != jaws[3] )
+    {
+      std::cerr << "Beam angles or jaws differ from the control point: gantry " << beamNode->GetGantryAngle()
+        << ", collimator " << beamNode->GetCollimatorAngle() << ", X1 jaw " << beamNode->GetX1Jaw() << std::endl;
+      return false;
+    }
+    vtkTable* table = mlcTableNode->GetTable();
+    vtkIdType numberOfLeafPairs = static_cast<vtkIdType>(leafPositions.size() / 2);
+    for (vtkIdType leafPair = 0; leafPair < numberOfLeafPairs; ++leafPair)
+    {
+      if ( table->GetValue(leafPair, 1).ToDouble() != leafPositions[leafPair]
+        || table->GetValue(leafPair, 2).ToDouble() != leafPositions[leafPair + numberOfLeafPairs] )
+      {
+        std::cerr << "Leaf pair " << leafPair << " differs from the control point: "
+          << table->GetValue(leafPair, 1).ToDouble() << ", " << table->GetValue(leafPair, 2).ToDouble() << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  /// Split the attributes written by WriteXML into alternating names and values
+  std::vector<std::string> GetXMLAttributes(const std::string& xml)
+  {
+    std::vector<std::string> attributes;
+    size_t position = 0;
+    while ((position = xml.find("=\"", position)) != std::string::npos)
+    {
+      size_t nameBegin = xml.rfind(' ', position) + 1;
+      size_t valueEnd = xml.find('"', position + 2);
+      attributes.push_back(xml.substr(nameBegin, position - nameBegin));
+      attributes.push_back(xml.substr(position + 2, valueEnd - position - 2));
+      position = valueEnd + 1;
+    }
+    return attributes;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int vtkMRMLRTBeamNodeTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkMRMLRTBeamNode> beamNode;
+  beamNode->SetName("Arc");
+  mrmlScene->AddNode(beamNode);
+
+  // MLC table with three leaf pairs (last row holds the last boundary only)
+  vtkNew<vtkMRMLTableNode> mlcTableNode;
+  mlcTableNode->SetName("MLCX_BoundaryAndPosition");
+  mrmlScene->AddNode(mlcTableNode);
+  vtkTable* table = mlcTableNode->GetTable();
+  const char* columnNames[3] = { "Boundary", "1", "2" };
+  for (const char* columnName : columnNames)
+  {
+    vtkNew<vtkDoubleArray> column;
+    column->SetName(columnName);
+    table->AddColumn(column);
+  }
+  table->SetNumberOfRows(4);
+  for (vtkIdType row = 0; row < 4; ++row)
+  {
+    table->SetValue(row, 0, -15.0 + 10.0 * row);
+    table->SetValue(row, 1, 0.0);
+    table->SetValue(row, 2, 0.0);
+  }
+  beamNode->SetAndObserveMultiLeafCollimatorTableNode(mlcTableNode);
+
+  //
+  // Control point store: leaf positions of a control point without leaf positions are carried over
+  double jaws0[4] = { -50.0, 50.0, -40.0, 40.0 };
+  double jaws1[4] = { -45.0, 45.0, -40.0, 40.0 };
+  double jaws2[4] = { -40.0, 40.0, -35.0, 35.0 };
+  std::vector<double> leaves0 = { -10.0, -20.0, -30.0, 10.0, 20.0, 30.0 };
+  std::vector<double> leaves2 = { -5.0, -15.0, -25.0, 5.0, 15.0, 25.0 };
+  if ( beamNode->AddControlPoint(0.0, 10.0, 0.0, jaws0, 0.0, leaves0) != 0
+    || beamNode->AddControlPoint(2.0, 10.0, 0.0, jaws1, 0.5, std::vector<double>()) != 1
+    || beamNode->AddControlPoint(4.0, 10.0, 0.0, jaws2, 1.0, leaves2) != 2 )
+  {
+    std::cerr << __LINE__ << ": Failed to add control points" << std::endl;
+    return EXIT_FAILURE;
+  }
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  int invalidControlPointIndex = beamNode->AddControlPoint(6.0, 10.0, 0.0, jaws2, 1.0, std::vector<double>(4, 0.0));
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  if (invalidControlPointIndex != -1 || beamNode->GetNumberOfControlPoints() != 3
+    || beamNode->GetControlPointCumulativeMetersetWeight(1) != 0.5 || beamNode->GetCurrentControlPointIndex() != -1)
+  {
+    std::cerr << __LINE__ << ": Control point with different number of leaves is added to the control point store" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Setting a control point to the beam materializes its geometry with a single geometry modified event
+  int geometryModifiedEvents = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountEvent);
+  callback->SetClientData(&geometryModifiedEvents);
+  beamNode->AddObserver(vtkMRMLRTBeamNode::BeamGeometryModified, callback);
+
+  if ( !beamNode->SetCurrentControlPointIndex(1) || beamNode->GetCurrentControlPointIndex() != 1
+    || !IsBeamGeometry(beamNode, mlcTableNode, 2.0, 10.0, jaws1, leaves0) )
+  {
+    std::cerr << __LINE__ << ": Geometry of control point 1 is not set to the beam" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (geometryModifiedEvents != 1)
+  {
+    std::cerr << __LINE__ << ": Beam geometry modified event invoked " << geometryModifiedEvents << " times instead of once" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if ( !beamNode->SetCurrentControlPointIndex(2)
+    || !IsBeamGeometry(beamNode, mlcTableNode, 4.0, 10.0, jaws2, leaves2) )
+  {
+    std::cerr << __LINE__ << ": Geometry of control point 2 is not set to the beam" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  bool invalidIndexSet = beamNode->SetCurrentControlPointIndex(3);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  if (invalidIndexSet || beamNode->GetCurrentControlPointIndex() != 2)
+  {
+    std::cerr << __LINE__ << ": Invalid control point index is set to the beam" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // The control point store is copied with the beam
+  vtkNew<vtkMRMLRTBeamNode> copiedBeamNode;
+  copiedBeamNode->Copy(beamNode);
+  if ( copiedBeamNode->GetNumberOfControlPoints() != 3
+    || copiedBeamNode->GetControlPointCumulativeMetersetWeight(2) != 1.0 )
+  {
+    std::cerr << __LINE__ << ": Control points are not copied with the beam" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // The control point store and the current control point are saved with the scene
+  std::stringstream beamNodeXml;
+  beamNode->WriteXML(beamNodeXml, 0);
+  std::vector<std::string> attributes = GetXMLAttributes(beamNodeXml.str());
+  std::vector<const char*> atts;
+  for (const std::string& attribute : attributes)
+  {
+    atts.push_back(attribute.c_str());
+  }
+  atts.push_back(nullptr);
+  vtkNew<vtkMRMLRTBeamNode> readBeamNode;
+  readBeamNode->ReadXMLAttributes(atts.data());
+  if ( readBeamNode->GetNumberOfControlPoints() != 3 || readBeamNode->GetCurrentControlPointIndex() != 2
+    || readBeamNode->GetControlPointCumulativeMetersetWeight(1) != 0.5 )
+  {
+    std::cerr << __LINE__ << ": Control points are not read from the scene: " << readBeamNode->GetNumberOfControlPoints()
+      << " control points, current control point " << readBeamNode->GetCurrentControlPointIndex() << std::endl;
+    return EXIT_FAILURE;
+  }
+  mrmlScene->AddNode(readBeamNode);
+  readBeamNode->SetAndObserveMultiLeafCollimatorTableNode(mlcTableNode);
+  if ( !readBeamNode->SetCurrentControlPointIndex(1)
+    || !IsBeamGeometry(readBeamNode, mlcTableNode, 2.0, 10.0, jaws1, leaves0)
+    || !readBeamNode->SetCurrentControlPointIndex(0)
+    || !IsBeamGeometry(readBeamNode, mlcTableNode, 0.0, 10.0, jaws0, leaves0) )
+  {
+    std::cerr << __LINE__ << ": Control points read from the scene differ from the saved ones" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  beamNode->RemoveObserver(callback);
+
+  //
+  // Geometry changes of a beam without MLC inside a modify block invoke a single geometry modified event,
+  // and the beam model is updated in place to the same poly data as a full regeneration
+  vtkNew<vtkMRMLRTBeamNode> staticBeamNode;
+  staticBeamNode->SetName("Static");
+  mrmlScene->AddNode(staticBeamNode);
+  vtkPolyData* beamModelPolyData = staticBeamNode->GetPolyData();
+  vtkCellArray* beamModelPolys = (beamModelPolyData ? beamModelPolyData->GetPolys() : nullptr);
+  if (!beamModelPolys || beamModelPolyData->GetNumberOfPoints() != 5)
+  {
+    std::cerr << __LINE__ << ": Beam without MLC does not have the default beam model" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int staticGeometryModifiedEvents = 0;
+  vtkNew<vtkCallbackCommand> updateCallback;
+  updateCallback->SetCallback(CountEventAndUpdateGeometry);
+  updateCallback->SetClientData(&staticGeometryModifiedEvents);
+  staticBeamNode->AddObserver(vtkMRMLRTBeamNode::BeamGeometryModified, updateCallback);
+
+  int wasModifying = staticBeamNode->StartModify();
+  staticBeamNode->SetX1Jaw(-35.0);
+  staticBeamNode->SetX2Jaw(55.0);
+  staticBeamNode->SetY1Jaw(-25.0);
+  staticBeamNode->SetY2Jaw(45.0);
+  staticBeamNode->SetSAD(1000.0);
+  staticBeamNode->EndModify(wasModifying);
+  if (staticGeometryModifiedEvents != 1)
+  {
+    std::cerr << __LINE__ << ": Beam geometry modified event invoked " << staticGeometryModifiedEvents
+      << " times instead of once for the changes in a modify block" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (staticBeamNode->GetPolyData() != beamModelPolyData || beamModelPolyData->GetPolys() != beamModelPolys)
+  {
+    std::cerr << __LINE__ << ": Beam model is regenerated instead of moving its vertices" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkNew<vtkPolyData> regeneratedPolyData;
+  staticBeamNode->CreateBeamPolyData(regeneratedPolyData);
+  double* sourcePoint = beamModelPolyData->GetPoint(0);
+  if (!ArePolyDataEqual(beamModelPolyData, regeneratedPolyData) || sourcePoint[2] != 1000.0)
+  {
+    std::cerr << __LINE__ << ": Updated beam model differs from the regenerated one" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Setting the current values again does not invoke the event, setting all jaws at once invokes it once
+  staticBeamNode->SetJawPositions(-35.0, 55.0, -25.0, 45.0);
+  staticBeamNode->SetSAD(1000.0);
+  if (staticGeometryModifiedEvents != 1)
+  {
+    std::cerr << __LINE__ << ": Beam geometry modified event invoked for unchanged geometry" << std::endl;
+    return EXIT_FAILURE;
+  }
+  staticBeamNode->SetJawPositions(-20.0, 30.0, -40.0, 10.0);
+  staticBeamNode->CreateBeamPolyData(regeneratedPolyData);
+  if ( staticGeometryModifiedEvents != 2 || beamModelPolyData->GetPolys() != beamModelPolys
+    || !ArePolyDataEqual(beamModelPolyData, regeneratedPolyData) )
+  {
+    std::cerr << __LINE__ << ": Setting all jaws invoked " << staticGeometryModifiedEvents - 1
+      << " geometry modified events, or the updated beam model differs from the regenerated one" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  staticBeamNode->RemoveObserver(updateCallback);
+  return EXIT_SUCCESS;
+}
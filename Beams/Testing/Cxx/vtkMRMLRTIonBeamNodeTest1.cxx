@@ -0,0 +1,196 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Beams includes
+#include "vtkMRMLRTIonBeamNode.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  /// Check that the scan spot table has the scan spots of the scan spot map of the beam
+  bool IsScanSpotTableInSync(vtkMRMLRTIonBeamNode* beamNode, vtkMRMLTableNode* tableNode)
+  {
+    vtkTable* table = tableNode->GetTable();
+    if (table->GetNumberOfRows() != beamNode->GetNumberOfScanSpots() || table->GetNumberOfColumns() != 3)
+    {
+      std::cerr << "Scan spot table has " << table->GetNumberOfRows() << " rows instead of "
+        << beamNode->GetNumberOfScanSpots() << std::endl;
+      return false;
+    }
+    for (vtkIdType spot = 0; spot < beamNode->GetNumberOfScanSpots(); ++spot)
+    {
+      if ( table->GetValue(spot, 0).ToFloat() != beamNode->GetScanSpotPositionsX()[spot]
+        || table->GetValue(spot, 1).ToFloat() != beamNode->GetScanSpotPositionsY()[spot]
+        || table->GetValue(spot, 2).ToFloat() != beamNode->GetScanSpotMetersetWeights()[spot] )
+      {
+        std::cerr << "Scan spot " << spot << " differs in the scan spot table" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int vtkMRMLRTIonBeamNodeTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkMRMLRTIonBeamNode> beamNode;
+
+  // Two energy layers, the tune ID of the second one contains the separator used in the scene file.
+  // They are added before adding the beam to the scene, so that the beam model is created from the scan spots.
+  std::vector<float> positionMap1 = { -10.0f, -10.0f, 10.0f, -10.0f, 0.1f, 12.345678f };
+  std::vector<float> weights1 = { 0.5f, 0.25f, 1.0f / 3.0f };
+  std::vector<float> positionMap2 = { 5.0f, 5.0f, -5.0f, 5.0f };
+  std::vector<float> weights2 = { 0.75f, 0.125f };
+  if (beamNode->AddScanSpotEnergyLayer(100.0, "Spot 4mm", positionMap1, weights1) != 0
+    || beamNode->AddScanSpotEnergyLayer(120.5, "Tune;50%", positionMap2, weights2) != 1)
+  {
+    std::cerr << __LINE__ << ": Failed to add scan spot energy layers" << std::endl;
+    return EXIT_FAILURE;
+  }
+  mrmlScene->AddNode(beamNode);
+
+  //
+  // Map to table: the referenced table is filled from the map, and follows its changes
+  vtkNew<vtkMRMLTableNode> tableNode;
+  mrmlScene->AddNode(tableNode);
+  beamNode->SetAndObserveScanSpotTableNode(tableNode);
+  if (!IsScanSpotTableInSync(beamNode, tableNode))
+  {
+    std::cerr << __LINE__ << ": Scan spot table is not filled from the scan spot map" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::vector<float> positionMap3 = { 1.0f, 2.0f };
+  std::vector<float> weights3 = { 0.5f };
+  beamNode->AddScanSpotEnergyLayer(140.0, "Spot 4mm", positionMap3, weights3);
+  if (!IsScanSpotTableInSync(beamNode, tableNode))
+  {
+    std::cerr << __LINE__ << ": Scan spot table is not updated with the added energy layer" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Table to map: editing a value keeps the energy layers, an appended spot is added to the last layer
+  tableNode->GetTable()->SetValue(3, 0, 42.0);
+  tableNode->Modified();
+  if (beamNode->GetScanSpotPositionsX()[3] != 42.0f || beamNode->GetNumberOfScanSpotEnergyLayers() != 3)
+  {
+    std::cerr << __LINE__ << ": Edited scan spot table is not applied to the scan spot map" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkIdType newRow = tableNode->GetTable()->InsertNextBlankRow();
+  tableNode->GetTable()->SetValue(newRow, 0, -20.0);
+  tableNode->GetTable()->SetValue(newRow, 1, 20.0);
+  tableNode->GetTable()->SetValue(newRow, 2, 0.5);
+  tableNode->Modified();
+  const vtkMRMLRTIonBeamNode::ScanSpotEnergyLayer* firstLayer = beamNode->GetScanSpotEnergyLayer(0);
+  const vtkMRMLRTIonBeamNode::ScanSpotEnergyLayer* lastLayer = beamNode->GetScanSpotEnergyLayer(2);
+  if ( beamNode->GetNumberOfScanSpots() != 7 || beamNode->GetNumberOfScanSpotEnergyLayers() != 3
+    || !firstLayer || firstLayer->NumberOfSpots != 3 || firstLayer->NominalBeamEnergy != 100.0
+    || !lastLayer || lastLayer->FirstSpotIndex != 5 || lastLayer->NumberOfSpots != 2 || lastLayer->NominalBeamEnergy != 140.0
+    || beamNode->GetScanSpotPositionsX()[6] != -20.0f || !IsScanSpotTableInSync(beamNode, tableNode) )
+  {
+    std::cerr << __LINE__ << ": Scan spot added to the table is not added to the last energy layer" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Removing a spot from the table is rejected, and the table is restored from the map
+  tableNode->GetTable()->RemoveRow(0);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  tableNode->Modified();
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  if ( beamNode->GetNumberOfScanSpots() != 7 || beamNode->GetNumberOfScanSpotEnergyLayers() != 3
+    || beamNode->GetScanSpotPositionsX()[0] != -10.0f || !IsScanSpotTableInSync(beamNode, tableNode) )
+  {
+    std::cerr << __LINE__ << ": Scan spot removed from the table is applied to the scan spot map" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Scene persistence: only the energy layers are saved with the beam, the spots are saved in the table
+  beamNode->RemoveAllScanSpots();
+  beamNode->AddScanSpotEnergyLayer(100.0, "Spot 4mm", positionMap1, weights1);
+  beamNode->AddScanSpotEnergyLayer(120.5, "Tune;50%", positionMap2, weights2);
+  mrmlScene->SetSaveToXMLString(1);
+  mrmlScene->Commit();
+  std::string sceneXML = mrmlScene->GetSceneXMLString();
+  if (sceneXML.find("ScanSpotEnergyLayerEnergies") == std::string::npos || sceneXML.find("ScanSpotPositionsX") != std::string::npos)
+  {
+    std::cerr << __LINE__ << ": Scene does not contain only the energy layers of the scan spot map" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkMRMLScene> loadedScene;
+  vtkNew<vtkMRMLRTIonBeamNode> ionBeamNodeClass;
+  loadedScene->RegisterNodeClass(ionBeamNodeClass);
+  loadedScene->SetLoadFromXMLString(1);
+  loadedScene->SetSceneXMLString(sceneXML);
+  loadedScene->Import();
+  vtkMRMLRTIonBeamNode* loadedBeamNode = vtkMRMLRTIonBeamNode::SafeDownCast(loadedScene->GetNodeByID(beamNode->GetID()));
+  vtkMRMLTableNode* loadedTableNode = (loadedBeamNode ? loadedBeamNode->GetScanSpotTableNode() : nullptr);
+  if (!loadedTableNode)
+  {
+    std::cerr << __LINE__ << ": Scan spot table is not referenced by the loaded beam" << std::endl;
+    return EXIT_FAILURE;
+  }
+  // Table contents are read by its storage node, which is not used when loading from a string
+  loadedTableNode->GetTable()->DeepCopy(tableNode->GetTable());
+  loadedTableNode->Modified();
+  if (loadedBeamNode->GetNumberOfScanSpotEnergyLayers() != 2
+    || loadedBeamNode->GetNumberOfScanSpots() != beamNode->GetNumberOfScanSpots())
+  {
+    std::cerr << __LINE__ << ": Scan spot map is not loaded from the scene" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int layerIndex = 0; layerIndex < 2; ++layerIndex)
+  {
+    const vtkMRMLRTIonBeamNode::ScanSpotEnergyLayer* layer = beamNode->GetScanSpotEnergyLayer(layerIndex);
+    const vtkMRMLRTIonBeamNode::ScanSpotEnergyLayer* loadedLayer = loadedBeamNode->GetScanSpotEnergyLayer(layerIndex);
+    if ( loadedLayer->NominalBeamEnergy != layer->NominalBeamEnergy || loadedLayer->ScanSpotTuneId != layer->ScanSpotTuneId
+      || loadedLayer->FirstSpotIndex != layer->FirstSpotIndex || loadedLayer->NumberOfSpots != layer->NumberOfSpots )
+    {
+      std::cerr << __LINE__ << ": Energy layer " << layerIndex << " differs after loading the scene: "
+        << loadedLayer->NominalBeamEnergy << " MeV, tune ID " << loadedLayer->ScanSpotTuneId << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  for (vtkIdType spot = 0; spot < beamNode->GetNumberOfScanSpots(); ++spot)
+  {
+    if ( loadedBeamNode->GetScanSpotPositionsX()[spot] != beamNode->GetScanSpotPositionsX()[spot]
+      || loadedBeamNode->GetScanSpotPositionsY()[spot] != beamNode->GetScanSpotPositionsY()[spot]
+      || loadedBeamNode->GetScanSpotMetersetWeights()[spot] != beamNode->GetScanSpotMetersetWeights()[spot] )
+    {
+      std::cerr << __LINE__ << ": Scan spot " << spot << " differs after loading the scene" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -258,6 +258,45 @@ int vtkSlicerIECTransformLogicTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)
     return EXIT_FAILURE;
     }
 
+  //
+  // Test cached transform matrices
+
+  // Bulk query of all frame to frame matrices for the beam
+  vtkSlicerIECTransformLogic::TransformMatrixMap transformMatrices;
+  if (!iecLogic->GetTransformMatricesForBeam(beamNode, transformMatrices))
+  {
+    std::cerr << __LINE__ << ": Failed to get transform matrices for beam" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkSmartPointer<vtkMatrix4x4> beamMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  beamTransformNode->GetMatrixTransformToParent(beamMatrix);
+  if (!IsEqual(transformMatrices[std::make_pair(vtkSlicerIECTransformLogic::Collimator, vtkSlicerIECTransformLogic::RAS)], beamMatrix))
+  {
+    std::cerr << __LINE__ << ": Collimator to RAS matrix from bulk query does not match beam transform" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Cached matrices are updated when an angle changes
+  beamNode->SetGantryAngle(1.0);
+  beamNode->SetCollimatorAngle(1.0);
+  iecLogic->UpdateBeamTransform(beamNode);
+  vtkSmartPointer<vtkMatrix4x4> collimatorToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  iecLogic->GetTransformMatrixBetween(vtkSlicerIECTransformLogic::Collimator, vtkSlicerIECTransformLogic::RAS, collimatorToRasMatrix);
+  double expectedBeamTransform_Gantry1Collimator1_MatrixElements[16] =
+    {  -0.999695, 0.0174497, -0.0174524, 1000,   -0.0174497, 0.000304586, 0.999848, 200,   0.0174524, 0.999848, 0, 0,   0, 0, 0, 1  };
+  if ( !IsTransformMatrixEqualTo(mrmlScene,
+      beamTransformNode, expectedBeamTransform_Gantry1Collimator1_MatrixElements ) )
+  {
+    std::cerr << __LINE__ << ": Beam transform does not match baseline for gantry and collimator 1 degree angle" << std::endl;
+    return EXIT_FAILURE;
+  }
+  beamTransformNode->GetMatrixTransformToParent(beamMatrix);
+  if (!IsEqual(collimatorToRasMatrix, beamMatrix))
+  {
+    std::cerr << __LINE__ << ": Cached Collimator to RAS matrix does not match beam transform" << std::endl;
+    return EXIT_FAILURE;
+  }
+
   //TODO: Test code to print all non-identity transforms (useful to add more test cases)
   //std::cout << "ZZZ after collimator angle 90:" << std::endl;
   //PrintLinearTransformNodeMatrices(mrmlScene, false, true);
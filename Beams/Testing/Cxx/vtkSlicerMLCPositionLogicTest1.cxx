@@ -0,0 +1,373 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Beams includes
+#include "vtkMRMLRTBeamNode.h"
+#include "vtkMRMLRTPlanNode.h"
+#include "vtkSlicerBeamsModuleLogic.h"
+#include "vtkSlicerIECTransformLogic.h"
+#include "vtkSlicerMLCPositionLogic.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLMarkupsCurveNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
+#include <vtkMRMLTransformNode.h>
+
+// VTK includes
+#include <vtkCubeSource.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTable.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Parameters of the beam's eye view fitting checked against the reference leaf positions
+  struct FittingOptions
+  {
+    double Margin;
+    double LeafEndRadius;
+    bool ParallelBeam;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Reference leaf positions of an MLCX for a box target, which is axis aligned in the beam frame.
+  /// The projection of the box section at height z from a source at height SAD is the box rectangle
+  /// scaled by SAD / (SAD - z), so the sections seen by a leaf pair strip are found analytically
+  /// from the range of scales whose rectangle overlaps the strip. A rounded leaf end is retracted
+  /// so that the ray from the source tangent to its arc passes through the fitted position.
+  /// @param boxCenter - center of the box in the beam frame, it must be on the isocenter plane (Z=0)
+  /// @param opened - output, flag per leaf pair if the projected box overlaps with its strip
+  void CalculateBoxReferenceLeafPositions( const std::vector<double>& boundaries, const double boxCenter[3],
+    const double boxHalfSize[3], const FittingOptions& options, double sad, double sourceToMLCDistance,
+    std::vector<double>& side1, std::vector<double>& side2, std::vector<bool>& opened)
+  {
+    double minScale = options.ParallelBeam ? 1. : sad / (sad + boxHalfSize[2]);
+    double maxScale = options.ParallelBeam ? 1. : sad / (sad - boxHalfSize[2]);
+    double x0 = boxCenter[0] - boxHalfSize[0];
+    double x1 = boxCenter[0] + boxHalfSize[0];
+    double y0 = boxCenter[1] - boxHalfSize[1];
+    double y1 = boxCenter[1] + boxHalfSize[1];
+
+    size_t nofLeafPairs = boundaries.size() - 1;
+    side1.assign( nofLeafPairs, 0.);
+    side2.assign( nofLeafPairs, 0.);
+    opened.assign( nofLeafPairs, false);
+    for ( size_t leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+    {
+      // Scales where the projected rectangle overlaps the strip: scale * y0 <= stripEnd and scale * y1 >= stripBegin
+      double stripBegin = boundaries[leafPair] - options.Margin;
+      double stripEnd = boundaries[leafPair + 1] + options.Margin;
+      double lowScale = minScale;
+      double highScale = maxScale;
+      if (y0 > 0.)
+      {
+        highScale = std::min( highScale, stripEnd / y0);
+      }
+      else if (y0 < 0.)
+      {
+        lowScale = std::max( lowScale, stripEnd / y0);
+      }
+      else if (stripEnd < 0.)
+      {
+        continue;
+      }
+      if (y1 > 0.)
+      {
+        lowScale = std::max( lowScale, stripBegin / y1);
+      }
+      else if (y1 < 0.)
+      {
+        highScale = std::min( highScale, stripBegin / y1);
+      }
+      else if (stripBegin > 0.)
+      {
+        continue;
+      }
+      if (lowScale > highScale)
+      {
+        continue;
+      }
+
+      double position1 = std::min( lowScale * x0, highScale * x0) - options.Margin;
+      double position2 = std::max( lowScale * x1, highScale * x1) + options.Margin;
+      double tanTheta1 = position1 / sad;
+      double tanTheta2 = position2 / sad;
+      side1[leafPair] = position1 - options.LeafEndRadius * (std::sqrt(1. + tanTheta1 * tanTheta1) - 1.) * sad / sourceToMLCDistance;
+      side2[leafPair] = position2 + options.LeafEndRadius * (std::sqrt(1. + tanTheta2 * tanTheta2) - 1.) * sad / sourceToMLCDistance;
+      opened[leafPair] = true;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerMLCPositionLogicTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerIECTransformLogic> iecLogic;
+  iecLogic->SetMRMLScene(mrmlScene);
+  iecLogic->BuildIECTransformHierarchy();
+  vtkNew<vtkSlicerBeamsModuleLogic> beamsLogic;
+  beamsLogic->SetMRMLScene(mrmlScene);
+  vtkSlicerMLCPositionLogic* mlcLogic = beamsLogic->GetMLCPositionLogic();
+
+  vtkNew<vtkMRMLRTBeamNode> beamNode;
+  mrmlScene->AddNode(beamNode);
+  vtkNew<vtkMRMLRTPlanNode> planNode;
+  mrmlScene->AddNode(planNode);
+  planNode->AddBeam(beamNode);
+  vtkMRMLTransformNode* beamTransformNode = beamNode->GetParentTransformNode();
+  if (!beamTransformNode)
+  {
+    std::cerr << __LINE__ << ": Beam node does not have a valid beam transform node" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Synthetic target: sphere of 25mm radius at the isocenter, off the leaf pair boundaries across the leaves.
+  // It is created in the beam frame and transformed to RAS.
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetCenter(3.0, 4.0, 0.0);
+  sphereSource->SetRadius(25.0);
+  sphereSource->SetThetaResolution(48);
+  sphereSource->SetPhiResolution(48);
+  vtkNew<vtkMatrix4x4> beamToWorldMatrix;
+  beamTransformNode->GetMatrixTransformToWorld(beamToWorldMatrix);
+  vtkNew<vtkTransform> beamToWorldTransform;
+  beamToWorldTransform->SetMatrix(beamToWorldMatrix);
+  vtkNew<vtkTransformPolyDataFilter> targetTransformFilter;
+  targetTransformFilter->SetTransform(beamToWorldTransform);
+  targetTransformFilter->SetInputConnection(sphereSource->GetOutputPort());
+  targetTransformFilter->Update();
+  vtkPolyData* targetPoly = targetTransformFilter->GetOutput();
+
+  // MLCX with 10 leaf pairs of 10mm
+  const int nofLeafPairs = 10;
+  vtkMRMLTableNode* collisionMlcTableNode = mlcLogic->CreateMultiLeafCollimatorTableNodeBoundaryData(true, nofLeafPairs, 10.0);
+  vtkMRMLTableNode* beamsEyeViewMlcTableNode = mlcLogic->CreateMultiLeafCollimatorTableNodeBoundaryData(true, nofLeafPairs, 10.0);
+  if (!collisionMlcTableNode || !beamsEyeViewMlcTableNode)
+  {
+    std::cerr << __LINE__ << ": Failed to create MLC tables" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Collision based calculation: convex hull curve (first pass) and leaf and target collision (second pass)
+  vtkMRMLMarkupsCurveNode* convexHullCurve = mlcLogic->CalculatePositionConvexHullCurve(beamNode, targetPoly);
+  if (!convexHullCurve || !mlcLogic->CalculateMultiLeafCollimatorPosition(collisionMlcTableNode, convexHullCurve)
+    || !mlcLogic->CalculateMultiLeafCollimatorPosition(beamNode, collisionMlcTableNode, targetPoly))
+  {
+    std::cerr << __LINE__ << ": Collision based MLC position calculation failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Beam's eye view projection
+  if (!mlcLogic->CalculateMultiLeafCollimatorPositionBeamsEyeView(beamNode, beamsEyeViewMlcTableNode, targetPoly))
+  {
+    std::cerr << __LINE__ << ": Beam's eye view MLC position calculation failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Compare the leaf pairs covering the target (Y from -21 to 29). The collision based calculation
+  // leaves the other leaf pairs at their initial position, the projection closes them.
+  const double tolerance = 0.1;
+  vtkTable* collisionMlcTable = collisionMlcTableNode->GetTable();
+  vtkTable* beamsEyeViewMlcTable = beamsEyeViewMlcTableNode->GetTable();
+  for (int leafPair = 2; leafPair <= 7; ++leafPair)
+  {
+    for (int side = 1; side <= 2; ++side)
+    {
+      double collisionPosition = collisionMlcTable->GetValue(leafPair, side).ToDouble();
+      double beamsEyeViewPosition = beamsEyeViewMlcTable->GetValue(leafPair, side).ToDouble();
+      if (std::fabs(collisionPosition - beamsEyeViewPosition) > tolerance)
+      {
+        std::cerr << __LINE__ << ": Leaf pair " << leafPair << " side " << side << " position mismatch: beam's eye view "
+          << beamsEyeViewPosition << ", collision based " << collisionPosition << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  //
+  // Margin, rounded leaf ends and divergent projection are not supported by the collision based calculation,
+  // so the beam's eye view projection is checked against the analytic leaf positions of a box target.
+  // The box is off the leaf pair boundaries and thick enough for the divergence to move the leaves.
+  const double boxCenter[3] = { 3.0, 4.0, 0.0 };
+  const double boxHalfSize[3] = { 25.0, 23.0, 60.0 };
+  vtkNew<vtkCubeSource> boxSource;
+  boxSource->SetCenter(boxCenter[0], boxCenter[1], boxCenter[2]);
+  boxSource->SetXLength(2.0 * boxHalfSize[0]);
+  boxSource->SetYLength(2.0 * boxHalfSize[1]);
+  boxSource->SetZLength(2.0 * boxHalfSize[2]);
+  vtkNew<vtkTransformPolyDataFilter> boxTransformFilter;
+  boxTransformFilter->SetTransform(beamToWorldTransform);
+  boxTransformFilter->SetInputConnection(boxSource->GetOutputPort());
+  boxTransformFilter->Update();
+  vtkPolyData* boxTargetPoly = boxTransformFilter->GetOutput();
+
+  std::vector<double> boundaries(nofLeafPairs + 1);
+  for (int row = 0; row <= nofLeafPairs; ++row)
+  {
+    boundaries[row] = beamsEyeViewMlcTable->GetValue(row, 0).ToDouble();
+  }
+  const FittingOptions fittingOptions[6] = {
+    { 0.0, 0.0, true }, { 5.0, 0.0, true }, { 0.0, 150.0, true },
+    { 0.0, 0.0, false }, { 5.0, 150.0, false }, { 12.0, 0.0, false } };
+  for (const FittingOptions& options : fittingOptions)
+  {
+    if (!mlcLogic->CalculateMultiLeafCollimatorPositionBeamsEyeView(beamNode, beamsEyeViewMlcTableNode, boxTargetPoly,
+      options.Margin, options.LeafEndRadius, options.ParallelBeam))
+    {
+      std::cerr << __LINE__ << ": Beam's eye view MLC position calculation failed for box target" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::vector<double> referenceSide1, referenceSide2;
+    std::vector<bool> opened;
+    CalculateBoxReferenceLeafPositions(boundaries, boxCenter, boxHalfSize, options,
+      beamNode->GetSAD(), beamNode->GetSourceToMultiLeafCollimatorDistance(), referenceSide1, referenceSide2, opened);
+    for (int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+    {
+      double side1 = beamsEyeViewMlcTable->GetValue(leafPair, 1).ToDouble();
+      double side2 = beamsEyeViewMlcTable->GetValue(leafPair, 2).ToDouble();
+      bool mismatch = opened[leafPair]
+        ? (std::fabs(side1 - referenceSide1[leafPair]) > 1.0e-3 || std::fabs(side2 - referenceSide2[leafPair]) > 1.0e-3)
+        : (side1 != side2);
+      if (mismatch)
+      {
+        std::cerr << __LINE__ << ": Box target with margin " << options.Margin << ", leaf end radius " << options.LeafEndRadius
+          << (options.ParallelBeam ? ", parallel" : ", divergent") << " beam: leaf pair " << leafPair << " positions "
+          << side1 << ", " << side2 << " instead of ";
+        if (opened[leafPair])
+        {
+          std::cerr << referenceSide1[leafPair] << ", " << referenceSide2[leafPair] << std::endl;
+        }
+        else
+        {
+          std::cerr << "closed" << std::endl;
+        }
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  //
+  // Batch calculation for control points must match the calculation for the beam set to each control point.
+  // The target is a sphere of 10mm radius at 70mm along Y of the beam frame, so it is only seen by the MLC
+  // if the collimator is rotated by 90 degrees (then it is along the leaves), and control point 2 fails.
+  vtkNew<vtkSphereSource> offAxisSphereSource;
+  offAxisSphereSource->SetCenter(0.0, 70.0, 0.0);
+  offAxisSphereSource->SetRadius(10.0);
+  vtkNew<vtkTransformPolyDataFilter> offAxisTargetTransformFilter;
+  offAxisTargetTransformFilter->SetTransform(beamToWorldTransform);
+  offAxisTargetTransformFilter->SetInputConnection(offAxisSphereSource->GetOutputPort());
+  offAxisTargetTransformFilter->Update();
+  vtkPolyData* offAxisTargetPoly = offAxisTargetTransformFilter->GetOutput();
+
+  std::vector<double> gantryAngles = { 0.0, 30.0, 60.0, 90.0 };
+  std::vector<double> collimatorAngles = { 90.0, 90.0, 0.0, 90.0 };
+  const int failingControlPoint = 2;
+  beamNode->SetAndObserveMultiLeafCollimatorTableNode(collisionMlcTableNode);
+  vtkNew<vtkMRMLTableNode> leafPositionsTableNode;
+  mrmlScene->AddNode(leafPositionsTableNode);
+  std::vector<int> failedControlPoints;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  bool allControlPointsFitted = mlcLogic->CalculateMultiLeafCollimatorPositionsForControlPoints(beamNode, offAxisTargetPoly,
+    gantryAngles, collimatorAngles, leafPositionsTableNode, 0.0, 0.0, true, &failedControlPoints);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  if (allControlPointsFitted || failedControlPoints.size() != 1 || failedControlPoints[0] != failingControlPoint)
+  {
+    std::cerr << __LINE__ << ": Control point " << failingControlPoint << " is not reported as the only failed one" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkTable* leafPositionsTable = leafPositionsTableNode->GetTable();
+
+  // The new row of the failed control point gets the leaf positions of the beam's MLC table
+  for (int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+  {
+    for (int side = 1; side <= 2; ++side)
+    {
+      double position = leafPositionsTable->GetValue(failingControlPoint, 2 + (side - 1) * nofLeafPairs + leafPair).ToDouble();
+      double mlcPosition = collisionMlcTable->GetValue(leafPair, side).ToDouble();
+      if (position != mlcPosition)
+      {
+        std::cerr << __LINE__ << ": Failed control point leaf pair " << leafPair << " side " << side << " position "
+          << position << " is not the MLC table position " << mlcPosition << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Fitting again must leave the row of the failed control point untouched
+  const double previousPosition = 123.0;
+  for (int column = 2; column < leafPositionsTable->GetNumberOfColumns(); ++column)
+  {
+    leafPositionsTable->SetValue(failingControlPoint, column, previousPosition);
+  }
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  mlcLogic->CalculateMultiLeafCollimatorPositionsForControlPoints(beamNode, offAxisTargetPoly,
+    gantryAngles, collimatorAngles, leafPositionsTableNode);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  for (int column = 2; column < leafPositionsTable->GetNumberOfColumns(); ++column)
+  {
+    if (leafPositionsTable->GetValue(failingControlPoint, column).ToDouble() != previousPosition)
+    {
+      std::cerr << __LINE__ << ": Row of failed control point is overwritten in column " << column << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  vtkMRMLTableNode* controlPointMlcTableNode = mlcLogic->CreateMultiLeafCollimatorTableNodeBoundaryData(true, nofLeafPairs, 10.0);
+  for (int controlPoint = 0; controlPoint < static_cast<int>(gantryAngles.size()); ++controlPoint)
+  {
+    if (controlPoint == failingControlPoint)
+    {
+      continue;
+    }
+    beamNode->SetGantryAngle(gantryAngles[controlPoint]);
+    beamNode->SetCollimatorAngle(collimatorAngles[controlPoint]);
+    beamsLogic->UpdateTransformForBeam(beamNode);
+    if (!mlcLogic->CalculateMultiLeafCollimatorPositionBeamsEyeView(beamNode, controlPointMlcTableNode, offAxisTargetPoly))
+    {
+      std::cerr << __LINE__ << ": Beam's eye view MLC position calculation failed at control point " << controlPoint << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (int leafPair = 0; leafPair < nofLeafPairs; ++leafPair)
+    {
+      for (int side = 1; side <= 2; ++side)
+      {
+        double batchPosition = leafPositionsTable->GetValue(controlPoint, 2 + (side - 1) * nofLeafPairs + leafPair).ToDouble();
+        double position = controlPointMlcTableNode->GetTable()->GetValue(leafPair, side).ToDouble();
+        if (std::fabs(batchPosition - position) > 1.0e-3)
+        {
+          std::cerr << __LINE__ << ": Control point " << controlPoint << " leaf pair " << leafPair << " side " << side
+            << " position mismatch: batch " << batchPosition << ", beam " << position << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -939,7 +939,9 @@ void qMRMLBeamParametersTabWidget::xJawsPositionValuesChanged(double minVal, dou
     return;
   }
 
-  // Do not disable modifier events as geometry need to be updated
+  // Do not disable modifier events as geometry need to be updated,
+  // but update it only once for both jaws
+  MRMLNodeModifyBlocker blocker(d->BeamNode);
   d->BeamNode->SetX1Jaw(minVal);
   d->BeamNode->SetX2Jaw(maxVal);
 }
@@ -955,7 +957,9 @@ void qMRMLBeamParametersTabWidget::yJawsPositionValuesChanged(double minVal, dou
     return;
   }
 
-  // Do not disable modifier events as geometry need to be updated
+  // Do not disable modifier events as geometry need to be updated,
+  // but update it only once for both jaws
+  MRMLNodeModifyBlocker blocker(d->BeamNode);
   d->BeamNode->SetY1Jaw(minVal);
   d->BeamNode->SetY2Jaw(maxVal);
 }
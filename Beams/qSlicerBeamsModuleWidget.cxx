@@ -41,6 +41,9 @@
 // MRML includes
 #include <vtkMRMLScene.h>
 
+// STD includes
+#include <algorithm>
+
 //-----------------------------------------------------------------------------
 /// \ingroup SlicerRt_QtModules_Beams
 class qSlicerBeamsModuleWidgetPrivate: public Ui_qSlicerBeamsModule
@@ -147,6 +150,7 @@ void qSlicerBeamsModuleWidget::setup()
   // Main parameters
   connect( d->lineEdit_BeamName, SIGNAL(textChanged(const QString &)), this, SLOT(beamNameChanged(const QString &)) );
   connect( d->doubleSpinBox_BeamWeight, SIGNAL(valueChanged(double)), this, SLOT(beamWeightChanged(double)) );
+  connect( d->SliderWidget_ControlPoint, SIGNAL(valueChanged(double)), this, SLOT(controlPointIndexChanged(double)) );
 
   // Handle scene change event if occurs
   qvtkConnect( d->logic(), vtkCommand::ModifiedEvent, this, SLOT( onLogicModified() ) );
@@ -193,6 +197,18 @@ void qSlicerBeamsModuleWidget::updateWidgetFromMRML()
     d->doubleSpinBox_BeamWeight->setValue(beamNode->GetBeamWeight());
   }
 
+  // Control point selection is only shown for dynamic beams loaded into a control point store
+  int numberOfControlPoints = (beamNode ? beamNode->GetNumberOfControlPoints() : 0);
+  d->label_ControlPoint->setVisible(numberOfControlPoints > 0);
+  d->SliderWidget_ControlPoint->setVisible(numberOfControlPoints > 0);
+  if (numberOfControlPoints > 0)
+  {
+    bool wasBlocked = d->SliderWidget_ControlPoint->blockSignals(true);
+    d->SliderWidget_ControlPoint->setMaximum(numberOfControlPoints - 1);
+    d->SliderWidget_ControlPoint->setValue(std::max(beamNode->GetCurrentControlPointIndex(), 0));
+    d->SliderWidget_ControlPoint->blockSignals(wasBlocked);
+  }
+
   this->updateButtonsState();
 }
 
@@ -287,6 +303,24 @@ void qSlicerBeamsModuleWidget::beamWeightChanged(double value)
   beamNode->DisableModifiedEventOff();
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerBeamsModuleWidget::controlPointIndexChanged(double value)
+{
+  Q_D(qSlicerBeamsModuleWidget);
+
+  vtkMRMLRTBeamNode* beamNode = vtkMRMLRTBeamNode::SafeDownCast(d->MRMLNodeComboBox_RtBeam->currentNode());
+  if (!beamNode || beamNode->GetNumberOfControlPoints() == 0)
+  {
+    return;
+  }
+
+  int controlPointIndex = static_cast<int>(value + 0.5);
+  if (controlPointIndex != beamNode->GetCurrentControlPointIndex())
+  {
+    beamNode->SetCurrentControlPointIndex(controlPointIndex);
+  }
+}
+
 //-----------------------------------------------------------------------------
 bool qSlicerBeamsModuleWidget::setEditedNode(vtkMRMLNode* node, QString role/*=QString()*/, QString context/*=QString()*/)
 {
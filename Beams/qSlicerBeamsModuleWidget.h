@@ -78,6 +78,8 @@ protected slots:
   // Main parameters
   void beamNameChanged(const QString &);
   void beamWeightChanged(double);
+  /// Set the geometry of the selected control point to a dynamic beam
+  void controlPointIndexChanged(double);
 
 protected:
   QScopedPointer<qSlicerBeamsModuleWidgetPrivate> d_ptr;
@@ -22,6 +22,11 @@ class DicomRtImportExportPluginClass(DICOMPlugin):
     self.tags['RTPlanLabel'] = "300a,0002"
     self.tags['ReferencedSOPInstanceUID'] = "0008,1155"
 
+    # Loadables of the last examination, parsed all together when the first of them is loaded
+    self.examinedLoadables = []
+    # Selected loadables parsed in advance, in loading order
+    self.parsedLoadables = []
+
   def examineForImport(self,fileLists):
     """ Returns a list of qSlicerDICOMLoadable
     instances corresponding to ways of interpreting the
@@ -51,6 +56,7 @@ class DicomRtImportExportPluginClass(DICOMPlugin):
           qtLoadable.selected = True
           loadables.append(qtLoadable)
 
+    self.examinedLoadables = loadables
     return loadables
 
   def load(self,loadable):
@@ -59,11 +65,42 @@ class DicomRtImportExportPluginClass(DICOMPlugin):
     """
     if len(loadable.files) > 1:
       logging.error('RT objects must be contained by a single file')
+    logic = slicer.modules.dicomrtimportexport.logic()
+
+    # The DICOM module loads the selected loadables one by one. When the first one is loaded, parse the files
+    # of all the selected loadables in parallel, so that only the node creation remains for the further ones
+    if any(examinedLoadable is loadable for examinedLoadable in self.examinedLoadables):
+      selectedLoadables = [examinedLoadable for examinedLoadable in self.examinedLoadables if examinedLoadable.selected]
+      self.examinedLoadables = []
+      self.releaseParsedLoadables()
+      if len(selectedLoadables) > 1:
+        vtkLoadables = vtk.vtkCollection()
+        for selectedLoadable in selectedLoadables:
+          vtkSelectedLoadable = slicer.vtkSlicerDICOMLoadable()
+          selectedLoadable.copyToVtkLoadable(vtkSelectedLoadable)
+          vtkLoadables.AddItem(vtkSelectedLoadable)
+        logic.ParseDicomRT(vtkLoadables)
+        self.parsedLoadables = selectedLoadables
+    elif not any(parsedLoadable is loadable for parsedLoadable in self.parsedLoadables):
+      # Another load has started, the objects parsed for the previous one are not needed any more
+      self.releaseParsedLoadables()
+
     vtkLoadable = slicer.vtkSlicerDICOMLoadable()
     loadable.copyToVtkLoadable(vtkLoadable)
-    success = slicer.modules.dicomrtimportexport.logic().LoadDicomRT(vtkLoadable)
+    success = logic.LoadDicomRT(vtkLoadable)
+
+    # The load ends with the last selected loadable. Release the objects parsed for the loadables
+    # that have not been loaded (e.g. because they were skipped), instead of keeping them until the scene is closed.
+    if self.parsedLoadables and self.parsedLoadables[-1] is loadable:
+      self.releaseParsedLoadables()
     return success
 
+  def releaseParsedLoadables(self):
+    """Release the objects parsed in advance for the selected loadables that have not been loaded
+    """
+    self.parsedLoadables = []
+    slicer.modules.dicomrtimportexport.logic().ReleaseParsedDicomRT()
+
   def examineForExport(self,subjectHierarchyItemID):
     """Return a list of DICOMExportable instances that describe the
     available techniques that this plugin offers to convert MRML
@@ -0,0 +1,554 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtDoseFileMap.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationObjectBaseKey.h>
+#include <vtkIntArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkShortArray.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedIntArray.h>
+#include <vtkUnsignedShortArray.h>
+
+// STD includes
+#include <cmath>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>    /* make sure OS specific configuration is included first */
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcuid.h>
+
+// Platform includes
+#ifdef _WIN32
+  #include <windows.h>
+  #include <vtksys/Encoding.hxx>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerDicomRtDoseFileMap);
+vtkInformationKeyMacro(vtkSlicerDicomRtDoseFileMap, FILE_MAPPING, ObjectBase);
+
+//----------------------------------------------------------------------------
+/// Platform specific copy-on-write mapping of a file. The mapping is released when the last reference is removed,
+/// so the arrays pointing into it can keep it alive after the file map is closed (\sa vtkSlicerDicomRtDoseFileMap::FILE_MAPPING).
+/// Pages are mapped readable and writable, but modifications are private to the process and never written to the file.
+class vtkSlicerDicomRtDoseFileMapping : public vtkObject
+{
+public:
+  static vtkSlicerDicomRtDoseFileMapping *New();
+  vtkTypeMacro(vtkSlicerDicomRtDoseFileMapping, vtkObject);
+
+  /// Map the whole file
+  bool Map(const char* fileName)
+  {
+    this->Unmap();
+#ifdef _WIN32
+    std::wstring wideFileName = vtksys::Encoding::ToWide(fileName);
+    this->File = CreateFileW(wideFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->File == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(this->File, &fileSize) || fileSize.QuadPart == 0)
+    {
+      this->Unmap();
+      return false;
+    }
+    this->Mapping = CreateFileMappingW(this->File, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (this->Mapping == nullptr)
+    {
+      this->Unmap();
+      return false;
+    }
+    this->Data = static_cast<unsigned char*>(MapViewOfFile(this->Mapping, FILE_MAP_COPY, 0, 0, 0));
+    if (this->Data == nullptr)
+    {
+      this->Unmap();
+      return false;
+    }
+    this->Size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fileDescriptor = open(fileName, O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+      return false;
+    }
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+    {
+      close(fileDescriptor);
+      return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0);
+    // The mapping stays valid after the file descriptor is closed
+    close(fileDescriptor);
+    if (data == MAP_FAILED)
+    {
+      return false;
+    }
+    this->Data = static_cast<unsigned char*>(data);
+    this->Size = static_cast<size_t>(fileStatus.st_size);
+#endif
+    return true;
+  }
+
+  /// Release the mapping
+  void Unmap()
+  {
+#ifdef _WIN32
+    if (this->Data)
+    {
+      UnmapViewOfFile(this->Data);
+    }
+    if (this->Mapping)
+    {
+      CloseHandle(this->Mapping);
+    }
+    if (this->File != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle(this->File);
+    }
+    this->Mapping = nullptr;
+    this->File = INVALID_HANDLE_VALUE;
+#else
+    if (this->Data)
+    {
+      munmap(this->Data, this->Size);
+    }
+#endif
+    this->Data = nullptr;
+    this->Size = 0;
+  }
+
+public:
+  unsigned char* Data{nullptr};
+  size_t Size{0};
+
+protected:
+  vtkSlicerDicomRtDoseFileMapping() = default;
+  ~vtkSlicerDicomRtDoseFileMapping() override
+  {
+    this->Unmap();
+  }
+
+private:
+#ifdef _WIN32
+  HANDLE File{INVALID_HANDLE_VALUE};
+  HANDLE Mapping{nullptr};
+#endif
+
+private:
+  vtkSlicerDicomRtDoseFileMapping(const vtkSlicerDicomRtDoseFileMapping&) = delete;
+  void operator=(const vtkSlicerDicomRtDoseFileMapping&) = delete;
+};
+
+vtkStandardNewMacro(vtkSlicerDicomRtDoseFileMapping);
+
+//----------------------------------------------------------------------------
+class vtkSlicerDicomRtDoseFileMap::vtkInternal
+{
+public:
+  /// Mapping of the currently opened file, nullptr if no file is open
+  vtkSmartPointer<vtkSlicerDicomRtDoseFileMapping> Mapping;
+};
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  unsigned int ReadUint32LittleEndian(const unsigned char* data)
+  {
+    return static_cast<unsigned int>(data[0]) | (static_cast<unsigned int>(data[1]) << 8)
+      | (static_cast<unsigned int>(data[2]) << 16) | (static_cast<unsigned int>(data[3]) << 24);
+  }
+
+  //----------------------------------------------------------------------------
+  template <class T>
+  void ComputeFrameDose(const T* storedValues, float* doseValues, vtkIdType numberOfValues, double doseGridScaling)
+  {
+    for (vtkIdType index=0; index<numberOfValues; ++index)
+    {
+      doseValues[index] = static_cast<float>(static_cast<float>(storedValues[index]) * doseGridScaling);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtDoseFileMap::vtkSlicerDicomRtDoseFileMap()
+{
+  this->Internal = new vtkInternal();
+  this->ResetHeader();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtDoseFileMap::~vtkSlicerDicomRtDoseFileMap()
+{
+  if (this->Internal)
+  {
+    delete this->Internal;
+    this->Internal = nullptr;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDoseFileMap::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Open: " << (this->IsOpen() ? "true" : "false") << "\n";
+  os << indent << "Rows: " << this->Rows << "\n";
+  os << indent << "Columns: " << this->Columns << "\n";
+  os << indent << "NumberOfFrames: " << this->NumberOfFrames << "\n";
+  os << indent << "BitsAllocated: " << this->BitsAllocated << "\n";
+  os << indent << "PixelRepresentation: " << this->PixelRepresentation << "\n";
+  os << indent << "DoseGridScaling: " << this->DoseGridScaling << "\n";
+  os << indent << "PixelSpacing: (" << this->PixelSpacing[0] << ", " << this->PixelSpacing[1] << ")\n";
+  os << indent << "PixelDataOffset: " << this->PixelDataOffset << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDoseFileMap::ResetHeader()
+{
+  this->Rows = 0;
+  this->Columns = 0;
+  this->NumberOfFrames = 0;
+  this->BitsAllocated = 0;
+  this->PixelRepresentation = 0;
+  this->DoseGridScaling = 1.0;
+  this->PixelSpacing[0] = this->PixelSpacing[1] = 1.0;
+  this->GridFrameOffsets.clear();
+  this->ExplicitVR = false;
+  this->PixelDataOffset = 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtDoseFileMap::Open(const char* fileName)
+{
+  this->Close();
+
+  if (!fileName || !*fileName)
+  {
+    vtkErrorMacro("Open: Invalid file name");
+    return false;
+  }
+
+  if (!this->ParseHeader(fileName))
+  {
+    this->ResetHeader();
+    return false;
+  }
+
+  vtkSmartPointer<vtkSlicerDicomRtDoseFileMapping> mapping = vtkSmartPointer<vtkSlicerDicomRtDoseFileMapping>::New();
+  if (!mapping->Map(fileName))
+  {
+    vtkErrorMacro("Open: Failed to map file '" << fileName << "' into memory");
+    this->ResetHeader();
+    return false;
+  }
+  this->Internal->Mapping = mapping;
+
+  if (!this->LocatePixelData())
+  {
+    vtkErrorMacro("Open: Failed to locate uncompressed pixel data in file '" << fileName << "'");
+    this->Close();
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDoseFileMap::Close()
+{
+  // Images returned by GetStoredPixelImageData keep their own reference to the mapping
+  this->Internal->Mapping = nullptr;
+  this->ResetHeader();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtDoseFileMap::IsOpen()
+{
+  return this->Internal->Mapping.GetPointer() != nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtDoseFileMap::ParseHeader(const char* fileName)
+{
+#ifdef VTK_WORDS_BIGENDIAN
+  vtkErrorMacro("ParseHeader: Memory mapped RT Dose access is not supported on big endian platforms");
+  return false;
+#else
+
+  // Parse attributes up to the pixel data, the pixel data itself is not read
+  DcmFileFormat fileformat;
+  if (!fileformat.loadFileUntilTag(fileName, EXS_Unknown, EGL_noChange,
+    DCM_MaxReadLength, ERM_autoDetect, DCM_PixelData).good())
+  {
+    vtkErrorMacro("ParseHeader: Failed to read DICOM file '" << fileName << "'");
+    return false;
+  }
+  DcmDataset* dataset = fileformat.getDataset();
+
+  OFString sopClass("");
+  if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass != UID_RTDoseStorage)
+  {
+    vtkErrorMacro("ParseHeader: File '" << fileName << "' is not an RT Dose");
+    return false;
+  }
+
+  E_TransferSyntax transferSyntax = dataset->getOriginalXfer();
+  if (transferSyntax != EXS_LittleEndianImplicit && transferSyntax != EXS_LittleEndianExplicit)
+  {
+    vtkErrorMacro("ParseHeader: Transfer syntax of RT Dose file '" << fileName << "' is not uncompressed little endian");
+    return false;
+  }
+  this->ExplicitVR = (transferSyntax == EXS_LittleEndianExplicit);
+
+  Uint16 rows = 0;
+  Uint16 columns = 0;
+  Uint16 bitsAllocated = 0;
+  Uint16 pixelRepresentation = 0;
+  Uint16 samplesPerPixel = 1;
+  Sint32 numberOfFrames = 1;
+  if (!dataset->findAndGetUint16(DCM_Rows, rows).good() || !dataset->findAndGetUint16(DCM_Columns, columns).good()
+    || !dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated).good())
+  {
+    vtkErrorMacro("ParseHeader: Image pixel attributes are missing from RT Dose file '" << fileName << "'");
+    return false;
+  }
+  dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRepresentation);
+  dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel);
+  dataset->findAndGetSint32(DCM_NumberOfFrames, numberOfFrames);
+  if ((bitsAllocated != 16 && bitsAllocated != 32) || samplesPerPixel != 1 || numberOfFrames < 1)
+  {
+    vtkErrorMacro("ParseHeader: Unsupported pixel data in RT Dose file '" << fileName << "' (bits allocated: "
+      << bitsAllocated << ", samples per pixel: " << samplesPerPixel << ", number of frames: " << numberOfFrames << ")");
+    return false;
+  }
+  this->Rows = rows;
+  this->Columns = columns;
+  this->BitsAllocated = bitsAllocated;
+  this->PixelRepresentation = pixelRepresentation;
+  this->NumberOfFrames = numberOfFrames;
+
+  Float64 doseGridScaling = 1.0;
+  if (dataset->findAndGetFloat64(DCM_DoseGridScaling, doseGridScaling).good())
+  {
+    this->DoseGridScaling = doseGridScaling;
+  }
+
+  // X spacing is the second element of the vector, while Y spacing is the first (see vtkSlicerDicomRtReader)
+  Float64 rowSpacing = 1.0;
+  Float64 columnSpacing = 1.0;
+  if (dataset->findAndGetFloat64(DCM_PixelSpacing, rowSpacing, 0).good()
+    && dataset->findAndGetFloat64(DCM_PixelSpacing, columnSpacing, 1).good())
+  {
+    this->PixelSpacing[0] = columnSpacing;
+    this->PixelSpacing[1] = rowSpacing;
+  }
+
+  Float64 frameOffset = 0.0;
+  for (unsigned long frameIndex=0; frameIndex<static_cast<unsigned long>(numberOfFrames); ++frameIndex)
+  {
+    if (!dataset->findAndGetFloat64(DCM_GridFrameOffsetVector, frameOffset, frameIndex).good())
+    {
+      break;
+    }
+    this->GridFrameOffsets.push_back(frameOffset);
+  }
+
+  return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtDoseFileMap::LocatePixelData()
+{
+  const unsigned char* data = (this->Internal->Mapping ? this->Internal->Mapping->Data : nullptr);
+  size_t fileSize = (this->Internal->Mapping ? this->Internal->Mapping->Size : 0);
+  size_t valueLength = static_cast<size_t>(this->GetNumberOfVoxelsPerFrame()) * this->NumberOfFrames * (this->BitsAllocated / 8);
+  size_t elementHeaderLength = (this->ExplicitVR ? 12 : 8);
+  if (!data || fileSize < valueLength + elementHeaderLength)
+  {
+    return false;
+  }
+
+  // Pixel data is the last element of an RT Dose, only optionally followed by padding,
+  // so look for its element header backwards from the latest possible position
+  for (size_t elementOffset = fileSize - valueLength - elementHeaderLength; ; --elementOffset)
+  {
+    const unsigned char* element = data + elementOffset;
+    if (element[0] == 0xE0 && element[1] == 0x7F && element[2] == 0x10 && element[3] == 0x00)
+    {
+      bool headerValid = true;
+      unsigned int length = 0;
+      if (this->ExplicitVR)
+      {
+        headerValid = (element[4] == 'O' && (element[5] == 'W' || element[5] == 'B') && element[6] == 0 && element[7] == 0);
+        length = ReadUint32LittleEndian(element + 8);
+      }
+      else
+      {
+        length = ReadUint32LittleEndian(element + 4);
+      }
+      if (headerValid && length == valueLength)
+      {
+        this->PixelDataOffset = elementOffset + elementHeaderLength;
+        return true;
+      }
+    }
+    if (elementOffset == 0)
+    {
+      break;
+    }
+  }
+
+  return false;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtDoseFileMap::GetScalarType()
+{
+  if (this->BitsAllocated == 16)
+  {
+    return (this->PixelRepresentation ? VTK_SHORT : VTK_UNSIGNED_SHORT);
+  }
+  else if (this->BitsAllocated == 32)
+  {
+    return (this->PixelRepresentation ? VTK_INT : VTK_UNSIGNED_INT);
+  }
+  return VTK_VOID;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerDicomRtDoseFileMap::GetNumberOfVoxelsPerFrame()
+{
+  return static_cast<vtkIdType>(this->Rows) * this->Columns;
+}
+
+//----------------------------------------------------------------------------
+const void* vtkSlicerDicomRtDoseFileMap::GetFramePointer(int frameIndex)
+{
+  if (!this->IsOpen() || frameIndex < 0 || frameIndex >= this->NumberOfFrames)
+  {
+    vtkErrorMacro("GetFramePointer: Invalid frame index " << frameIndex << " or no file is open");
+    return nullptr;
+  }
+  size_t frameLength = static_cast<size_t>(this->GetNumberOfVoxelsPerFrame()) * (this->BitsAllocated / 8);
+  return this->Internal->Mapping->Data + this->PixelDataOffset + frameIndex * frameLength;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtDoseFileMap::GetFrameDose(int frameIndex, float* doseValues)
+{
+  const void* storedValues = this->GetFramePointer(frameIndex);
+  if (!storedValues || !doseValues)
+  {
+    vtkErrorMacro("GetFrameDose: Invalid frame or output buffer");
+    return false;
+  }
+
+  vtkIdType numberOfValues = this->GetNumberOfVoxelsPerFrame();
+  switch (this->GetScalarType())
+  {
+  case VTK_SHORT:
+    ComputeFrameDose(static_cast<const short*>(storedValues), doseValues, numberOfValues, this->DoseGridScaling);
+    break;
+  case VTK_UNSIGNED_SHORT:
+    ComputeFrameDose(static_cast<const unsigned short*>(storedValues), doseValues, numberOfValues, this->DoseGridScaling);
+    break;
+  case VTK_INT:
+    ComputeFrameDose(static_cast<const int*>(storedValues), doseValues, numberOfValues, this->DoseGridScaling);
+    break;
+  case VTK_UNSIGNED_INT:
+    ComputeFrameDose(static_cast<const unsigned int*>(storedValues), doseValues, numberOfValues, this->DoseGridScaling);
+    break;
+  default:
+    vtkErrorMacro("GetFrameDose: Unsupported stored pixel type");
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtDoseFileMap::GetStoredPixelImageData(vtkImageData* imageData)
+{
+  if (!imageData || !this->IsOpen())
+  {
+    vtkErrorMacro("GetStoredPixelImageData: Invalid image or no file is open");
+    return false;
+  }
+
+  vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(this->GetScalarType()));
+  if (!scalars)
+  {
+    vtkErrorMacro("GetStoredPixelImageData: Unsupported stored pixel type");
+    return false;
+  }
+  vtkIdType numberOfValues = this->GetNumberOfVoxelsPerFrame() * this->NumberOfFrames;
+  void* storedValues = this->Internal->Mapping->Data + this->PixelDataOffset;
+  // Save flag is set, so the array never frees the mapped memory. The mapping is released when
+  // the array does not reference it any more, so the image remains valid after the file map is closed
+  switch (this->GetScalarType())
+  {
+  case VTK_SHORT:
+    vtkShortArray::SafeDownCast(scalars)->SetArray(static_cast<short*>(storedValues), numberOfValues, 1);
+    break;
+  case VTK_UNSIGNED_SHORT:
+    vtkUnsignedShortArray::SafeDownCast(scalars)->SetArray(static_cast<unsigned short*>(storedValues), numberOfValues, 1);
+    break;
+  case VTK_INT:
+    vtkIntArray::SafeDownCast(scalars)->SetArray(static_cast<int*>(storedValues), numberOfValues, 1);
+    break;
+  case VTK_UNSIGNED_INT:
+    vtkUnsignedIntArray::SafeDownCast(scalars)->SetArray(static_cast<unsigned int*>(storedValues), numberOfValues, 1);
+    break;
+  default:
+    break;
+  }
+  scalars->SetName("StoredPixelValues");
+  scalars->GetInformation()->Set(vtkSlicerDicomRtDoseFileMap::FILE_MAPPING(), this->Internal->Mapping);
+
+  // Use uniform frame spacing if the offsets are available
+  double frameSpacing = 1.0;
+  if (this->GridFrameOffsets.size() > 1)
+  {
+    frameSpacing = fabs(this->GridFrameOffsets[1] - this->GridFrameOffsets[0]);
+  }
+
+  imageData->Initialize();
+  imageData->SetDimensions(this->Columns, this->Rows, this->NumberOfFrames);
+  imageData->SetOrigin(0.0, 0.0, 0.0);
+  imageData->SetSpacing(this->PixelSpacing[0], this->PixelSpacing[1], frameSpacing);
+  imageData->GetPointData()->SetScalars(scalars);
+
+  return true;
+}
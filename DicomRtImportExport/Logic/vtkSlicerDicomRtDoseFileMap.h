@@ -0,0 +1,145 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerDicomRtDoseFileMap_h
+#define __vtkSlicerDicomRtDoseFileMap_h
+
+#include "vtkSlicerDicomRtImportExportModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <vector>
+
+class vtkImageData;
+class vtkInformationObjectBaseKey;
+
+/// \ingroup SlicerRt_QtModules_DicomRtImport
+/// \brief Memory mapped access to the pixel data of a multi-frame RT Dose file.
+///
+/// Only the header of the file is parsed (up to the Pixel Data element), then the whole file is mapped
+/// copy-on-write into the address space of the process without reading it. The file is never modified. The operating system pages in the frames
+/// when they are accessed, so doses larger than the available memory can be processed frame by frame.
+/// Only uncompressed little endian transfer syntaxes (implicit and explicit VR) are supported.
+///
+/// The stored pixel values can be accessed per frame (\sa GetFramePointer, \sa GetFrameDose), or as
+/// an image whose scalars point directly into the mapping (\sa GetStoredPixelImageData).
+class VTK_SLICER_DICOMRTIMPORTEXPORT_LOGIC_EXPORT vtkSlicerDicomRtDoseFileMap : public vtkObject
+{
+public:
+  static vtkSlicerDicomRtDoseFileMap *New();
+  vtkTypeMacro(vtkSlicerDicomRtDoseFileMap, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Parse the header of an RT Dose file and map the file into memory.
+  /// The previously opened file is closed.
+  /// \return Success flag. Fails if the file is not an RT Dose, or its pixel data is compressed or big endian
+  bool Open(const char* fileName);
+
+  /// Close the currently opened file. The mapping is released once no image returned by
+  /// \sa GetStoredPixelImageData uses it any more
+  void Close();
+
+  /// Determine whether a file is mapped
+  bool IsOpen();
+
+  /// Get number of rows in a frame
+  vtkGetMacro(Rows, int);
+  /// Get number of columns in a frame
+  vtkGetMacro(Columns, int);
+  /// Get number of frames
+  vtkGetMacro(NumberOfFrames, int);
+  /// Get number of bits allocated for a stored pixel value (16 or 32)
+  vtkGetMacro(BitsAllocated, int);
+  /// Get pixel representation (0: unsigned, 1: two's complement signed)
+  vtkGetMacro(PixelRepresentation, int);
+  /// Get dose grid scaling. Dose values are the stored pixel values multiplied by this factor
+  vtkGetMacro(DoseGridScaling, double);
+  /// Get pixel spacing (X spacing first, unlike in the DICOM attribute)
+  vtkGetVector2Macro(PixelSpacing, double);
+  /// Get Grid Frame Offset Vector (3004,000C), the Z offsets of the frames in mm
+  const std::vector<double>& GetGridFrameOffsets() { return this->GridFrameOffsets; };
+
+  /// Get VTK scalar type of the stored pixel values
+  int GetScalarType();
+  /// Get number of voxels in one frame
+  vtkIdType GetNumberOfVoxelsPerFrame();
+
+  /// Get pointer to the stored pixel values of a frame within the mapping.
+  /// The memory is read-only, and only valid while the file is open.
+  /// \return Pointer to the first value of the frame, nullptr if the frame index is invalid or no file is open
+  const void* GetFramePointer(int frameIndex);
+
+  /// Compute the dose values of a frame (stored pixel values multiplied by dose grid scaling).
+  /// Only this frame of the file is paged in.
+  /// \param doseValues Output buffer with room for \sa GetNumberOfVoxelsPerFrame values
+  /// \return Success flag
+  bool GetFrameDose(int frameIndex, float* doseValues);
+
+  /// Set the stored pixel values of all frames as the scalars of an image, without copying them.
+  /// The image geometry is set in IJK space: origin is zero and spacing is the pixel spacing and the frame spacing.
+  /// The scalars point into the mapping and keep it alive (\sa FILE_MAPPING), so the image stays valid after the
+  /// file map is closed or deleted. Modified scalars are only changed in memory, not in the file.
+  /// Dose values are obtained by multiplying the scalars with the dose grid scaling.
+  /// \return Success flag
+  bool GetStoredPixelImageData(vtkImageData* imageData);
+
+  /// Key in the information of the scalars returned by \sa GetStoredPixelImageData, holding the file mapping
+  static vtkInformationObjectBaseKey* FILE_MAPPING();
+
+protected:
+  /// Parse attributes needed for accessing the pixel data
+  /// \return Success flag
+  bool ParseHeader(const char* fileName);
+
+  /// Find the offset of the pixel data value in the mapped file
+  /// \return Success flag
+  bool LocatePixelData();
+
+  /// Reset the parsed attributes
+  void ResetHeader();
+
+protected:
+  vtkSlicerDicomRtDoseFileMap();
+  ~vtkSlicerDicomRtDoseFileMap() override;
+
+protected:
+  int Rows;
+  int Columns;
+  int NumberOfFrames;
+  int BitsAllocated;
+  int PixelRepresentation;
+  double DoseGridScaling;
+  double PixelSpacing[2];
+  std::vector<double> GridFrameOffsets;
+
+  /// Set if the transfer syntax is explicit VR little endian, unset if implicit
+  bool ExplicitVR;
+
+  /// Offset of the pixel data value within the mapped file
+  size_t PixelDataOffset;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSlicerDicomRtDoseFileMap(const vtkSlicerDicomRtDoseFileMap&) = delete;
+  void operator=(const vtkSlicerDicomRtDoseFileMap&) = delete;
+};
+
+#endif
@@ -105,20 +105,29 @@
 #include <vtkMRMLMarkupsDisplayNode.h>
 
 // VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
 #include <vtkCutter.h>
 #include <vtkGeneralTransform.h>
-#include <vtkImageCast.h>
+#include <vtkImageConstantPad.h>
+#include <vtkIdList.h>
 #include <vtkImageData.h>
 #include <vtkLookupTable.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPlane.h>
+#include <vtkPoints.h>
+#include <vtkPointData.h>
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkStripper.h>
+#include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkTable.h>
 #include <vtkDoubleArray.h>
+#include <vtkSMPTools.h>
 
 // ITK includes
 #include <itkImage.h>
@@ -130,6 +139,11 @@
 #include "vtkSlicerDICOMLoadable.h"
 #include "vtkSlicerDICOMExportable.h"
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDicomRtImportExportModuleLogic);
 vtkCxxSetObjectMacro(vtkSlicerDicomRtImportExportModuleLogic, IsodoseLogic, vtkSlicerIsodoseModuleLogic);
@@ -138,10 +152,256 @@ vtkCxxSetObjectMacro(vtkSlicerDicomRtImportExportModuleLogic, BeamsLogic, vtkSli
 
 namespace
 {
+  /// Maximum number of dose volumes read ahead in parallel when loading parsed loadables.
+  /// Limits the memory taken by dose volumes waiting for their loadable to be loaded.
+  const unsigned int MAXIMUM_NUMBER_OF_DOSE_VOLUMES_READ_AT_ONCE = 4;
+
   const char* SafeStr(const char* ptr)
   {
     return ptr ? ptr : "";
   }
+
+  //---------------------------------------------------------------------------
+  template <class T>
+  void ApplyDoseGridScalingToValues(const T* storedValues, float* doseValues, vtkIdType numberOfValues, double doseGridScaling)
+  {
+    vtkSMPTools::For(0, numberOfValues, [&](vtkIdType begin, vtkIdType end)
+    {
+      for (vtkIdType index=begin; index<end; ++index)
+      {
+        doseValues[index] = static_cast<float>(static_cast<float>(storedValues[index]) * doseGridScaling);
+      }
+    });
+  }
+
+  //---------------------------------------------------------------------------
+  /// Slice planes of the anatomical image that closed surfaces are cut with on export
+  struct PlanarContourSliceGeometry
+  {
+    /// World position of the origin of the image (IJK=0,0,0)
+    double Origin[3]{0.0,0.0,0.0};
+    /// Unit direction of the I and J axes of the image, spanning the slice planes
+    double AxisX[3]{1.0,0.0,0.0};
+    double AxisY[3]{0.0,1.0,0.0};
+    /// Unit normal of the slice planes (direction of the K axis of the image)
+    double Normal[3]{0.0,0.0,1.0};
+    /// Distance between slices
+    double SliceSpacing{1.0};
+  };
+
+  //---------------------------------------------------------------------------
+  /// Get the slice geometry of an image. Slice planes are perpendicular to the unit normal
+  /// (the direction of the K axis of the image), at the given distance from the origin of the image
+  void GetPlanarContourSliceGeometry(vtkOrientedImageData* image, PlanarContourSliceGeometry& sliceGeometry)
+  {
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    image->GetImageToWorldMatrix(imageToWorldMatrix);
+    for (int axis=0; axis<3; ++axis)
+    {
+      sliceGeometry.Origin[axis] = imageToWorldMatrix->GetElement(axis,3);
+      sliceGeometry.AxisX[axis] = imageToWorldMatrix->GetElement(axis,0);
+      sliceGeometry.AxisY[axis] = imageToWorldMatrix->GetElement(axis,1);
+      sliceGeometry.Normal[axis] = imageToWorldMatrix->GetElement(axis,2);
+    }
+    vtkMath::Normalize(sliceGeometry.AxisX);
+    vtkMath::Normalize(sliceGeometry.AxisY);
+    sliceGeometry.SliceSpacing = vtkMath::Normalize(sliceGeometry.Normal);
+  }
+
+  //---------------------------------------------------------------------------
+  /// Planar contours of a segment, cut from its closed surface
+  struct SegmentPlanarContours
+  {
+    /// Slice index (K) of the first element of \sa SliceLines and \sa SliceContours
+    int FirstSlice{0};
+    /// Points of the polylines cut from the closed surface
+    vtkSmartPointer<vtkPoints> Points;
+    /// Point IDs of the polylines in each slice
+    std::vector< std::vector< std::vector<vtkIdType> > > SliceLines;
+    /// Planar contours in each slice, with polygons as cells. Empty slices contain nullptr
+    std::vector< vtkSmartPointer<vtkPolyData> > SliceContours;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Cut a closed surface with all slice planes between minSlice and maxSlice that intersect it, in one pass,
+  /// and sort the resulting polylines by slice. Uses only local pipelines, so it can be called from multiple
+  /// threads at the same time for different surfaces.
+  void CutClosedSurfaceWithSlices(vtkPolyData* closedSurface, const PlanarContourSliceGeometry& sliceGeometry,
+    int minSlice, int maxSlice, SegmentPlanarContours& contours)
+  {
+    if (!closedSurface || closedSurface->GetNumberOfPoints() == 0)
+    {
+      return;
+    }
+
+    // Determine the range of slices intersecting the bounding box of the surface
+    double bounds[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
+    closedSurface->GetBounds(bounds);
+    double minDistance = VTK_DOUBLE_MAX;
+    double maxDistance = -VTK_DOUBLE_MAX;
+    for (int corner=0; corner<8; ++corner)
+    {
+      double cornerPoint[3] = { bounds[(corner & 1) ? 1 : 0], bounds[(corner & 2) ? 3 : 2], bounds[(corner & 4) ? 5 : 4] };
+      double relativePoint[3] = {0.0,0.0,0.0};
+      vtkMath::Subtract(cornerPoint, sliceGeometry.Origin, relativePoint);
+      double distance = vtkMath::Dot(relativePoint, sliceGeometry.Normal);
+      minDistance = std::min(minDistance, distance);
+      maxDistance = std::max(maxDistance, distance);
+    }
+    int firstSlice = std::max(minSlice, static_cast<int>(std::ceil(minDistance / sliceGeometry.SliceSpacing)));
+    int lastSlice = std::min(maxSlice, static_cast<int>(std::floor(maxDistance / sliceGeometry.SliceSpacing)));
+    if (firstSlice > lastSlice)
+    {
+      return;
+    }
+
+    // Cut with all the slice planes at once (contour values are the distances of the planes from the origin)
+    vtkNew<vtkPlane> slicePlane;
+    slicePlane->SetOrigin(sliceGeometry.Origin[0], sliceGeometry.Origin[1], sliceGeometry.Origin[2]);
+    slicePlane->SetNormal(sliceGeometry.Normal[0], sliceGeometry.Normal[1], sliceGeometry.Normal[2]);
+    vtkNew<vtkCutter> cutter;
+    cutter->SetInputData(closedSurface);
+    cutter->SetCutFunction(slicePlane);
+    cutter->SetGenerateCutScalars(0);
+    cutter->SetNumberOfContours(lastSlice - firstSlice + 1);
+    for (int slice=firstSlice; slice<=lastSlice; ++slice)
+    {
+      cutter->SetValue(slice - firstSlice, slice * sliceGeometry.SliceSpacing);
+    }
+    vtkNew<vtkStripper> stripper;
+    stripper->SetInputConnection(cutter->GetOutputPort());
+    stripper->Update();
+
+    vtkPolyData* slicePolyLines = stripper->GetOutput();
+    contours.FirstSlice = firstSlice;
+    contours.Points = slicePolyLines->GetPoints();
+    contours.SliceLines.resize(lastSlice - firstSlice + 1);
+    if (!contours.Points)
+    {
+      return;
+    }
+
+    // Sort polylines by slice, based on the position of their first point
+    vtkCellArray* lines = slicePolyLines->GetLines();
+    vtkNew<vtkIdList> linePointIds;
+    for (lines->InitTraversal(); lines->GetNextCell(linePointIds); )
+    {
+      if (linePointIds->GetNumberOfIds() < 2)
+      {
+        continue;
+      }
+      double point[3] = {0.0,0.0,0.0};
+      contours.Points->GetPoint(linePointIds->GetId(0), point);
+      vtkMath::Subtract(point, sliceGeometry.Origin, point);
+      int slice = vtkMath::Round(vtkMath::Dot(point, sliceGeometry.Normal) / sliceGeometry.SliceSpacing);
+      if (slice < firstSlice || slice > lastSlice)
+      {
+        continue;
+      }
+      contours.SliceLines[slice - firstSlice].push_back(
+        std::vector<vtkIdType>(linePointIds->GetPointer(0), linePointIds->GetPointer(0) + linePointIds->GetNumberOfIds()) );
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  /// Create the planar contours of a slice from the polylines cut from a closed surface.
+  /// The repeated closing point of closed polylines is removed, and contours with less than three points are dropped.
+  /// Contours are oriented by their nesting level: outer contours (even level) are counter-clockwise, holes (odd level)
+  /// are clockwise, when viewed against the slice normal. Can be called from multiple threads at the same time.
+  /// \return Poly data with the contours as polygons, nullptr if there are no valid contours in the slice
+  vtkSmartPointer<vtkPolyData> CreateSlicePlanarContours(vtkPoints* points, const std::vector< std::vector<vtkIdType> >& lines,
+    const PlanarContourSliceGeometry& sliceGeometry)
+  {
+    // Get point IDs and in-plane coordinates of the contours
+    std::vector< std::vector<vtkIdType> > contourPointIds;
+    std::vector< std::vector<double> > contourX;
+    std::vector< std::vector<double> > contourY;
+    for (const std::vector<vtkIdType>& line : lines)
+    {
+      std::vector<vtkIdType> pointIds(line);
+      if (pointIds.size() > 1 && pointIds.front() == pointIds.back())
+      {
+        pointIds.pop_back();
+      }
+      if (pointIds.size() < 3)
+      {
+        continue;
+      }
+      std::vector<double> x(pointIds.size());
+      std::vector<double> y(pointIds.size());
+      for (size_t pointIndex=0; pointIndex<pointIds.size(); ++pointIndex)
+      {
+        double point[3] = {0.0,0.0,0.0};
+        points->GetPoint(pointIds[pointIndex], point);
+        vtkMath::Subtract(point, sliceGeometry.Origin, point);
+        x[pointIndex] = vtkMath::Dot(point, sliceGeometry.AxisX);
+        y[pointIndex] = vtkMath::Dot(point, sliceGeometry.AxisY);
+      }
+      contourPointIds.push_back(pointIds);
+      contourX.push_back(x);
+      contourY.push_back(y);
+    }
+    if (contourPointIds.empty())
+    {
+      return nullptr;
+    }
+
+    vtkSmartPointer<vtkPoints> contourPoints = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkCellArray> contourPolys = vtkSmartPointer<vtkCellArray>::New();
+    for (size_t contourIndex=0; contourIndex<contourPointIds.size(); ++contourIndex)
+    {
+      const std::vector<double>& x = contourX[contourIndex];
+      const std::vector<double>& y = contourY[contourIndex];
+      size_t numberOfPoints = x.size();
+
+      // Nesting level is the number of other contours containing this one (contours cut from a closed surface do not cross)
+      int nestingLevel = 0;
+      for (size_t otherIndex=0; otherIndex<contourPointIds.size(); ++otherIndex)
+      {
+        if (otherIndex == contourIndex)
+        {
+          continue;
+        }
+        const std::vector<double>& otherX = contourX[otherIndex];
+        const std::vector<double>& otherY = contourY[otherIndex];
+        bool inside = false;
+        for (size_t i=0, j=otherX.size()-1; i<otherX.size(); j=i++)
+        {
+          if ( ((otherY[i] > y[0]) != (otherY[j] > y[0]))
+            && (x[0] < (otherX[j]-otherX[i]) * (y[0]-otherY[i]) / (otherY[j]-otherY[i]) + otherX[i]) )
+          {
+            inside = !inside;
+          }
+        }
+        if (inside)
+        {
+          ++nestingLevel;
+        }
+      }
+
+      // Signed area is positive for counter-clockwise contours
+      double signedArea = 0.0;
+      for (size_t i=0, j=numberOfPoints-1; i<numberOfPoints; j=i++)
+      {
+        signedArea += x[j] * y[i] - x[i] * y[j];
+      }
+      bool reverse = ((nestingLevel % 2 == 0) != (signedArea > 0.0));
+
+      const std::vector<vtkIdType>& pointIds = contourPointIds[contourIndex];
+      contourPolys->InsertNextCell(static_cast<vtkIdType>(numberOfPoints));
+      for (size_t pointIndex=0; pointIndex<numberOfPoints; ++pointIndex)
+      {
+        double point[3] = {0.0,0.0,0.0};
+        points->GetPoint(pointIds[reverse ? numberOfPoints-1-pointIndex : pointIndex], point);
+        contourPolys->InsertCellPoint(contourPoints->InsertNextPoint(point));
+      }
+    }
+
+    vtkSmartPointer<vtkPolyData> contourPolyData = vtkSmartPointer<vtkPolyData>::New();
+    contourPolyData->SetPoints(contourPoints);
+    contourPolyData->SetPolys(contourPolys);
+    return contourPolyData;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -151,7 +411,27 @@ public:
   vtkInternal(vtkSlicerDicomRtImportExportModuleLogic* external);
   ~vtkInternal() = default;
 
+  /// Result of examining a single file in \sa ExamineForLoad
+  struct ExamineResult
+  {
+    /// Flag indicating that the file is a loadable RT object
+    bool Loadable{false};
+    /// Flag indicating that the file is an RT dose, whose name is completed with the referenced plan label
+    bool RtDose{false};
+    OFString Name;
+    std::vector<OFString> ReferencedSOPInstanceUIDs;
+  };
+
+  /// Examine a single file for \sa ExamineForLoad. Only the beginning of the file is parsed, up to the
+  /// attributes needed for the given RT object. Does not access the DICOM database, so it can be called
+  /// from multiple threads at the same time.
+  void ExamineFile(const std::string& fileName, ExamineResult& result);
+
+  /// Append the label of the referenced RT plan to the names of examined RT doses, using the DICOM database
+  void ExamineRtDoseReferencedPlanLabels(std::vector<ExamineResult>& results);
+
   /// Examine RT Dose dataset and assemble name and referenced SOP instances
+  /// The referenced RT plan label is added to the name by \sa ExamineRtDoseReferencedPlanLabels
   void ExamineRtDoseDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
 
   /// Examine RT Plan dataset and assemble name and referenced SOP instances
@@ -166,9 +446,45 @@ public:
   /// Examine RT Image dataset and assemble name and referenced SOP instances
   void ExamineRtImageDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
 
+  /// DICOM objects parsed from the file of a loadable by \sa ParseLoadable, waiting to be loaded into the scene
+  struct ParsedLoadable
+  {
+    std::string FileName;
+    vtkSmartPointer<vtkSlicerDicomRtReader> Reader;
+    /// Dose volume with the dose grid scaling applied, not added to the scene yet (only for RT dose).
+    /// Read by \sa ReadRtDoseVolume when the loadable is about to be loaded
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> DoseVolumeNode;
+    /// Set when reading the dose volume has been attempted, so that failed reads are not repeated
+    bool DoseVolumeRead{false};
+    /// Errors and warnings reported while parsing, logged by \sa LogParseMessages on the main thread
+    std::vector<std::string> Errors;
+    std::vector<std::string> Warnings;
+  };
+
+  /// Parse the DICOM file of a loadable. The pixel data of RT dose files is not read.
+  /// Does not access the MRML scene, the DICOM database or the output window, so it can be called from
+  /// multiple threads at the same time.
+  void ParseLoadable(const std::string& fileName, ParsedLoadable& parsedLoadable);
+
+  /// Read the dose volume of a parsed RT dose file and replace its stored pixel values with the dose values.
+  /// The volume node is not added to the scene and errors are only collected, so it can be called from
+  /// multiple threads at the same time.
+  void ReadRtDoseVolume(ParsedLoadable& parsedLoadable);
+
+  /// Read the dose volumes of the parsed loadable of a file and of the next parsed RT doses in parallel,
+  /// at most \sa MAXIMUM_NUMBER_OF_DOSE_VOLUMES_READ_AT_ONCE at a time
+  void ReadParsedRtDoseVolumes(const std::string& fileName);
+
+  /// Log and clear the errors and warnings collected while parsing a loadable. Must be called on the main thread
+  void LogParseMessages(ParsedLoadable& parsedLoadable);
+
+  /// Collect the errors and warnings of objects used while parsing into the parsed loadable given as client data
+  static void CollectParseMessagesCallback(vtkObject* caller, unsigned long eid, void* clientData, void* callData);
+
   /// Load RT Dose and related objects into the MRML scene
+  /// \param volumeNode Dose volume read by \sa ReadRtDoseVolume before the loadable is loaded
   /// \return Success flag
-  bool LoadRtDose(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable);
+  bool LoadRtDose(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable, vtkMRMLScalarVolumeNode* volumeNode);
 
   /// Load RT Plan and related objects into the MRML scene
   /// \return Success flag
@@ -182,7 +498,12 @@ public:
   vtkMRMLRTBeamNode* LoadStaticBeam(vtkSlicerDicomRtReader* rtReader, const char* seriesName, vtkMRMLRTPlanNode* planNode, int beamIndex,
     vtkMRMLTableNode* mlcTableNode, vtkMRMLTableNode* scanSpotTableNode);
 
-  /// Load dynamic beam (called from \sa LoadExternalBeamPlan)
+  /// Load dynamic beam into a single beam node (called from \sa LoadExternalBeamPlan)
+  /// Beam is dynamic or has multiple control points. The control points are stored in the
+  /// control point store of the beam node, and the first control point is set to the beam
+  vtkMRMLRTBeamNode* LoadDynamicBeam(vtkSlicerDicomRtReader* rtReader, const char* seriesName, vtkMRMLRTPlanNode* planNode, int beamIndex);
+
+  /// Load dynamic beam as sequences (called from \sa LoadExternalBeamPlan if control points are pre-materialized)
   /// Beam is dynamic or has multiple control points
   bool LoadDynamicBeamSequence( vtkSlicerDicomRtReader* rtReader, const char* seriesName, 
     vtkMRMLRTPlanNode* planNode, int beamIndex, vtkMRMLRTBeamNode* proxyBeamNode, 
@@ -229,6 +550,16 @@ public:
 
 public:
   vtkSlicerDicomRtImportExportModuleLogic* External;
+
+  /// Segments waiting for deferred closed surface conversion.
+  /// Each entry contains a segmentation node ID and the IDs of its segments that have not been converted yet
+  std::vector<std::pair<std::string, std::vector<std::string> > > ClosedSurfaceConversionQueue;
+
+  /// Loadables parsed by \sa vtkSlicerDicomRtImportExportModuleLogic::ParseDicomRT that have not been loaded yet,
+  /// keyed by the name of their file
+  std::map<std::string, ParsedLoadable> ParsedLoadables;
+  /// Names of the files in \sa ParsedLoadables, in the order of the loadables
+  std::vector<std::string> ParsedFileNames;
 };
 
 //----------------------------------------------------------------------------
@@ -263,7 +594,7 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(
     name += " [" + instanceNumber + "]";
   }
 
-  // Find RTPlan name for RTDose series
+  // Find referenced RTPlan for RTDose series
   OFString referencedSOPInstanceUID("");
   DRTDoseIOD rtDoseObject;
   if (rtDoseObject.read(*dataset).good())
@@ -281,8 +612,28 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(
       }
     }
   }
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseReferencedPlanLabels(std::vector<ExamineResult>& results)
+{
+  // Only open the database if there is a dose referencing a plan
+  bool referencedPlanFound = false;
+  for (const ExamineResult& result : results)
+  {
+    if (result.Loadable && result.RtDose && !result.ReferencedSOPInstanceUIDs.empty())
+    {
+      referencedPlanFound = true;
+      break;
+    }
+  }
+  if (!referencedPlanFound)
+  {
+    return;
+  }
 
-  // Create and open DICOM database to perform database operations for getting RTPlan name
+  // Create and open DICOM database to perform database operations for getting RTPlan name.
+  // The database is opened once for all the examined doses.
   QSettings settings;
   QString databaseDirectory = settings.value("DatabaseDirectory").toString();
   QString databaseFile = databaseDirectory + vtkSlicerDicomRtReader::DICOMREADER_DICOM_DATABASE_FILENAME.c_str();
@@ -292,10 +643,17 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(
   // Get RTPlan name to show it with the dose
   //TODO: Uncomment this line when figured out the reason for the crash, see https://github.com/SlicerRt/SlicerRT/issues/135
   QString rtPlanLabelTag("300a,0002");
-  QString rtPlanFileName = dicomDatabase->fileForInstance(referencedSOPInstanceUID.c_str());
-  if (!rtPlanFileName.isEmpty())
+  for (ExamineResult& result : results)
   {
-   name += OFString(": ") + OFString(dicomDatabase->fileValue(rtPlanFileName,rtPlanLabelTag).toUtf8().constData());
+    if (!result.Loadable || !result.RtDose || result.ReferencedSOPInstanceUIDs.empty())
+    {
+      continue;
+    }
+    QString rtPlanFileName = dicomDatabase->fileForInstance(result.ReferencedSOPInstanceUIDs.back().c_str());
+    if (!rtPlanFileName.isEmpty())
+    {
+      result.Name += OFString(": ") + OFString(dicomDatabase->fileValue(rtPlanFileName,rtPlanLabelTag).toUtf8().constData());
+    }
   }
 
   // Close and delete DICOM database
@@ -305,6 +663,100 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(
   QSqlDatabase::removeDatabase(QString(vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str()) + "TagCache");
 }
 
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineFile(const std::string& fileName, ExamineResult& result)
+{
+  result = ExamineResult();
+
+  // Parse the header only. Parsing stops before the ROI contour sequence, which is by far the largest part of
+  // a structure set, and values longer than the maximum read length (e.g. DVH data) are left in the file.
+  // All the attributes needed for structure sets precede the contours, and the other RT objects do not
+  // contain the ROI contour sequence, so this first pass reads their header up to the RT specific modules.
+  DcmFileFormat fileformat;
+  OFCondition condition = fileformat.loadFileUntilTag(fileName.c_str(), EXS_Unknown, EGL_noChange,
+    DCM_MaxReadLength, ERM_autoDetect, DCM_ROIContourSequence);
+  if (!condition.good())
+  {
+    return; // Failed to parse this file, skip it
+  }
+
+  // Check SOP Class UID for one of the supported RT objects
+  DcmDataset* dataset = fileformat.getDataset();
+  OFString sopClass;
+  if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
+  {
+    return; // Failed to parse this file, skip it
+  }
+
+  // Parse further the RT objects whose examined attributes follow the ROI contour sequence tag:
+  // until the pixel data for dose and image, and until the dose reference sequence for plans
+  // (i.e. before the beam sequences)
+  DcmTagKey stopTag = DCM_UndefinedTagKey;
+  if (sopClass == UID_RTDoseStorage || sopClass == UID_RTImageStorage)
+  {
+    stopTag = DCM_PixelData;
+  }
+  else if (sopClass == UID_RTPlanStorage || sopClass == UID_RTIonPlanStorage)
+  {
+    stopTag = DCM_DoseReferenceSequence;
+  }
+  if (stopTag != DCM_UndefinedTagKey)
+  {
+    condition = fileformat.loadFileUntilTag(fileName.c_str(), EXS_Unknown, EGL_noChange,
+      DCM_MaxReadLength, ERM_autoDetect, stopTag);
+    if (!condition.good())
+    {
+      return;
+    }
+    dataset = fileformat.getDataset();
+  }
+
+  // DICOM parsing is successful, now check if the object is loadable
+  OFString seriesNumber("");
+  dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
+  if (!seriesNumber.empty())
+  {
+    result.Name += seriesNumber + ": ";
+  }
+
+  // RTDose
+  if (sopClass == UID_RTDoseStorage)
+  {
+    this->ExamineRtDoseDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+    result.RtDose = true;
+  }
+  // RTPlan
+  else if (sopClass == UID_RTPlanStorage)
+  {
+    this->ExamineRtPlanDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+  }
+  // RTIonPlan
+  else if (sopClass == UID_RTIonPlanStorage)
+  {
+    this->ExamineRtPlanDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+  }
+  // RTStructureSet
+  else if (sopClass == UID_RTStructureSetStorage)
+  {
+    this->ExamineRtStructureSetDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+  }
+  // RTImage
+  else if (sopClass == UID_RTImageStorage)
+  {
+    this->ExamineRtImageDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+  }
+  /* Not yet supported
+  else if (sopClass == UID_RTTreatmentSummaryRecordStorage)
+  else if (sopClass == UID_RTIonBeamsTreatmentRecordStorage)
+  */
+  else
+  {
+    return; // Not an RT file
+  }
+
+  result.Loadable = true;
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtPlanDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> & vtkNotUsed(referencedSOPInstanceUIDs))
 {
@@ -363,84 +815,44 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtStructureSet
   DRTStructureSetIOD rtStructureSetObject;
   if (rtStructureSetObject.read(*dataset).good())
   {
-    DRTROIContourSequence &rtROIContourSequenceObject = rtStructureSetObject.getROIContourSequence();
-    if (rtROIContourSequenceObject.gotoFirstItem().good())
-    {
-      do // For all ROIs
-      {
-        DRTROIContourSequence::Item &currentRoiObject = rtROIContourSequenceObject.getCurrentItem();
-        if (currentRoiObject.isValid())
-        {
-          DRTContourSequence &rtContourSequenceObject = currentRoiObject.getContourSequence();
-          if (rtContourSequenceObject.gotoFirstItem().good())
-          {
-            do // For all contours
-            {
-              DRTContourSequence::Item &contourItem = rtContourSequenceObject.getCurrentItem();
-              if (!contourItem.isValid())
-              {
-                DRTContourImageSequence &rtContourImageSequenceObject = contourItem.getContourImageSequence();
-                if (rtContourImageSequenceObject.gotoFirstItem().good())
-                {
-                  DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequenceObject.getCurrentItem();
-                  if (rtContourImageSequenceItem.isValid())
-                  {
-                    OFString referencedSOPInstanceUID("");
-                    if (rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-                    {
-                      referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-                    }
-                  }
-                }
-              }
-            } // For all contours
-            while (rtContourSequenceObject.gotoNextItem().good());
-          }
-        }
-      } // For all ROIs
-      while (rtROIContourSequenceObject.gotoNextItem().good());
-    } // End ROIContourSequence
-
-    // If the above tags do not store the referenced instance UIDs, then look at the other possible place
-    if (referencedSOPInstanceUIDs.empty())
+    // The referenced image instance UIDs are listed in the referenced frame of reference sequence.
+    // The contours are not examined, as they are not parsed (\sa ExamineFile)
+    DRTReferencedFrameOfReferenceSequence &rtReferencedFrameOfReferenceSequenceObject = rtStructureSetObject.getReferencedFrameOfReferenceSequence();
+    if (rtReferencedFrameOfReferenceSequenceObject.gotoFirstItem().good())
     {
-      DRTReferencedFrameOfReferenceSequence &rtReferencedFrameOfReferenceSequenceObject = rtStructureSetObject.getReferencedFrameOfReferenceSequence();
-      if (rtReferencedFrameOfReferenceSequenceObject.gotoFirstItem().good())
+      DRTReferencedFrameOfReferenceSequence::Item &currentReferencedFrameOfReferenceSequenceItem = rtReferencedFrameOfReferenceSequenceObject.getCurrentItem();
+      if (currentReferencedFrameOfReferenceSequenceItem.isValid())
       {
-        DRTReferencedFrameOfReferenceSequence::Item &currentReferencedFrameOfReferenceSequenceItem = rtReferencedFrameOfReferenceSequenceObject.getCurrentItem();
-        if (currentReferencedFrameOfReferenceSequenceItem.isValid())
+        DRTRTReferencedStudySequence &rtReferencedStudySequenceObject = currentReferencedFrameOfReferenceSequenceItem.getRTReferencedStudySequence();
+        if (rtReferencedStudySequenceObject.gotoFirstItem().good())
         {
-          DRTRTReferencedStudySequence &rtReferencedStudySequenceObject = currentReferencedFrameOfReferenceSequenceItem.getRTReferencedStudySequence();
-          if (rtReferencedStudySequenceObject.gotoFirstItem().good())
+          DRTRTReferencedStudySequence::Item &rtReferencedStudySequenceItem = rtReferencedStudySequenceObject.getCurrentItem();
+          if (rtReferencedStudySequenceItem.isValid())
           {
-            DRTRTReferencedStudySequence::Item &rtReferencedStudySequenceItem = rtReferencedStudySequenceObject.getCurrentItem();
-            if (rtReferencedStudySequenceItem.isValid())
+            DRTRTReferencedSeriesSequence &rtReferencedSeriesSequenceObject = rtReferencedStudySequenceItem.getRTReferencedSeriesSequence();
+            if (rtReferencedSeriesSequenceObject.gotoFirstItem().good())
             {
-              DRTRTReferencedSeriesSequence &rtReferencedSeriesSequenceObject = rtReferencedStudySequenceItem.getRTReferencedSeriesSequence();
               if (rtReferencedSeriesSequenceObject.gotoFirstItem().good())
               {
-                if (rtReferencedSeriesSequenceObject.gotoFirstItem().good())
+                DRTRTReferencedSeriesSequence::Item &rtReferencedSeriesSequenceItem = rtReferencedSeriesSequenceObject.getCurrentItem();
+                if (rtReferencedSeriesSequenceItem.isValid())
                 {
-                  DRTRTReferencedSeriesSequence::Item &rtReferencedSeriesSequenceItem = rtReferencedSeriesSequenceObject.getCurrentItem();
-                  if (rtReferencedSeriesSequenceItem.isValid())
+                  DRTContourImageSequence &rtContourImageSequenceObject = rtReferencedSeriesSequenceItem.getContourImageSequence();
+                  if (rtContourImageSequenceObject.gotoFirstItem().good())
                   {
-                    DRTContourImageSequence &rtContourImageSequenceObject = rtReferencedSeriesSequenceItem.getContourImageSequence();
-                    if (rtContourImageSequenceObject.gotoFirstItem().good())
+                    do
                     {
-                      do
+                      DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequenceObject.getCurrentItem();
+                      if (rtContourImageSequenceItem.isValid())
                       {
-                        DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequenceObject.getCurrentItem();
-                        if (rtContourImageSequenceItem.isValid())
+                        OFString referencedSOPInstanceUID("");
+                        if (rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
                         {
-                          OFString referencedSOPInstanceUID("");
-                          if (rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-                          {
-                            referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-                          }
+                          referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
                         }
-                      } // For all contours
-                      while (rtContourImageSequenceObject.gotoNextItem().good());
-                    }
+                      }
+                    } // For all contours
+                    while (rtContourImageSequenceObject.gotoNextItem().good());
                   }
                 }
               }
@@ -448,7 +860,7 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtStructureSet
           }
         }
       }
-    } // End DRTReferencedFrameOfReferenceSequence
+    }
   } // End finding referenced instance UIDs
 }
 
@@ -487,68 +899,172 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtImageDataset
 }
 
 //---------------------------------------------------------------------------
-bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtDose(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable)
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::CollectParseMessagesCallback(
+  vtkObject* vtkNotUsed(caller), unsigned long eid, void* clientData, void* callData)
 {
-  vtkMRMLScene* scene = this->External->GetMRMLScene();
-  if (!scene)
+  ParsedLoadable* parsedLoadable = static_cast<ParsedLoadable*>(clientData);
+  const char* message = static_cast<const char*>(callData);
+  if (!parsedLoadable || !message)
   {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Invalid MRML scene");
-    return false;
+    return;
+  }
+  if (eid == vtkCommand::ErrorEvent)
+  {
+    parsedLoadable->Errors.push_back(message);
+  }
+  else if (eid == vtkCommand::WarningEvent)
+  {
+    parsedLoadable->Warnings.push_back(message);
   }
+}
 
-  const char* fileName = loadable->GetFiles()->GetValue(0);
-  const char* seriesName = loadable->GetName();
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ParseLoadable(const std::string& fileName, ParsedLoadable& parsedLoadable)
+{
+  parsedLoadable.FileName = fileName;
+  parsedLoadable.Reader = vtkSmartPointer<vtkSlicerDicomRtReader>::New();
+
+  // Messages of the reader are collected instead of being displayed, as this may run on a worker thread
+  vtkNew<vtkCallbackCommand> collectMessagesCallback;
+  collectMessagesCallback->SetCallback(vtkInternal::CollectParseMessagesCallback);
+  collectMessagesCallback->SetClientData(&parsedLoadable);
+  parsedLoadable.Reader->AddObserver(vtkCommand::ErrorEvent, collectMessagesCallback);
+  parsedLoadable.Reader->AddObserver(vtkCommand::WarningEvent, collectMessagesCallback);
+
+  parsedLoadable.Reader->SetFileName(fileName.c_str());
+  parsedLoadable.Reader->SetCacheDirectory(this->External->ParsedObjectCacheDirectory);
+  parsedLoadable.Reader->Update();
+
+  parsedLoadable.Reader->RemoveObserver(collectMessagesCallback);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ReadRtDoseVolume(ParsedLoadable& parsedLoadable)
+{
+  vtkSlicerDicomRtReader* rtReader = parsedLoadable.Reader;
+  const std::string& fileName = parsedLoadable.FileName;
+  if (!rtReader || !rtReader->GetLoadRTDoseSuccessful() || parsedLoadable.DoseVolumeRead)
+  {
+    return;
+  }
+  parsedLoadable.DoseVolumeRead = true;
 
   // Load Volume
   vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
   vtkSmartPointer<vtkMRMLScalarVolumeNode> volumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
-  volumeStorageNode->SetFileName(fileName);
+  volumeStorageNode->SetFileName(fileName.c_str());
   volumeStorageNode->ResetFileNameList();
   volumeStorageNode->SetSingleFile(1);
 
-  // Read volume from disk
-  if (!volumeStorageNode->ReadData(volumeNode))
-  {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Failed to load dose volume file '" << fileName << "' (series name '" << seriesName << "')");
-    return false;
+  // Read volume from disk. Messages of the storage node are collected instead of being displayed, as this may run on a worker thread
+  vtkNew<vtkCallbackCommand> collectMessagesCallback;
+  collectMessagesCallback->SetCallback(vtkInternal::CollectParseMessagesCallback);
+  collectMessagesCallback->SetClientData(&parsedLoadable);
+  volumeStorageNode->AddObserver(vtkCommand::ErrorEvent, collectMessagesCallback);
+  volumeStorageNode->AddObserver(vtkCommand::WarningEvent, collectMessagesCallback);
+  bool readSuccessful = volumeStorageNode->ReadData(volumeNode);
+  volumeStorageNode->RemoveObserver(collectMessagesCallback);
+  vtkImageData* storedPixelData = volumeNode->GetImageData();
+  if (!readSuccessful || !storedPixelData || !storedPixelData->GetPointData() || !storedPixelData->GetPointData()->GetScalars())
+  {
+    parsedLoadable.Errors.push_back("ReadRtDoseVolume: Failed to load dose volume file '" + fileName + "'");
+    return;
   }
 
-  volumeNode->SetScene(this->External->GetMRMLScene());
-  std::string volumeNodeName = scene->GenerateUniqueName(seriesName);
-  volumeNode->SetName(volumeNodeName.c_str());
-
   // Set new spacing
   double* initialSpacing = volumeNode->GetSpacing();
   double* correctSpacing = rtReader->GetPixelSpacing();
   volumeNode->SetSpacing(correctSpacing[0], correctSpacing[1], initialSpacing[2]);
   volumeNode->SetAttribute(vtkSlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
-  scene->AddNode(volumeNode);
 
   // Apply dose grid scaling
   if (!rtReader->GetDoseGridScaling())
   {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Empty dose unit value found for dose volume " << volumeNode->GetName());
+    parsedLoadable.Errors.push_back("ReadRtDoseVolume: Empty dose unit value found for dose volume file '" + fileName + "'");
   }
   double doseGridScaling = vtkVariant(rtReader->GetDoseGridScaling()).ToDouble();
 
+  // Replace the stored pixel values with the dose values before adding the volume to the scene,
+  // so that the stored pixel data is released right away and observers only see the dose
   vtkSmartPointer<vtkImageData> floatVolumeData = vtkSmartPointer<vtkImageData>::New();
+  if (!vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling(storedPixelData, doseGridScaling, floatVolumeData))
+  {
+    parsedLoadable.Errors.push_back("ReadRtDoseVolume: Failed to apply dose grid scaling to dose volume file '" + fileName + "'");
+    return;
+  }
+  volumeNode->SetAndObserveImageData(floatVolumeData);
 
-  vtkSmartPointer<vtkImageCast> imageCast = vtkSmartPointer<vtkImageCast>::New();
-  imageCast->SetInputData(volumeNode->GetImageData());
-  imageCast->SetOutputScalarTypeToFloat();
-  imageCast->Update();
-  floatVolumeData->DeepCopy(imageCast->GetOutput());
+  parsedLoadable.DoseVolumeNode = volumeNode;
+}
 
-  float value = 0.0;
-  float* floatPtr = (float*)floatVolumeData->GetScalarPointer();
-  for (long i=0; i<floatVolumeData->GetNumberOfPoints(); ++i)
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ReadParsedRtDoseVolumes(const std::string& fileName)
+{
+  // Dose volumes of the file and of the next parsed RT doses that have not been read yet
+  std::vector<ParsedLoadable*> doseLoadables;
+  std::vector<std::string>::iterator fileNameIt = std::find(this->ParsedFileNames.begin(), this->ParsedFileNames.end(), fileName);
+  for ( ; fileNameIt != this->ParsedFileNames.end() && doseLoadables.size() < MAXIMUM_NUMBER_OF_DOSE_VOLUMES_READ_AT_ONCE; ++fileNameIt)
   {
-    value = (*floatPtr) * doseGridScaling;
-    (*floatPtr) = value;
-    ++floatPtr;
+    std::map<std::string, ParsedLoadable>::iterator parsedLoadableIt = this->ParsedLoadables.find(*fileNameIt);
+    if ( parsedLoadableIt != this->ParsedLoadables.end() && parsedLoadableIt->second.Reader
+      && parsedLoadableIt->second.Reader->GetLoadRTDoseSuccessful() && !parsedLoadableIt->second.DoseVolumeRead )
+    {
+      doseLoadables.push_back(&parsedLoadableIt->second);
+    }
   }
 
-  volumeNode->SetAndObserveImageData(floatVolumeData);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(doseLoadables.size()), [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType doseIndex=begin; doseIndex<end; ++doseIndex)
+    {
+      this->ReadRtDoseVolume(*doseLoadables[doseIndex]);
+    }
+  });
+
+  for (ParsedLoadable* doseLoadable : doseLoadables)
+  {
+    this->LogParseMessages(*doseLoadable);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LogParseMessages(ParsedLoadable& parsedLoadable)
+{
+  for (const std::string& error : parsedLoadable.Errors)
+  {
+    vtkErrorWithObjectMacro(this->External, "Error while loading file '" << parsedLoadable.FileName << "': " << error);
+  }
+  for (const std::string& warning : parsedLoadable.Warnings)
+  {
+    vtkWarningWithObjectMacro(this->External, "Warning while loading file '" << parsedLoadable.FileName << "': " << warning);
+  }
+  parsedLoadable.Errors.clear();
+  parsedLoadable.Warnings.clear();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtDose(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable,
+  vtkMRMLScalarVolumeNode* volumeNode)
+{
+  vtkMRMLScene* scene = this->External->GetMRMLScene();
+  if (!scene)
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Invalid MRML scene");
+    return false;
+  }
+
+  const char* seriesName = loadable->GetName();
+  if (!volumeNode)
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Failed to load dose volume (series name '" << seriesName << "')");
+    return false;
+  }
+
+  volumeNode->SetScene(scene);
+  std::string volumeNodeName = scene->GenerateUniqueName(seriesName);
+  volumeNode->SetName(volumeNodeName.c_str());
+  scene->AddNode(volumeNode);
+  double doseGridScaling = vtkVariant(rtReader->GetDoseGridScaling()).ToDouble();
 
   // Get default isodose color table and default dose color table
   vtkMRMLColorTableNode* defaultIsodoseColorTable = vtkSlicerIsodoseModuleLogic::GetDefaultIsodoseColorTable(scene);
@@ -822,8 +1338,13 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadExternalBeamPlan(
     {
       ionBeamNode = vtkMRMLRTIonBeamNode::SafeDownCast(beamNode);
     }
-    else if (!singleBeam && this->LoadDynamicBeamSequence( rtReader, seriesName, 
-      planNode, beamIndex, beamNode, beamTransformNode, mlcTableNode, scanSpotTableNode))
+    else if (!singleBeam && !this->External->PreMaterializeControlPoints
+      && (beamNode = this->LoadDynamicBeam( rtReader, seriesName, planNode, beamIndex)))
+    {
+    }
+    else if (!singleBeam && this->External->PreMaterializeControlPoints
+      && this->LoadDynamicBeamSequence( rtReader, seriesName, planNode, beamIndex,
+      beamNode, beamTransformNode, mlcTableNode, scanSpotTableNode))
     {
     }
     else
@@ -871,10 +1392,7 @@ vtkMRMLRTBeamNode* vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadSta
   double jawPositions[2][2] = {{0.0, 0.0},{0.0, 0.0}};
   if (rtReader->GetBeamControlPointJawPositions( dicomBeamNumber, 0, jawPositions))
   {
-    beamNode->SetX1Jaw(jawPositions[0][0]);
-    beamNode->SetX2Jaw(jawPositions[0][1]);
-    beamNode->SetY1Jaw(jawPositions[1][0]);
-    beamNode->SetY2Jaw(jawPositions[1][1]);
+    beamNode->SetJawPositions( jawPositions[0][0], jawPositions[0][1], jawPositions[1][0], jawPositions[1][1]);
   }
 
   beamNode->SetGantryAngle(rtReader->GetBeamControlPointGantryAngle( dicomBeamNumber, 0));
@@ -959,6 +1477,11 @@ vtkMRMLRTBeamNode* vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadSta
       0, positions, weights);
     if (result)
     {
+      // Columnar scan spot map of the beam, the table node is created as a view of it
+      ionBeamNode->AddScanSpotEnergyLayer( 
+        rtReader->GetBeamControlPointNominalBeamEnergy( dicomBeamNumber, 0),
+        rtReader->GetBeamControlPointScanSpotTuneId( dicomBeamNumber, 0), positions, weights);
+
       scanSpotTableNode = CreateScanSpotTableNode( "ScanSpot_PositionMap_MetersetWeights", positions, weights);
     }
     else
@@ -1032,6 +1555,103 @@ vtkMRMLRTBeamNode* vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadSta
   return beamNode;
 }
 
+//---------------------------------------------------------------------------
+vtkMRMLRTBeamNode* vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadDynamicBeam( 
+  vtkSlicerDicomRtReader* rtReader, const char* seriesName, vtkMRMLRTPlanNode* planNode, int beamIndex)
+{
+  // Beam node, transform, MLC and scan spot tables are created from the first control point
+  // the same way as for a static beam
+  vtkMRMLRTBeamNode* beamNode = this->LoadStaticBeam( rtReader, seriesName, planNode, beamIndex, nullptr, nullptr);
+  if (!beamNode)
+  {
+    return nullptr;
+  }
+  vtkMRMLRTIonBeamNode* ionBeamNode = vtkMRMLRTIonBeamNode::SafeDownCast(beamNode);
+
+  unsigned int dicomBeamNumber = rtReader->GetBeamNumberForIndex(beamIndex);
+  unsigned int nofControlPoints = rtReader->GetBeamNumberOfControlPoints(dicomBeamNumber);
+
+  // Jaw positions that are not present in a control point are unchanged from the previous one
+  double jaws[4] = { beamNode->GetX1Jaw(), beamNode->GetX2Jaw(), beamNode->GetY1Jaw(), beamNode->GetY2Jaw() };
+
+  // Buffers are reused for all control points, so that their memory is only allocated once
+  std::vector<double> boundaries, positions;
+  std::vector<float> spotPositions, spotWeights;
+
+  // Fill control point store of the beam. No nodes are created for the individual control points
+  bool controlPointsAdded = true;
+  {
+    // Modifications are blocked only while the control points are added, so that a failed beam can be removed
+    MRMLNodeModifyBlocker blocker(beamNode);
+    for ( unsigned int controlPointIndex = 0; controlPointIndex < nofControlPoints && controlPointsAdded; ++controlPointIndex)
+    {
+      double jawPositions[2][2] = {{0.0, 0.0},{0.0, 0.0}};
+      if (rtReader->GetBeamControlPointJawPositions( dicomBeamNumber, controlPointIndex, jawPositions))
+      {
+        jaws[0] = jawPositions[0][0];
+        jaws[1] = jawPositions[0][1];
+        jaws[2] = jawPositions[1][0];
+        jaws[3] = jawPositions[1][1];
+      }
+
+      if (!rtReader->GetBeamControlPointMultiLeafCollimatorPositions( dicomBeamNumber, 
+        controlPointIndex, boundaries, positions))
+      {
+        positions.clear();
+      }
+
+      if (beamNode->AddControlPoint( 
+        rtReader->GetBeamControlPointGantryAngle( dicomBeamNumber, controlPointIndex),
+        rtReader->GetBeamControlPointBeamLimitingDeviceAngle( dicomBeamNumber, controlPointIndex),
+        rtReader->GetBeamControlPointPatientSupportAngle( dicomBeamNumber, controlPointIndex),
+        jaws, rtReader->GetBeamControlPointCumulativeMetersetWeight( dicomBeamNumber, controlPointIndex),
+        positions) < 0)
+      {
+        vtkErrorWithObjectMacro( this->External, "LoadDynamicBeam: Failed to add control point " 
+          << controlPointIndex << " to beam " << beamNode->GetName());
+        controlPointsAdded = false;
+        continue;
+      }
+
+      // Scan spots of the further control points are added to the scan spot map of the ion beam
+      // (control point 0 has been added when the beam was created)
+      if (ionBeamNode && controlPointIndex > 0)
+      {
+        if (rtReader->GetBeamControlPointScanSpotParameters( dicomBeamNumber, 
+          controlPointIndex, spotPositions, spotWeights))
+        {
+          ionBeamNode->AddScanSpotEnergyLayer( 
+            rtReader->GetBeamControlPointNominalBeamEnergy( dicomBeamNumber, controlPointIndex),
+            rtReader->GetBeamControlPointScanSpotTuneId( dicomBeamNumber, controlPointIndex), spotPositions, spotWeights);
+        }
+      }
+    }
+  }
+
+  if (!controlPointsAdded)
+  {
+    // Remove the partially loaded beam together with the nodes created for it
+    vtkMRMLScene* scene = beamNode->GetScene();
+    vtkSmartPointer<vtkMRMLTransformNode> beamTransformNode = beamNode->GetParentTransformNode();
+    vtkSmartPointer<vtkMRMLTableNode> mlcTableNode = beamNode->GetMultiLeafCollimatorTableNode();
+    vtkSmartPointer<vtkMRMLTableNode> scanSpotTableNode = (ionBeamNode ? ionBeamNode->GetScanSpotTableNode() : nullptr);
+    planNode->RemoveBeam(beamNode);
+    for (vtkMRMLNode* node : { static_cast<vtkMRMLNode*>(beamTransformNode), 
+      static_cast<vtkMRMLNode*>(mlcTableNode), static_cast<vtkMRMLNode*>(scanSpotTableNode) })
+    {
+      if (node && node->GetScene() == scene)
+      {
+        scene->RemoveNode(node);
+      }
+    }
+    return nullptr;
+  }
+
+  // The scan spot table of the beam is kept in sync with the scan spot map, so it shows the scan spots of all control points
+  beamNode->SetCurrentControlPointIndex(0);
+  return beamNode;
+}
+
 //---------------------------------------------------------------------------
 bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadDynamicBeamSequence( 
   vtkSlicerDicomRtReader* rtReader, const char* seriesName, 
@@ -1152,10 +1772,7 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadDynamicBeamSequen
     double jawPositions[2][2] = {{0.0, 0.0},{0.0, 0.0}};
     if (rtReader->GetBeamControlPointJawPositions( dicomBeamNumber, controlPointIndex, jawPositions))
     {
-      beamNode->SetX1Jaw(jawPositions[0][0]);
-      beamNode->SetX2Jaw(jawPositions[0][1]);
-      beamNode->SetY1Jaw(jawPositions[1][0]);
-      beamNode->SetY2Jaw(jawPositions[1][1]);
+      beamNode->SetJawPositions( jawPositions[0][0], jawPositions[0][1], jawPositions[1][0], jawPositions[1][1]);
     }
 
     beamNode->SetGantryAngle(rtReader->GetBeamControlPointGantryAngle( dicomBeamNumber, controlPointIndex));
@@ -1224,6 +1841,11 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadDynamicBeamSequen
         controlPointIndex, positions, weights);
       if (result)
       {
+        // Columnar scan spot map of the control point beam, the table node is created as a view of it
+        ionBeamNode->AddScanSpotEnergyLayer( 
+          rtReader->GetBeamControlPointNominalBeamEnergy( dicomBeamNumber, controlPointIndex),
+          rtReader->GetBeamControlPointScanSpotTuneId( dicomBeamNumber, controlPointIndex), positions, weights);
+
         scanSpotTableNode = CreateScanSpotTableNode( "ScanSpot_PositionMap_MetersetWeights", 
           positions, weights, tableSequenceNode->GetSequenceScene());
 
@@ -1462,6 +2084,8 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
   // Number of loaded points. Used to prevent unreasonably long loading times with the downside of a less nice initial representation
   long maximumNumberOfPoints = -1;
   long totalNumberOfPoints = 0;
+  // Segments created for the contour ROIs. They are added to the segmentation in one batch after all ROIs are processed
+  std::vector<vtkSmartPointer<vtkSegment> > segments;
 
   // Add ROIs
   int numberOfRois = rtReader->GetNumberOfRois();
@@ -1593,27 +2217,45 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
         segmentationNode->GetSegmentation()->SetConversionParameter(vtkPlanarContourToClosedSurfaceConversionRule::GetDefaultSliceThicknessParameterName(), defaultSliceThicknessStream.str());
       }
 
-      // Add segment for current structure
+      // Create segment for current structure
       vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
       segment->SetName(roiLabel);
       segment->SetColor(roiColor[0], roiColor[1], roiColor[2]);
       segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(), roiPolyData);
-      segmentationNode->GetSegmentation()->AddSegment(segment);
 
       // Add DICOM ROI number as tag to the segment
       std::stringstream roiNumberStream;
       roiNumberStream << rtReader->GetRoiNumber(internalROIIndex);
       segment->SetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_NUMBER_SEGMENT_TAG_NAME, roiNumberStream.str());
+
+      segments.push_back(segment);
     }
   } // for all ROIs
 
+  // Add segments in a single modification of the segmentation node so that observers
+  // (display node, subject hierarchy, views) are only updated once for the whole structure set
+  if (segmentationNode.GetPointer() && !segments.empty())
+  {
+    MRMLNodeModifyBlocker segmentationNodeBlocker(segmentationNode);
+    MRMLNodeModifyBlocker segmentationDisplayNodeBlocker(segmentationDisplayNode);
+    for (vtkSegment* segment : segments)
+    {
+      segmentationNode->GetSegmentation()->AddSegment(segment);
+    }
+  }
+
   // Force showing closed surface model instead of contour points and calculate auto opacity values for segments
   // Do not set closed surface display in case of extremely large structures, to prevent unreasonably long load times
   if (segmentationDisplayNode.GetPointer())
   {
     // Arbitrary thresholds, can revisit
     vtkDebugWithObjectMacro(this->External, "LoadRtStructureSet: Maximum number of points in a segment = " << maximumNumberOfPoints << ", Total number of points in segmentation = " << totalNumberOfPoints);
-    if (maximumNumberOfPoints < 800000 && totalNumberOfPoints < 3000000)
+    if (this->External->DeferClosedSurfaceConversion && maximumNumberOfPoints < 800000)
+    {
+      // Planar contours are shown until the visible segments are converted by ProcessClosedSurfaceConversionQueue
+      this->External->QueueClosedSurfaceConversion(segmentationNode);
+    }
+    else if (maximumNumberOfPoints < 800000 && totalNumberOfPoints < 3000000)
     {
       segmentationDisplayNode->SetPreferredDisplayRepresentationName3D(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
       segmentationDisplayNode->SetPreferredDisplayRepresentationName2D(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
@@ -1857,13 +2499,14 @@ vtkMRMLTableNode* vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::CreateSc
     msWeights->SetName("Weight");
     table->AddColumn(msWeights);
 
+    // Fill typed columns directly, setting values through variants is slow for large spot maps
     vtkIdType size = positions.size() / 2;
     table->SetNumberOfRows(size);
     for ( vtkIdType row = 0; row < size; ++row)
     {
-      table->SetValue( row, 0, positions[2 * row]);
-      table->SetValue( row, 1, positions[2 * row + 1]);
-      table->SetValue( row, 2, weights[row]);
+      posX->SetValue( row, positions[2 * row]);
+      posY->SetValue( row, positions[2 * row + 1]);
+      msWeights->SetValue( row, weights[row]);
     }
     tableNode->SetUseColumnNameAsColumnHeader(true);
     tableNode->SetColumnDescription( "X", "Scan spot positions X");
@@ -2197,6 +2840,9 @@ vtkSlicerDicomRtImportExportModuleLogic::vtkSlicerDicomRtImportExportModuleLogic
   this->BeamsLogic = nullptr;
 
   this->BeamModelsInSeparateBranch = true;
+  this->PreMaterializeControlPoints = false;
+  this->DeferClosedSurfaceConversion = false;
+  this->ParsedObjectCacheDirectory = nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -2205,6 +2851,7 @@ vtkSlicerDicomRtImportExportModuleLogic::~vtkSlicerDicomRtImportExportModuleLogi
   this->SetIsodoseLogic(nullptr);
   this->SetPlanarImageLogic(nullptr);
   this->SetBeamsLogic(nullptr);
+  this->SetParsedObjectCacheDirectory(nullptr);
 
   if (this->Internal)
   {
@@ -2235,6 +2882,9 @@ void vtkSlicerDicomRtImportExportModuleLogic::OnMRMLSceneEndClose()
     vtkErrorMacro("OnMRMLSceneEndClose: Invalid MRML scene");
     return;
   }
+
+  this->Internal->ClosedSurfaceConversionQueue.clear();
+  this->ReleaseParsedDicomRT();
 }
 
 //-----------------------------------------------------------------------------
@@ -2265,82 +2915,121 @@ void vtkSlicerDicomRtImportExportModuleLogic::ExamineForLoad(vtkStringArray* fil
   }
   loadables->RemoveAllItems();
 
+  std::vector<std::string> fileNames(fileList->GetNumberOfValues());
   for (int fileIndex=0; fileIndex<fileList->GetNumberOfValues(); ++fileIndex)
   {
-    // Load file in DCMTK
-    DcmFileFormat fileformat;
-    vtkStdString fileName = fileList->GetValue(fileIndex);
-    OFCondition result = fileformat.loadFile(fileName.c_str(), EXS_Unknown);
-    if (!result.good())
-    {
-      continue; // Failed to parse this file, skip it
-    }
+    fileNames[fileIndex] = fileList->GetValue(fileIndex);
+  }
 
-    // Check SOP Class UID for one of the supported RT objects
-    DcmDataset *dataset = fileformat.getDataset();
-    OFString sopClass;
-    if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
+  // Parse the file headers in parallel. The DICOM database is only accessed afterwards from this thread.
+  std::vector<vtkInternal::ExamineResult> results(fileNames.size());
+  vtkSMPTools::For(0, static_cast<vtkIdType>(fileNames.size()), [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType fileIndex=begin; fileIndex<end; ++fileIndex)
     {
-      continue; // Failed to parse this file, skip it
+      this->Internal->ExamineFile(fileNames[fileIndex], results[fileIndex]);
     }
+  });
+  this->Internal->ExamineRtDoseReferencedPlanLabels(results);
 
-    // DICOM parsing is successful, now check if the object is loadable
-    OFString name("");
-    OFString seriesNumber("");
-    std::vector<OFString> referencedSOPInstanceUIDs;
-    dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
-    if (!seriesNumber.empty())
+  // Create loadables in the order of the files
+  for (size_t fileIndex=0; fileIndex<fileNames.size(); ++fileIndex)
+  {
+    const vtkInternal::ExamineResult& result = results[fileIndex];
+    if (!result.Loadable)
     {
-      name += seriesNumber + ": ";
+      continue;
     }
 
-    // RTDose
-    if (sopClass == UID_RTDoseStorage)
-    {
-      this->Internal->ExamineRtDoseDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTPlan
-    else if (sopClass == UID_RTPlanStorage)
-    {
-      this->Internal->ExamineRtPlanDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTIonPlan
-    else if (sopClass == UID_RTIonPlanStorage)
+    // The file is a loadable RT object, create and set up loadable
+    vtkNew<vtkSlicerDICOMLoadable> loadable;
+    loadable->SetName(result.Name.c_str());
+    loadable->AddFile(fileNames[fileIndex].c_str());
+    loadable->SetConfidence(1.0);
+    loadable->SetSelected(true);
+    for (const OFString& referencedSOPInstanceUID : result.ReferencedSOPInstanceUIDs)
     {
-      this->Internal->ExamineRtPlanDataset(dataset, name, referencedSOPInstanceUIDs);
+      loadable->AddReferencedInstanceUID(referencedSOPInstanceUID.c_str());
     }
-    // RTStructureSet
-    else if (sopClass == UID_RTStructureSetStorage)
+    loadables->AddItem(loadable);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::ParseDicomRT(vtkCollection* loadables)
+{
+  this->ReleaseParsedDicomRT();
+  if (!loadables)
+  {
+    return;
+  }
+
+  std::vector<std::string> fileNames;
+  for (int loadableIndex=0; loadableIndex<loadables->GetNumberOfItems(); ++loadableIndex)
+  {
+    vtkSlicerDICOMLoadable* loadable = vtkSlicerDICOMLoadable::SafeDownCast(loadables->GetItemAsObject(loadableIndex));
+    if (!loadable || !loadable->GetFiles() || loadable->GetFiles()->GetNumberOfValues() < 1)
     {
-      this->Internal->ExamineRtStructureSetDataset(dataset, name, referencedSOPInstanceUIDs);
+      continue;
     }
-    // RTImage
-    else if (sopClass == UID_RTImageStorage)
+    std::string fileName = loadable->GetFiles()->GetValue(0);
+    if (std::find(fileNames.begin(), fileNames.end(), fileName) == fileNames.end())
     {
-      this->Internal->ExamineRtImageDataset(dataset, name, referencedSOPInstanceUIDs);
+      fileNames.push_back(fileName);
     }
-    /* Not yet supported
-    else if (sopClass == UID_RTTreatmentSummaryRecordStorage)
-    else if (sopClass == UID_RTIonBeamsTreatmentRecordStorage)
-    */
-    else
+  }
+
+  // Parse the files in parallel. The MRML scene and the DICOM database are only accessed when the loadables are loaded,
+  // and the dose volumes are only read shortly before their loadable is loaded (see ReadParsedRtDoseVolumes).
+  std::vector<vtkInternal::ParsedLoadable> parsedLoadables(fileNames.size());
+  vtkSMPTools::For(0, static_cast<vtkIdType>(fileNames.size()), [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType fileIndex=begin; fileIndex<end; ++fileIndex)
     {
-      continue; // Not an RT file
+      this->Internal->ParseLoadable(fileNames[fileIndex], parsedLoadables[fileIndex]);
     }
+  });
 
-    // The file is a loadable RT object, create and set up loadable
-    vtkNew<vtkSlicerDICOMLoadable> loadable;
-    loadable->SetName(name.c_str());
-    loadable->AddFile(fileName.c_str());
-    loadable->SetConfidence(1.0);
-    loadable->SetSelected(true);
-    std::vector<OFString>::iterator uidIt;
-    for (uidIt = referencedSOPInstanceUIDs.begin(); uidIt != referencedSOPInstanceUIDs.end(); ++uidIt)
+  // Messages of the worker threads are logged here on the main thread
+  for (size_t fileIndex=0; fileIndex<fileNames.size(); ++fileIndex)
+  {
+    this->Internal->LogParseMessages(parsedLoadables[fileIndex]);
+    this->Internal->ParsedLoadables[fileNames[fileIndex]] = parsedLoadables[fileIndex];
+  }
+  this->Internal->ParsedFileNames = fileNames;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::ReleaseParsedDicomRT()
+{
+  this->Internal->ParsedLoadables.clear();
+  this->Internal->ParsedFileNames.clear();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRT(vtkCollection* loadables)
+{
+  if (!loadables)
+  {
+    vtkErrorMacro("LoadDicomRT: Invalid loadables collection");
+    return false;
+  }
+
+  this->ParseDicomRT(loadables);
+
+  // Create the nodes serially, in the order of the loadables
+  bool loadSuccessful = true;
+  for (int loadableIndex=0; loadableIndex<loadables->GetNumberOfItems(); ++loadableIndex)
+  {
+    vtkSlicerDICOMLoadable* loadable = vtkSlicerDICOMLoadable::SafeDownCast(loadables->GetItemAsObject(loadableIndex));
+    if (!this->LoadDicomRT(loadable))
     {
-      loadable->AddReferencedInstanceUID(uidIt->c_str());
+      loadSuccessful = false;
     }
-    loadables->AddItem(loadable);
   }
+
+  this->ReleaseParsedDicomRT();
+  return loadSuccessful;
 }
 
 //---------------------------------------------------------------------------
@@ -2358,9 +3047,26 @@ bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRT(vtkSlicerDICOMLoadable
 
   vtkDebugMacro("Loading series '" << loadable->GetName() << "' from file '" << firstFileName << "'");
 
-  vtkSmartPointer<vtkSlicerDicomRtReader> rtReader = vtkSmartPointer<vtkSlicerDicomRtReader>::New();
-  rtReader->SetFileName(firstFileName);
-  rtReader->Update();
+  // Use the objects parsed in advance if available, parse the file otherwise.
+  // Dose volumes of parsed loadables are read in parallel with the next few parsed doses.
+  vtkInternal::ParsedLoadable parsedLoadable;
+  std::map<std::string, vtkInternal::ParsedLoadable>::iterator parsedLoadableIt = this->Internal->ParsedLoadables.find(firstFileName);
+  if (parsedLoadableIt != this->Internal->ParsedLoadables.end())
+  {
+    if (parsedLoadableIt->second.Reader->GetLoadRTDoseSuccessful() && !parsedLoadableIt->second.DoseVolumeRead)
+    {
+      this->Internal->ReadParsedRtDoseVolumes(firstFileName);
+    }
+    parsedLoadable = parsedLoadableIt->second;
+    this->Internal->ParsedLoadables.erase(parsedLoadableIt);
+  }
+  else
+  {
+    this->Internal->ParseLoadable(firstFileName, parsedLoadable);
+    this->Internal->ReadRtDoseVolume(parsedLoadable);
+    this->Internal->LogParseMessages(parsedLoadable);
+  }
+  vtkSlicerDicomRtReader* rtReader = parsedLoadable.Reader;
 
   // One series can contain composite information, e.g, an RTPLAN series can contain structure sets and plans as well
   // TODO: vtkSlicerDicomRtReader class does not support this yet
@@ -2374,7 +3080,7 @@ bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRT(vtkSlicerDICOMLoadable
   // RTDOSE
   if (rtReader->GetLoadRTDoseSuccessful())
   {
-    loadSuccessful = this->Internal->LoadRtDose(rtReader, loadable);
+    loadSuccessful = this->Internal->LoadRtDose(rtReader, loadable, parsedLoadable.DoseVolumeNode);
   }
 
   // RTPLAN
@@ -2398,6 +3104,280 @@ bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRT(vtkSlicerDICOMLoadable
   return loadSuccessful;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling(vtkImageData* storedPixelData, double doseGridScaling, vtkImageData* doseImageData)
+{
+  if (!storedPixelData || !storedPixelData->GetPointData() || !storedPixelData->GetPointData()->GetScalars() || !doseImageData)
+  {
+    vtkGenericWarningMacro("vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling: Invalid input or output image");
+    return false;
+  }
+  if (storedPixelData == doseImageData)
+  {
+    vtkGenericWarningMacro("vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling: Input and output images must be different");
+    return false;
+  }
+
+  int numberOfComponents = storedPixelData->GetNumberOfScalarComponents();
+  doseImageData->SetExtent(storedPixelData->GetExtent());
+  doseImageData->SetOrigin(storedPixelData->GetOrigin());
+  doseImageData->SetSpacing(storedPixelData->GetSpacing());
+  doseImageData->AllocateScalars(VTK_FLOAT, numberOfComponents);
+
+  vtkIdType numberOfValues = storedPixelData->GetNumberOfPoints() * numberOfComponents;
+  float* doseValues = static_cast<float*>(doseImageData->GetScalarPointer());
+  void* storedValues = storedPixelData->GetScalarPointer();
+  switch (storedPixelData->GetScalarType())
+  {
+    vtkTemplateMacro( ApplyDoseGridScalingToValues(static_cast<VTK_TT*>(storedValues), doseValues, numberOfValues, doseGridScaling) );
+  default:
+    vtkGenericWarningMacro("vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling: Unknown scalar type in stored pixel data");
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::ResampleSegmentLabelmapToReferenceImage(
+  vtkOrientedImageData* binaryLabelmap, vtkOrientedImageData* referenceImage, vtkOrientedImageData* outputLabelmap)
+{
+  if (!binaryLabelmap || !referenceImage || !outputLabelmap)
+  {
+    vtkGenericWarningMacro("vtkSlicerDicomRtImportExportModuleLogic::ResampleSegmentLabelmapToReferenceImage: Invalid input or output image");
+    return false;
+  }
+
+  int referenceExtent[6] = {0,-1,0,-1,0,-1};
+  referenceImage->GetExtent(referenceExtent);
+  vtkNew<vtkMatrix4x4> referenceImageToWorldMatrix;
+  referenceImage->GetImageToWorldMatrix(referenceImageToWorldMatrix);
+
+  // Determine the region of the reference image covered by the non-empty part of the labelmap.
+  // Labelmap voxels are resampled with nearest neighbor interpolation, so they cover half a labelmap voxel
+  // around their centers. The corners of that region are transformed, not the voxel centers, so that
+  // labelmaps much coarser than the reference image are not clipped.
+  int croppedExtent[6] = {0,-1,0,-1,0,-1};
+  int effectiveExtent[6] = {0,-1,0,-1,0,-1};
+  if ( vtkOrientedImageDataResample::CalculateEffectiveExtent(binaryLabelmap, effectiveExtent)
+    && effectiveExtent[0] <= effectiveExtent[1] && effectiveExtent[2] <= effectiveExtent[3] && effectiveExtent[4] <= effectiveExtent[5] )
+  {
+    vtkNew<vtkTransform> labelmapToReferenceTransform;
+    vtkOrientedImageDataResample::GetTransformBetweenOrientedImages(binaryLabelmap, referenceImage, labelmapToReferenceTransform);
+    double croppedBounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    for (int corner=0; corner<8; ++corner)
+    {
+      double labelmapCorner[3] = {
+        (corner & 1) ? effectiveExtent[1] + 0.5 : effectiveExtent[0] - 0.5,
+        (corner & 2) ? effectiveExtent[3] + 0.5 : effectiveExtent[2] - 0.5,
+        (corner & 4) ? effectiveExtent[5] + 0.5 : effectiveExtent[4] - 0.5 };
+      double referenceCorner[3] = { 0.0, 0.0, 0.0 };
+      labelmapToReferenceTransform->TransformPoint(labelmapCorner, referenceCorner);
+      for (int axis=0; axis<3; ++axis)
+      {
+        croppedBounds[2*axis] = std::min(croppedBounds[2*axis], referenceCorner[axis]);
+        croppedBounds[2*axis+1] = std::max(croppedBounds[2*axis+1], referenceCorner[axis]);
+      }
+    }
+    for (int axis=0; axis<3; ++axis)
+    {
+      // Add one voxel margin so that rounding in the resampling cannot clip the segment
+      croppedExtent[2*axis] = std::max(static_cast<int>(std::floor(croppedBounds[2*axis])) - 1, referenceExtent[2*axis]);
+      croppedExtent[2*axis+1] = std::min(static_cast<int>(std::ceil(croppedBounds[2*axis+1])) + 1, referenceExtent[2*axis+1]);
+    }
+  }
+
+  vtkNew<vtkImageConstantPad> padder;
+  padder->SetConstant(0.0);
+  padder->SetOutputWholeExtent(referenceExtent);
+  vtkNew<vtkOrientedImageData> croppedLabelmap;
+  if (croppedExtent[0] > croppedExtent[1] || croppedExtent[2] > croppedExtent[3] || croppedExtent[4] > croppedExtent[5])
+  {
+    // Empty segment or segment outside the reference image: output is all zeros
+    croppedLabelmap->SetExtent(referenceExtent);
+    croppedLabelmap->AllocateScalars(binaryLabelmap->GetScalarType(), 1);
+    croppedLabelmap->GetPointData()->GetScalars()->Fill(0.0);
+  }
+  else
+  {
+    // Resample only within the cropped region of the reference geometry
+    vtkNew<vtkOrientedImageData> croppedReferenceImage;
+    croppedReferenceImage->SetGeometryFromImageToWorldMatrix(referenceImageToWorldMatrix);
+    croppedReferenceImage->SetExtent(croppedExtent);
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(binaryLabelmap, croppedReferenceImage, croppedLabelmap))
+    {
+      return false;
+    }
+  }
+
+  // Pad the cropped labelmap to the full reference extent
+  padder->SetInputData(croppedLabelmap);
+  padder->Update();
+  outputLabelmap->ShallowCopy(padder->GetOutput());
+  outputLabelmap->SetGeometryFromImageToWorldMatrix(referenceImageToWorldMatrix);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::CutClosedSurfaceToPlanarContours(
+  vtkPolyData* closedSurface, vtkOrientedImageData* referenceImage, vtkPolyData* outputContours)
+{
+  if (!closedSurface || !referenceImage || !outputContours)
+  {
+    vtkGenericWarningMacro("vtkSlicerDicomRtImportExportModuleLogic::CutClosedSurfaceToPlanarContours: Invalid input surface, reference image or output contours");
+    return false;
+  }
+
+  PlanarContourSliceGeometry sliceGeometry;
+  GetPlanarContourSliceGeometry(referenceImage, sliceGeometry);
+  int referenceExtent[6] = {0,-1,0,-1,0,-1};
+  referenceImage->GetExtent(referenceExtent);
+  SegmentPlanarContours contours;
+  CutClosedSurfaceWithSlices(closedSurface, sliceGeometry, referenceExtent[4], referenceExtent[5], contours);
+
+  // Gather the contours of all slices into one poly data
+  vtkNew<vtkPoints> outputPoints;
+  vtkNew<vtkCellArray> outputPolys;
+  vtkNew<vtkIdList> contourPointIds;
+  for (const std::vector< std::vector<vtkIdType> >& sliceLines : contours.SliceLines)
+  {
+    if (sliceLines.empty())
+    {
+      continue;
+    }
+    vtkSmartPointer<vtkPolyData> sliceContours = CreateSlicePlanarContours(contours.Points, sliceLines, sliceGeometry);
+    if (!sliceContours)
+    {
+      continue;
+    }
+    vtkCellArray* slicePolys = sliceContours->GetPolys();
+    for (slicePolys->InitTraversal(); slicePolys->GetNextCell(contourPointIds); )
+    {
+      outputPolys->InsertNextCell(contourPointIds->GetNumberOfIds());
+      for (vtkIdType pointIndex=0; pointIndex<contourPointIds->GetNumberOfIds(); ++pointIndex)
+      {
+        outputPolys->InsertCellPoint(outputPoints->InsertNextPoint(sliceContours->GetPoint(contourPointIds->GetId(pointIndex))));
+      }
+    }
+  }
+
+  outputContours->Initialize();
+  outputContours->SetPoints(outputPoints);
+  outputContours->SetPolys(outputPolys);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::QueueClosedSurfaceConversion(vtkMRMLSegmentationNode* segmentationNode)
+{
+  if (!segmentationNode || !segmentationNode->GetID() || !segmentationNode->GetSegmentation())
+  {
+    vtkErrorMacro("QueueClosedSurfaceConversion: Invalid segmentation node");
+    return;
+  }
+
+  std::vector<std::string> segmentIDs;
+  segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  if (segmentIDs.empty())
+  {
+    return;
+  }
+
+  this->Internal->ClosedSurfaceConversionQueue.push_back(std::make_pair(std::string(segmentationNode->GetID()), segmentIDs));
+  this->InvokeEvent(ClosedSurfaceConversionQueuedEvent);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::ProcessClosedSurfaceConversionQueue()
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene || this->Internal->ClosedSurfaceConversionQueue.empty())
+  {
+    return false;
+  }
+
+  std::string closedSurfaceName(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
+  auto entryIt = this->Internal->ClosedSurfaceConversionQueue.begin();
+  while (entryIt != this->Internal->ClosedSurfaceConversionQueue.end())
+  {
+    vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(scene->GetNodeByID(entryIt->first));
+    vtkMRMLSegmentationDisplayNode* displayNode = (segmentationNode ?
+      vtkMRMLSegmentationDisplayNode::SafeDownCast(segmentationNode->GetDisplayNode()) : nullptr);
+    if (!segmentationNode || !segmentationNode->GetSegmentation() || !displayNode)
+    {
+      // Segmentation has been removed
+      entryIt = this->Internal->ClosedSurfaceConversionQueue.erase(entryIt);
+      continue;
+    }
+    vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+
+    // Drop segments that have been removed or converted in the meantime (e.g. on request of another module),
+    // and find the first segment that is shown in 3D
+    std::vector<std::string>& segmentIDs = entryIt->second;
+    bool segmentationVisible3D = displayNode->GetVisibility() && displayNode->GetVisibility3D();
+    std::string segmentIdToConvert;
+    for (auto segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); )
+    {
+      vtkSegment* segment = segmentation->GetSegment(*segmentIdIt);
+      if (!segment || segment->GetRepresentation(closedSurfaceName))
+      {
+        segmentIdIt = segmentIDs.erase(segmentIdIt);
+        continue;
+      }
+      if (segmentIdToConvert.empty() && segmentationVisible3D
+        && displayNode->GetSegmentVisibility(*segmentIdIt) && displayNode->GetSegmentVisibility3D(*segmentIdIt))
+      {
+        segmentIdToConvert = *segmentIdIt;
+      }
+      ++segmentIdIt;
+    }
+
+    if (!segmentIdToConvert.empty())
+    {
+      if (!segmentation->ConvertSingleSegment(segmentIdToConvert, closedSurfaceName))
+      {
+        vtkErrorMacro("ProcessClosedSurfaceConversionQueue: Failed to convert segment " << segmentIdToConvert
+          << " of segmentation " << segmentationNode->GetName() << " to closed surface");
+      }
+      segmentIDs.erase(std::find(segmentIDs.begin(), segmentIDs.end(), segmentIdToConvert));
+      return true;
+    }
+
+    // No visible segment is waiting, show the converted closed surfaces
+    if (displayNode->GetPreferredDisplayRepresentationName3D() == nullptr
+      || closedSurfaceName != displayNode->GetPreferredDisplayRepresentationName3D())
+    {
+      MRMLNodeModifyBlocker blocker(displayNode);
+      displayNode->SetPreferredDisplayRepresentationName3D(closedSurfaceName.c_str());
+      displayNode->SetPreferredDisplayRepresentationName2D(closedSurfaceName.c_str());
+    }
+
+    if (segmentIDs.empty())
+    {
+      // All segments are converted, auto opacities can be calculated without triggering conversion
+      displayNode->CalculateAutoOpacitiesForSegments();
+      entryIt = this->Internal->ClosedSurfaceConversionQueue.erase(entryIt);
+    }
+    else
+    {
+      ++entryIt;
+    }
+  }
+
+  return false;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportModuleLogic::GetNumberOfPendingClosedSurfaceConversions()
+{
+  int numberOfPendingSegments = 0;
+  for (const auto& entry : this->Internal->ClosedSurfaceConversionQueue)
+  {
+    numberOfPendingSegments += static_cast<int>(entry.second.size());
+  }
+  return numberOfPendingSegments;
+}
+
 //----------------------------------------------------------------------------
 std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkCollection* exportables)
 {
@@ -2655,31 +3635,30 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
         return error;
       }
 
-      // Export each segment in segmentation
+      // Get labelmap of each segment in segmentation (accesses MRML, so it is done on the main thread)
       std::vector< std::string > segmentIDs;
       segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+      std::vector< vtkSmartPointer<vtkOrientedImageData> > binaryLabelmaps;
       for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
       {
         std::string segmentID = *segmentIdIt;
-        vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
 
-        // Get binary labelmap representation
+        // Get binary labelmap representation (copy it as it will be probably transformed and resampled)
+        vtkSmartPointer<vtkOrientedImageData> binaryLabelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
 #if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
-        vtkNew<vtkOrientedImageData> binaryLabelmap;
-        segmentationNode->GetBinaryLabelmapRepresentation(segmentID, binaryLabelmap);
+        segmentationNode->GetBinaryLabelmapRepresentation(segmentID, binaryLabelmapCopy);
 #else
+        vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentID);
         vtkOrientedImageData* binaryLabelmap = vtkOrientedImageData::SafeDownCast(
           segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
-#endif
         if (!binaryLabelmap)
         {
           error = "Failed to get binary labelmap representation from segment " + segmentID;
           vtkErrorMacro("ExportDicomRTStudy: " + error);
           return error;
         }
-        // Temporarily copy labelmap image data as it will be probably resampled
-        vtkSmartPointer<vtkOrientedImageData> binaryLabelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
         binaryLabelmapCopy->DeepCopy(binaryLabelmap);
+#endif
 
         // Apply parent transformation nodes if necessary
         if (segmentationNode->GetParentTransformNode())
@@ -2691,32 +3670,60 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
             return errorMessage;
           }
         }
-        // Make sure the labelmap dimensions match the reference dimensions
-        if ( !vtkOrientedImageDataResample::DoGeometriesMatch(imageOrientedImageData, binaryLabelmapCopy)
-          || !vtkOrientedImageDataResample::DoExtentsMatch(imageOrientedImageData, binaryLabelmapCopy) )
+        binaryLabelmaps.push_back(binaryLabelmapCopy);
+      } // For each segment
+
+      // Resample the labelmaps to the anatomical image and convert them to Plastimatch format in parallel.
+      // Each labelmap is only resampled within its own extent instead of the full anatomical image.
+      std::vector<UCharImageType::Pointer> itkStructures(segmentIDs.size());
+      std::vector<std::string> segmentErrors(segmentIDs.size());
+      vtkSMPTools::For(0, static_cast<vtkIdType>(segmentIDs.size()), [&](vtkIdType begin, vtkIdType end)
+      {
+        for (vtkIdType segmentIndex=begin; segmentIndex<end; ++segmentIndex)
         {
-          if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(binaryLabelmapCopy, imageOrientedImageData, binaryLabelmapCopy))
+          vtkOrientedImageData* binaryLabelmap = binaryLabelmaps[segmentIndex];
+
+          // Make sure the labelmap dimensions match the reference dimensions
+          vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = binaryLabelmap;
+          if ( !vtkOrientedImageDataResample::DoGeometriesMatch(imageOrientedImageData, binaryLabelmap)
+            || !vtkOrientedImageDataResample::DoExtentsMatch(imageOrientedImageData, binaryLabelmap) )
           {
-            error = "Failed to resample segment " + segmentID + " to match anatomical image geometry";
-            vtkErrorMacro("ExportDicomRTStudy: " + error);
-            return error;
+            resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+            if (!vtkSlicerDicomRtImportExportModuleLogic::ResampleSegmentLabelmapToReferenceImage(
+              binaryLabelmap, imageOrientedImageData, resampledLabelmap))
+            {
+              segmentErrors[segmentIndex] = "Failed to resample segment " + segmentIDs[segmentIndex] + " to match anatomical image geometry";
+              continue;
+            }
           }
+
+          // Convert mask to Plm image
+          Plm_image::Pointer plmStructure = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(resampledLabelmap);
+          if (!plmStructure)
+          {
+            segmentErrors[segmentIndex] = "Failed to convert segment labelmap " + segmentIDs[segmentIndex] + " to Plastimatch image";
+            continue;
+          }
+          itkStructures[segmentIndex] = plmStructure->itk_uchar();
         }
+      });
 
-        // Convert mask to Plm image
-        Plm_image::Pointer plmStructure = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(binaryLabelmapCopy);
-        if (!plmStructure)
+      // Add structures to the writer in segment order, so that the output does not depend on the threading
+      for (size_t segmentIndex=0; segmentIndex<segmentIDs.size(); ++segmentIndex)
+      {
+        if (!segmentErrors[segmentIndex].empty())
         {
-          error = "Failed to convert segment labelmap " + segmentID + " to Plastimatch image";
+          error = segmentErrors[segmentIndex];
           vtkErrorMacro("ExportDicomRTStudy: " + error);
           return error;
         }
 
         // Get segment properties
+        vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentIDs[segmentIndex]);
         std::string segmentName = segment->GetName();
         double* segmentColor = segment->GetColor();
 
-        rtWriter->AddStructure(plmStructure->itk_uchar(), segmentName.c_str(), segmentColor);
+        rtWriter->AddStructure(itkStructures[segmentIndex], segmentName.c_str(), segmentColor);
       } // For each segment
     }
     // If master representation is poly data type, then export from closed surface
@@ -2738,20 +3745,17 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
       {
         segmentationNode->GetParentTransformNode()->GetTransformToWorld(nodeToWorldTransform);
       }
-      // Initialize poly data transformer
-      vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-      transformPolyData->SetTransform(nodeToWorldTransform);
-
-      // Initialize cutting plane with normal of the Z axis of the anatomical image
-      vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      imageOrientedImageData->GetImageToWorldMatrix(imageToWorldMatrix);
-      double normal[3] = { imageToWorldMatrix->GetElement(0,2), imageToWorldMatrix->GetElement(1,2), imageToWorldMatrix->GetElement(2,2) };
-      vtkSmartPointer<vtkPlane> slicePlane = vtkSmartPointer<vtkPlane>::New();
-      slicePlane->SetNormal(normal);
-
-      // Export each segment in segmentation
+
+      // Get slice geometry of the anatomical image
+      PlanarContourSliceGeometry sliceGeometry;
+      GetPlanarContourSliceGeometry(imageOrientedImageData, sliceGeometry);
+      int imageExtent[6] = {0,-1,0,-1,0,-1};
+      imageOrientedImageData->GetExtent(imageExtent);
+
+      // Get closed surface of each segment in world coordinates (accesses MRML, so it is done on the main thread)
       std::vector< std::string > segmentIDs;
       segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+      std::vector< vtkSmartPointer<vtkPolyData> > worldSurfaces;
       for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
       {
         std::string segmentID = *segmentIdIt;
@@ -2767,69 +3771,76 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
           return error;
         }
 
-        // Initialize cutter pipeline for segment
+        vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+        transformPolyData->SetTransform(nodeToWorldTransform);
         transformPolyData->SetInputData(closedSurfacePolyData);
-        vtkSmartPointer<vtkCutter> cutter = vtkSmartPointer<vtkCutter>::New();
-        cutter->SetInputConnection(transformPolyData->GetOutputPort());
-        cutter->SetGenerateCutScalars(0);
-        vtkSmartPointer<vtkStripper> stripper = vtkSmartPointer<vtkStripper>::New();
-        stripper->SetInputConnection(cutter->GetOutputPort());
-
-        // Get segment bounding box
-        double bounds[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
         transformPolyData->Update();
-        transformPolyData->GetOutput()->GetBounds(bounds);
+        worldSurfaces.push_back(transformPolyData->GetOutput());
+      }
+
+      // Cut the closed surfaces with all the slice planes of the anatomical image they intersect, in parallel for the segments
+      std::vector<SegmentPlanarContours> segmentContours(segmentIDs.size());
+      vtkSMPTools::For(0, static_cast<vtkIdType>(segmentIDs.size()), [&](vtkIdType begin, vtkIdType end)
+      {
+        for (vtkIdType segmentIndex=begin; segmentIndex<end; ++segmentIndex)
+        {
+          CutClosedSurfaceWithSlices(worldSurfaces[segmentIndex], sliceGeometry, imageExtent[4], imageExtent[5], segmentContours[segmentIndex]);
+        }
+      });
+
+      // Create the planar contours of each slice of each segment in parallel
+      std::vector< std::pair<size_t, size_t> > segmentSlices;
+      for (size_t segmentIndex=0; segmentIndex<segmentContours.size(); ++segmentIndex)
+      {
+        for (size_t sliceIndex=0; sliceIndex<segmentContours[segmentIndex].SliceLines.size(); ++sliceIndex)
+        {
+          if (!segmentContours[segmentIndex].SliceLines[sliceIndex].empty())
+          {
+            segmentSlices.push_back(std::make_pair(segmentIndex, sliceIndex));
+          }
+        }
+        segmentContours[segmentIndex].SliceContours.resize(segmentContours[segmentIndex].SliceLines.size());
+      }
+      vtkSMPTools::For(0, static_cast<vtkIdType>(segmentSlices.size()), [&](vtkIdType begin, vtkIdType end)
+      {
+        for (vtkIdType index=begin; index<end; ++index)
+        {
+          SegmentPlanarContours& contours = segmentContours[segmentSlices[index].first];
+          size_t sliceIndex = segmentSlices[index].second;
+          contours.SliceContours[sliceIndex] = CreateSlicePlanarContours(contours.Points, contours.SliceLines[sliceIndex], sliceGeometry);
+        }
+      });
+
+      // Add contours to writer in segment order
+      for (size_t segmentIndex=0; segmentIndex<segmentIDs.size(); ++segmentIndex)
+      {
+        const SegmentPlanarContours& contours = segmentContours[segmentIndex];
 
         // Containers to be passed to the writer
         std::vector<int> sliceNumbers;
         std::vector<std::string> sliceUIDs;
         std::vector<vtkPolyData*> sliceContours;
-
-        // Create planar contours from closed surface based on each of the anatomical image slices
-        int imageExtent[6] = {0,-1,0,-1,0,-1};
-        imageOrientedImageData->GetExtent(imageExtent);
-        for (int slice=imageExtent[4]; slice<imageExtent[5]; ++slice)
+        for (size_t sliceIndex=0; sliceIndex<contours.SliceContours.size(); ++sliceIndex)
         {
-          // Calculate slice origin
-          double origin[3] = { imageToWorldMatrix->GetElement(0,3) + slice*normal[0],
-                               imageToWorldMatrix->GetElement(1,3) + slice*normal[1],
-                               imageToWorldMatrix->GetElement(2,3) + slice*normal[2] };
-          slicePlane->SetOrigin(origin);
-          if (origin[2] < bounds[4] || origin[2] > bounds[5])
+          if (!contours.SliceContours[sliceIndex])
           {
-            // No contours outside surface bounds
             continue;
           }
-
-          // Cut closed surface at slice
-          cutter->SetCutFunction(slicePlane);
-
           // Get instance UID of corresponding slice
-          int sliceNumber = slice-imageExtent[0];
+          int sliceNumber = contours.FirstSlice + static_cast<int>(sliceIndex) - imageExtent[4];
           sliceNumbers.push_back(sliceNumber);
           std::string sliceInstanceUID = (imageSliceUIDs.size() > static_cast<size_t>(sliceNumber) ? imageSliceUIDs[sliceNumber] : "");
           sliceUIDs.push_back(sliceInstanceUID);
-
-          // Save slice contour
-          stripper->Update();
-          vtkPolyData* sliceContour = vtkPolyData::New();
-          sliceContour->SetPoints(stripper->GetOutput()->GetPoints());
-          sliceContour->SetPolys(stripper->GetOutput()->GetLines());
-          sliceContours.push_back(sliceContour);
-        } // For each anatomical image slice
+          sliceContours.push_back(contours.SliceContours[sliceIndex]);
+        }
 
         // Get segment properties
+        vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentIDs[segmentIndex]);
         std::string segmentName = segment->GetName();
         double* segmentColor = segment->GetColor();
 
         // Add contours to writer
         rtWriter->AddStructure(segmentName.c_str(), segmentColor, sliceNumbers, sliceUIDs, sliceContours);
-
-        // Clean up slice contours
-        for (std::vector<vtkPolyData*>::iterator contourIt=sliceContours.begin(); contourIt!=sliceContours.end(); ++contourIt)
-        {
-          (*contourIt)->Delete();
-        }
       } // For each segment
     }
     else
@@ -35,12 +35,18 @@
 // Slicer includes
 #include "vtkSlicerModuleLogic.h"
 
+// VTK includes
+#include <vtkCommand.h>
+
 #include "vtkSlicerDicomRtImportExportModuleLogicExport.h"
 
 class vtkCollection;
+class vtkImageData;
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLScene;
 class vtkMRMLSegmentationNode;
+class vtkOrientedImageData;
+class vtkPolyData;
 class vtkSlicerBeamsModuleLogic;
 class vtkSlicerDICOMLoadable;
 class vtkSlicerDicomReaderBase;
@@ -57,15 +63,40 @@ public:
   vtkTypeMacro(vtkSlicerDicomRtImportExportModuleLogic, vtkSlicerModuleLogic);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
-  /// Examine a list of file lists and determine what objects can be loaded from them
+  enum
+  {
+    /// Invoked when segments are added to the deferred closed surface conversion queue
+    ClosedSurfaceConversionQueuedEvent = vtkCommand::UserEvent + 1
+  };
+
+  /// Examine a list of file lists and determine what objects can be loaded from them.
+  /// Only the headers of the files are parsed (up to the attributes needed for examination, so pixel
+  /// data and contour sequences are not read), and the files are examined in parallel.
   /// \param fileList List of files to examine and generate loadables from
   /// \param loadables Collection to store generated (output) loadables
   void ExamineForLoad(vtkStringArray* fileList, vtkCollection* loadables);
 
-  /// Load DICOM RT series from file name
+  /// Load DICOM RT series from file name.
+  /// If the loadable has been parsed in advance by \sa ParseDicomRT, then only the MRML nodes are created.
   /// /return True if loading successful
   bool LoadDicomRT(vtkSlicerDICOMLoadable* loadable);
 
+  /// Load multiple DICOM RT series. All loadables are parsed in parallel first (\sa ParseDicomRT),
+  /// then the MRML nodes are created in the order of the loadables.
+  /// \param loadables Collection of vtkSlicerDICOMLoadable objects to load
+  /// /return True if loading all loadables was successful
+  bool LoadDicomRT(vtkCollection* loadables);
+
+  /// Parse the DICOM files of loadables in parallel, ahead of loading them with \sa LoadDicomRT.
+  /// The RT objects are decoded without accessing the MRML scene, then they are kept until the loadables
+  /// are loaded, \sa ReleaseParsedDicomRT is called, the scene is closed, or this function is called again.
+  /// Dose volumes are not read here, but a few at a time in parallel when the RT doses are loaded.
+  /// \param loadables Collection of vtkSlicerDICOMLoadable objects to parse
+  void ParseDicomRT(vtkCollection* loadables);
+
+  /// Release the objects parsed by \sa ParseDicomRT that have not been loaded
+  void ReleaseParsedDicomRT();
+
   /// Export RT study (list of RT exportables) to DICOM files
   /// \return Error message, empty string if success
   std::string ExportDicomRTStudy(vtkCollection* exportables);
@@ -77,6 +108,47 @@ public:
   /// Insert currently loaded series in the proper place in subject hierarchy
   static void InsertSeriesInSubjectHierarchy(vtkSlicerDicomReaderBase* reader, vtkMRMLScene* scene);
 
+  /// Compute dose values from the stored pixel values of an RT dose by applying the dose grid scaling.
+  /// Type conversion and scaling are done in a single multithreaded pass that writes directly into
+  /// the float scalars of the output image, so no intermediate copy of the dose grid is made.
+  /// \param storedPixelData Image containing the stored pixel values (any scalar type)
+  /// \param doseGridScaling Dose Grid Scaling (3004,000E) value of the RT dose
+  /// \param doseImageData Output image, its geometry is set from the input and its scalars are allocated as float
+  /// \return Success flag
+  static bool ApplyDoseGridScaling(vtkImageData* storedPixelData, double doseGridScaling, vtkImageData* doseImageData);
+
+  /// Resample a segment labelmap to the geometry and extent of the reference image for RTSTRUCT export.
+  /// Only the region of the reference image that the segment occupies is resampled, the rest of the
+  /// output is filled with zeros, so the result is the same as resampling to the whole reference image.
+  /// Uses only local pipelines, so it can be called from multiple threads at the same time.
+  /// \return Success flag
+  static bool ResampleSegmentLabelmapToReferenceImage(
+    vtkOrientedImageData* binaryLabelmap, vtkOrientedImageData* referenceImage, vtkOrientedImageData* outputLabelmap);
+
+  /// Cut a closed surface with the slice planes of the reference image into planar contours for RTSTRUCT export.
+  /// Contours are oriented by their nesting level: outer contours are counter-clockwise, holes are clockwise,
+  /// when viewed against the slice normal (direction of the K axis of the reference image).
+  /// \param closedSurface Closed surface in world coordinates
+  /// \param outputContours Planar contours of all slices, with one polygon per contour
+  /// eturn Success flag
+  static bool CutClosedSurfaceToPlanarContours(
+    vtkPolyData* closedSurface, vtkOrientedImageData* referenceImage, vtkPolyData* outputContours);
+
+  /// Add all segments of a segmentation to the deferred closed surface conversion queue.
+  /// Called when a structure set is loaded with \sa DeferClosedSurfaceConversion on.
+  /// Invokes \sa ClosedSurfaceConversionQueuedEvent if segments are queued
+  void QueueClosedSurfaceConversion(vtkMRMLSegmentationNode* segmentationNode);
+
+  /// Convert the next segment waiting for deferred closed surface conversion (\sa DeferClosedSurfaceConversion).
+  /// Only segments that are visible in 3D are converted, hidden segments stay in the queue until they are shown.
+  /// When no visible segment of a structure set is waiting anymore, its display is switched to closed surface.
+  /// Meant to be called periodically from the application event loop, so that the GUI stays responsive.
+  /// \return True if a segment was converted, false if there was nothing to convert
+  bool ProcessClosedSurfaceConversionQueue();
+
+  /// Get number of segments (visible or hidden) waiting for deferred closed surface conversion
+  int GetNumberOfPendingClosedSurfaceConversions();
+
 public:
   /// Set Isodose module logic
   void SetIsodoseLogic(vtkSlicerIsodoseModuleLogic* isodoseLogic);
@@ -90,6 +162,17 @@ public:
   vtkGetMacro(BeamModelsInSeparateBranch, bool);
   vtkBooleanMacro(BeamModelsInSeparateBranch, bool);
 
+  vtkSetMacro(PreMaterializeControlPoints, bool);
+  vtkGetMacro(PreMaterializeControlPoints, bool);
+  vtkBooleanMacro(PreMaterializeControlPoints, bool);
+
+  vtkSetMacro(DeferClosedSurfaceConversion, bool);
+  vtkGetMacro(DeferClosedSurfaceConversion, bool);
+  vtkBooleanMacro(DeferClosedSurfaceConversion, bool);
+
+  vtkSetStringMacro(ParsedObjectCacheDirectory);
+  vtkGetStringMacro(ParsedObjectCacheDirectory);
+
 protected:
   void SetMRMLSceneInternal(vtkMRMLScene* newScene) override;
   void OnMRMLSceneEndClose() override;
@@ -121,6 +204,26 @@ private:
   /// Flag determining whether the generated beam models are arranged in a separate subject hierarchy
   /// branch, or each beam model is added under its corresponding isocenter fiducial
   bool BeamModelsInSeparateBranch;
+
+  /// Flag determining how dynamic beams (beams with more than two control points) are loaded.
+  /// If on, then a beam node, a transform node and an MLC or scan spot table node is created for each
+  /// control point and they are browsed with a sequence browser. If off (default), then a single beam
+  /// node is created, which stores the control points in its compact control point store, and the
+  /// geometry of a control point is set to the beam on demand (\sa vtkMRMLRTBeamNode::SetCurrentControlPointIndex),
+  /// e.g. when selected in the Beams module
+  bool PreMaterializeControlPoints;
+
+  /// Flag determining when the planar contours of a loaded structure set are converted to closed surface.
+  /// If off (default), then all segments are converted when the structure set is loaded. If on, then the
+  /// segments are queued and converted one by one by \sa ProcessClosedSurfaceConversionQueue when they are
+  /// visible in 3D. Until then the planar contours are shown. Modules needing other representations (such
+  /// as binary labelmap for DVH) convert the segments they use through the segmentation as usual.
+  bool DeferClosedSurfaceConversion;
+
+  /// Directory of the on-disk cache of parsed RT structure sets and plans (\sa vtkSlicerDicomRtReader::SetCacheDirectory).
+  /// When loading a file that has been loaded before and has not changed since, the ROI contours and the beams are
+  /// restored from the cache instead of parsing the DICOM file. Caching is disabled if empty (default).
+  char* ParsedObjectCacheDirectory;
 };
 
 #endif
@@ -29,14 +29,26 @@
 
 // VTK includes
 #include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
 #include <vtkMath.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPoints.h>
 #include <vtkPolyData.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
+#include <vtksys/SystemTools.hxx>
 
 // STD includes
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
 #include <vector>
 #include <map>
 
@@ -44,6 +56,7 @@
 #include <dcmtk/config/osconfig.h>    /* make sure OS specific configuration is included first */
 
 #include <dcmtk/ofstd/ofconapp.h>
+#include <dcmtk/ofstd/ofstd.h>
 
 #include <dcmtk/dcmrt/drtdose.h>
 #include <dcmtk/dcmrt/drtimage.h>
@@ -58,6 +71,16 @@
 
 vtkStandardNewMacro(vtkSlicerDicomRtReader);
 
+namespace
+{
+  /// Identifier at the beginning of the cache files of parsed RT objects
+  const std::array<char, 8> CACHE_FILE_MAGIC = { { 'S', 'R', 'T', 'C', 'A', 'C', 'H', 'E' } };
+  /// Version of the cache file format. Increment it whenever the serialized data changes, so that old cache files are ignored
+  const uint32_t CACHE_FILE_FORMAT_VERSION = 1;
+  /// Extension of the cache files of parsed RT objects
+  const std::string CACHE_FILE_EXTENSION = ".rtcache";
+}
+
 //----------------------------------------------------------------------------
 class vtkSlicerDicomRtReader::vtkInternal
 {
@@ -151,6 +174,25 @@ public:
   /// List of loaded contour ROIs from structure set
   std::vector<RoiEntry> RoiSequenceVector;
 
+  /// Undecoded planar contours of a ROI, collected from the ROI contour sequence.
+  /// The contour data is decoded later in parallel into preallocated point and cell buffers.
+  class RoiContourData
+  {
+  public:
+    RoiContourData()
+      : Roi(nullptr)
+    {
+      this->ContourPointOffsets.push_back(0);
+    }
+
+    /// ROI entry that receives the decoded poly data
+    RoiEntry* Roi;
+    /// Contour Data (3006,0050) value of each valid contour as stored in the dataset
+    std::vector<OFString> ContourDataStrings;
+    /// Index of the first point of each contour within the ROI. The last element is the total number of points
+    std::vector<vtkIdType> ContourPointOffsets;
+  };
+
   //TODO: Use referenced beams to load beams in correct order
   class ReferencedBeamEntry
   {
@@ -356,8 +398,11 @@ public:
   void LoadRTStructureSet(DcmDataset* dataset);
   /// Load contours from a structure sequence
   void LoadContoursFromRoiSequence(DRTStructureSetROISequence* roiSequence);
-  /// Load individual contour from RT Structure Set
-  vtkSlicerDicomRtReader::vtkInternal::RoiEntry* LoadContour(DRTROIContourSequence::Item &roiObject, DRTStructureSetIOD* rtStructureSet);
+  /// Load individual contour from RT Structure Set.
+  /// Only collects the contour data strings into \sa contourData, call \sa DecodeRoiContours to create the poly data
+  vtkSlicerDicomRtReader::vtkInternal::RoiEntry* LoadContour(DRTROIContourSequence::Item &roiObject, DRTStructureSetIOD* rtStructureSet, RoiContourData& contourData);
+  /// Decode collected contour data of all ROIs in parallel and set the resulting poly data to the ROI entries
+  void DecodeRoiContours(std::vector<RoiContourData>& roiContours);
 
   /// Load RT Image
   void LoadRTImage(DcmDataset* dataset);
@@ -381,6 +426,160 @@ public:
   /// Get contour image sequence object in the referenced frame of reference sequence for a structure set
   DRTContourImageSequence* GetReferencedFrameOfReferenceContourImageSequence(DRTStructureSetIOD* rtStructureSet);
 
+public:
+  /// Binary stream for the cache of parsed RT objects (\sa vtkSlicerDicomRtReader::CacheDirectory).
+  /// The same serialization functions are used for storing and restoring an object, the direction is
+  /// determined by the stream. When restoring, the stream fails instead of reading beyond the input.
+  class CacheStream
+  {
+  public:
+    /// Create stream for storing an object
+    CacheStream(std::ostream& output)
+      : Output(&output)
+      , Input(nullptr)
+      , RemainingBytes(0)
+      , Good(true)
+    {
+    }
+    /// Create stream for restoring an object from an input of the given length
+    CacheStream(std::istream& input, uint64_t inputLength)
+      : Output(nullptr)
+      , Input(&input)
+      , RemainingBytes(inputLength)
+      , Good(true)
+    {
+    }
+
+    bool IsStoring() { return this->Output != nullptr; }
+    bool IsGood() { return this->Good; }
+    /// Indicate that the restored data is invalid
+    void Fail() { this->Good = false; }
+
+    /// Serialize a value of trivially copyable type
+    template<class T> void Value(T& value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be serialized as bytes");
+      this->Bytes(&value, sizeof(T));
+    }
+    /// Serialize a vector of trivially copyable values
+    template<class T> void Value(std::vector<T>& values)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be serialized as bytes");
+      uint64_t size = values.size();
+      this->Size(size, sizeof(T));
+      if (!this->IsStoring())
+      {
+        values.resize(size);
+      }
+      if (size > 0)
+      {
+        this->Bytes(values.data(), size * sizeof(T));
+      }
+    }
+    /// Serialize a string
+    void Value(std::string& value)
+    {
+      uint64_t size = value.size();
+      this->Size(size, 1);
+      if (!this->IsStoring())
+      {
+        value.resize(size);
+      }
+      if (size > 0)
+      {
+        this->Bytes(&value[0], size);
+      }
+    }
+    /// Serialize a string member of a VTK class (allocated by vtkSetStringMacro, may be nullptr)
+    void Value(char*& value)
+    {
+      bool valid = (value != nullptr);
+      this->Value(valid);
+      std::string stringValue(valid && this->IsStoring() ? value : "");
+      if (valid)
+      {
+        this->Value(stringValue);
+      }
+      if (!this->IsStoring() && this->Good)
+      {
+        delete [] value;
+        value = nullptr;
+        if (valid)
+        {
+          value = new char[stringValue.size() + 1];
+          strcpy(value, stringValue.c_str());
+        }
+      }
+    }
+    /// Serialize the number of elements of a container. When restoring, the stream fails if that many elements
+    /// of the given minimum size cannot be in the remaining input (so that corrupt files cannot cause huge allocations)
+    void Size(uint64_t& size, uint64_t elementSize)
+    {
+      this->Value(size);
+      if (!this->IsStoring() && (!this->Good || (elementSize > 0 && size > this->RemainingBytes / elementSize)))
+      {
+        this->Good = false;
+        size = 0;
+      }
+    }
+
+  protected:
+    void Bytes(void* data, uint64_t length)
+    {
+      if (!this->Good)
+      {
+        return;
+      }
+      if (this->IsStoring())
+      {
+        this->Output->write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length));
+        this->Good = this->Output->good();
+      }
+      else if (length > this->RemainingBytes)
+      {
+        this->Good = false;
+      }
+      else
+      {
+        this->Input->read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(length));
+        this->Good = this->Input->good();
+        this->RemainingBytes -= length;
+      }
+    }
+
+  protected:
+    std::ostream* Output;
+    std::istream* Input;
+    uint64_t RemainingBytes;
+    bool Good;
+  };
+
+  /// Get the key of the cache entry of a DICOM file: SOP instance UID, and the size and hash of the file contents.
+  /// Only the beginning of the file is parsed to get the UIDs.
+  /// \return True if the file contains an RT object that is cached (structure set or plan), false otherwise
+  bool GetCacheKey(const char* fileName, std::string& sopInstanceUid, uint64_t& fileSize, uint64_t& fileHash);
+  /// Compute 64-bit FNV-1a hash of the contents of a file
+  static bool ComputeFileHash(const char* fileName, uint64_t& fileSize, uint64_t& fileHash);
+  /// Get path of the cache file for an RT object
+  std::string GetCacheFilePath(const std::string& sopInstanceUid);
+
+  /// Restore the loaded RT object from the cache
+  /// \return True if a valid cache file was found for the given key and it was restored, false otherwise
+  bool ReadFromCache(const std::string& sopInstanceUid, uint64_t fileSize, uint64_t fileHash);
+  /// Store the loaded RT object in the cache
+  void WriteToCache(const std::string& sopInstanceUid, uint64_t fileSize, uint64_t fileHash);
+
+  /// Store or restore the loaded RT object, including the attributes of the reader
+  void SerializeLoadedObject(CacheStream& stream);
+  /// Store or restore a ROI, including its contour poly data
+  void SerializeRoi(CacheStream& stream, RoiEntry& roi);
+  /// Store or restore a beam, including its control points
+  void SerializeBeam(CacheStream& stream, BeamEntry& beam);
+  /// Store or restore a control point of a beam
+  void SerializeControlPoint(CacheStream& stream, ControlPointEntry& controlPoint);
+  /// Store or restore a brachytherapy channel
+  void SerializeChannel(CacheStream& stream, ChannelEntry& channel);
+
 public:
   vtkSlicerDicomRtReader* External;
 };
@@ -483,92 +682,63 @@ vtkSlicerDicomRtReader::vtkInternal::ControlPointEntry::ControlPointEntry()
 {
 }
 
-vtkSlicerDicomRtReader::vtkInternal::ControlPointEntry::ControlPointEntry(const ControlPointEntry& src)
-  :
-  Index(src.Index),
-  IsocenterPositionRas(src.IsocenterPositionRas),
-  CumulativeMetersetWeight(src.CumulativeMetersetWeight),
-  GantryAngle(src.GantryAngle),
-  PatientSupportAngle(src.PatientSupportAngle),
-  BeamLimitingDeviceAngle(src.BeamLimitingDeviceAngle),
-  NominalBeamEnergy(src.NominalBeamEnergy),
-  MetersetRate(src.MetersetRate),
-  JawPositions(src.JawPositions),
-  MultiLeafCollimatorType(src.MultiLeafCollimatorType),
-  LeafPositions(src.LeafPositions),
-  ReferencedRangeShifterNumber(src.ReferencedRangeShifterNumber),
-  RangeShifterSetting(src.RangeShifterSetting),
-  IsocenterToRangeShifterDistance(src.IsocenterToRangeShifterDistance),
-  RangeShifterWaterEquivalentThickness(src.RangeShifterWaterEquivalentThickness),
-  GantryRotationDirection(src.GantryRotationDirection),
-  GantryPitchAngle(src.GantryPitchAngle),
-  GantryPitchRotationDirection(src.GantryPitchRotationDirection),
-  BeamLimitingDeviceRotationDirection(src.BeamLimitingDeviceRotationDirection),
-  ScanSpotTuneId(src.ScanSpotTuneId),
-  NumberOfScanSpotPositions(src.NumberOfScanSpotPositions),
-  ScanSpotReorderingAllowed(src.ScanSpotReorderingAllowed),
-  ScanSpotPositionMap(src.ScanSpotPositionMap),
-  ScanSpotMetersetWeights(src.ScanSpotMetersetWeights),
-  NumberOfPaintings(src.NumberOfPaintings),
-  ScanningSpotSize(src.ScanningSpotSize),
-  PatientSupportRotationDirection(src.PatientSupportRotationDirection),
-  TableTopPitchAngle(src.TableTopPitchAngle),
-  TableTopPitchRotationDirection(src.TableTopPitchRotationDirection),
-  TableTopRollAngle(src.TableTopRollAngle),
-  TableTopRollRotationDirection(src.TableTopRollRotationDirection),
-  TableTopVerticalPosition(src.TableTopVerticalPosition),
-  TableTopLongitudinalPosition(src.TableTopLongitudinalPosition),
-  TableTopLateralPosition(src.TableTopLateralPosition)
-{
-}
-
-vtkSlicerDicomRtReader::vtkInternal::ControlPointEntry&
-vtkSlicerDicomRtReader::vtkInternal::ControlPointEntry::operator=(const ControlPointEntry& src)
-{
-  this->Index = src.Index;
-  this->IsocenterPositionRas = src.IsocenterPositionRas;
-  
-  this->CumulativeMetersetWeight = src.CumulativeMetersetWeight;
-  
-  this->GantryAngle = src.GantryAngle;
-  this->PatientSupportAngle = src.PatientSupportAngle;
-  this->BeamLimitingDeviceAngle = src.BeamLimitingDeviceAngle;
-  
-  this->NominalBeamEnergy = src.NominalBeamEnergy;
-  this->MetersetRate = src.MetersetRate;
-  
-  this->JawPositions = src.JawPositions;
-  this->MultiLeafCollimatorType = src.MultiLeafCollimatorType;
-  this->LeafPositions = src.LeafPositions;
-  
-  this->ReferencedRangeShifterNumber = src.ReferencedRangeShifterNumber;
-  this->RangeShifterSetting = src.RangeShifterSetting;
-  this->IsocenterToRangeShifterDistance = src.IsocenterToRangeShifterDistance;
-  this->RangeShifterWaterEquivalentThickness = src.RangeShifterWaterEquivalentThickness;
-
-  this->GantryRotationDirection = src.GantryRotationDirection;
-  this->GantryPitchAngle = src.GantryPitchAngle;
-  this->GantryPitchRotationDirection = src.GantryPitchRotationDirection;
-  this->BeamLimitingDeviceRotationDirection = src.BeamLimitingDeviceRotationDirection;
-
-  this->ScanSpotTuneId = src.ScanSpotTuneId;
-  this->NumberOfScanSpotPositions = src.NumberOfScanSpotPositions;
-  this->ScanSpotReorderingAllowed = src.ScanSpotReorderingAllowed;
-  this->ScanSpotPositionMap = src.ScanSpotPositionMap;
-  this->ScanSpotMetersetWeights = src.ScanSpotMetersetWeights;
-  this->NumberOfPaintings = src.NumberOfPaintings;
-  this->ScanningSpotSize = src.ScanningSpotSize;
-
-  this->PatientSupportRotationDirection = src.PatientSupportRotationDirection;
-    
-  this->TableTopPitchAngle = src.TableTopPitchAngle;
-  this->TableTopPitchRotationDirection = src.TableTopPitchRotationDirection;
-  this->TableTopRollAngle = src.TableTopRollAngle;
-  this->TableTopRollRotationDirection = src.TableTopRollRotationDirection;
-  this->TableTopVerticalPosition = src.TableTopVerticalPosition;
-  this->TableTopLongitudinalPosition = src.TableTopLongitudinalPosition;
-  this->TableTopLateralPosition = src.TableTopLateralPosition;
-  return *this;
+void vtkSlicerDicomRtReader::vtkInternal::ControlPointEntry::InheritAttributes(const ControlPointEntry& previous)
+{
+  this->IsocenterPositionRas = previous.IsocenterPositionRas;
+
+  this->CumulativeMetersetWeight = previous.CumulativeMetersetWeight;
+
+  this->GantryAngle = previous.GantryAngle;
+  this->PatientSupportAngle = previous.PatientSupportAngle;
+  this->BeamLimitingDeviceAngle = previous.BeamLimitingDeviceAngle;
+
+  this->NominalBeamEnergy = previous.NominalBeamEnergy;
+  this->MetersetRate = previous.MetersetRate;
+
+  this->JawPositions = previous.JawPositions;
+  this->MultiLeafCollimatorType = previous.MultiLeafCollimatorType;
+
+  this->ReferencedRangeShifterNumber = previous.ReferencedRangeShifterNumber;
+  this->RangeShifterSetting = previous.RangeShifterSetting;
+  this->IsocenterToRangeShifterDistance = previous.IsocenterToRangeShifterDistance;
+  this->RangeShifterWaterEquivalentThickness = previous.RangeShifterWaterEquivalentThickness;
+
+  this->GantryRotationDirection = previous.GantryRotationDirection;
+  this->GantryPitchAngle = previous.GantryPitchAngle;
+  this->GantryPitchRotationDirection = previous.GantryPitchRotationDirection;
+  this->BeamLimitingDeviceRotationDirection = previous.BeamLimitingDeviceRotationDirection;
+
+  this->ScanSpotTuneId = previous.ScanSpotTuneId;
+  this->NumberOfScanSpotPositions = previous.NumberOfScanSpotPositions;
+  this->ScanSpotReorderingAllowed = previous.ScanSpotReorderingAllowed;
+  this->NumberOfPaintings = previous.NumberOfPaintings;
+  this->ScanningSpotSize = previous.ScanningSpotSize;
+
+  this->PatientSupportRotationDirection = previous.PatientSupportRotationDirection;
+
+  this->TableTopPitchAngle = previous.TableTopPitchAngle;
+  this->TableTopPitchRotationDirection = previous.TableTopPitchRotationDirection;
+  this->TableTopRollAngle = previous.TableTopRollAngle;
+  this->TableTopRollRotationDirection = previous.TableTopRollRotationDirection;
+  this->TableTopVerticalPosition = previous.TableTopVerticalPosition;
+  this->TableTopLongitudinalPosition = previous.TableTopLongitudinalPosition;
+  this->TableTopLateralPosition = previous.TableTopLateralPosition;
+}
+
+void vtkSlicerDicomRtReader::vtkInternal::ControlPointEntry::InheritArrays(const ControlPointEntry& previous)
+{
+  if (this->LeafPositions.empty())
+  {
+    this->LeafPositions = previous.LeafPositions;
+  }
+  if (this->ScanSpotPositionMap.empty())
+  {
+    this->ScanSpotPositionMap = previous.ScanSpotPositionMap;
+  }
+  if (this->ScanSpotMetersetWeights.empty())
+  {
+    this->ScanSpotMetersetWeights = previous.ScanSpotMetersetWeights;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -1028,12 +1198,9 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
         continue;
       }
     
-      // Initialize control point vector so that it can be correctly filled even if control points arrive in random order
-      for ( Sint32 i = 0; i < beamNumberOfControlPoints; ++i)
-      {
-        ControlPointEntry dummyControlPoint;
-        beamEntry.ControlPointSequenceVector.push_back(dummyControlPoint);
-      }
+      // Initialize control point vector so that it can be correctly filled even if control points arrive in random order.
+      // Control points are decoded in place into this storage, no control point is copied afterwards.
+      beamEntry.ControlPointSequenceVector.resize(std::max<Sint32>(beamNumberOfControlPoints, 0));
       unsigned int controlPointCount = 0;
     
       do
@@ -1064,11 +1231,12 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
 
         // Control point item from the ControlPointSequenceVector
         ControlPointEntry& controlPoint = beamEntry.ControlPointSequenceVector.at(controlPointIndex);
-        // assign previous point control point to a current control point
+        // Inherit attributes from the previous control point (arrays are inherited after decoding if needed)
+        const ControlPointEntry* prevControlPoint = nullptr;
         if (controlPointIndex > 0)
         {
-          ControlPointEntry& prevControlPoint = beamEntry.ControlPointSequenceVector.at(controlPointIndex - 1);
-          controlPoint = ControlPointEntry(prevControlPoint);
+          prevControlPoint = &beamEntry.ControlPointSequenceVector[controlPointIndex - 1];
+          controlPoint.InheritAttributes(*prevControlPoint);
         }
 //        ControlPointEntry& controlPointEntry = beamEntry.ControlPointSequenceVector.at(controlPointCount); 
         controlPoint.Index = controlPointIndex;
@@ -1174,8 +1342,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
                   std::string& mlcType = controlPoint.MultiLeafCollimatorType;
 
                   mlcType = rtBeamLimitingDeviceType.c_str();
-                  mlcPositions.resize(leafJawPositions.size());
-                  std::copy( leafJawPositions.begin(), leafJawPositions.end(), mlcPositions.begin());
+                  mlcPositions.assign(leafJawPositions.begin(), leafJawPositions.end());
                   vtkDebugWithObjectMacro( this->External, "LoadRTPlan: " 
                     << mlcType << " leaf positions have been loaded");
                 }
@@ -1194,6 +1361,11 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
           while (currentCollimatorPositionSequence.gotoNextItem().good());
  
         }
+
+        if (prevControlPoint)
+        {
+          controlPoint.InheritArrays(*prevControlPoint);
+        }
         ++controlPointCount;
       }
       while (rtControlPointSequence.gotoNextItem().good());
@@ -1203,7 +1375,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
         vtkErrorWithObjectMacro( this->External, "LoadRTPlan: Number of control points expected ("
           << beamNumberOfControlPoints << ") and found (" << controlPointCount << ") do not match. Invalid points remain among control points");
       }
-      this->BeamSequenceVector.push_back(beamEntry);
+      this->BeamSequenceVector.push_back(std::move(beamEntry));
     }
     while (rtPlanBeamSequence.gotoNextItem().good());
 
@@ -1267,11 +1439,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
       }
 
       // Initialize control point vector so that it can be correctly filled even if control points arrive in random order
-      for (int i=0; i<channelNumberOfControlPoints; ++i)
-      {
-        std::array<double,3> dummyControlPoint = { 0.0, 0.0, 0.0 };
-        channelEntry.ControlPointVector.push_back(dummyControlPoint);
-      }
+      channelEntry.ControlPointVector.resize(std::max(channelNumberOfControlPoints, 0), { 0.0, 0.0, 0.0 });
       unsigned int controlPointCount = 0;
       do
       {
@@ -1309,7 +1477,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
           << channelNumberOfControlPoints << ") and found (" << controlPointCount << ") do not match. Invalid points remain among control points");
       }
 
-      this->ChannelSequenceVector.push_back(channelEntry);
+      this->ChannelSequenceVector.push_back(std::move(channelEntry));
     }
     while (channelSequence.gotoNextItem().good());
   }
@@ -1594,12 +1762,9 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTIonPlan(DcmDataset* dataset)
         continue;
       }
 
-      // Initialize control point vector so that it can be correctly filled even if control points arrive in random order
-      for ( Sint32 i = 0; i < beamNumberOfControlPoints; ++i)
-      {
-        ControlPointEntry dummyControlPoint;
-        beamEntry.ControlPointSequenceVector.push_back(dummyControlPoint);
-      }
+      // Initialize control point vector so that it can be correctly filled even if control points arrive in random order.
+      // Control points are decoded in place into this storage, no control point is copied afterwards.
+      beamEntry.ControlPointSequenceVector.resize(std::max<Sint32>(beamNumberOfControlPoints, 0));
       unsigned int controlPointCount = 0;
 
       do
@@ -1628,11 +1793,12 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTIonPlan(DcmDataset* dataset)
 
         // Control point item from the ControlPointSequenceVector
         ControlPointEntry& controlPoint = beamEntry.ControlPointSequenceVector.at(controlPointIndex);
-        // assign previous point control point to a current control point
+        // Inherit attributes from the previous control point (arrays are inherited after decoding if needed)
+        const ControlPointEntry* prevControlPoint = nullptr;
         if (controlPointIndex > 0)
         {
-          ControlPointEntry& prevControlPoint = beamEntry.ControlPointSequenceVector.at(controlPointIndex - 1);
-          controlPoint = ControlPointEntry(prevControlPoint);
+          prevControlPoint = &beamEntry.ControlPointSequenceVector[controlPointIndex - 1];
+          controlPoint.InheritAttributes(*prevControlPoint);
         }
 //        ControlPointEntry& controlPointEntry = beamEntry.ControlPointSequenceVector.at(controlPointCount);        
         controlPoint.Index = controlPointIndex;
@@ -1712,7 +1878,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTIonPlan(DcmDataset* dataset)
  
           Sint32 nofScanSpotPositions = -1;
           dataCondition = controlPointItem.getNumberOfScanSpotPositions(nofScanSpotPositions);
-          if (dataCondition.good())
+          if (dataCondition.good() && nofScanSpotPositions >= 0)
           {
             controlPoint.NumberOfScanSpotPositions = nofScanSpotPositions;
           }
@@ -1735,29 +1901,31 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTIonPlan(DcmDataset* dataset)
           {
             controlPoint.ScanningSpotSize[1] = scanningSpotSizeY;
           }
-          if (controlPoint.NumberOfScanSpotPositions > 0)
+          // Decode the spot map directly into its final storage, if the control point has its own map.
+          // Otherwise the arrays are left empty, so that the map of the previous control point is inherited.
+          Float32 firstScanSpotPosition = 0.f;
+          if (nofScanSpotPositions > 0 && controlPointItem.getScanSpotPositionMap(firstScanSpotPosition, 0).good())
           {
-            controlPoint.ScanSpotPositionMap.resize(2 * controlPoint.NumberOfScanSpotPositions);
-            controlPoint.ScanSpotMetersetWeights.resize(controlPoint.NumberOfScanSpotPositions);
+            const unsigned int numberOfPositions = static_cast<unsigned int>(nofScanSpotPositions);
+            controlPoint.ScanSpotPositionMap.assign(2 * numberOfPositions, 0.0f);
+            controlPoint.ScanSpotMetersetWeights.assign(numberOfPositions, 0.0f);
+            float* positionMap = controlPoint.ScanSpotPositionMap.data();
+            float* metersetWeights = controlPoint.ScanSpotMetersetWeights.data();
 
-            for ( unsigned int i = 0; i < controlPoint.NumberOfScanSpotPositions; ++i)
+            for ( unsigned int i = 0; i < 2 * numberOfPositions; ++i)
             {
-              Float32 x = -1.f, y = -1.f, w = -1.f;
-              dataCondition = controlPointItem.getScanSpotPositionMap( x, 2 * i);
-              if (dataCondition.good())
-              {
-                controlPoint.ScanSpotPositionMap.at(2 * i) = float(x);
-              }
-              dataCondition = controlPointItem.getScanSpotPositionMap( y, 2 * i + 1);
-              if (dataCondition.good())
+              Float32 value = 0.f;
+              if (controlPointItem.getScanSpotPositionMap( value, i).good())
               {
-                controlPoint.ScanSpotPositionMap.at(2 * i + 1) = float(y);
+                positionMap[i] = float(value);
               }
-
-              dataCondition = controlPointItem.getScanSpotMetersetWeights( w, i);
-              if (dataCondition.good())
+            }
+            for ( unsigned int i = 0; i < numberOfPositions; ++i)
+            {
+              Float32 value = 0.f;
+              if (controlPointItem.getScanSpotMetersetWeights( value, i).good())
               {
-                controlPoint.ScanSpotMetersetWeights.at(i) = float(w);
+                metersetWeights[i] = float(value);
               }
             }
           }
@@ -1818,8 +1986,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTIonPlan(DcmDataset* dataset)
                   std::string& mlcType = controlPoint.MultiLeafCollimatorType;
 
                   mlcType = rtBeamLimitingDeviceType.c_str();
-                  mlcPositions.resize(leafJawPositions.size());
-                  std::copy( leafJawPositions.begin(), leafJawPositions.end(), mlcPositions.begin());
+                  mlcPositions.assign(leafJawPositions.begin(), leafJawPositions.end());
                   vtkDebugWithObjectMacro( this->External, "LoadRTIonPlan: " 
                     << mlcType << " leaf positions have been loaded");
                 }
@@ -1839,6 +2006,11 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTIonPlan(DcmDataset* dataset)
           while (currentCollimatorPositionSequence.gotoNextItem().good());
 
         }
+
+        if (prevControlPoint)
+        {
+          controlPoint.InheritArrays(*prevControlPoint);
+        }
         ++controlPointCount;
       }
       while (rtIonControlPointSequence.gotoNextItem().good());
@@ -1848,7 +2020,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTIonPlan(DcmDataset* dataset)
         vtkErrorWithObjectMacro( this->External, "LoadRTIonPlan: Number of control points expected ("
           << beamNumberOfControlPoints << ") and found (" << controlPointCount << ") do not match. Invalid points remain among control points");
       }
-      this->BeamSequenceVector.push_back(beamEntry);
+      this->BeamSequenceVector.push_back(std::move(beamEntry));
     }
     while (ionBeamSequence.gotoNextItem().good());
 
@@ -1945,18 +2117,28 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTStructureSet(DcmDataset* dataset
   }
 
   // Read ROIs, iterate over ROI contour sequence
+  std::vector<RoiContourData> roiContours;
+  roiContours.reserve(this->RoiSequenceVector.size());
   do 
   {
     DRTROIContourSequence::Item &currentRoi = rtROIContourSequence.getCurrentItem();
-    RoiEntry* currentRoiEntry = this->LoadContour(currentRoi, rtStructureSet);
+    RoiContourData currentRoiContours;
+    RoiEntry* currentRoiEntry = this->LoadContour(currentRoi, rtStructureSet, currentRoiContours);
     if (currentRoiEntry)
     {
       // Set referenced series UID
       currentRoiEntry->ReferencedSeriesUID = (std::string)referencedSeriesInstanceUID.c_str();
     }
+    if (currentRoiContours.Roi)
+    {
+      roiContours.push_back(std::move(currentRoiContours));
+    }
   }
   while (rtROIContourSequence.gotoNextItem().good());
 
+  // Create contour poly data for all ROIs
+  this->DecodeRoiContours(roiContours);
+
   // Get SOP instance UID
   OFString sopInstanceUid("");
   if (rtStructureSet->getSOPInstanceUID(sopInstanceUid).bad())
@@ -2016,7 +2198,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadContoursFromRoiSequence(DRTStructu
 
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkInternal::LoadContour(
-  DRTROIContourSequence::Item &roi, DRTStructureSetIOD* rtStructureSet)
+  DRTROIContourSequence::Item &roi, DRTStructureSetIOD* rtStructureSet, RoiContourData& contourData)
 {
   if (!roi.isValid())
   {
@@ -2046,11 +2228,6 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     return roiEntry;
   }
 
-  // Create containers for contour poly data
-  vtkSmartPointer<vtkPoints> currentRoiContourPoints = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> currentRoiContourCells = vtkSmartPointer<vtkCellArray>::New();
-  vtkIdType pointId = 0;
-
   // Read contour data, iterate over contour sequence
   do
   {
@@ -2069,28 +2246,21 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     int numberOfPoints;
     ss >> numberOfPoints;
 
-    // Get contour point data
-    OFVector<vtkTypeFloat64> contourData_LPS;
-    contourItem.getContourData(contourData_LPS);
-    if (contourData_LPS.size() != size_t(numberOfPoints * 3))
+    // Get contour point data. Only the value multiplicity is checked here, the values are decoded in DecodeRoiContours
+    OFString contourDataString("");
+    contourItem.getContourData(contourDataString, -1);
+    size_t numberOfValues = (contourDataString.empty() ? 0 : std::count(contourDataString.begin(), contourDataString.end(), '\\') + 1);
+    if (numberOfPoints <= 0 || numberOfValues != size_t(numberOfPoints * 3))
     {
       vtkErrorWithObjectMacro(this->External, "LoadContour: Contour sequence object item is invalid: "
         << " number of contour points is " << numberOfPoints << " therefore expected "
-        << numberOfPoints * 3 << " values in contour data but only found " << contourData_LPS.size());
+        << numberOfPoints * 3 << " values in contour data but only found " << numberOfValues);
       continue;
     }
 
-    unsigned int contourIndex = currentRoiContourCells->InsertNextCell(numberOfPoints+1);
-    for (int k=0; k<numberOfPoints; k++)
-    {
-      // Convert from DICOM LPS -> Slicer RAS
-      currentRoiContourPoints->InsertPoint(pointId, -contourData_LPS[3*k], -contourData_LPS[3*k+1], contourData_LPS[3*k+2]);
-      currentRoiContourCells->InsertCellPoint(pointId);
-      pointId++;
-    }
-
-    // Close the contour
-    currentRoiContourCells->InsertCellPoint(pointId-numberOfPoints);
+    unsigned int contourIndex = static_cast<unsigned int>(contourData.ContourDataStrings.size());
+    contourData.ContourDataStrings.push_back(contourDataString);
+    contourData.ContourPointOffsets.push_back(contourData.ContourPointOffsets.back() + numberOfPoints);
 
     // Add map to the referenced slice instance UID
     // This is not a mandatory field so no error logged if not found. The reason why
@@ -2151,20 +2321,8 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     }
   }
 
-  // Save just loaded contour data into ROI entry
-  vtkSmartPointer<vtkPolyData> currentRoiPolyData = vtkSmartPointer<vtkPolyData>::New();
-  currentRoiPolyData->SetPoints(currentRoiContourPoints);
-  if (currentRoiContourPoints->GetNumberOfPoints() == 1)
-  {
-    // Point ROI
-    currentRoiPolyData->SetVerts(currentRoiContourCells);
-  }
-  else if (currentRoiContourPoints->GetNumberOfPoints() > 1)
-  {
-    // Contour ROI
-    currentRoiPolyData->SetLines(currentRoiContourCells);
-  }
-  roiEntry->SetPolyData(currentRoiPolyData);
+  // Contour data is decoded into the ROI entry later, together with the other ROIs
+  contourData.Roi = roiEntry;
 
   // Get structure color
   Sint32 roiDisplayColor = -1;
@@ -2192,6 +2350,112 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
   return roiEntry;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::DecodeRoiContours(std::vector<RoiContourData>& roiContours)
+{
+  // Preallocate points and cells of each ROI and flatten the contours into a single list
+  // so that the work is balanced between threads even if a few ROIs contain most of the points
+  std::vector<vtkSmartPointer<vtkPoints> > roiPoints(roiContours.size());
+  std::vector<vtkSmartPointer<vtkIdTypeArray> > roiCellIds(roiContours.size());
+  std::vector<std::pair<size_t, size_t> > contours;
+  for (size_t roiIndex=0; roiIndex<roiContours.size(); ++roiIndex)
+  {
+    RoiContourData& roiContourData = roiContours[roiIndex];
+    size_t numberOfContours = roiContourData.ContourDataStrings.size();
+    vtkIdType numberOfPoints = roiContourData.ContourPointOffsets.back();
+
+    roiPoints[roiIndex] = vtkSmartPointer<vtkPoints>::New();
+    roiPoints[roiIndex]->SetDataTypeToFloat();
+    roiPoints[roiIndex]->SetNumberOfPoints(numberOfPoints);
+
+    // Each closed contour cell stores its size, its points, and the first point again
+    roiCellIds[roiIndex] = vtkSmartPointer<vtkIdTypeArray>::New();
+    roiCellIds[roiIndex]->SetNumberOfValues(numberOfPoints + 2 * numberOfContours);
+
+    for (size_t contourIndex=0; contourIndex<numberOfContours; ++contourIndex)
+    {
+      contours.push_back(std::make_pair(roiIndex, contourIndex));
+    }
+  }
+
+  // Decode contour data
+  std::vector<char> contourValid(contours.size(), 1);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(contours.size()), [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType index=begin; index<end; ++index)
+    {
+      size_t roiIndex = contours[index].first;
+      size_t contourIndex = contours[index].second;
+      const RoiContourData& roiContourData = roiContours[roiIndex];
+      vtkIdType firstPointId = roiContourData.ContourPointOffsets[contourIndex];
+      vtkIdType numberOfPoints = roiContourData.ContourPointOffsets[contourIndex+1] - firstPointId;
+
+      float* points = vtkFloatArray::SafeDownCast(roiPoints[roiIndex]->GetData())->GetPointer(3 * firstPointId);
+      const char* value = roiContourData.ContourDataStrings[contourIndex].c_str();
+      for (vtkIdType valueIndex=0; valueIndex<3*numberOfPoints; ++valueIndex)
+      {
+        OFBool success = OFFalse;
+        double coordinate = OFStandard::atof(value, &success);
+        if (!success)
+        {
+          contourValid[index] = 0;
+          coordinate = 0.0;
+        }
+        // Convert from DICOM LPS -> Slicer RAS
+        points[valueIndex] = static_cast<float>(valueIndex % 3 == 2 ? coordinate : -coordinate);
+        // Skip to the next value in the multi-valued string
+        value = strchr(value, '\\');
+        if (!value)
+        {
+          break;
+        }
+        ++value;
+      }
+
+      // Add closed contour cell
+      vtkIdType* cellIds = roiCellIds[roiIndex]->GetPointer(firstPointId + 2 * contourIndex);
+      cellIds[0] = numberOfPoints + 1;
+      for (vtkIdType k=0; k<numberOfPoints; ++k)
+      {
+        cellIds[k+1] = firstPointId + k;
+      }
+      cellIds[numberOfPoints+1] = firstPointId;
+    }
+  });
+
+  for (size_t index=0; index<contours.size(); ++index)
+  {
+    if (!contourValid[index])
+    {
+      RoiEntry* roiEntry = roiContours[contours[index].first].Roi;
+      vtkErrorWithObjectMacro(this->External, "DecodeRoiContours: Contour data of contour " << contours[index].second
+        << " in ROI " << roiEntry->Number << ": " << roiEntry->Name << " contains invalid values");
+    }
+  }
+
+  // Save decoded contour data into ROI entries
+  for (size_t roiIndex=0; roiIndex<roiContours.size(); ++roiIndex)
+  {
+    vtkSmartPointer<vtkCellArray> currentRoiContourCells = vtkSmartPointer<vtkCellArray>::New();
+    currentRoiContourCells->SetCells(
+      static_cast<vtkIdType>(roiContours[roiIndex].ContourDataStrings.size()), roiCellIds[roiIndex]);
+
+    vtkSmartPointer<vtkPolyData> currentRoiPolyData = vtkSmartPointer<vtkPolyData>::New();
+    currentRoiPolyData->SetPoints(roiPoints[roiIndex]);
+    if (roiPoints[roiIndex]->GetNumberOfPoints() == 1)
+    {
+      // Point ROI
+      currentRoiPolyData->SetVerts(currentRoiContourCells);
+    }
+    else if (roiPoints[roiIndex]->GetNumberOfPoints() > 1)
+    {
+      // Contour ROI
+      currentRoiPolyData->SetLines(currentRoiContourCells);
+    }
+    roiContours[roiIndex].Roi->SetPolyData(currentRoiPolyData);
+  }
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtReader::vtkInternal::LoadRTImage(DcmDataset* dataset)
 {
@@ -2433,6 +2697,473 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTImage(DcmDataset* dataset)
   this->External->LoadRTImageSuccessful = true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::vtkInternal::GetCacheKey(const char* fileName, std::string& sopInstanceUid, uint64_t& fileSize, uint64_t& fileHash)
+{
+  // The SOP common attributes are at the beginning of the dataset, stop parsing right after them
+  DcmFileFormat fileformat;
+  if (fileformat.loadFileUntilTag(fileName, EXS_Unknown, EGL_noChange, DCM_MaxReadLength, ERM_autoDetect, DCM_StudyDate).bad())
+  {
+    return false;
+  }
+  OFString sopClass("");
+  OFString sopInstance("");
+  DcmDataset* dataset = fileformat.getDataset();
+  if ( dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).bad()
+    || dataset->findAndGetOFString(DCM_SOPInstanceUID, sopInstance).bad() || sopInstance.empty() )
+  {
+    return false;
+  }
+  if (sopClass != UID_RTStructureSetStorage && sopClass != UID_RTPlanStorage && sopClass != UID_RTIonPlanStorage)
+  {
+    return false;
+  }
+  // The UID is used as file name, so make sure it only contains the characters allowed in UIDs
+  if (sopInstance.size() > 64 || strspn(sopInstance.c_str(), "0123456789.") != sopInstance.size())
+  {
+    vtkWarningWithObjectMacro(this->External, "GetCacheKey: Invalid SOP instance UID '" << sopInstance << "', file is not cached");
+    return false;
+  }
+  sopInstanceUid = sopInstance.c_str();
+
+  return ComputeFileHash(fileName, fileSize, fileHash);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::vtkInternal::ComputeFileHash(const char* fileName, uint64_t& fileSize, uint64_t& fileHash)
+{
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+
+  fileSize = 0;
+  fileHash = 14695981039346656037ULL; // FNV offset basis
+  std::vector<char> buffer(1 << 20);
+  while (file)
+  {
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    std::streamsize bytesRead = file.gcount();
+    for (std::streamsize index=0; index<bytesRead; ++index)
+    {
+      fileHash ^= static_cast<unsigned char>(buffer[index]);
+      fileHash *= 1099511628211ULL; // FNV prime
+    }
+    fileSize += static_cast<uint64_t>(bytesRead);
+  }
+  return file.eof();
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSlicerDicomRtReader::vtkInternal::GetCacheFilePath(const std::string& sopInstanceUid)
+{
+  return std::string(this->External->CacheDirectory) + "/" + sopInstanceUid + CACHE_FILE_EXTENSION;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::vtkInternal::ReadFromCache(const std::string& sopInstanceUid, uint64_t fileSize, uint64_t fileHash)
+{
+  std::ifstream input(this->GetCacheFilePath(sopInstanceUid).c_str(), std::ios::binary);
+  if (!input)
+  {
+    return false;
+  }
+  input.seekg(0, std::ios::end);
+  std::streamoff inputLength = input.tellg();
+  input.seekg(0, std::ios::beg);
+  if (inputLength <= 0)
+  {
+    return false;
+  }
+  CacheStream stream(input, static_cast<uint64_t>(inputLength));
+
+  // Check that the cache file was written from the same file contents with the current format
+  std::array<char, 8> magic = { { 0 } };
+  uint32_t formatVersion = 0;
+  uint64_t cachedFileSize = 0;
+  uint64_t cachedFileHash = 0;
+  stream.Value(magic);
+  stream.Value(formatVersion);
+  stream.Value(cachedFileSize);
+  stream.Value(cachedFileHash);
+  if ( !stream.IsGood() || magic != CACHE_FILE_MAGIC || formatVersion != CACHE_FILE_FORMAT_VERSION
+    || cachedFileSize != fileSize || cachedFileHash != fileHash )
+  {
+    vtkDebugWithObjectMacro(this->External, "ReadFromCache: Cache file for SOP instance " << sopInstanceUid << " is outdated");
+    return false;
+  }
+
+  this->SerializeLoadedObject(stream);
+  if (!stream.IsGood())
+  {
+    vtkWarningWithObjectMacro(this->External, "ReadFromCache: Failed to read cache file for SOP instance " << sopInstanceUid << ", parsing DICOM file instead");
+    this->RoiSequenceVector.clear();
+    this->BeamSequenceVector.clear();
+    this->ChannelSequenceVector.clear();
+    this->External->LoadRTStructureSetSuccessful = false;
+    this->External->LoadRTPlanSuccessful = false;
+    this->External->LoadRTIonPlanSuccessful = false;
+    return false;
+  }
+
+  vtkDebugWithObjectMacro(this->External, "ReadFromCache: Restored SOP instance " << sopInstanceUid << " from cache");
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::WriteToCache(const std::string& sopInstanceUid, uint64_t fileSize, uint64_t fileHash)
+{
+  if (!vtksys::SystemTools::MakeDirectory(this->External->CacheDirectory))
+  {
+    vtkWarningWithObjectMacro(this->External, "WriteToCache: Failed to create cache directory " << this->External->CacheDirectory);
+    return;
+  }
+
+  // Write into a temporary file and rename it when complete, so that incomplete cache files are never read
+  std::string cacheFilePath = this->GetCacheFilePath(sopInstanceUid);
+  std::string temporaryFilePath = cacheFilePath + ".tmp";
+  bool success = false;
+  {
+    std::ofstream output(temporaryFilePath.c_str(), std::ios::binary | std::ios::trunc);
+    CacheStream stream(output);
+    std::array<char, 8> magic = CACHE_FILE_MAGIC;
+    uint32_t formatVersion = CACHE_FILE_FORMAT_VERSION;
+    stream.Value(magic);
+    stream.Value(formatVersion);
+    stream.Value(fileSize);
+    stream.Value(fileHash);
+    this->SerializeLoadedObject(stream);
+    output.flush();
+    success = stream.IsGood() && output.good();
+  }
+  if (success)
+  {
+    vtksys::SystemTools::RemoveFile(cacheFilePath);
+    success = (std::rename(temporaryFilePath.c_str(), cacheFilePath.c_str()) == 0);
+  }
+  if (!success)
+  {
+    vtkWarningWithObjectMacro(this->External, "WriteToCache: Failed to write cache file " << cacheFilePath);
+    vtksys::SystemTools::RemoveFile(temporaryFilePath);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::SerializeLoadedObject(CacheStream& stream)
+{
+  vtkSlicerDicomRtReader* reader = this->External;
+
+  // Patient, study and series information
+  stream.Value(reader->PatientName);
+  stream.Value(reader->PatientId);
+  stream.Value(reader->PatientSex);
+  stream.Value(reader->PatientBirthDate);
+  stream.Value(reader->PatientComments);
+  stream.Value(reader->StudyInstanceUid);
+  stream.Value(reader->StudyId);
+  stream.Value(reader->StudyDescription);
+  stream.Value(reader->StudyDate);
+  stream.Value(reader->StudyTime);
+  stream.Value(reader->SeriesInstanceUid);
+  stream.Value(reader->SeriesDescription);
+  stream.Value(reader->SeriesModality);
+  stream.Value(reader->SeriesNumber);
+  stream.Value(reader->SOPInstanceUID);
+
+  // Structure set and plan attributes
+  stream.Value(reader->RTStructureSetReferencedSOPInstanceUIDs);
+  stream.Value(reader->RTPlanReferencedStructureSetSOPInstanceUID);
+  stream.Value(reader->RTPlanReferencedDoseSOPInstanceUIDs);
+  stream.Value(reader->LoadRTStructureSetSuccessful);
+  stream.Value(reader->LoadRTPlanSuccessful);
+  stream.Value(reader->LoadRTIonPlanSuccessful);
+
+  uint64_t numberOfRois = this->RoiSequenceVector.size();
+  stream.Size(numberOfRois, 1);
+  this->RoiSequenceVector.resize(numberOfRois);
+  for (RoiEntry& roi : this->RoiSequenceVector)
+  {
+    this->SerializeRoi(stream, roi);
+  }
+
+  uint64_t numberOfBeams = this->BeamSequenceVector.size();
+  stream.Size(numberOfBeams, 1);
+  this->BeamSequenceVector.resize(numberOfBeams);
+  for (BeamEntry& beam : this->BeamSequenceVector)
+  {
+    this->SerializeBeam(stream, beam);
+  }
+
+  uint64_t numberOfChannels = this->ChannelSequenceVector.size();
+  stream.Size(numberOfChannels, 1);
+  this->ChannelSequenceVector.resize(numberOfChannels);
+  for (ChannelEntry& channel : this->ChannelSequenceVector)
+  {
+    this->SerializeChannel(stream, channel);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::SerializeRoi(CacheStream& stream, RoiEntry& roi)
+{
+  stream.Value(roi.Number);
+  stream.Value(roi.Name);
+  stream.Value(roi.Description);
+  stream.Value(roi.DisplayColor);
+  stream.Value(roi.ReferencedSeriesUID);
+  stream.Value(roi.ReferencedFrameOfReferenceUID);
+
+  uint64_t numberOfSliceUids = roi.ContourIndexToSOPInstanceUIDMap.size();
+  stream.Size(numberOfSliceUids, sizeof(int));
+  if (stream.IsStoring())
+  {
+    for (std::map<int,std::string>::iterator uidIt=roi.ContourIndexToSOPInstanceUIDMap.begin(); uidIt!=roi.ContourIndexToSOPInstanceUIDMap.end(); ++uidIt)
+    {
+      int contourIndex = uidIt->first;
+      stream.Value(contourIndex);
+      stream.Value(uidIt->second);
+    }
+  }
+  else
+  {
+    roi.ContourIndexToSOPInstanceUIDMap.clear();
+    for (uint64_t index=0; index<numberOfSliceUids && stream.IsGood(); ++index)
+    {
+      int contourIndex = 0;
+      std::string sliceUid;
+      stream.Value(contourIndex);
+      stream.Value(sliceUid);
+      roi.ContourIndexToSOPInstanceUIDMap[contourIndex] = sliceUid;
+    }
+  }
+
+  // Contour poly data: point coordinates and point (vertex) or contour (line) cells in legacy cell array layout
+  bool hasPolyData = (roi.PolyData != nullptr);
+  stream.Value(hasPolyData);
+  if (!hasPolyData)
+  {
+    return;
+  }
+  std::vector<float> pointCoordinates;
+  std::vector<int64_t> verts;
+  std::vector<int64_t> lines;
+  int64_t numberOfVerts = 0;
+  int64_t numberOfLines = 0;
+  if (stream.IsStoring())
+  {
+    vtkPoints* points = roi.PolyData->GetPoints();
+    vtkIdType numberOfPoints = (points ? points->GetNumberOfPoints() : 0);
+    pointCoordinates.resize(3 * numberOfPoints);
+    for (vtkIdType pointId=0; pointId<numberOfPoints; ++pointId)
+    {
+      double point[3] = {0.0,0.0,0.0};
+      points->GetPoint(pointId, point);
+      for (int axis=0; axis<3; ++axis)
+      {
+        pointCoordinates[3*pointId+axis] = static_cast<float>(point[axis]);
+      }
+    }
+    vtkNew<vtkIdList> cellPointIds;
+    vtkCellArray* cellArrays[2] = { roi.PolyData->GetVerts(), roi.PolyData->GetLines() };
+    std::vector<int64_t>* cellValues[2] = { &verts, &lines };
+    int64_t* numberOfCells[2] = { &numberOfVerts, &numberOfLines };
+    for (int cellType=0; cellType<2; ++cellType)
+    {
+      if (!cellArrays[cellType])
+      {
+        continue;
+      }
+      for (cellArrays[cellType]->InitTraversal(); cellArrays[cellType]->GetNextCell(cellPointIds); )
+      {
+        cellValues[cellType]->push_back(cellPointIds->GetNumberOfIds());
+        for (vtkIdType index=0; index<cellPointIds->GetNumberOfIds(); ++index)
+        {
+          cellValues[cellType]->push_back(cellPointIds->GetId(index));
+        }
+        ++(*numberOfCells[cellType]);
+      }
+    }
+  }
+  stream.Value(pointCoordinates);
+  stream.Value(numberOfVerts);
+  stream.Value(verts);
+  stream.Value(numberOfLines);
+  stream.Value(lines);
+  if (stream.IsStoring() || !stream.IsGood())
+  {
+    return;
+  }
+
+  // Validate cells so that a corrupt cache file cannot create invalid poly data
+  int64_t numberOfPoints = static_cast<int64_t>(pointCoordinates.size() / 3);
+  const std::vector<int64_t>* cellValues[2] = { &verts, &lines };
+  const int64_t numberOfCells[2] = { numberOfVerts, numberOfLines };
+  vtkSmartPointer<vtkCellArray> cellArrays[2];
+  for (int cellType=0; cellType<2; ++cellType)
+  {
+    const std::vector<int64_t>& values = *cellValues[cellType];
+    int64_t cellCount = 0;
+    for (size_t index=0; index<values.size(); index+=values[index]+1, ++cellCount)
+    {
+      if (values[index] < 0 || static_cast<uint64_t>(values[index]) >= values.size() - index)
+      {
+        stream.Fail();
+        return;
+      }
+      for (int64_t pointIndex=1; pointIndex<=values[index]; ++pointIndex)
+      {
+        if (values[index+pointIndex] < 0 || values[index+pointIndex] >= numberOfPoints)
+        {
+          stream.Fail();
+          return;
+        }
+      }
+    }
+    if (cellCount != numberOfCells[cellType] || cellCount == 0)
+    {
+      continue;
+    }
+    vtkSmartPointer<vtkIdTypeArray> cellIds = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellIds->SetNumberOfValues(static_cast<vtkIdType>(values.size()));
+    std::copy(values.begin(), values.end(), cellIds->GetPointer(0));
+    cellArrays[cellType] = vtkSmartPointer<vtkCellArray>::New();
+    cellArrays[cellType]->SetCells(static_cast<vtkIdType>(cellCount), cellIds);
+  }
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(static_cast<vtkIdType>(numberOfPoints));
+  if (numberOfPoints > 0)
+  {
+    std::copy(pointCoordinates.begin(), pointCoordinates.end(), vtkFloatArray::SafeDownCast(points->GetData())->GetPointer(0));
+  }
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  if (cellArrays[0])
+  {
+    polyData->SetVerts(cellArrays[0]);
+  }
+  if (cellArrays[1])
+  {
+    polyData->SetLines(cellArrays[1]);
+  }
+  roi.SetPolyData(polyData);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::SerializeBeam(CacheStream& stream, BeamEntry& beam)
+{
+  stream.Value(beam.Number);
+  stream.Value(beam.Name);
+  stream.Value(beam.Type);
+  stream.Value(beam.Description);
+  stream.Value(beam.RadiationType);
+  stream.Value(beam.RadiationIon);
+  stream.Value(beam.SourceAxisDistance);
+  stream.Value(beam.SourceIsoToJawsDistance);
+
+  stream.Value(beam.MultiLeafCollimatorType);
+  stream.Value(beam.MultiLeafCollimator.SourceIsoDistance);
+  stream.Value(beam.MultiLeafCollimator.NumberOfLeafJawPairs);
+  stream.Value(beam.MultiLeafCollimator.LeafPositionBoundary);
+
+  // Compensator and block entries do not contain data yet, only their number is kept
+  stream.Value(beam.NumberOfCompensators);
+  uint64_t numberOfCompensatorEntries = beam.CompensatorSequenceVector.size();
+  stream.Size(numberOfCompensatorEntries, 1);
+  beam.CompensatorSequenceVector.resize(numberOfCompensatorEntries);
+  stream.Value(beam.NumberOfBlocks);
+  uint64_t numberOfBlockEntries = beam.BlockSequenceVector.size();
+  stream.Size(numberOfBlockEntries, 1);
+  beam.BlockSequenceVector.resize(numberOfBlockEntries);
+
+  stream.Value(beam.NumberOfRangeShifters);
+  uint64_t numberOfRangeShifterEntries = beam.RangeShifterSequenceVector.size();
+  stream.Size(numberOfRangeShifterEntries, 1);
+  beam.RangeShifterSequenceVector.resize(numberOfRangeShifterEntries);
+  for (RangeShifterEntry& rangeShifter : beam.RangeShifterSequenceVector)
+  {
+    stream.Value(rangeShifter.Number);
+    stream.Value(rangeShifter.ID);
+    stream.Value(rangeShifter.AccessoryCode);
+    stream.Value(rangeShifter.Type);
+    stream.Value(rangeShifter.Description);
+  }
+
+  stream.Value(beam.NumberOfControlPoints);
+  uint64_t numberOfControlPointEntries = beam.ControlPointSequenceVector.size();
+  stream.Size(numberOfControlPointEntries, 1);
+  beam.ControlPointSequenceVector.resize(numberOfControlPointEntries);
+  for (ControlPointEntry& controlPoint : beam.ControlPointSequenceVector)
+  {
+    this->SerializeControlPoint(stream, controlPoint);
+  }
+
+  stream.Value(beam.FinalCumulativeMetersetWeight);
+  stream.Value(beam.ScanMode);
+  stream.Value(beam.TreatmentMachineName);
+  stream.Value(beam.TreatmentDeliveryType);
+  stream.Value(beam.Manufacturer);
+  stream.Value(beam.InstitutionName);
+  stream.Value(beam.InstitutionAddress);
+  stream.Value(beam.InstitutionalDepartmentName);
+  stream.Value(beam.ManufacturerModelName);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::SerializeControlPoint(CacheStream& stream, ControlPointEntry& controlPoint)
+{
+  stream.Value(controlPoint.Index);
+  stream.Value(controlPoint.IsocenterPositionRas);
+  stream.Value(controlPoint.CumulativeMetersetWeight);
+  stream.Value(controlPoint.GantryAngle);
+  stream.Value(controlPoint.PatientSupportAngle);
+  stream.Value(controlPoint.BeamLimitingDeviceAngle);
+  stream.Value(controlPoint.NominalBeamEnergy);
+  stream.Value(controlPoint.MetersetRate);
+  stream.Value(controlPoint.JawPositions);
+  stream.Value(controlPoint.MultiLeafCollimatorType);
+  stream.Value(controlPoint.LeafPositions);
+
+  stream.Value(controlPoint.ReferencedRangeShifterNumber);
+  stream.Value(controlPoint.RangeShifterSetting);
+  stream.Value(controlPoint.IsocenterToRangeShifterDistance);
+  stream.Value(controlPoint.RangeShifterWaterEquivalentThickness);
+
+  stream.Value(controlPoint.GantryRotationDirection);
+  stream.Value(controlPoint.GantryPitchAngle);
+  stream.Value(controlPoint.GantryPitchRotationDirection);
+  stream.Value(controlPoint.BeamLimitingDeviceRotationDirection);
+
+  stream.Value(controlPoint.ScanSpotTuneId);
+  stream.Value(controlPoint.NumberOfScanSpotPositions);
+  stream.Value(controlPoint.ScanSpotReorderingAllowed);
+  stream.Value(controlPoint.ScanSpotPositionMap);
+  stream.Value(controlPoint.ScanSpotMetersetWeights);
+  stream.Value(controlPoint.NumberOfPaintings);
+  stream.Value(controlPoint.ScanningSpotSize);
+
+  stream.Value(controlPoint.PatientSupportRotationDirection);
+  stream.Value(controlPoint.TableTopPitchAngle);
+  stream.Value(controlPoint.TableTopPitchRotationDirection);
+  stream.Value(controlPoint.TableTopRollAngle);
+  stream.Value(controlPoint.TableTopRollRotationDirection);
+  stream.Value(controlPoint.TableTopVerticalPosition);
+  stream.Value(controlPoint.TableTopLongitudinalPosition);
+  stream.Value(controlPoint.TableTopLateralPosition);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::SerializeChannel(CacheStream& stream, ChannelEntry& channel)
+{
+  stream.Value(channel.Number);
+  stream.Value(channel.NumberOfControlPoints);
+  stream.Value(channel.Length);
+  stream.Value(channel.TotalTime);
+  stream.Value(channel.ControlPointVector);
+}
+
 
 //----------------------------------------------------------------------------
 // vtkSlicerDicomRtReader methods
@@ -2466,11 +3197,15 @@ vtkSlicerDicomRtReader::vtkSlicerDicomRtReader()
   this->LoadRTPlanSuccessful = false;
   this->LoadRTIonPlanSuccessful = false;
   this->LoadRTImageSuccessful = false;
+
+  this->CacheDirectory = nullptr;
 }
 
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtReader::~vtkSlicerDicomRtReader()
 {
+  this->SetCacheDirectory(nullptr);
+
   if (this->Internal)
   {
     delete this->Internal;
@@ -2496,11 +3231,25 @@ void vtkSlicerDicomRtReader::Update()
     QString databaseFile = databaseDirectory + DICOMREADER_DICOM_DATABASE_FILENAME.c_str();
     this->SetDatabaseFile(databaseFile.toUtf8().constData());
 
+    // Restore parsed object from the cache if the file has not changed since it was cached
+    std::string sopInstanceUid;
+    uint64_t fileSize = 0;
+    uint64_t fileHash = 0;
+    bool cacheEnabled = (this->CacheDirectory != nullptr && strlen(this->CacheDirectory) > 0
+      && this->Internal->GetCacheKey(this->FileName, sopInstanceUid, fileSize, fileHash));
+    if (cacheEnabled && this->Internal->ReadFromCache(sopInstanceUid, fileSize, fileHash))
+    {
+      return;
+    }
+
     // Load DICOM file or dataset
     DcmFileFormat fileformat;
 
+    // Parsing stops at the pixel data, which none of the RT objects need from this reader. The pixel data of RT doses
+    // and images is read by the volume storage nodes, or accessed without loading it using vtkSlicerDicomRtDoseFileMap
     OFCondition result = EC_TagNotFound;
-    result = fileformat.loadFile(this->FileName, EXS_Unknown);
+    result = fileformat.loadFileUntilTag(this->FileName, EXS_Unknown, EGL_noChange,
+      DCM_MaxReadLength, ERM_autoDetect, DCM_PixelData);
     if (result.good())
     {
       DcmDataset *dataset = fileformat.getDataset();
@@ -2542,6 +3291,13 @@ void vtkSlicerDicomRtReader::Update()
         {
           //OFLOG_ERROR(drtdumpLogger, "unsupported SOPClassUID (" << sopClass << ") in file: " << ifname);
         }
+
+        // Store parsed object in the cache
+        if ( cacheEnabled
+          && (this->LoadRTStructureSetSuccessful || this->LoadRTPlanSuccessful || this->LoadRTIonPlanSuccessful) )
+        {
+          this->Internal->WriteToCache(sopInstanceUid, fileSize, fileHash);
+        }
       } 
       else 
       {
@@ -2700,6 +3456,32 @@ double vtkSlicerDicomRtReader::GetBeamControlPointNominalBeamEnergy( unsigned in
   return 0.;
 }
 
+//----------------------------------------------------------------------------
+double vtkSlicerDicomRtReader::GetBeamControlPointCumulativeMetersetWeight( unsigned int beamNumber, 
+  unsigned int controlPointIndex)
+{
+  vtkInternal::BeamEntry* beam=this->Internal->FindBeamByNumber(beamNumber);
+  if (beam && (controlPointIndex < beam->ControlPointSequenceVector.size()))
+  {
+    vtkInternal::ControlPointEntry& controlPoint = beam->ControlPointSequenceVector.at(controlPointIndex);
+    return controlPoint.CumulativeMetersetWeight;
+  }
+  return -1.;
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerDicomRtReader::GetBeamControlPointScanSpotTuneId( unsigned int beamNumber, 
+  unsigned int controlPointIndex)
+{
+  vtkInternal::BeamEntry* beam=this->Internal->FindBeamByNumber(beamNumber);
+  if (beam && (controlPointIndex < beam->ControlPointSequenceVector.size()))
+  {
+    vtkInternal::ControlPointEntry& controlPoint = beam->ControlPointSequenceVector.at(controlPointIndex);
+    return controlPoint.ScanSpotTuneId.c_str();
+  }
+  return nullptr;
+}
+
 //----------------------------------------------------------------------------
 double* vtkSlicerDicomRtReader::GetBeamControlPointIsocenterPositionRas( unsigned int beamNumber,
   unsigned int controlPointIndex)
@@ -106,6 +106,16 @@ public:
   double GetBeamControlPointNominalBeamEnergy( unsigned int beamNumber, 
     unsigned int controlPoint);
 
+  /// Get cumulative meterset weight for a given control point of a beam
+  /// \return Cumulative meterset weight, -1 if not available
+  double GetBeamControlPointCumulativeMetersetWeight( unsigned int beamNumber, 
+    unsigned int controlPoint);
+
+  /// Get scan spot tune ID for a given control point of a modulated ion beam
+  /// \return Tune ID string, nullptr if the control point is not found
+  const char* GetBeamControlPointScanSpotTuneId( unsigned int beamNumber, 
+    unsigned int controlPoint);
+
   /// Get source axis distance for a given beam
   double GetBeamSourceAxisDistance(unsigned int beamNumber);
 
@@ -290,6 +300,15 @@ public:
   /// Get load image successful flag
   vtkGetMacro(LoadRTImageSuccessful, bool);
 
+  /// Get directory of the on-disk cache of parsed RT objects
+  vtkGetStringMacro(CacheDirectory);
+  /// Set directory of the on-disk cache of parsed RT objects. Caching is disabled if empty (default).
+  /// Structure sets and (ion) plans are cached: the first time a file is read, the decoded ROIs, beams and
+  /// channels are stored in a binary file named after the SOP instance UID, and the next times the file is
+  /// read they are restored from the cache without parsing the DICOM file. A cache file is only used if the
+  /// size and the hash of the DICOM file contents are the same as when the cache file was written.
+  vtkSetStringMacro(CacheDirectory);
+
 protected:
   /// Set pixel spacing for dose volume
   vtkSetVector2Macro(PixelSpacing, double);
@@ -371,6 +390,9 @@ protected:
   /// Flag indicating if RT Image has been successfully read from the input dataset
   bool LoadRTImageSuccessful;
 
+  /// Directory of the on-disk cache of parsed RT objects. Caching is disabled if empty
+  char* CacheDirectory;
+
 protected:
   vtkSlicerDicomRtReader();
   ~vtkSlicerDicomRtReader() override;
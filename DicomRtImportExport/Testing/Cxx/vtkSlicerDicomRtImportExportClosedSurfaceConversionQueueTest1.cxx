@@ -0,0 +1,220 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtImportExportModuleLogic.h"
+#include "vtkPlanarContourToClosedSurfaceConversionRule.h"
+
+// Segmentations includes
+#include <vtkMRMLSegmentationDisplayNode.h>
+#include <vtkMRMLSegmentationNode.h>
+
+// SegmentationCore includes
+#include <vtkSegment.h>
+#include <vtkSegmentation.h>
+#include <vtkSegmentationConverter.h>
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
+namespace
+{
+  const int NUMBER_OF_SEGMENTS = 3;
+  const int NUMBER_OF_SLICES = 4;
+  const double SLICE_THICKNESS = 2.0;
+
+  //----------------------------------------------------------------------------
+  void CountEventsCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+  {
+    ++(*static_cast<int*>(clientData));
+  }
+
+  //----------------------------------------------------------------------------
+  /// Create planar contours of a box: one closed square on each slice
+  vtkSmartPointer<vtkPolyData> CreateBoxContours(double centerX, double halfSize)
+  {
+    vtkNew<vtkPoints> points;
+    vtkNew<vtkCellArray> lines;
+    for (int slice = 0; slice < NUMBER_OF_SLICES; ++slice)
+    {
+      double z = slice * SLICE_THICKNESS;
+      vtkIdType firstPointId = points->InsertNextPoint(centerX - halfSize, -halfSize, z);
+      points->InsertNextPoint(centerX + halfSize, -halfSize, z);
+      points->InsertNextPoint(centerX + halfSize, halfSize, z);
+      points->InsertNextPoint(centerX - halfSize, halfSize, z);
+
+      // Contours are closed by repeating the first point
+      lines->InsertNextCell(5);
+      for (vtkIdType pointIndex = 0; pointIndex < 4; ++pointIndex)
+      {
+        lines->InsertCellPoint(firstPointId + pointIndex);
+      }
+      lines->InsertCellPoint(firstPointId);
+    }
+
+    vtkSmartPointer<vtkPolyData> contours = vtkSmartPointer<vtkPolyData>::New();
+    contours->SetPoints(points);
+    contours->SetLines(lines);
+    return contours;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Call ProcessClosedSurfaceConversionQueue until it has nothing left to convert, and return the number of converted segments
+  int DrainClosedSurfaceConversionQueue(vtkSlicerDicomRtImportExportModuleLogic* logic)
+  {
+    int numberOfConvertedSegments = 0;
+    while (logic->ProcessClosedSurfaceConversionQueue())
+    {
+      ++numberOfConvertedSegments;
+      if (numberOfConvertedSegments > NUMBER_OF_SEGMENTS)
+      {
+        break;
+      }
+    }
+    return numberOfConvertedSegments;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportClosedSurfaceConversionQueueTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerDicomRtImportExportModuleLogic> dicomRtImportExportLogic;
+  // Registers the planar contour to closed surface conversion rule
+  dicomRtImportExportLogic->SetMRMLScene(mrmlScene);
+
+  int numberOfQueuedEvents = 0;
+  vtkNew<vtkCallbackCommand> queuedCallback;
+  queuedCallback->SetCallback(CountEventsCallback);
+  queuedCallback->SetClientData(&numberOfQueuedEvents);
+  dicomRtImportExportLogic->AddObserver(vtkSlicerDicomRtImportExportModuleLogic::ClosedSurfaceConversionQueuedEvent, queuedCallback);
+
+  //
+  // Invalid input is not queued
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  dicomRtImportExportLogic->QueueClosedSurfaceConversion(nullptr);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  if (numberOfQueuedEvents != 0 || dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() != 0
+    || dicomRtImportExportLogic->ProcessClosedSurfaceConversionQueue())
+  {
+    std::cerr << __LINE__ << ": Invalid segmentation node is queued for closed surface conversion" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Structure set like segmentation with planar contour segments shown as contours
+  vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+  mrmlScene->AddNode(segmentationNode);
+  vtkNew<vtkMRMLSegmentationDisplayNode> displayNode;
+  mrmlScene->AddNode(displayNode);
+  segmentationNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+
+  std::string planarContourName(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName());
+  std::string closedSurfaceName(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  segmentation->SetMasterRepresentationName(planarContourName.c_str());
+  segmentation->SetConversionParameter(vtkPlanarContourToClosedSurfaceConversionRule::GetDefaultSliceThicknessParameterName(), "2");
+  std::vector<std::string> segmentIDs;
+  for (int segmentIndex = 0; segmentIndex < NUMBER_OF_SEGMENTS; ++segmentIndex)
+  {
+    vtkNew<vtkSegment> segment;
+    segment->AddRepresentation(planarContourName, CreateBoxContours(segmentIndex * 30.0, 10.0));
+    segmentIDs.push_back(segmentation->AddSegment(segment));
+  }
+  displayNode->SetPreferredDisplayRepresentationName3D(planarContourName.c_str());
+
+  //
+  // Queue the segments, the hidden one stays in the queue
+  dicomRtImportExportLogic->QueueClosedSurfaceConversion(segmentationNode);
+  if (numberOfQueuedEvents != 1
+    || dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() != NUMBER_OF_SEGMENTS)
+  {
+    std::cerr << __LINE__ << ": Queued event invoked " << numberOfQueuedEvents << " times and "
+      << dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() << " segments are pending instead of "
+      << NUMBER_OF_SEGMENTS << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string& hiddenSegmentID = segmentIDs.back();
+  displayNode->SetSegmentVisibility(hiddenSegmentID, false);
+  int numberOfConvertedSegments = DrainClosedSurfaceConversionQueue(dicomRtImportExportLogic);
+  if (numberOfConvertedSegments != NUMBER_OF_SEGMENTS - 1
+    || dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() != 1)
+  {
+    std::cerr << __LINE__ << ": " << numberOfConvertedSegments << " visible segments are converted and "
+      << dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() << " are pending" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (const std::string& segmentID : segmentIDs)
+  {
+    bool converted = (segmentation->GetSegment(segmentID)->GetRepresentation(closedSurfaceName) != nullptr);
+    if (converted == (segmentID == hiddenSegmentID))
+    {
+      std::cerr << __LINE__ << ": Segment " << segmentID << (converted ? " is" : " is not") << " converted" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (!displayNode->GetPreferredDisplayRepresentationName3D()
+    || closedSurfaceName != displayNode->GetPreferredDisplayRepresentationName3D())
+  {
+    std::cerr << __LINE__ << ": Converted closed surfaces are not shown" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Showing the hidden segment converts it and empties the queue
+  displayNode->SetSegmentVisibility(hiddenSegmentID, true);
+  numberOfConvertedSegments = DrainClosedSurfaceConversionQueue(dicomRtImportExportLogic);
+  if (numberOfConvertedSegments != 1
+    || dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() != 0
+    || !segmentation->GetSegment(hiddenSegmentID)->GetRepresentation(closedSurfaceName))
+  {
+    std::cerr << __LINE__ << ": Shown segment is not converted, "
+      << dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() << " segments are pending" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (dicomRtImportExportLogic->ProcessClosedSurfaceConversionQueue())
+  {
+    std::cerr << __LINE__ << ": Drained queue still converts segments" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Segmentations removed from the scene are dropped from the queue
+  dicomRtImportExportLogic->QueueClosedSurfaceConversion(segmentationNode);
+  mrmlScene->RemoveNode(segmentationNode);
+  if (dicomRtImportExportLogic->ProcessClosedSurfaceConversionQueue()
+    || dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() != 0)
+  {
+    std::cerr << __LINE__ << ": Removed segmentation is not dropped from the queue" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
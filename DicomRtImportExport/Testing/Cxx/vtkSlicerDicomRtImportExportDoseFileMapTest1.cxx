@@ -0,0 +1,267 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtDoseFileMap.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLVolumeArchetypeStorageNode.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dctk.h>
+
+// STD includes
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const unsigned int ROWS = 6;
+  const unsigned int COLUMNS = 7;
+  const unsigned int NUMBER_OF_FRAMES = 5;
+  const double DOSE_GRID_SCALING = 0.25;
+
+  //----------------------------------------------------------------------------
+  /// Write a multi-frame RT Dose with distinct stored values in every voxel
+  bool WriteMultiFrameRtDose(const std::string& fileName, E_TransferSyntax transferSyntax, Uint16 bitsAllocated)
+  {
+    DcmFileFormat fileFormat;
+    DcmDataset* dataset = fileFormat.getDataset();
+    char uid[100] = { 0 };
+    dataset->putAndInsertString(DCM_SOPClassUID, UID_RTDoseStorage);
+    dataset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+    dataset->putAndInsertString(DCM_StudyInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_STUDY_UID_ROOT));
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_SERIES_UID_ROOT));
+    dataset->putAndInsertString(DCM_FrameOfReferenceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+    dataset->putAndInsertString(DCM_Modality, "RTDOSE");
+    dataset->putAndInsertString(DCM_PatientName, "DoseFileMap^Test");
+    dataset->putAndInsertString(DCM_PatientID, "DoseFileMapTest");
+    dataset->putAndInsertString(DCM_DoseUnits, "GY");
+    dataset->putAndInsertString(DCM_DoseType, "PHYSICAL");
+    dataset->putAndInsertString(DCM_DoseSummationType, "PLAN");
+    dataset->putAndInsertString(DCM_DoseGridScaling, "0.25");
+    dataset->putAndInsertString(DCM_ImagePositionPatient, "-10\\-20\\30");
+    dataset->putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0");
+    dataset->putAndInsertString(DCM_PixelSpacing, "2\\3");
+    dataset->putAndInsertString(DCM_GridFrameOffsetVector, "0\\2.5\\5\\7.5\\10");
+    dataset->putAndInsertTagKey(DCM_FrameIncrementPointer, DCM_GridFrameOffsetVector);
+    dataset->putAndInsertString(DCM_SamplesPerPixel, "1");
+    dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    dataset->putAndInsertUint16(DCM_Rows, ROWS);
+    dataset->putAndInsertUint16(DCM_Columns, COLUMNS);
+    dataset->putAndInsertString(DCM_NumberOfFrames, "5");
+    dataset->putAndInsertUint16(DCM_BitsAllocated, bitsAllocated);
+    dataset->putAndInsertUint16(DCM_BitsStored, bitsAllocated);
+    dataset->putAndInsertUint16(DCM_HighBit, bitsAllocated - 1);
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+
+    const unsigned int numberOfVoxels = ROWS * COLUMNS * NUMBER_OF_FRAMES;
+    if (bitsAllocated == 16)
+    {
+      std::vector<Uint16> pixels(numberOfVoxels);
+      for (unsigned int i=0; i<numberOfVoxels; ++i)
+      {
+        pixels[i] = static_cast<Uint16>(i * 311);
+      }
+      dataset->putAndInsertUint16Array(DCM_PixelData, pixels.data(), numberOfVoxels);
+    }
+    else
+    {
+      // Little endian byte order of the 32-bit values is the same as in memory on the supported platforms
+      std::vector<Uint32> pixels(numberOfVoxels);
+      for (unsigned int i=0; i<numberOfVoxels; ++i)
+      {
+        pixels[i] = i * 1000003u;
+      }
+      std::vector<Uint8> bytes(numberOfVoxels * sizeof(Uint32));
+      memcpy(bytes.data(), pixels.data(), bytes.size());
+      dataset->putAndInsertUint8Array(DCM_PixelData, bytes.data(), bytes.size());
+    }
+
+    return fileFormat.saveFile(fileName.c_str(), transferSyntax).good();
+  }
+
+  //----------------------------------------------------------------------------
+  /// Compare the stored pixel image and the frame doses of the file map with the voxels read by the volume storage node
+  bool IsDoseFileMapConsistentWithStorageNode(const std::string& fileName, int expectedScalarType)
+  {
+    vtkNew<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode;
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    volumeStorageNode->SetFileName(fileName.c_str());
+    volumeStorageNode->ResetFileNameList();
+    volumeStorageNode->SetSingleFile(1);
+    if (!volumeStorageNode->ReadData(volumeNode) || !volumeNode->GetImageData())
+    {
+      std::cerr << "Failed to read RT Dose file " << fileName << " with volume storage node" << std::endl;
+      return false;
+    }
+    vtkDataArray* referenceScalars = volumeNode->GetImageData()->GetPointData()->GetScalars();
+
+    vtkSmartPointer<vtkSlicerDicomRtDoseFileMap> doseFileMap = vtkSmartPointer<vtkSlicerDicomRtDoseFileMap>::New();
+    if (!doseFileMap->Open(fileName.c_str()))
+    {
+      std::cerr << "Failed to map RT Dose file " << fileName << std::endl;
+      return false;
+    }
+    if ( doseFileMap->GetRows() != static_cast<int>(ROWS) || doseFileMap->GetColumns() != static_cast<int>(COLUMNS)
+      || doseFileMap->GetNumberOfFrames() != static_cast<int>(NUMBER_OF_FRAMES) || doseFileMap->GetScalarType() != expectedScalarType
+      || doseFileMap->GetDoseGridScaling() != DOSE_GRID_SCALING
+      || doseFileMap->GetPixelSpacing()[0] != 3.0 || doseFileMap->GetPixelSpacing()[1] != 2.0
+      || doseFileMap->GetGridFrameOffsets().size() != NUMBER_OF_FRAMES )
+    {
+      std::cerr << "Invalid header attributes parsed from " << fileName << std::endl;
+      return false;
+    }
+    int* referenceDimensions = volumeNode->GetImageData()->GetDimensions();
+    if ( referenceDimensions[0] != doseFileMap->GetColumns() || referenceDimensions[1] != doseFileMap->GetRows()
+      || referenceDimensions[2] != doseFileMap->GetNumberOfFrames() )
+    {
+      std::cerr << "Dimensions of " << fileName << " differ from the volume read by the storage node" << std::endl;
+      return false;
+    }
+
+    // Frame doses
+    vtkIdType numberOfVoxelsPerFrame = doseFileMap->GetNumberOfVoxelsPerFrame();
+    std::vector<float> frameDose(numberOfVoxelsPerFrame);
+    for (int frameIndex = 0; frameIndex < doseFileMap->GetNumberOfFrames(); ++frameIndex)
+    {
+      if (!doseFileMap->GetFrameDose(frameIndex, frameDose.data()))
+      {
+        std::cerr << "Failed to get dose of frame " << frameIndex << " from " << fileName << std::endl;
+        return false;
+      }
+      for (vtkIdType voxelIndex = 0; voxelIndex < numberOfVoxelsPerFrame; ++voxelIndex)
+      {
+        double referenceDose = static_cast<float>(referenceScalars->GetTuple1(frameIndex * numberOfVoxelsPerFrame + voxelIndex) * DOSE_GRID_SCALING);
+        if (frameDose[voxelIndex] != referenceDose)
+        {
+          std::cerr << "Dose mismatch in frame " << frameIndex << " of " << fileName << " at voxel " << voxelIndex
+            << ": " << frameDose[voxelIndex] << " instead of " << referenceDose << std::endl;
+          return false;
+        }
+      }
+    }
+
+    // Stored pixel image, used after the file map is closed and deleted
+    vtkNew<vtkImageData> storedPixelImageData;
+    if (!doseFileMap->GetStoredPixelImageData(storedPixelImageData))
+    {
+      std::cerr << "Failed to get stored pixel image from " << fileName << std::endl;
+      return false;
+    }
+    doseFileMap->Close();
+    doseFileMap = nullptr;
+
+    vtkDataArray* storedScalars = storedPixelImageData->GetPointData()->GetScalars();
+    if ( !storedScalars || storedScalars->GetDataType() != expectedScalarType
+      || storedScalars->GetNumberOfTuples() != referenceScalars->GetNumberOfTuples() )
+    {
+      std::cerr << "Invalid stored pixel image from " << fileName << std::endl;
+      return false;
+    }
+    for (vtkIdType voxelIndex = 0; voxelIndex < storedScalars->GetNumberOfTuples(); ++voxelIndex)
+    {
+      if (storedScalars->GetTuple1(voxelIndex) != referenceScalars->GetTuple1(voxelIndex))
+      {
+        std::cerr << "Stored pixel value mismatch in " << fileName << " at voxel " << voxelIndex << ": "
+          << storedScalars->GetTuple1(voxelIndex) << " instead of " << referenceScalars->GetTuple1(voxelIndex) << std::endl;
+        return false;
+      }
+    }
+
+    // Modifying the stored pixel image does not change the file
+    double firstStoredValue = storedScalars->GetTuple1(0);
+    storedScalars->SetTuple1(0, firstStoredValue + 1.0);
+    vtkNew<vtkSlicerDicomRtDoseFileMap> reopenedDoseFileMap;
+    vtkNew<vtkImageData> reopenedStoredPixelImageData;
+    if ( !reopenedDoseFileMap->Open(fileName.c_str()) || !reopenedDoseFileMap->GetStoredPixelImageData(reopenedStoredPixelImageData)
+      || reopenedStoredPixelImageData->GetPointData()->GetScalars()->GetTuple1(0) != firstStoredValue )
+    {
+      std::cerr << "Modified stored pixel image changed the file " << fileName << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportDoseFileMapTest1(int argc, char* argv[])
+{
+  // TemporaryDirectory
+  const char* temporaryDirectory = nullptr;
+  if (argc > 2 && std::string(argv[1]) == "-TemporaryDirectory")
+  {
+    temporaryDirectory = argv[2];
+    std::cout << "Temporary directory: " << temporaryDirectory << std::endl;
+  }
+  else
+  {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string doseDirectory = std::string(temporaryDirectory) + "/DicomRtImportExportDoseFileMapTest";
+  vtksys::SystemTools::MakeDirectory(doseDirectory);
+
+  std::string implicitVrFileName = doseDirectory + "/RTDOSE_ImplicitVR.dcm";
+  std::string explicitVrFileName = doseDirectory + "/RTDOSE_ExplicitVR.dcm";
+  if ( !WriteMultiFrameRtDose(implicitVrFileName, EXS_LittleEndianImplicit, 16)
+    || !WriteMultiFrameRtDose(explicitVrFileName, EXS_LittleEndianExplicit, 32) )
+  {
+    std::cerr << "Failed to write synthetic RT Dose files to " << doseDirectory << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if ( !IsDoseFileMapConsistentWithStorageNode(implicitVrFileName, VTK_UNSIGNED_SHORT)
+    || !IsDoseFileMapConsistentWithStorageNode(explicitVrFileName, VTK_UNSIGNED_INT) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Compressed or big endian pixel data is not mapped
+  std::string bigEndianFileName = doseDirectory + "/RTDOSE_BigEndian.dcm";
+  if (!WriteMultiFrameRtDose(bigEndianFileName, EXS_BigEndianExplicit, 16))
+  {
+    std::cerr << "Failed to write big endian RT Dose file " << bigEndianFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkNew<vtkSlicerDicomRtDoseFileMap> doseFileMap;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  bool bigEndianOpened = doseFileMap->Open(bigEndianFileName.c_str());
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  if (bigEndianOpened || doseFileMap->IsOpen())
+  {
+    std::cerr << "Big endian RT Dose file is mapped" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtImportExportModuleLogic.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageCast.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <string>
+
+namespace
+{
+  const double DOSE_GRID_SCALING = 1.5e-5;
+
+  //----------------------------------------------------------------------------
+  /// Apply dose grid scaling the way it was done before the scaling was fused into a single pass:
+  /// cast to float, deep copy, then scale every voxel. Used as baseline for the benchmark.
+  void ApplyDoseGridScalingInSeparatePasses(vtkImageData* storedPixelData, double doseGridScaling, vtkImageData* doseImageData)
+  {
+    vtkNew<vtkImageCast> imageCast;
+    imageCast->SetInputData(storedPixelData);
+    imageCast->SetOutputScalarTypeToFloat();
+    imageCast->Update();
+    doseImageData->DeepCopy(imageCast->GetOutput());
+
+    float* floatPtr = static_cast<float*>(doseImageData->GetScalarPointer());
+    for (vtkIdType i=0; i<doseImageData->GetNumberOfPoints(); ++i)
+    {
+      (*floatPtr) = (*floatPtr) * doseGridScaling;
+      ++floatPtr;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Check the dose computed from a small grid of the given scalar type against
+  /// dose = stored pixel value * dose grid scaling for every voxel
+  bool IsDoseGridScalingCorrect(int scalarType)
+  {
+    // Odd, non-zero based extent so that the geometry is checked as well as the values
+    vtkNew<vtkImageData> storedPixelData;
+    storedPixelData->SetExtent(2, 8, -1, 3, 0, 2);
+    storedPixelData->SetSpacing(2.0, 2.5, 3.0);
+    storedPixelData->SetOrigin(-12.5, 4.0, -30.0);
+    storedPixelData->AllocateScalars(scalarType, 1);
+    vtkIdType numberOfVoxels = storedPixelData->GetNumberOfPoints();
+    bool isSigned = (scalarType == VTK_SHORT || scalarType == VTK_INT);
+    double maximumValue = (scalarType == VTK_UNSIGNED_SHORT || scalarType == VTK_SHORT) ? 30000.0 : 40000000.0;
+    for (vtkIdType i=0; i<numberOfVoxels; ++i)
+    {
+      double value = std::floor(maximumValue * i / (numberOfVoxels - 1));
+      storedPixelData->GetPointData()->GetScalars()->SetTuple1(i, (isSigned && i % 2) ? -value : value);
+    }
+
+    vtkNew<vtkImageData> doseImageData;
+    if (!vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling(storedPixelData, DOSE_GRID_SCALING, doseImageData))
+    {
+      std::cerr << "Failed to apply dose grid scaling to " << storedPixelData->GetScalarTypeAsString() << " pixel data" << std::endl;
+      return false;
+    }
+
+    if (doseImageData->GetScalarType() != VTK_FLOAT)
+    {
+      std::cerr << "Dose image scalar type is " << doseImageData->GetScalarTypeAsString() << " instead of float" << std::endl;
+      return false;
+    }
+    for (int i=0; i<3; ++i)
+    {
+      if ( doseImageData->GetExtent()[2*i] != storedPixelData->GetExtent()[2*i]
+        || doseImageData->GetExtent()[2*i+1] != storedPixelData->GetExtent()[2*i+1]
+        || doseImageData->GetSpacing()[i] != storedPixelData->GetSpacing()[i]
+        || doseImageData->GetOrigin()[i] != storedPixelData->GetOrigin()[i] )
+      {
+        std::cerr << "Dose image geometry differs from " << storedPixelData->GetScalarTypeAsString() << " pixel data geometry" << std::endl;
+        return false;
+      }
+    }
+
+    // Float has 24 bits of mantissa, so allow for the rounding of the stored value and of the product
+    for (vtkIdType i=0; i<numberOfVoxels; ++i)
+    {
+      double expectedDose = storedPixelData->GetPointData()->GetScalars()->GetTuple1(i) * DOSE_GRID_SCALING;
+      double dose = doseImageData->GetPointData()->GetScalars()->GetTuple1(i);
+      if (std::fabs(dose - expectedDose) > 1.0e-6 * std::fabs(expectedDose))
+      {
+        std::cerr << "Dose value mismatch for " << storedPixelData->GetScalarTypeAsString() << " pixel data at voxel "
+          << i << ": " << dose << " instead of " << expectedDose << std::endl;
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Time the fused dose grid scaling against the separate cast, copy and scale passes
+  /// on a synthetic dose grid with the size of a typical fine resolution dose
+  bool RunDoseGridScalingBenchmark()
+  {
+    const int dimensions[3] = { 512, 512, 300 };
+
+    vtkNew<vtkImageData> storedPixelData;
+    storedPixelData->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+    storedPixelData->SetSpacing(1.0, 1.0, 2.5);
+    storedPixelData->SetOrigin(-256.0, -256.0, -375.0);
+    storedPixelData->AllocateScalars(VTK_UNSIGNED_INT, 1);
+    unsigned int* storedValues = static_cast<unsigned int*>(storedPixelData->GetScalarPointer());
+    vtkIdType numberOfVoxels = storedPixelData->GetNumberOfPoints();
+    for (vtkIdType i=0; i<numberOfVoxels; ++i)
+    {
+      storedValues[i] = static_cast<unsigned int>((i * 2654435761u) % 40000000u);
+    }
+    std::cout << "Dose grid: " << dimensions[0] << "x" << dimensions[1] << "x" << dimensions[2]
+      << " (" << numberOfVoxels << " voxels)" << std::endl;
+
+    vtkNew<vtkTimerLog> timer;
+    vtkNew<vtkImageData> doseImageData;
+    double checkpointStart = timer->GetUniversalTime();
+    if (!vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling(storedPixelData, DOSE_GRID_SCALING, doseImageData))
+    {
+      std::cerr << "Failed to apply dose grid scaling" << std::endl;
+      return false;
+    }
+    double fusedTime = timer->GetUniversalTime() - checkpointStart;
+
+    vtkNew<vtkImageData> baselineDoseImageData;
+    checkpointStart = timer->GetUniversalTime();
+    ApplyDoseGridScalingInSeparatePasses(storedPixelData, DOSE_GRID_SCALING, baselineDoseImageData);
+    double baselineTime = timer->GetUniversalTime() - checkpointStart;
+
+    std::cout << "Dose grid scaling time: fused " << fusedTime << " s, separate passes " << baselineTime << " s" << std::endl;
+    std::cout << "Intermediate dose grid copies: fused 0, separate passes 2" << std::endl;
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportDoseGridScalingTest1(int argc, char* argv[])
+{
+  // Benchmark is only run on request, as it allocates over a GB of memory and takes a while
+  bool benchmark = (argc > 1 && std::string(argv[1]) == "-Benchmark");
+
+  const int scalarTypes[4] = { VTK_UNSIGNED_SHORT, VTK_SHORT, VTK_UNSIGNED_INT, VTK_INT };
+  for (int scalarType : scalarTypes)
+  {
+    if (!IsDoseGridScalingCorrect(scalarType))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Invalid input
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(2, 2, 2);
+  imageData->AllocateScalars(VTK_UNSIGNED_INT, 1);
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  bool invalidInputAccepted = vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling(nullptr, DOSE_GRID_SCALING, imageData)
+    || vtkSlicerDicomRtImportExportModuleLogic::ApplyDoseGridScaling(imageData, DOSE_GRID_SCALING, imageData);
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  if (invalidInputAccepted)
+  {
+    std::cerr << "Dose grid scaling accepts invalid input" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (benchmark && !RunDoseGridScalingBenchmark())
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,481 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtImportExportModuleLogic.h"
+
+// Slicer includes
+#include "vtkSlicerDICOMLoadable.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkStringArray.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dctk.h>
+
+// STD includes
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const unsigned int NUMBER_OF_REFERENCED_IMAGES = 3;
+  const unsigned int NUMBER_OF_ROIS = 20;
+  const unsigned int NUMBER_OF_CONTOURS_PER_ROI = 50;
+  const unsigned int NUMBER_OF_CONTOUR_POINTS = 200;
+
+  //----------------------------------------------------------------------------
+  std::string ToString(double value)
+  {
+    std::ostringstream stream;
+    stream << value;
+    return stream.str();
+  }
+
+  //----------------------------------------------------------------------------
+  /// Insert the patient, study and series attributes shared by the synthetic RT objects
+  void InsertCommonAttributes(DcmDataset* dataset, const char* sopClassUID, const char* modality,
+    const char* studyInstanceUID, const char* frameOfReferenceUID, const char* seriesNumber)
+  {
+    char uid[100] = { 0 };
+    dataset->putAndInsertString(DCM_SOPClassUID, sopClassUID);
+    dataset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+    dataset->putAndInsertString(DCM_StudyInstanceUID, studyInstanceUID);
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_SERIES_UID_ROOT));
+    dataset->putAndInsertString(DCM_FrameOfReferenceUID, frameOfReferenceUID);
+    dataset->putAndInsertString(DCM_Modality, modality);
+    dataset->putAndInsertString(DCM_SeriesNumber, seriesNumber);
+    dataset->putAndInsertString(DCM_InstanceNumber, "1");
+    dataset->putAndInsertString(DCM_PatientName, "Examine^Test");
+    dataset->putAndInsertString(DCM_PatientID, "ExamineTest");
+    dataset->putAndInsertString(DCM_StudyDate, "20200101");
+    dataset->putAndInsertString(DCM_StudyTime, "120000");
+  }
+
+  //----------------------------------------------------------------------------
+  /// Insert 16-bit pixel data with the given number of frames
+  void InsertPixelData(DcmDataset* dataset, unsigned int rows, unsigned int columns, unsigned int frames)
+  {
+    dataset->putAndInsertString(DCM_SamplesPerPixel, "1");
+    dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    dataset->putAndInsertUint16(DCM_Rows, rows);
+    dataset->putAndInsertUint16(DCM_Columns, columns);
+    dataset->putAndInsertString(DCM_NumberOfFrames, ToString(frames).c_str());
+    dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+    dataset->putAndInsertUint16(DCM_BitsStored, 16);
+    dataset->putAndInsertUint16(DCM_HighBit, 15);
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+    std::vector<Uint16> pixels(rows * columns * frames);
+    for (size_t i=0; i<pixels.size(); ++i)
+    {
+      pixels[i] = static_cast<Uint16>(i % 1000);
+    }
+    dataset->putAndInsertUint16Array(DCM_PixelData, pixels.data(), pixels.size());
+  }
+
+  //----------------------------------------------------------------------------
+  /// Write the supported RT objects of one study. The structure set has a large ROI contour sequence, and the
+  /// dose and image have pixel data, which are the parts of the files that are not parsed when examining them.
+  bool WriteSyntheticStudy(const std::string& directory, std::vector<std::string>& fileNames)
+  {
+    char studyInstanceUID[100] = { 0 };
+    dcmGenerateUniqueIdentifier(studyInstanceUID, SITE_STUDY_UID_ROOT);
+    char frameOfReferenceUID[100] = { 0 };
+    dcmGenerateUniqueIdentifier(frameOfReferenceUID, SITE_INSTANCE_UID_ROOT);
+    OFString planInstanceUID;
+    char uid[100] = { 0 };
+
+    // RT plan. Its instance is referenced by the RT image.
+    {
+      DcmFileFormat fileFormat;
+      DcmDataset* dataset = fileFormat.getDataset();
+      InsertCommonAttributes(dataset, UID_RTPlanStorage, "RTPLAN", studyInstanceUID, frameOfReferenceUID, "3");
+      dataset->findAndGetOFString(DCM_SOPInstanceUID, planInstanceUID);
+      dataset->putAndInsertString(DCM_RTPlanLabel, "Prostate");
+      dataset->putAndInsertString(DCM_RTPlanName, "Prostate IMRT");
+      dataset->putAndInsertString(DCM_RTPlanGeometry, "PATIENT");
+      DcmItem* doseReferenceItem = nullptr;
+      dataset->findOrCreateSequenceItem(DCM_DoseReferenceSequence, doseReferenceItem, -2);
+      doseReferenceItem->putAndInsertString(DCM_DoseReferenceNumber, "1");
+      doseReferenceItem->putAndInsertString(DCM_DoseReferenceStructureType, "SITE");
+      doseReferenceItem->putAndInsertString(DCM_DoseReferenceType, "TARGET");
+      DcmItem* beamItem = nullptr;
+      dataset->findOrCreateSequenceItem(DCM_BeamSequence, beamItem, -2);
+      beamItem->putAndInsertString(DCM_BeamNumber, "1");
+      beamItem->putAndInsertString(DCM_BeamName, "AP");
+      beamItem->putAndInsertString(DCM_BeamType, "STATIC");
+      beamItem->putAndInsertString(DCM_RadiationType, "PHOTON");
+      beamItem->putAndInsertString(DCM_NumberOfControlPoints, "2");
+      fileNames.push_back(directory + "/RTPLAN.dcm");
+      if (!fileFormat.saveFile(fileNames.back().c_str(), EXS_LittleEndianExplicit).good())
+      {
+        return false;
+      }
+    }
+
+    // RT ion plan with the same label and name
+    {
+      DcmFileFormat fileFormat;
+      DcmDataset* dataset = fileFormat.getDataset();
+      InsertCommonAttributes(dataset, UID_RTIonPlanStorage, "RTPLAN", studyInstanceUID, frameOfReferenceUID, "4");
+      dataset->putAndInsertString(DCM_RTPlanLabel, "Proton");
+      dataset->putAndInsertString(DCM_RTPlanName, "Proton");
+      dataset->putAndInsertString(DCM_RTPlanGeometry, "PATIENT");
+      DcmItem* beamItem = nullptr;
+      dataset->findOrCreateSequenceItem(DCM_IonBeamSequence, beamItem, -2);
+      beamItem->putAndInsertString(DCM_BeamNumber, "1");
+      beamItem->putAndInsertString(DCM_BeamName, "Field1");
+      beamItem->putAndInsertString(DCM_RadiationType, "PROTON");
+      beamItem->putAndInsertString(DCM_NumberOfControlPoints, "2");
+      fileNames.push_back(directory + "/RTIONPLAN.dcm");
+      if (!fileFormat.saveFile(fileNames.back().c_str(), EXS_LittleEndianExplicit).good())
+      {
+        return false;
+      }
+    }
+
+    // RT structure set referencing the images in the referenced frame of reference sequence
+    {
+      DcmFileFormat fileFormat;
+      DcmDataset* dataset = fileFormat.getDataset();
+      InsertCommonAttributes(dataset, UID_RTStructureSetStorage, "RTSTRUCT", studyInstanceUID, frameOfReferenceUID, "2");
+      dataset->putAndInsertString(DCM_StructureSetLabel, "Contours");
+      dataset->putAndInsertString(DCM_StructureSetDate, "20200101");
+      dataset->putAndInsertString(DCM_StructureSetTime, "120000");
+
+      DcmItem* frameOfReferenceItem = nullptr;
+      dataset->findOrCreateSequenceItem(DCM_ReferencedFrameOfReferenceSequence, frameOfReferenceItem, -2);
+      frameOfReferenceItem->putAndInsertString(DCM_FrameOfReferenceUID, frameOfReferenceUID);
+      DcmItem* studyItem = nullptr;
+      frameOfReferenceItem->findOrCreateSequenceItem(DCM_RTReferencedStudySequence, studyItem, -2);
+      studyItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_RETIRED_DetachedStudyManagementSOPClass);
+      studyItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, studyInstanceUID);
+      DcmItem* seriesItem = nullptr;
+      studyItem->findOrCreateSequenceItem(DCM_RTReferencedSeriesSequence, seriesItem, -2);
+      seriesItem->putAndInsertString(DCM_SeriesInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_SERIES_UID_ROOT));
+      for (unsigned int imageIndex=0; imageIndex<NUMBER_OF_REFERENCED_IMAGES; ++imageIndex)
+      {
+        DcmItem* imageItem = nullptr;
+        seriesItem->findOrCreateSequenceItem(DCM_ContourImageSequence, imageItem, -2);
+        imageItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_CTImageStorage);
+        imageItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+      }
+
+      std::string contourData;
+      for (unsigned int pointIndex=0; pointIndex<NUMBER_OF_CONTOUR_POINTS; ++pointIndex)
+      {
+        contourData += (pointIndex > 0 ? "\\" : "") + ToString(pointIndex * 0.5) + "\\" + ToString(pointIndex * 0.25) + "\\0";
+      }
+      for (unsigned int roiIndex=0; roiIndex<NUMBER_OF_ROIS; ++roiIndex)
+      {
+        std::string roiNumber = ToString(roiIndex + 1);
+        DcmItem* roiItem = nullptr;
+        dataset->findOrCreateSequenceItem(DCM_StructureSetROISequence, roiItem, -2);
+        roiItem->putAndInsertString(DCM_ROINumber, roiNumber.c_str());
+        roiItem->putAndInsertString(DCM_ReferencedFrameOfReferenceUID, frameOfReferenceUID);
+        roiItem->putAndInsertString(DCM_ROIName, ("ROI " + roiNumber).c_str());
+        roiItem->putAndInsertString(DCM_ROIGenerationAlgorithm, "MANUAL");
+
+        DcmItem* roiContourItem = nullptr;
+        dataset->findOrCreateSequenceItem(DCM_ROIContourSequence, roiContourItem, -2);
+        roiContourItem->putAndInsertString(DCM_ReferencedROINumber, roiNumber.c_str());
+        for (unsigned int contourIndex=0; contourIndex<NUMBER_OF_CONTOURS_PER_ROI; ++contourIndex)
+        {
+          DcmItem* contourItem = nullptr;
+          roiContourItem->findOrCreateSequenceItem(DCM_ContourSequence, contourItem, -2);
+          DcmItem* contourImageItem = nullptr;
+          contourItem->findOrCreateSequenceItem(DCM_ContourImageSequence, contourImageItem, -2);
+          contourImageItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_CTImageStorage);
+          contourImageItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+          contourItem->putAndInsertString(DCM_ContourGeometricType, "CLOSED_PLANAR");
+          contourItem->putAndInsertString(DCM_NumberOfContourPoints, ToString(NUMBER_OF_CONTOUR_POINTS).c_str());
+          contourItem->putAndInsertString(DCM_ContourData, contourData.c_str());
+        }
+      }
+      fileNames.push_back(directory + "/RTSTRUCT.dcm");
+      if (!fileFormat.saveFile(fileNames.back().c_str(), EXS_LittleEndianExplicit).good())
+      {
+        return false;
+      }
+    }
+
+    // RT dose. It does not reference the plan, so that the DICOM database is not needed for the plan label.
+    {
+      DcmFileFormat fileFormat;
+      DcmDataset* dataset = fileFormat.getDataset();
+      InsertCommonAttributes(dataset, UID_RTDoseStorage, "RTDOSE", studyInstanceUID, frameOfReferenceUID, "5");
+      dataset->putAndInsertString(DCM_SeriesDescription, "Total dose");
+      dataset->putAndInsertString(DCM_InstanceNumber, "7");
+      dataset->putAndInsertString(DCM_DoseUnits, "GY");
+      dataset->putAndInsertString(DCM_DoseType, "PHYSICAL");
+      dataset->putAndInsertString(DCM_DoseSummationType, "PLAN");
+      dataset->putAndInsertString(DCM_DoseGridScaling, "0.001");
+      dataset->putAndInsertString(DCM_ImagePositionPatient, "0\\0\\0");
+      dataset->putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0");
+      dataset->putAndInsertString(DCM_PixelSpacing, "2\\2");
+      dataset->putAndInsertString(DCM_GridFrameOffsetVector, "0\\2\\4\\6");
+      InsertPixelData(dataset, 64, 64, 4);
+      fileNames.push_back(directory + "/RTDOSE.dcm");
+      if (!fileFormat.saveFile(fileNames.back().c_str(), EXS_LittleEndianExplicit).good())
+      {
+        return false;
+      }
+    }
+
+    // RT image referencing the plan
+    {
+      DcmFileFormat fileFormat;
+      DcmDataset* dataset = fileFormat.getDataset();
+      InsertCommonAttributes(dataset, UID_RTImageStorage, "RTIMAGE", studyInstanceUID, frameOfReferenceUID, "6");
+      dataset->putAndInsertString(DCM_RTImageLabel, "Portal");
+      dataset->putAndInsertString(DCM_RTImagePlane, "NORMAL");
+      DcmItem* referencedPlanItem = nullptr;
+      dataset->findOrCreateSequenceItem(DCM_ReferencedRTPlanSequence, referencedPlanItem, -2);
+      referencedPlanItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_RTPlanStorage);
+      referencedPlanItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, planInstanceUID.c_str());
+      InsertPixelData(dataset, 32, 32, 1);
+      fileNames.push_back(directory + "/RTIMAGE.dcm");
+      if (!fileFormat.saveFile(fileNames.back().c_str(), EXS_LittleEndianExplicit).good())
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get the first item of a sequence path in a dataset
+  DcmItem* GetFirstSequenceItem(DcmItem* item, const std::vector<DcmTagKey>& sequenceTags)
+  {
+    for (const DcmTagKey& sequenceTag : sequenceTags)
+    {
+      DcmItem* sequenceItem = nullptr;
+      if (!item || !item->findAndGetSequenceItem(sequenceTag, sequenceItem, 0).good())
+      {
+        return nullptr;
+      }
+      item = sequenceItem;
+    }
+    return item;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Assemble the loadable name and referenced instance UIDs of an RT object from its fully parsed file,
+  /// the way the files were examined before only their headers were parsed
+  bool ExamineFullFile(const std::string& fileName, std::string& name, std::vector<std::string>& referencedInstanceUIDs)
+  {
+    DcmFileFormat fileFormat;
+    if (!fileFormat.loadFile(fileName.c_str()).good())
+    {
+      return false;
+    }
+    DcmDataset* dataset = fileFormat.getDataset();
+    OFString sopClass;
+    dataset->findAndGetOFString(DCM_SOPClassUID, sopClass);
+    OFString seriesNumber;
+    dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
+    name = (seriesNumber.empty() ? "" : std::string(seriesNumber.c_str()) + ": ");
+    referencedInstanceUIDs.clear();
+
+    OFString value;
+    if (sopClass == UID_RTDoseStorage)
+    {
+      name += "RTDOSE";
+      if (dataset->findAndGetOFString(DCM_SeriesDescription, value).good() && !value.empty())
+      {
+        name += std::string(": ") + value.c_str();
+      }
+      if (dataset->findAndGetOFString(DCM_InstanceNumber, value).good() && !value.empty())
+      {
+        name += std::string(" [") + value.c_str() + "]";
+      }
+      DcmItem* referencedPlanItem = GetFirstSequenceItem(dataset, { DCM_ReferencedRTPlanSequence });
+      if (referencedPlanItem && referencedPlanItem->findAndGetOFString(DCM_ReferencedSOPInstanceUID, value).good())
+      {
+        referencedInstanceUIDs.push_back(value.c_str());
+      }
+    }
+    else if (sopClass == UID_RTPlanStorage || sopClass == UID_RTIonPlanStorage)
+    {
+      name += "RTPLAN";
+      OFString planLabel;
+      dataset->findAndGetOFString(DCM_RTPlanLabel, planLabel);
+      OFString planName;
+      dataset->findAndGetOFString(DCM_RTPlanName, planName);
+      if (!planLabel.empty() && !planName.empty() && planLabel != planName)
+      {
+        name += std::string(": ") + planLabel.c_str() + " (" + planName.c_str() + ")";
+      }
+      else if (!planLabel.empty() || !planName.empty())
+      {
+        name += std::string(": ") + (planLabel.empty() ? planName : planLabel).c_str();
+      }
+    }
+    else if (sopClass == UID_RTStructureSetStorage)
+    {
+      name += "RTSTRUCT";
+      if (dataset->findAndGetOFString(DCM_StructureSetLabel, value).good() && !value.empty())
+      {
+        name += std::string(": ") + value.c_str();
+      }
+      DcmItem* seriesItem = GetFirstSequenceItem(dataset,
+        { DCM_ReferencedFrameOfReferenceSequence, DCM_RTReferencedStudySequence, DCM_RTReferencedSeriesSequence });
+      DcmItem* imageItem = nullptr;
+      for (unsigned long imageIndex=0; seriesItem
+        && seriesItem->findAndGetSequenceItem(DCM_ContourImageSequence, imageItem, imageIndex).good(); ++imageIndex)
+      {
+        if (imageItem->findAndGetOFString(DCM_ReferencedSOPInstanceUID, value).good())
+        {
+          referencedInstanceUIDs.push_back(value.c_str());
+        }
+      }
+    }
+    else if (sopClass == UID_RTImageStorage)
+    {
+      name += "RTIMAGE";
+      if (dataset->findAndGetOFString(DCM_RTImageLabel, value).good() && !value.empty())
+      {
+        name += std::string(": ") + value.c_str();
+      }
+      DcmItem* referencedPlanItem = GetFirstSequenceItem(dataset, { DCM_ReferencedRTPlanSequence });
+      if (referencedPlanItem && referencedPlanItem->findAndGetOFString(DCM_ReferencedSOPInstanceUID, value).good())
+      {
+        referencedInstanceUIDs.push_back(value.c_str());
+      }
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportExamineTest1(int argc, char* argv[])
+{
+  // TemporaryDirectory
+  const char* temporaryDirectory = nullptr;
+  if (argc > 2 && std::string(argv[1]) == "-TemporaryDirectory")
+  {
+    temporaryDirectory = argv[2];
+    std::cout << "Temporary directory: " << temporaryDirectory << std::endl;
+  }
+  else
+  {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string studyDirectory = std::string(temporaryDirectory) + "/DicomRtImportExportExamineTest";
+  vtksys::SystemTools::MakeDirectory(studyDirectory);
+  std::vector<std::string> fileNames;
+  if (!WriteSyntheticStudy(studyDirectory, fileNames))
+  {
+    std::cerr << "Failed to write synthetic RT study to " << studyDirectory << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Examine the RT files and a file that is not DICOM
+  std::string invalidFileName = studyDirectory + "/NotDicom.dcm";
+  std::ofstream invalidFile(invalidFileName.c_str());
+  invalidFile << "Not a DICOM file" << std::endl;
+  invalidFile.close();
+  vtkNew<vtkStringArray> fileList;
+  for (const std::string& fileName : fileNames)
+  {
+    fileList->InsertNextValue(fileName);
+  }
+  fileList->InsertNextValue(invalidFileName);
+
+  vtkNew<vtkSlicerDicomRtImportExportModuleLogic> dicomRtLogic;
+  vtkNew<vtkCollection> loadables;
+  dicomRtLogic->ExamineForLoad(fileList, loadables);
+
+  // Loadables are created in the order of the files, and must be the same as the ones from the fully parsed files
+  if (loadables->GetNumberOfItems() != static_cast<int>(fileNames.size()))
+  {
+    std::cerr << "Number of loadables is " << loadables->GetNumberOfItems() << " instead of " << fileNames.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int loadableIndex=0; loadableIndex<loadables->GetNumberOfItems(); ++loadableIndex)
+  {
+    vtkSlicerDICOMLoadable* loadable = vtkSlicerDICOMLoadable::SafeDownCast(loadables->GetItemAsObject(loadableIndex));
+    const std::string& fileName = fileNames[loadableIndex];
+    std::string expectedName;
+    std::vector<std::string> expectedReferencedInstanceUIDs;
+    if (!ExamineFullFile(fileName, expectedName, expectedReferencedInstanceUIDs))
+    {
+      std::cerr << "Failed to parse " << fileName << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!loadable || !loadable->GetFiles() || loadable->GetFiles()->GetNumberOfValues() != 1
+      || fileName != loadable->GetFiles()->GetValue(0))
+    {
+      std::cerr << "Loadable " << loadableIndex << " is not created for " << fileName << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (expectedName != (loadable->GetName() ? loadable->GetName() : ""))
+    {
+      std::cerr << "Loadable name of " << fileName << " is '" << (loadable->GetName() ? loadable->GetName() : "")
+        << "' instead of '" << expectedName << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+    vtkStringArray* referencedInstanceUIDs = loadable->GetReferencedInstanceUIDs();
+    vtkIdType numberOfReferencedInstanceUIDs = (referencedInstanceUIDs ? referencedInstanceUIDs->GetNumberOfValues() : 0);
+    if (numberOfReferencedInstanceUIDs != static_cast<vtkIdType>(expectedReferencedInstanceUIDs.size()))
+    {
+      std::cerr << "Loadable of " << fileName << " has " << numberOfReferencedInstanceUIDs
+        << " referenced instance UIDs instead of " << expectedReferencedInstanceUIDs.size() << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (vtkIdType uidIndex=0; uidIndex<numberOfReferencedInstanceUIDs; ++uidIndex)
+    {
+      if (referencedInstanceUIDs->GetValue(uidIndex) != expectedReferencedInstanceUIDs[uidIndex])
+      {
+        std::cerr << "Referenced instance UID " << uidIndex << " of " << fileName << " is "
+          << referencedInstanceUIDs->GetValue(uidIndex) << " instead of " << expectedReferencedInstanceUIDs[uidIndex] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // The structure set and the image must have their references found in the examined headers
+  vtkSlicerDICOMLoadable* structureSetLoadable = vtkSlicerDICOMLoadable::SafeDownCast(loadables->GetItemAsObject(2));
+  vtkSlicerDICOMLoadable* imageLoadable = vtkSlicerDICOMLoadable::SafeDownCast(loadables->GetItemAsObject(4));
+  if ( structureSetLoadable->GetReferencedInstanceUIDs()->GetNumberOfValues() != NUMBER_OF_REFERENCED_IMAGES
+    || imageLoadable->GetReferencedInstanceUIDs()->GetNumberOfValues() != 1 )
+  {
+    std::cerr << "Referenced instances of the structure set or the image are not found" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (const std::string& fileName : fileNames)
+  {
+    vtksys::SystemTools::RemoveFile(fileName);
+  }
+  vtksys::SystemTools::RemoveFile(invalidFileName);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtReader.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dctk.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const double GANTRY_ANGLE = 90.0;
+
+  //----------------------------------------------------------------------------
+  float GetSpotPosition(unsigned int controlPointIndex, unsigned int valueIndex)
+  {
+    return static_cast<float>(valueIndex % 40) * 2.5f - 50.0f + static_cast<float>(controlPointIndex % 10) * 0.25f;
+  }
+
+  //----------------------------------------------------------------------------
+  float GetSpotWeight(unsigned int controlPointIndex, unsigned int spotIndex)
+  {
+    return static_cast<float>((controlPointIndex * 7 + spotIndex) % 1000) * 0.001f;
+  }
+
+  //----------------------------------------------------------------------------
+  double GetNominalBeamEnergy(unsigned int controlPointIndex)
+  {
+    return 70.0 + static_cast<double>(controlPointIndex / 2) * 0.5;
+  }
+
+  //----------------------------------------------------------------------------
+  std::string ToString(double value)
+  {
+    std::ostringstream stream;
+    stream << value;
+    return stream.str();
+  }
+
+  //----------------------------------------------------------------------------
+  /// Write a modulated RT Ion Plan with one beam of many control points, each with a full spot map.
+  /// Only the first control point specifies the gantry angle, and the last control point has no spot map,
+  /// so both are inherited from the previous control points.
+  bool WriteSyntheticIonPlan(const std::string& fileName, unsigned int numberOfControlPoints, unsigned int numberOfSpotsPerControlPoint)
+  {
+    DcmFileFormat fileFormat;
+    DcmDataset* dataset = fileFormat.getDataset();
+
+    char uid[100] = { 0 };
+    dataset->putAndInsertString(DCM_SOPClassUID, UID_RTIonPlanStorage);
+    dataset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+    dataset->putAndInsertString(DCM_StudyInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_STUDY_UID_ROOT));
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_SERIES_UID_ROOT));
+    dataset->putAndInsertString(DCM_Modality, "RTPLAN");
+    dataset->putAndInsertString(DCM_PatientName, "IonPlanDecoding^Test");
+    dataset->putAndInsertString(DCM_RTPlanLabel, "Synthetic");
+
+    DcmItem* fractionGroupItem = nullptr;
+    dataset->findOrCreateSequenceItem(DCM_FractionGroupSequence, fractionGroupItem, -2);
+    fractionGroupItem->putAndInsertString(DCM_FractionGroupNumber, "1");
+    fractionGroupItem->putAndInsertString(DCM_NumberOfFractionsPlanned, "1");
+    fractionGroupItem->putAndInsertString(DCM_NumberOfBeams, "1");
+    fractionGroupItem->putAndInsertString(DCM_NumberOfBrachyApplicationSetups, "0");
+
+    DcmItem* beamItem = nullptr;
+    dataset->findOrCreateSequenceItem(DCM_IonBeamSequence, beamItem, -2);
+    beamItem->putAndInsertString(DCM_BeamNumber, "1");
+    beamItem->putAndInsertString(DCM_BeamName, "Field1");
+    beamItem->putAndInsertString(DCM_BeamType, "STATIC");
+    beamItem->putAndInsertString(DCM_RadiationType, "PROTON");
+    beamItem->putAndInsertString(DCM_TreatmentDeliveryType, "TREATMENT");
+    beamItem->putAndInsertString(DCM_ScanMode, "MODULATED");
+    beamItem->putAndInsertString(DCM_NumberOfControlPoints, ToString(numberOfControlPoints).c_str());
+    beamItem->putAndInsertString(DCM_FinalCumulativeMetersetWeight, ToString(numberOfControlPoints - 1).c_str());
+
+    std::vector<Float32> positionMap(2 * numberOfSpotsPerControlPoint);
+    std::vector<Float32> metersetWeights(numberOfSpotsPerControlPoint);
+    for (unsigned int controlPointIndex=0; controlPointIndex<numberOfControlPoints; ++controlPointIndex)
+    {
+      DcmItem* controlPointItem = nullptr;
+      beamItem->findOrCreateSequenceItem(DCM_IonControlPointSequence, controlPointItem, -2);
+      controlPointItem->putAndInsertString(DCM_ControlPointIndex, ToString(controlPointIndex).c_str());
+      controlPointItem->putAndInsertString(DCM_CumulativeMetersetWeight, ToString(controlPointIndex).c_str());
+      controlPointItem->putAndInsertString(DCM_NominalBeamEnergy, ToString(GetNominalBeamEnergy(controlPointIndex)).c_str());
+      if (controlPointIndex == 0)
+      {
+        controlPointItem->putAndInsertString(DCM_GantryAngle, ToString(GANTRY_ANGLE).c_str());
+        controlPointItem->putAndInsertString(DCM_PatientSupportAngle, "0");
+        controlPointItem->putAndInsertString(DCM_IsocenterPosition, "0\\0\\0");
+      }
+      if (controlPointIndex == numberOfControlPoints - 1)
+      {
+        continue;
+      }
+
+      for (unsigned int i=0; i<2*numberOfSpotsPerControlPoint; ++i)
+      {
+        positionMap[i] = GetSpotPosition(controlPointIndex, i);
+      }
+      for (unsigned int i=0; i<numberOfSpotsPerControlPoint; ++i)
+      {
+        metersetWeights[i] = GetSpotWeight(controlPointIndex, i);
+      }
+      controlPointItem->putAndInsertString(DCM_ScanSpotTuneID, "3.0");
+      controlPointItem->putAndInsertString(DCM_NumberOfScanSpotPositions, ToString(numberOfSpotsPerControlPoint).c_str());
+      controlPointItem->putAndInsertFloat32Array(DCM_ScanSpotPositionMap, positionMap.data(), positionMap.size());
+      controlPointItem->putAndInsertFloat32Array(DCM_ScanSpotMetersetWeights, metersetWeights.data(), metersetWeights.size());
+      controlPointItem->putAndInsertString(DCM_NumberOfPaintings, "1");
+    }
+
+    return fileFormat.saveFile(fileName.c_str(), EXS_LittleEndianExplicit).good();
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportIonPlanDecodingTest1(int argc, char* argv[])
+{
+  // TemporaryDirectory
+  const char* temporaryDirectory = nullptr;
+  if (argc > 2 && std::string(argv[1]) == "-TemporaryDirectory")
+  {
+    temporaryDirectory = argv[2];
+    std::cout << "Temporary directory: " << temporaryDirectory << std::endl;
+  }
+  else
+  {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Benchmark is only run on request, as the plan it decodes is large and takes a while to write
+  bool benchmark = (argc > 3 && std::string(argv[3]) == "-Benchmark");
+  const unsigned int numberOfControlPoints = (benchmark ? 2000 : 20);
+  const unsigned int numberOfSpotsPerControlPoint = (benchmark ? 400 : 40);
+
+  vtksys::SystemTools::MakeDirectory(temporaryDirectory);
+  std::string planFileName = std::string(temporaryDirectory) + "/IonPlanDecodingTest.dcm";
+  if (!WriteSyntheticIonPlan(planFileName, numberOfControlPoints, numberOfSpotsPerControlPoint))
+  {
+    std::cerr << "Failed to write synthetic RT Ion Plan to " << planFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Synthetic RT Ion Plan: " << numberOfControlPoints << " control points, "
+    << numberOfSpotsPerControlPoint << " spots per control point" << std::endl;
+
+  vtkNew<vtkTimerLog> timer;
+
+  // Decode plan
+  vtkNew<vtkSlicerDicomRtReader> rtReader;
+  rtReader->SetFileName(planFileName.c_str());
+  double checkpointStart = timer->GetUniversalTime();
+  rtReader->Update();
+  double decodingTime = timer->GetUniversalTime() - checkpointStart;
+  if (!rtReader->GetLoadRTIonPlanSuccessful())
+  {
+    std::cerr << "Failed to load synthetic RT Ion Plan" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Access all control points the way the module logic does, reusing the buffers
+  checkpointStart = timer->GetUniversalTime();
+  if (rtReader->GetNumberOfBeams() != 1)
+  {
+    std::cerr << "Number of beams is " << rtReader->GetNumberOfBeams() << " instead of 1" << std::endl;
+    return EXIT_FAILURE;
+  }
+  unsigned int beamNumber = rtReader->GetBeamNumberForIndex(0);
+  if (rtReader->GetBeamNumberOfControlPoints(beamNumber) != numberOfControlPoints)
+  {
+    std::cerr << "Number of control points is " << rtReader->GetBeamNumberOfControlPoints(beamNumber)
+      << " instead of " << numberOfControlPoints << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<float> positionMap;
+  std::vector<float> metersetWeights;
+  for (unsigned int controlPointIndex=0; controlPointIndex<numberOfControlPoints; ++controlPointIndex)
+  {
+    if (!rtReader->GetBeamControlPointScanSpotParameters(beamNumber, controlPointIndex, positionMap, metersetWeights))
+    {
+      std::cerr << "Failed to get scan spot parameters of control point " << controlPointIndex << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (positionMap.size() != 2 * numberOfSpotsPerControlPoint || metersetWeights.size() != numberOfSpotsPerControlPoint)
+    {
+      std::cerr << "Invalid spot map size in control point " << controlPointIndex << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The last control point has no spot map, it is inherited from the previous one
+    unsigned int spotMapControlPointIndex = std::min(controlPointIndex, numberOfControlPoints - 2);
+    for (unsigned int i=0; i<2*numberOfSpotsPerControlPoint; ++i)
+    {
+      if (positionMap[i] != GetSpotPosition(spotMapControlPointIndex, i))
+      {
+        std::cerr << "Spot position mismatch in control point " << controlPointIndex << " at value " << i
+          << ": " << positionMap[i] << " instead of " << GetSpotPosition(spotMapControlPointIndex, i) << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    for (unsigned int i=0; i<numberOfSpotsPerControlPoint; ++i)
+    {
+      if (metersetWeights[i] != GetSpotWeight(spotMapControlPointIndex, i))
+      {
+        std::cerr << "Spot weight mismatch in control point " << controlPointIndex << " at spot " << i
+          << ": " << metersetWeights[i] << " instead of " << GetSpotWeight(spotMapControlPointIndex, i) << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    if (std::fabs(rtReader->GetBeamControlPointNominalBeamEnergy(beamNumber, controlPointIndex) - GetNominalBeamEnergy(controlPointIndex)) > 1e-6)
+    {
+      std::cerr << "Nominal beam energy mismatch in control point " << controlPointIndex << std::endl;
+      return EXIT_FAILURE;
+    }
+    // Gantry angle is only specified in the first control point
+    if (std::fabs(rtReader->GetBeamControlPointGantryAngle(beamNumber, controlPointIndex) - GANTRY_ANGLE) > 1e-6)
+    {
+      std::cerr << "Gantry angle is not inherited in control point " << controlPointIndex << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  double accessTime = timer->GetUniversalTime() - checkpointStart;
+
+  std::cout << "RT Ion Plan decoding time: " << decodingTime << " s, control point access time: " << accessTime << " s" << std::endl;
+
+  vtksys::SystemTools::RemoveFile(planFileName);
+  return EXIT_SUCCESS;
+}
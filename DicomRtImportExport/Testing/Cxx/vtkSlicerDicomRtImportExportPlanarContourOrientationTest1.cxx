@@ -0,0 +1,208 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtImportExportModuleLogic.h"
+
+// SegmentationCore includes
+#include <vtkOrientedImageData.h>
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkAppendPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkCubeSource.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <cmath>
+#include <map>
+
+namespace
+{
+  // Hollow box: 40x40x20 mm outer box with a closed 20x20x12 mm cavity in its middle.
+  // Slice planes are at odd Z coordinates, so that none of them coincides with a face of the boxes.
+  const double OUTER_SIZE[3] = { 40.0, 40.0, 20.0 };
+  const double CAVITY_SIZE[3] = { 20.0, 20.0, 12.0 };
+  const int NUMBER_OF_SLICES_THROUGH_WALL = 10;
+  const int NUMBER_OF_SLICES_THROUGH_CAVITY = 6;
+
+  //----------------------------------------------------------------------------
+  /// Create the closed surface of the hollow box: the surface of the outer box and the surface of the cavity
+  void CreateHollowBoxSurface(vtkPolyData* closedSurface)
+  {
+    vtkNew<vtkCubeSource> outerBox;
+    outerBox->SetXLength(OUTER_SIZE[0]);
+    outerBox->SetYLength(OUTER_SIZE[1]);
+    outerBox->SetZLength(OUTER_SIZE[2]);
+    vtkNew<vtkCubeSource> cavity;
+    cavity->SetXLength(CAVITY_SIZE[0]);
+    cavity->SetYLength(CAVITY_SIZE[1]);
+    cavity->SetZLength(CAVITY_SIZE[2]);
+    vtkNew<vtkAppendPolyData> append;
+    append->AddInputConnection(outerBox->GetOutputPort());
+    append->AddInputConnection(cavity->GetOutputPort());
+    append->Update();
+    closedSurface->ShallowCopy(append->GetOutput());
+  }
+
+  //----------------------------------------------------------------------------
+  /// Create a 1x1x2 mm reference image covering the hollow box, with slice planes at odd Z coordinates.
+  /// If flipped, the image is rotated by 180 degrees around the X axis, so its slice normal points to -Z.
+  void CreateReferenceImage(bool flipped, vtkOrientedImageData* referenceImage)
+  {
+    vtkNew<vtkTransform> imageToWorldTransform;
+    if (flipped)
+    {
+      imageToWorldTransform->Translate(-30.0, 30.0, 11.0);
+      imageToWorldTransform->RotateX(180.0);
+    }
+    else
+    {
+      imageToWorldTransform->Translate(-30.0, -30.0, -11.0);
+    }
+    imageToWorldTransform->Scale(1.0, 1.0, 2.0);
+    referenceImage->SetGeometryFromImageToWorldMatrix(imageToWorldTransform->GetMatrix());
+    referenceImage->SetExtent(0, 60, 0, 60, 0, 11);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Signed area of a planar polygon, positive if it is counter-clockwise when viewed against the normal
+  double GetSignedArea(vtkPolyData* contours, vtkIdList* pointIds, const double normal[3])
+  {
+    double areaVector[3] = { 0.0, 0.0, 0.0 };
+    vtkIdType numberOfPoints = pointIds->GetNumberOfIds();
+    for (vtkIdType i=0; i<numberOfPoints; ++i)
+    {
+      double point1[3] = { 0.0, 0.0, 0.0 };
+      double point2[3] = { 0.0, 0.0, 0.0 };
+      contours->GetPoint(pointIds->GetId(i), point1);
+      contours->GetPoint(pointIds->GetId((i + 1) % numberOfPoints), point2);
+      double cross[3] = { 0.0, 0.0, 0.0 };
+      vtkMath::Cross(point1, point2, cross);
+      vtkMath::Add(areaVector, cross, areaVector);
+    }
+    return 0.5 * vtkMath::Dot(areaVector, normal);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Cut the hollow box into planar contours with the slices of the reference image, and check that
+  /// every slice has the outer contour counter-clockwise, and the slices through the cavity also have
+  /// the contour of the cavity clockwise, when viewed against the slice normal
+  bool AreContoursOriented(vtkPolyData* closedSurface, bool flipped)
+  {
+    vtkNew<vtkOrientedImageData> referenceImage;
+    CreateReferenceImage(flipped, referenceImage);
+    double sliceNormal[3] = { 0.0, 0.0, (flipped ? -1.0 : 1.0) };
+
+    vtkNew<vtkPolyData> contours;
+    if (!vtkSlicerDicomRtImportExportModuleLogic::CutClosedSurfaceToPlanarContours(closedSurface, referenceImage, contours))
+    {
+      std::cerr << "Failed to cut closed surface into planar contours" << std::endl;
+      return false;
+    }
+
+    // Number of counter-clockwise (outer) and clockwise (hole) contours in each slice, keyed by Z coordinate
+    std::map<int, int> outerContoursInSlice;
+    std::map<int, int> holeContoursInSlice;
+    double outerArea = OUTER_SIZE[0] * OUTER_SIZE[1];
+    double cavityArea = CAVITY_SIZE[0] * CAVITY_SIZE[1];
+    vtkCellArray* polys = contours->GetPolys();
+    vtkNew<vtkIdList> pointIds;
+    for (polys->InitTraversal(); polys->GetNextCell(pointIds); )
+    {
+      double firstPoint[3] = { 0.0, 0.0, 0.0 };
+      contours->GetPoint(pointIds->GetId(0), firstPoint);
+      int sliceZ = vtkMath::Round(firstPoint[2]);
+      double signedArea = GetSignedArea(contours, pointIds, sliceNormal);
+      if (std::fabs(signedArea - outerArea) < 1.0e-3 * outerArea)
+      {
+        ++outerContoursInSlice[sliceZ];
+      }
+      else if (std::fabs(signedArea + cavityArea) < 1.0e-3 * cavityArea)
+      {
+        ++holeContoursInSlice[sliceZ];
+      }
+      else
+      {
+        std::cerr << "Contour at Z=" << sliceZ << " has signed area " << signedArea << " instead of "
+          << outerArea << " (outer, counter-clockwise) or " << -cavityArea << " (hole, clockwise)" << std::endl;
+        return false;
+      }
+    }
+
+    if ( outerContoursInSlice.size() != static_cast<size_t>(NUMBER_OF_SLICES_THROUGH_WALL)
+      || holeContoursInSlice.size() != static_cast<size_t>(NUMBER_OF_SLICES_THROUGH_CAVITY) )
+    {
+      std::cerr << outerContoursInSlice.size() << " slices with outer contours and " << holeContoursInSlice.size()
+        << " slices with holes instead of " << NUMBER_OF_SLICES_THROUGH_WALL << " and " << NUMBER_OF_SLICES_THROUGH_CAVITY << std::endl;
+      return false;
+    }
+    for (const std::pair<const int, int>& outerContours : outerContoursInSlice)
+    {
+      int sliceZ = outerContours.first;
+      bool throughCavity = (std::abs(sliceZ) < CAVITY_SIZE[2] / 2.0);
+      int numberOfHoles = (holeContoursInSlice.count(sliceZ) ? holeContoursInSlice[sliceZ] : 0);
+      if (outerContours.second != 1 || numberOfHoles != (throughCavity ? 1 : 0))
+      {
+        std::cerr << "Slice at Z=" << sliceZ << " has " << outerContours.second << " outer contours and "
+          << numberOfHoles << " holes" << std::endl;
+        return false;
+      }
+    }
+
+    return true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportPlanarContourOrientationTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkPolyData> closedSurface;
+  CreateHollowBoxSurface(closedSurface);
+
+  // Orientation is relative to the slice normal, so it is checked with both slice normal directions
+  if (!AreContoursOriented(closedSurface, false))
+  {
+    std::cerr << "Slice normal +Z" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!AreContoursOriented(closedSurface, true))
+  {
+    std::cerr << "Slice normal -Z" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Invalid input
+  vtkNew<vtkPolyData> contours;
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  bool invalidInputAccepted = vtkSlicerDicomRtImportExportModuleLogic::CutClosedSurfaceToPlanarContours(
+    closedSurface, nullptr, contours);
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  if (invalidInputAccepted)
+  {
+    std::cerr << "Cutting closed surface accepts invalid input" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,542 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtReader.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dctk.h>
+
+// STD includes
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const char* STRUCTURE_SET_SOP_INSTANCE_UID = "1.2.826.0.1.3680043.2.1125.48.1";
+  const char* PLAN_SOP_INSTANCE_UID = "1.2.826.0.1.3680043.2.1125.48.2";
+  const char* REFERENCED_SERIES_INSTANCE_UID = "1.2.826.0.1.3680043.2.1125.48.3";
+  const int NUMBER_OF_SLICES = 3;
+  const int NUMBER_OF_LEAF_PAIRS = 4;
+
+  //----------------------------------------------------------------------------
+  std::string ToString(double value)
+  {
+    std::ostringstream stream;
+    stream << value;
+    return stream.str();
+  }
+
+  //----------------------------------------------------------------------------
+  std::string GetSliceInstanceUid(int slice)
+  {
+    return std::string(REFERENCED_SERIES_INSTANCE_UID) + "." + ToString(slice + 1);
+  }
+
+  //----------------------------------------------------------------------------
+  void InsertCommonAttributes(DcmDataset* dataset, const char* sopClassUid, const char* sopInstanceUid, const char* modality)
+  {
+    dataset->putAndInsertString(DCM_SOPClassUID, sopClassUid);
+    dataset->putAndInsertString(DCM_SOPInstanceUID, sopInstanceUid);
+    dataset->putAndInsertString(DCM_StudyInstanceUID, "1.2.826.0.1.3680043.2.1125.48.4");
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, (std::string(sopInstanceUid) + ".1").c_str());
+    dataset->putAndInsertString(DCM_FrameOfReferenceUID, "1.2.826.0.1.3680043.2.1125.48.5");
+    dataset->putAndInsertString(DCM_Modality, modality);
+    dataset->putAndInsertString(DCM_PatientName, "ReaderCache^Test");
+    dataset->putAndInsertString(DCM_PatientID, "ReaderCacheTest");
+    dataset->putAndInsertString(DCM_StudyDate, "20200101");
+    dataset->putAndInsertString(DCM_StudyTime, "120000");
+    dataset->putAndInsertString(DCM_SeriesNumber, "1");
+  }
+
+  //----------------------------------------------------------------------------
+  /// Write an RT structure set with two ROIs of square contours on consecutive slices.
+  /// The name of the first ROI is given, so that the file can be modified without changing its SOP instance UID.
+  bool WriteSyntheticStructureSet(const std::string& fileName, const char* firstRoiName)
+  {
+    DcmFileFormat fileFormat;
+    DcmDataset* dataset = fileFormat.getDataset();
+    InsertCommonAttributes(dataset, UID_RTStructureSetStorage, STRUCTURE_SET_SOP_INSTANCE_UID, "RTSTRUCT");
+    dataset->putAndInsertString(DCM_StructureSetLabel, "ReaderCache");
+
+    // Referenced series with the slices the contours are on
+    DcmItem* frameOfReferenceItem = nullptr;
+    dataset->findOrCreateSequenceItem(DCM_ReferencedFrameOfReferenceSequence, frameOfReferenceItem, -2);
+    frameOfReferenceItem->putAndInsertString(DCM_FrameOfReferenceUID, "1.2.826.0.1.3680043.2.1125.48.5");
+    DcmItem* referencedStudyItem = nullptr;
+    frameOfReferenceItem->findOrCreateSequenceItem(DCM_RTReferencedStudySequence, referencedStudyItem, -2);
+    referencedStudyItem->putAndInsertString(DCM_ReferencedSOPClassUID, "1.2.840.10008.3.1.2.3.1");
+    referencedStudyItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, "1.2.826.0.1.3680043.2.1125.48.4");
+    DcmItem* referencedSeriesItem = nullptr;
+    referencedStudyItem->findOrCreateSequenceItem(DCM_RTReferencedSeriesSequence, referencedSeriesItem, -2);
+    referencedSeriesItem->putAndInsertString(DCM_SeriesInstanceUID, REFERENCED_SERIES_INSTANCE_UID);
+    for (int slice=0; slice<NUMBER_OF_SLICES; ++slice)
+    {
+      DcmItem* contourImageItem = nullptr;
+      referencedSeriesItem->findOrCreateSequenceItem(DCM_ContourImageSequence, contourImageItem, -2);
+      contourImageItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_CTImageStorage);
+      contourImageItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, GetSliceInstanceUid(slice).c_str());
+    }
+
+    const char* roiNames[2] = { firstRoiName, "Target" };
+    const char* roiColors[2] = { "255\\0\\0", "0\\128\\255" };
+    for (int roiIndex=0; roiIndex<2; ++roiIndex)
+    {
+      std::string roiNumber = ToString(roiIndex + 1);
+      DcmItem* roiItem = nullptr;
+      dataset->findOrCreateSequenceItem(DCM_StructureSetROISequence, roiItem, -2);
+      roiItem->putAndInsertString(DCM_ROINumber, roiNumber.c_str());
+      roiItem->putAndInsertString(DCM_ReferencedFrameOfReferenceUID, "1.2.826.0.1.3680043.2.1125.48.5");
+      roiItem->putAndInsertString(DCM_ROIName, roiNames[roiIndex]);
+      roiItem->putAndInsertString(DCM_ROIGenerationAlgorithm, "MANUAL");
+
+      DcmItem* roiContourItem = nullptr;
+      dataset->findOrCreateSequenceItem(DCM_ROIContourSequence, roiContourItem, -2);
+      roiContourItem->putAndInsertString(DCM_ReferencedROINumber, roiNumber.c_str());
+      roiContourItem->putAndInsertString(DCM_ROIDisplayColor, roiColors[roiIndex]);
+      double halfSize = 10.0 + 5.0 * roiIndex;
+      for (int slice=0; slice<NUMBER_OF_SLICES; ++slice)
+      {
+        double z = 2.5 * slice;
+        std::ostringstream contourData;
+        contourData << -halfSize << "\\" << -halfSize << "\\" << z << "\\"
+          << halfSize << "\\" << -halfSize << "\\" << z << "\\"
+          << halfSize << "\\" << halfSize << "\\" << z << "\\"
+          << -halfSize << "\\" << halfSize << "\\" << z;
+        DcmItem* contourItem = nullptr;
+        roiContourItem->findOrCreateSequenceItem(DCM_ContourSequence, contourItem, -2);
+        contourItem->putAndInsertString(DCM_ContourGeometricType, "CLOSED_PLANAR");
+        contourItem->putAndInsertString(DCM_NumberOfContourPoints, "4");
+        contourItem->putAndInsertString(DCM_ContourData, contourData.str().c_str());
+        DcmItem* contourImageItem = nullptr;
+        contourItem->findOrCreateSequenceItem(DCM_ContourImageSequence, contourImageItem, -2);
+        contourImageItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_CTImageStorage);
+        contourImageItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, GetSliceInstanceUid(slice).c_str());
+      }
+    }
+
+    return fileFormat.saveFile(fileName.c_str(), EXS_LittleEndianExplicit).good();
+  }
+
+  //----------------------------------------------------------------------------
+  /// Write an RT plan with one dynamic beam of two control points with jaws and MLC.
+  /// The gantry angle of the first control point is given, so that the file can be modified without changing
+  /// its SOP instance UID.
+  bool WriteSyntheticPlan(const std::string& fileName, double gantryAngle)
+  {
+    DcmFileFormat fileFormat;
+    DcmDataset* dataset = fileFormat.getDataset();
+    InsertCommonAttributes(dataset, UID_RTPlanStorage, PLAN_SOP_INSTANCE_UID, "RTPLAN");
+    dataset->putAndInsertString(DCM_RTPlanLabel, "ReaderCache");
+    dataset->putAndInsertString(DCM_RTPlanGeometry, "PATIENT");
+
+    DcmItem* referencedStructureSetItem = nullptr;
+    dataset->findOrCreateSequenceItem(DCM_ReferencedStructureSetSequence, referencedStructureSetItem, -2);
+    referencedStructureSetItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_RTStructureSetStorage);
+    referencedStructureSetItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, STRUCTURE_SET_SOP_INSTANCE_UID);
+
+    DcmItem* fractionGroupItem = nullptr;
+    dataset->findOrCreateSequenceItem(DCM_FractionGroupSequence, fractionGroupItem, -2);
+    fractionGroupItem->putAndInsertString(DCM_FractionGroupNumber, "1");
+    fractionGroupItem->putAndInsertString(DCM_NumberOfFractionsPlanned, "1");
+    fractionGroupItem->putAndInsertString(DCM_NumberOfBeams, "1");
+    fractionGroupItem->putAndInsertString(DCM_NumberOfBrachyApplicationSetups, "0");
+
+    DcmItem* beamItem = nullptr;
+    dataset->findOrCreateSequenceItem(DCM_BeamSequence, beamItem, -2);
+    beamItem->putAndInsertString(DCM_BeamNumber, "1");
+    beamItem->putAndInsertString(DCM_BeamName, "Arc1");
+    beamItem->putAndInsertString(DCM_BeamType, "DYNAMIC");
+    beamItem->putAndInsertString(DCM_RadiationType, "PHOTON");
+    beamItem->putAndInsertString(DCM_TreatmentDeliveryType, "TREATMENT");
+    beamItem->putAndInsertString(DCM_SourceAxisDistance, "1000");
+    beamItem->putAndInsertString(DCM_NumberOfWedges, "0");
+    beamItem->putAndInsertString(DCM_NumberOfCompensators, "0");
+    beamItem->putAndInsertString(DCM_NumberOfBoli, "0");
+    beamItem->putAndInsertString(DCM_NumberOfBlocks, "0");
+    beamItem->putAndInsertString(DCM_NumberOfControlPoints, "2");
+    beamItem->putAndInsertString(DCM_FinalCumulativeMetersetWeight, "1");
+
+    const char* deviceTypes[3] = { "ASYMX", "ASYMY", "MLCX" };
+    const char* deviceDistances[3] = { "400", "300", "500" };
+    for (int deviceIndex=0; deviceIndex<3; ++deviceIndex)
+    {
+      DcmItem* deviceItem = nullptr;
+      beamItem->findOrCreateSequenceItem(DCM_BeamLimitingDeviceSequence, deviceItem, -2);
+      deviceItem->putAndInsertString(DCM_RTBeamLimitingDeviceType, deviceTypes[deviceIndex]);
+      deviceItem->putAndInsertString(DCM_SourceToBeamLimitingDeviceDistance, deviceDistances[deviceIndex]);
+      if (deviceIndex == 2)
+      {
+        deviceItem->putAndInsertString(DCM_NumberOfLeafJawPairs, ToString(NUMBER_OF_LEAF_PAIRS).c_str());
+        deviceItem->putAndInsertString(DCM_LeafPositionBoundaries, "-20\\-10\\0\\10\\20");
+      }
+      else
+      {
+        deviceItem->putAndInsertString(DCM_NumberOfLeafJawPairs, "1");
+      }
+    }
+
+    for (int controlPointIndex=0; controlPointIndex<2; ++controlPointIndex)
+    {
+      DcmItem* controlPointItem = nullptr;
+      beamItem->findOrCreateSequenceItem(DCM_ControlPointSequence, controlPointItem, -2);
+      controlPointItem->putAndInsertString(DCM_ControlPointIndex, ToString(controlPointIndex).c_str());
+      controlPointItem->putAndInsertString(DCM_CumulativeMetersetWeight, ToString(controlPointIndex).c_str());
+      controlPointItem->putAndInsertString(DCM_GantryAngle, ToString(gantryAngle + 30.0 * controlPointIndex).c_str());
+      if (controlPointIndex == 0)
+      {
+        controlPointItem->putAndInsertString(DCM_NominalBeamEnergy, "6");
+        controlPointItem->putAndInsertString(DCM_BeamLimitingDeviceAngle, "15");
+        controlPointItem->putAndInsertString(DCM_PatientSupportAngle, "10");
+        controlPointItem->putAndInsertString(DCM_IsocenterPosition, "5\\-10\\2.5");
+      }
+
+      const char* devicePositions[3] = { "-30\\40", "-25\\35",
+        (controlPointIndex == 0 ? "-5\\-6\\-7\\-8\\5\\6\\7\\8" : "-1\\-2\\-3\\-4\\1\\2\\3\\4") };
+      for (int deviceIndex=0; deviceIndex<3; ++deviceIndex)
+      {
+        DcmItem* devicePositionItem = nullptr;
+        controlPointItem->findOrCreateSequenceItem(DCM_BeamLimitingDevicePositionSequence, devicePositionItem, -2);
+        devicePositionItem->putAndInsertString(DCM_RTBeamLimitingDeviceType, deviceTypes[deviceIndex]);
+        devicePositionItem->putAndInsertString(DCM_LeafJawPositions, devicePositions[deviceIndex]);
+      }
+    }
+
+    return fileFormat.saveFile(fileName.c_str(), EXS_LittleEndianExplicit).good();
+  }
+
+  //----------------------------------------------------------------------------
+  bool AreStringsEqual(const char* string1, const char* string2)
+  {
+    return std::string(string1 ? string1 : "") == std::string(string2 ? string2 : "");
+  }
+
+  //----------------------------------------------------------------------------
+  /// Check that the patient, study and series information and the SOP instance UID of two readers are the same
+  bool AreCommonAttributesEqual(vtkSlicerDicomRtReader* reader1, vtkSlicerDicomRtReader* reader2)
+  {
+    return AreStringsEqual(reader1->GetPatientName(), reader2->GetPatientName())
+      && AreStringsEqual(reader1->GetPatientId(), reader2->GetPatientId())
+      && AreStringsEqual(reader1->GetStudyInstanceUid(), reader2->GetStudyInstanceUid())
+      && AreStringsEqual(reader1->GetStudyDate(), reader2->GetStudyDate())
+      && AreStringsEqual(reader1->GetSeriesInstanceUid(), reader2->GetSeriesInstanceUid())
+      && AreStringsEqual(reader1->GetSeriesModality(), reader2->GetSeriesModality())
+      && AreStringsEqual(reader1->GetSeriesNumber(), reader2->GetSeriesNumber())
+      && AreStringsEqual(reader1->GetSOPInstanceUID(), reader2->GetSOPInstanceUID());
+  }
+
+  //----------------------------------------------------------------------------
+  bool ArePolyDataEqual(vtkPolyData* polyData1, vtkPolyData* polyData2)
+  {
+    if (!polyData1 || !polyData2)
+    {
+      return polyData1 == polyData2;
+    }
+    if ( polyData1->GetNumberOfPoints() != polyData2->GetNumberOfPoints()
+      || polyData1->GetNumberOfLines() != polyData2->GetNumberOfLines()
+      || polyData1->GetNumberOfPolys() != polyData2->GetNumberOfPolys() )
+    {
+      return false;
+    }
+    for (vtkIdType pointId=0; pointId<polyData1->GetNumberOfPoints(); ++pointId)
+    {
+      double point1[3] = { 0.0, 0.0, 0.0 };
+      double point2[3] = { 0.0, 0.0, 0.0 };
+      polyData1->GetPoint(pointId, point1);
+      polyData2->GetPoint(pointId, point2);
+      if (point1[0] != point2[0] || point1[1] != point2[1] || point1[2] != point2[2])
+      {
+        return false;
+      }
+    }
+    vtkCellArray* lines1 = polyData1->GetLines();
+    vtkCellArray* lines2 = polyData2->GetLines();
+    lines1->InitTraversal();
+    lines2->InitTraversal();
+    vtkNew<vtkIdList> pointIds1;
+    vtkNew<vtkIdList> pointIds2;
+    while (lines1->GetNextCell(pointIds1))
+    {
+      if (!lines2->GetNextCell(pointIds2) || pointIds1->GetNumberOfIds() != pointIds2->GetNumberOfIds())
+      {
+        return false;
+      }
+      for (vtkIdType index=0; index<pointIds1->GetNumberOfIds(); ++index)
+      {
+        if (pointIds1->GetId(index) != pointIds2->GetId(index))
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Check that two readers loaded the same structure set
+  bool AreStructureSetsEqual(vtkSlicerDicomRtReader* reader1, vtkSlicerDicomRtReader* reader2)
+  {
+    if ( !reader1->GetLoadRTStructureSetSuccessful() || !reader2->GetLoadRTStructureSetSuccessful()
+      || !AreCommonAttributesEqual(reader1, reader2)
+      || !AreStringsEqual(reader1->GetRTStructureSetReferencedSOPInstanceUIDs(), reader2->GetRTStructureSetReferencedSOPInstanceUIDs())
+      || reader1->GetNumberOfRois() != reader2->GetNumberOfRois() )
+    {
+      std::cerr << "Structure set attributes or number of ROIs differ" << std::endl;
+      return false;
+    }
+    for (int roiIndex=0; roiIndex<reader1->GetNumberOfRois(); ++roiIndex)
+    {
+      double* color1 = reader1->GetRoiDisplayColor(roiIndex);
+      double* color2 = reader2->GetRoiDisplayColor(roiIndex);
+      if ( reader1->GetRoiNumber(roiIndex) != reader2->GetRoiNumber(roiIndex)
+        || !AreStringsEqual(reader1->GetRoiName(roiIndex), reader2->GetRoiName(roiIndex))
+        || !AreStringsEqual(reader1->GetRoiReferencedSeriesUid(roiIndex), reader2->GetRoiReferencedSeriesUid(roiIndex))
+        || color1[0] != color2[0] || color1[1] != color2[1] || color1[2] != color2[2]
+        || !ArePolyDataEqual(reader1->GetRoiPolyData(roiIndex), reader2->GetRoiPolyData(roiIndex)) )
+      {
+        std::cerr << "ROI " << roiIndex << " differs" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Check that two readers loaded the same plan
+  bool ArePlansEqual(vtkSlicerDicomRtReader* reader1, vtkSlicerDicomRtReader* reader2)
+  {
+    if ( !reader1->GetLoadRTPlanSuccessful() || !reader2->GetLoadRTPlanSuccessful()
+      || !AreCommonAttributesEqual(reader1, reader2)
+      || !AreStringsEqual(reader1->GetRTPlanReferencedStructureSetSOPInstanceUID(), reader2->GetRTPlanReferencedStructureSetSOPInstanceUID())
+      || reader1->GetNumberOfBeams() != reader2->GetNumberOfBeams() )
+    {
+      std::cerr << "Plan attributes or number of beams differ" << std::endl;
+      return false;
+    }
+    for (int beamIndex=0; beamIndex<reader1->GetNumberOfBeams(); ++beamIndex)
+    {
+      unsigned int beamNumber = reader1->GetBeamNumberForIndex(beamIndex);
+      if ( beamNumber != reader2->GetBeamNumberForIndex(beamIndex)
+        || !AreStringsEqual(reader1->GetBeamName(beamNumber), reader2->GetBeamName(beamNumber))
+        || !AreStringsEqual(reader1->GetBeamType(beamNumber), reader2->GetBeamType(beamNumber))
+        || !AreStringsEqual(reader1->GetBeamRadiationType(beamNumber), reader2->GetBeamRadiationType(beamNumber))
+        || reader1->GetBeamSourceAxisDistance(beamNumber) != reader2->GetBeamSourceAxisDistance(beamNumber)
+        || reader1->GetBeamSourceToJawsDistanceX(beamNumber) != reader2->GetBeamSourceToJawsDistanceX(beamNumber)
+        || reader1->GetBeamSourceToJawsDistanceY(beamNumber) != reader2->GetBeamSourceToJawsDistanceY(beamNumber)
+        || reader1->GetBeamSourceToMultiLeafCollimatorDistance(beamNumber) != reader2->GetBeamSourceToMultiLeafCollimatorDistance(beamNumber)
+        || reader1->GetBeamNumberOfControlPoints(beamNumber) != reader2->GetBeamNumberOfControlPoints(beamNumber) )
+      {
+        std::cerr << "Beam " << beamNumber << " differs" << std::endl;
+        return false;
+      }
+      for (unsigned int controlPointIndex=0; controlPointIndex<reader1->GetBeamNumberOfControlPoints(beamNumber); ++controlPointIndex)
+      {
+        double* isocenter1 = reader1->GetBeamControlPointIsocenterPositionRas(beamNumber, controlPointIndex);
+        double* isocenter2 = reader2->GetBeamControlPointIsocenterPositionRas(beamNumber, controlPointIndex);
+        double jawPositions1[2][2] = { { 0.0, 0.0 }, { 0.0, 0.0 } };
+        double jawPositions2[2][2] = { { 0.0, 0.0 }, { 0.0, 0.0 } };
+        bool jawsValid1 = reader1->GetBeamControlPointJawPositions(beamNumber, controlPointIndex, jawPositions1);
+        bool jawsValid2 = reader2->GetBeamControlPointJawPositions(beamNumber, controlPointIndex, jawPositions2);
+        std::vector<double> boundaries1;
+        std::vector<double> boundaries2;
+        std::vector<double> leafPositions1;
+        std::vector<double> leafPositions2;
+        const char* mlcType1 = reader1->GetBeamControlPointMultiLeafCollimatorPositions(beamNumber, controlPointIndex, boundaries1, leafPositions1);
+        const char* mlcType2 = reader2->GetBeamControlPointMultiLeafCollimatorPositions(beamNumber, controlPointIndex, boundaries2, leafPositions2);
+        if ( !isocenter1 || !isocenter2
+          || isocenter1[0] != isocenter2[0] || isocenter1[1] != isocenter2[1] || isocenter1[2] != isocenter2[2]
+          || reader1->GetBeamControlPointGantryAngle(beamNumber, controlPointIndex) != reader2->GetBeamControlPointGantryAngle(beamNumber, controlPointIndex)
+          || reader1->GetBeamControlPointBeamLimitingDeviceAngle(beamNumber, controlPointIndex) != reader2->GetBeamControlPointBeamLimitingDeviceAngle(beamNumber, controlPointIndex)
+          || reader1->GetBeamControlPointPatientSupportAngle(beamNumber, controlPointIndex) != reader2->GetBeamControlPointPatientSupportAngle(beamNumber, controlPointIndex)
+          || reader1->GetBeamControlPointNominalBeamEnergy(beamNumber, controlPointIndex) != reader2->GetBeamControlPointNominalBeamEnergy(beamNumber, controlPointIndex)
+          || reader1->GetBeamControlPointCumulativeMetersetWeight(beamNumber, controlPointIndex) != reader2->GetBeamControlPointCumulativeMetersetWeight(beamNumber, controlPointIndex)
+          || jawsValid1 != jawsValid2
+          || jawPositions1[0][0] != jawPositions2[0][0] || jawPositions1[0][1] != jawPositions2[0][1]
+          || jawPositions1[1][0] != jawPositions2[1][0] || jawPositions1[1][1] != jawPositions2[1][1]
+          || !AreStringsEqual(mlcType1, mlcType2) || boundaries1 != boundaries2 || leafPositions1 != leafPositions2 )
+        {
+          std::cerr << "Control point " << controlPointIndex << " of beam " << beamNumber << " differs" << std::endl;
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportReaderCacheTest1(int argc, char* argv[])
+{
+  // TemporaryDirectory
+  const char* temporaryDirectory = nullptr;
+  if (argc > 2 && std::string(argv[1]) == "-TemporaryDirectory")
+  {
+    temporaryDirectory = argv[2];
+    std::cout << "Temporary directory: " << temporaryDirectory << std::endl;
+  }
+  else
+  {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string testDirectory = std::string(temporaryDirectory) + "/ReaderCacheTest";
+  std::string cacheDirectory = testDirectory + "/Cache";
+  vtksys::SystemTools::RemoveADirectory(testDirectory);
+  vtksys::SystemTools::MakeDirectory(testDirectory);
+  std::string structureSetFileName = testDirectory + "/StructureSet.dcm";
+  std::string planFileName = testDirectory + "/Plan.dcm";
+  if (!WriteSyntheticStructureSet(structureSetFileName, "Body") || !WriteSyntheticPlan(planFileName, 180.0))
+  {
+    std::cerr << "Failed to write synthetic RT objects to " << testDirectory << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Structure set: reading without cache, populating the cache and reading from the cache give the same result
+  vtkNew<vtkSlicerDicomRtReader> uncachedStructureSetReader;
+  uncachedStructureSetReader->SetFileName(structureSetFileName.c_str());
+  uncachedStructureSetReader->Update();
+  if (!uncachedStructureSetReader->GetLoadRTStructureSetSuccessful() || uncachedStructureSetReader->GetNumberOfRois() != 2)
+  {
+    std::cerr << "Failed to load synthetic RT structure set" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkSlicerDicomRtReader> firstStructureSetReader;
+  firstStructureSetReader->SetCacheDirectory(cacheDirectory.c_str());
+  firstStructureSetReader->SetFileName(structureSetFileName.c_str());
+  firstStructureSetReader->Update();
+  std::string structureSetCacheFilePath = cacheDirectory + "/" + STRUCTURE_SET_SOP_INSTANCE_UID + ".rtcache";
+  if (!vtksys::SystemTools::FileExists(structureSetCacheFilePath.c_str(), true))
+  {
+    std::cerr << "Structure set cache file " << structureSetCacheFilePath << " is not written" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkSlicerDicomRtReader> secondStructureSetReader;
+  secondStructureSetReader->SetCacheDirectory(cacheDirectory.c_str());
+  secondStructureSetReader->SetFileName(structureSetFileName.c_str());
+  secondStructureSetReader->Update();
+  if ( !AreStructureSetsEqual(uncachedStructureSetReader, firstStructureSetReader)
+    || !AreStructureSetsEqual(uncachedStructureSetReader, secondStructureSetReader) )
+  {
+    std::cerr << "Structure set read from the cache differs from the one parsed from the DICOM file" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Plan: parsing the file logs warnings about the missing brachy module, so any warning-free read is served
+  // from the cache, otherwise the output check of the test driver fails
+  vtkNew<vtkSlicerDicomRtReader> firstPlanReader;
+  firstPlanReader->SetCacheDirectory(cacheDirectory.c_str());
+  firstPlanReader->SetFileName(planFileName.c_str());
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  firstPlanReader->Update();
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  if (!firstPlanReader->GetLoadRTPlanSuccessful() || firstPlanReader->GetNumberOfBeams() != 1)
+  {
+    std::cerr << "Failed to load synthetic RT plan" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkSlicerDicomRtReader> secondPlanReader;
+  secondPlanReader->SetCacheDirectory(cacheDirectory.c_str());
+  secondPlanReader->SetFileName(planFileName.c_str());
+  secondPlanReader->Update();
+  if (!ArePlansEqual(firstPlanReader, secondPlanReader))
+  {
+    std::cerr << "Plan read from the cache differs from the one parsed from the DICOM file" << std::endl;
+    return EXIT_FAILURE;
+  }
+  unsigned int beamNumber = secondPlanReader->GetBeamNumberForIndex(0);
+  if ( secondPlanReader->GetBeamNumberOfControlPoints(beamNumber) != 2
+    || secondPlanReader->GetBeamControlPointGantryAngle(beamNumber, 1) != 210.0
+    || secondPlanReader->GetBeamControlPointBeamLimitingDeviceAngle(beamNumber, 1) != 15.0 )
+  {
+    std::cerr << "Plan read from the cache has invalid control points" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Modified files with the same SOP instance UIDs miss the cache
+  if (!WriteSyntheticStructureSet(structureSetFileName, "External") || !WriteSyntheticPlan(planFileName, 90.0))
+  {
+    std::cerr << "Failed to modify synthetic RT objects in " << testDirectory << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkSlicerDicomRtReader> modifiedStructureSetReader;
+  modifiedStructureSetReader->SetCacheDirectory(cacheDirectory.c_str());
+  modifiedStructureSetReader->SetFileName(structureSetFileName.c_str());
+  modifiedStructureSetReader->Update();
+  if ( !modifiedStructureSetReader->GetLoadRTStructureSetSuccessful()
+    || !AreStringsEqual(modifiedStructureSetReader->GetRoiName(0), "External") )
+  {
+    std::cerr << "Modified structure set is read from the outdated cache: first ROI name is "
+      << (modifiedStructureSetReader->GetRoiName(0) ? modifiedStructureSetReader->GetRoiName(0) : "(none)") << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkSlicerDicomRtReader> modifiedPlanReader;
+  modifiedPlanReader->SetCacheDirectory(cacheDirectory.c_str());
+  modifiedPlanReader->SetFileName(planFileName.c_str());
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  modifiedPlanReader->Update();
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  beamNumber = modifiedPlanReader->GetBeamNumberForIndex(0);
+  if ( !modifiedPlanReader->GetLoadRTPlanSuccessful()
+    || modifiedPlanReader->GetBeamControlPointGantryAngle(beamNumber, 0) != 90.0 )
+  {
+    std::cerr << "Modified plan is read from the outdated cache: gantry angle is "
+      << modifiedPlanReader->GetBeamControlPointGantryAngle(beamNumber, 0) << " instead of 90" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The cache is updated with the modified files
+  vtkNew<vtkSlicerDicomRtReader> updatedStructureSetReader;
+  updatedStructureSetReader->SetCacheDirectory(cacheDirectory.c_str());
+  updatedStructureSetReader->SetFileName(structureSetFileName.c_str());
+  updatedStructureSetReader->Update();
+  vtkNew<vtkSlicerDicomRtReader> updatedPlanReader;
+  updatedPlanReader->SetCacheDirectory(cacheDirectory.c_str());
+  updatedPlanReader->SetFileName(planFileName.c_str());
+  updatedPlanReader->Update();
+  if ( !AreStructureSetsEqual(modifiedStructureSetReader, updatedStructureSetReader)
+    || !ArePlansEqual(modifiedPlanReader, updatedPlanReader) )
+  {
+    std::cerr << "Modified RT objects read from the updated cache differ from the ones parsed from the DICOM files" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtksys::SystemTools::RemoveADirectory(testDirectory);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtImportExportModuleLogic.h"
+
+// SegmentationCore includes
+#include <vtkOrientedImageData.h>
+#include <vtkOrientedImageDataResample.h>
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Create a 1mm reference image covering 40x40x40 voxels
+  void CreateReferenceImage(vtkOrientedImageData* referenceImage)
+  {
+    referenceImage->SetExtent(0, 39, 0, 39, 0, 39);
+    referenceImage->SetSpacing(1.0, 1.0, 1.0);
+    referenceImage->SetOrigin(-20.0, -20.0, -20.0);
+    referenceImage->AllocateScalars(VTK_SHORT, 1);
+    referenceImage->GetPointData()->GetScalars()->Fill(0.0);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Create a labelmap with the given spacing and rotation around the Z axis, containing a small block of
+  /// segment voxels in its middle, so that the block boundary is far from the voxel centers of the reference image
+  void CreateCoarseLabelmap(double spacing, double rotationAngle, vtkOrientedImageData* labelmap)
+  {
+    vtkNew<vtkTransform> labelmapToWorldTransform;
+    labelmapToWorldTransform->RotateZ(rotationAngle);
+    labelmapToWorldTransform->Translate(-3.0 * spacing, -3.0 * spacing, -3.0 * spacing);
+    labelmapToWorldTransform->Scale(spacing, spacing, spacing);
+    labelmap->SetGeometryFromImageToWorldMatrix(labelmapToWorldTransform->GetMatrix());
+    labelmap->SetExtent(0, 5, 0, 5, 0, 5);
+    labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    labelmap->GetPointData()->GetScalars()->Fill(0.0);
+    for (int k=2; k<=3; ++k)
+    {
+      for (int j=2; j<=3; ++j)
+      {
+        for (int i=2; i<=3; ++i)
+        {
+          labelmap->SetScalarComponentFromDouble(i, j, k, 0, 1.0);
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Compare resampling within the segment extent to resampling to the whole reference image
+  /// \return Number of segment voxels in the output, -1 on mismatch
+  int CompareCroppedAndFullResampling(vtkOrientedImageData* labelmap, vtkOrientedImageData* referenceImage)
+  {
+    vtkNew<vtkOrientedImageData> croppedResampledLabelmap;
+    if (!vtkSlicerDicomRtImportExportModuleLogic::ResampleSegmentLabelmapToReferenceImage(labelmap, referenceImage, croppedResampledLabelmap))
+    {
+      std::cerr << "Failed to resample labelmap within its extent" << std::endl;
+      return -1;
+    }
+    vtkNew<vtkOrientedImageData> fullResampledLabelmap;
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(labelmap, referenceImage, fullResampledLabelmap))
+    {
+      std::cerr << "Failed to resample labelmap to the whole reference image" << std::endl;
+      return -1;
+    }
+
+    int referenceExtent[6] = {0,-1,0,-1,0,-1};
+    referenceImage->GetExtent(referenceExtent);
+    int croppedResampledExtent[6] = {0,-1,0,-1,0,-1};
+    croppedResampledLabelmap->GetExtent(croppedResampledExtent);
+    for (int i=0; i<6; ++i)
+    {
+      if (croppedResampledExtent[i] != referenceExtent[i])
+      {
+        std::cerr << "Resampled labelmap extent differs from the reference extent" << std::endl;
+        return -1;
+      }
+    }
+
+    int numberOfSegmentVoxels = 0;
+    for (int k=referenceExtent[4]; k<=referenceExtent[5]; ++k)
+    {
+      for (int j=referenceExtent[2]; j<=referenceExtent[3]; ++j)
+      {
+        for (int i=referenceExtent[0]; i<=referenceExtent[1]; ++i)
+        {
+          double croppedValue = croppedResampledLabelmap->GetScalarComponentAsDouble(i, j, k, 0);
+          double fullValue = fullResampledLabelmap->GetScalarComponentAsDouble(i, j, k, 0);
+          if (croppedValue != fullValue)
+          {
+            std::cerr << "Resampled labelmap mismatch at voxel (" << i << ", " << j << ", " << k << "): "
+              << croppedValue << " instead of " << fullValue << std::endl;
+            return -1;
+          }
+          if (fullValue != 0.0)
+          {
+            ++numberOfSegmentVoxels;
+          }
+        }
+      }
+    }
+    return numberOfSegmentVoxels;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportSegmentResampleTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkOrientedImageData> referenceImage;
+  CreateReferenceImage(referenceImage);
+
+  // Labelmap voxels much larger than the reference voxels, axis aligned and rotated.
+  // The segment block is 2 labelmap voxels wide, so it covers about (2*spacing)^3 reference voxels.
+  const double spacings[3] = { 2.5, 5.0, 6.0 };
+  const double rotationAngles[2] = { 0.0, 30.0 };
+  for (double spacing : spacings)
+  {
+    for (double rotationAngle : rotationAngles)
+    {
+      vtkNew<vtkOrientedImageData> labelmap;
+      CreateCoarseLabelmap(spacing, rotationAngle, labelmap);
+      int numberOfSegmentVoxels = CompareCroppedAndFullResampling(labelmap, referenceImage);
+      if (numberOfSegmentVoxels < 0)
+      {
+        std::cerr << "Labelmap spacing " << spacing << ", rotation angle " << rotationAngle << std::endl;
+        return EXIT_FAILURE;
+      }
+      double expectedNumberOfSegmentVoxels = 8.0 * spacing * spacing * spacing;
+      if (std::fabs(numberOfSegmentVoxels - expectedNumberOfSegmentVoxels) > 0.5 * expectedNumberOfSegmentVoxels)
+      {
+        std::cerr << "Labelmap spacing " << spacing << ", rotation angle " << rotationAngle << ": "
+          << numberOfSegmentVoxels << " segment voxels instead of about " << expectedNumberOfSegmentVoxels << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Empty labelmap results in an empty output covering the reference image
+  vtkNew<vtkOrientedImageData> emptyLabelmap;
+  CreateCoarseLabelmap(5.0, 0.0, emptyLabelmap);
+  emptyLabelmap->GetPointData()->GetScalars()->Fill(0.0);
+  if (CompareCroppedAndFullResampling(emptyLabelmap, referenceImage) != 0)
+  {
+    std::cerr << "Empty labelmap is not resampled to an empty output" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Invalid input
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  bool invalidInputAccepted = vtkSlicerDicomRtImportExportModuleLogic::ResampleSegmentLabelmapToReferenceImage(
+    nullptr, referenceImage, emptyLabelmap);
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  if (invalidInputAccepted)
+  {
+    std::cerr << "Resampling accepts invalid input" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
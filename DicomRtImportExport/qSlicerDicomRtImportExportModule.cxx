@@ -26,6 +26,7 @@
 
 // Qt includes
 #include <QDebug> 
+#include <QTimer>
 
 // Slicer includes
 #include <qSlicerCoreApplication.h>
@@ -53,6 +54,11 @@ class qSlicerDicomRtImportExportModulePrivate
 {
 public:
   qSlicerDicomRtImportExportModulePrivate();
+
+  /// Timer driving the deferred closed surface conversion of loaded structure sets.
+  /// One segment is converted per timeout so that the application stays responsive.
+  /// It only runs while the conversion queue is not empty
+  QTimer ClosedSurfaceConversionTimer;
 };
 
 //-----------------------------------------------------------------------------
@@ -61,6 +67,9 @@ public:
 //-----------------------------------------------------------------------------
 qSlicerDicomRtImportExportModulePrivate::qSlicerDicomRtImportExportModulePrivate() = default;
 
+// Interval of checking the deferred closed surface conversion queue when there is no visible segment to convert
+static const int CLOSED_SURFACE_CONVERSION_IDLE_INTERVAL_MS = 500;
+
 //-----------------------------------------------------------------------------
 // qSlicerDicomRtImportExportModule methods
 
@@ -157,6 +166,49 @@ void qSlicerDicomRtImportExportModule::setup()
   // Register Subject Hierarchy plugins
   qSlicerSubjectHierarchyPluginHandler::instance()->registerPlugin(new qSlicerSubjectHierarchyRtImagePlugin());
   qSlicerSubjectHierarchyPluginHandler::instance()->registerPlugin(new qSlicerSubjectHierarchyRtDoseVolumePlugin());
+
+  // Process deferred closed surface conversion of structure sets in the background when segments are queued
+  Q_D(qSlicerDicomRtImportExportModule);
+  connect(&d->ClosedSurfaceConversionTimer, SIGNAL(timeout()), this, SLOT(processClosedSurfaceConversionQueue()));
+  qvtkConnect(dicomRtImportExportLogic, vtkSlicerDicomRtImportExportModuleLogic::ClosedSurfaceConversionQueuedEvent,
+    this, SLOT(onClosedSurfaceConversionQueued()));
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerDicomRtImportExportModule::onClosedSurfaceConversionQueued()
+{
+  Q_D(qSlicerDicomRtImportExportModule);
+  if (!d->ClosedSurfaceConversionTimer.isActive())
+  {
+    d->ClosedSurfaceConversionTimer.setInterval(0);
+    d->ClosedSurfaceConversionTimer.start();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerDicomRtImportExportModule::processClosedSurfaceConversionQueue()
+{
+  Q_D(qSlicerDicomRtImportExportModule);
+
+  vtkSlicerDicomRtImportExportModuleLogic* dicomRtImportExportLogic = vtkSlicerDicomRtImportExportModuleLogic::SafeDownCast(this->logic());
+  if (!dicomRtImportExportLogic)
+  {
+    d->ClosedSurfaceConversionTimer.stop();
+    return;
+  }
+
+  // If no segment was converted, then the structure sets without visible segments waiting have been finalized
+  // and removed from the queue, so the queue is empty if no segment is pending
+  bool segmentConverted = dicomRtImportExportLogic->ProcessClosedSurfaceConversionQueue();
+  if (!segmentConverted && dicomRtImportExportLogic->GetNumberOfPendingClosedSurfaceConversions() == 0)
+  {
+    d->ClosedSurfaceConversionTimer.stop();
+    return;
+  }
+
+  // Convert the next segment as soon as pending events are processed if there was work to do,
+  // otherwise wait for a segment to be shown
+  d->ClosedSurfaceConversionTimer.setInterval(segmentConverted ? 0 : CLOSED_SURFACE_CONVERSION_IDLE_INTERVAL_MS);
 }
 
 //-----------------------------------------------------------------------------
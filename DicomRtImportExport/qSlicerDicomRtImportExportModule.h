@@ -25,6 +25,9 @@
 // SlicerQt includes
 #include "qSlicerLoadableModule.h"
 
+// CTK includes
+#include <ctkVTKObject.h>
+
 #include "qSlicerDicomRtImportExportModuleExport.h"
 
 class qSlicerDicomRtImportExportModulePrivate;
@@ -34,6 +37,7 @@ class Q_SLICER_QTMODULES_DICOMRTIMPORTEXPORT_EXPORT qSlicerDicomRtImportExportMo
   public qSlicerLoadableModule
 {
   Q_OBJECT
+  QVTK_OBJECT
 #ifdef Slicer_HAVE_QT5
   Q_PLUGIN_METADATA(IID "org.slicer.modules.loadable.qSlicerLoadableModule/1.0");
 #endif
@@ -76,6 +80,14 @@ protected:
   /// Create and return the logic associated to this module (will return only import logic!)
   vtkMRMLAbstractLogic* createLogic() override;
 
+protected slots:
+  /// Start processing the deferred closed surface conversion queue when segments are queued
+  void onClosedSurfaceConversionQueued();
+
+  /// Convert the next visible segment waiting for deferred closed surface conversion.
+  /// Stops the timer when the queue is empty
+  void processClosedSurfaceConversionQueue();
+
 protected:
   QScopedPointer<qSlicerDicomRtImportExportModulePrivate> d_ptr;
 
@@ -28,6 +28,7 @@
 #include <vtkMRMLScene.h>
 #include <vtkMRMLLinearTransformNode.h>
 #include <vtkMRMLSegmentationNode.h>
+#include <vtkMRMLTableNode.h>
 
 // VTK includes
 #include <vtkObjectFactory.h>
@@ -64,6 +65,7 @@ static const char* TABLETOPECCENTRICROTATION_TO_PATIENTSUPPORT_TRANSFORM_NODE_RE
 
 static const char* BEAM_REFERENCE_ROLE = "beamRef";
 static const char* PATIENT_BODY_SEGMENTATION_REFERENCE_ROLE = "patientBodySegmentationRef";
+static const char* COLLISION_MAP_TABLE_REFERENCE_ROLE = "collisionMapTableRef";
 
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLRoomsEyeViewNode);
@@ -85,6 +87,22 @@ vtkMRMLRoomsEyeViewNode::vtkMRMLRoomsEyeViewNode()
   , AdditionalModelLateralDisplacement(0.0)
   , ApplicatorHolderVisibility(0)
   , ElectronApplicatorVisibility(0)
+  , CollisionProxyTriangleBudget(5000)
+  , CollisionProxySafetyMargin(5.0)
+  , CollisionProxyExactConfirmation(true)
+  , PatientBodyCollisionTriangleBudget(0)
+  , ClearanceTolerance(10.0)
+  , ClearanceDistanceFieldMargin(100.0)
+  , ClearanceWarningThreshold(50.0)
+  , GantryTableTopClearance(VTK_DOUBLE_MAX)
+  , GantryPatientSupportClearance(VTK_DOUBLE_MAX)
+  , CollimatorTableTopClearance(VTK_DOUBLE_MAX)
+  , GantryPatientClearance(VTK_DOUBLE_MAX)
+  , CollimatorPatientClearance(VTK_DOUBLE_MAX)
+  , CollisionMapGantryAngleStep(5.0)
+  , CollisionMapPatientSupportAngleMinimum(-90.0)
+  , CollisionMapPatientSupportAngleMaximum(90.0)
+  , CollisionMapPatientSupportAngleStep(10.0)
 {
   this->SetSingletonTag("IEC");
 }
@@ -118,6 +136,17 @@ void vtkMRMLRoomsEyeViewNode::WriteXML(ostream& of, int nIndent)
   vtkMRMLWriteXMLStringMacro(TreatmentMachineDescriptorFilePath, TreatmentMachineDescriptorFilePath);
   vtkMRMLWriteXMLIntMacro(ApplicatorHolderVisibility, ApplicatorHolderVisibility);
   vtkMRMLWriteXMLIntMacro(ElectronApplicatorVisibility, ElectronApplicatorVisibility);
+  vtkMRMLWriteXMLIntMacro(CollisionProxyTriangleBudget, CollisionProxyTriangleBudget);
+  vtkMRMLWriteXMLFloatMacro(CollisionProxySafetyMargin, CollisionProxySafetyMargin);
+  vtkMRMLWriteXMLBooleanMacro(CollisionProxyExactConfirmation, CollisionProxyExactConfirmation);
+  vtkMRMLWriteXMLIntMacro(PatientBodyCollisionTriangleBudget, PatientBodyCollisionTriangleBudget);
+  vtkMRMLWriteXMLFloatMacro(ClearanceTolerance, ClearanceTolerance);
+  vtkMRMLWriteXMLFloatMacro(ClearanceDistanceFieldMargin, ClearanceDistanceFieldMargin);
+  vtkMRMLWriteXMLFloatMacro(ClearanceWarningThreshold, ClearanceWarningThreshold);
+  vtkMRMLWriteXMLFloatMacro(CollisionMapGantryAngleStep, CollisionMapGantryAngleStep);
+  vtkMRMLWriteXMLFloatMacro(CollisionMapPatientSupportAngleMinimum, CollisionMapPatientSupportAngleMinimum);
+  vtkMRMLWriteXMLFloatMacro(CollisionMapPatientSupportAngleMaximum, CollisionMapPatientSupportAngleMaximum);
+  vtkMRMLWriteXMLFloatMacro(CollisionMapPatientSupportAngleStep, CollisionMapPatientSupportAngleStep);
   vtkMRMLWriteXMLEndMacro(); 
 }
 
@@ -143,6 +172,17 @@ void vtkMRMLRoomsEyeViewNode::ReadXMLAttributes(const char** atts)
   vtkMRMLReadXMLStringMacro(TreatmentMachineDescriptorFilePath, TreatmentMachineDescriptorFilePath);
   vtkMRMLReadXMLIntMacro(ApplicatorHolderVisibility, ApplicatorHolderVisibility);
   vtkMRMLReadXMLIntMacro(ElectronApplicatorVisibility, ElectronApplicatorVisibility);
+  vtkMRMLReadXMLIntMacro(CollisionProxyTriangleBudget, CollisionProxyTriangleBudget);
+  vtkMRMLReadXMLFloatMacro(CollisionProxySafetyMargin, CollisionProxySafetyMargin);
+  vtkMRMLReadXMLBooleanMacro(CollisionProxyExactConfirmation, CollisionProxyExactConfirmation);
+  vtkMRMLReadXMLIntMacro(PatientBodyCollisionTriangleBudget, PatientBodyCollisionTriangleBudget);
+  vtkMRMLReadXMLFloatMacro(ClearanceTolerance, ClearanceTolerance);
+  vtkMRMLReadXMLFloatMacro(ClearanceDistanceFieldMargin, ClearanceDistanceFieldMargin);
+  vtkMRMLReadXMLFloatMacro(ClearanceWarningThreshold, ClearanceWarningThreshold);
+  vtkMRMLReadXMLFloatMacro(CollisionMapGantryAngleStep, CollisionMapGantryAngleStep);
+  vtkMRMLReadXMLFloatMacro(CollisionMapPatientSupportAngleMinimum, CollisionMapPatientSupportAngleMinimum);
+  vtkMRMLReadXMLFloatMacro(CollisionMapPatientSupportAngleMaximum, CollisionMapPatientSupportAngleMaximum);
+  vtkMRMLReadXMLFloatMacro(CollisionMapPatientSupportAngleStep, CollisionMapPatientSupportAngleStep);
   vtkMRMLReadXMLEndMacro(); 
 
   this->EndModify(disabledModify);
@@ -175,6 +215,22 @@ void vtkMRMLRoomsEyeViewNode::Copy(vtkMRMLNode *anode)
   vtkMRMLCopyStringMacro(TreatmentMachineDescriptorFilePath);
   vtkMRMLCopyIntMacro(ApplicatorHolderVisibility);
   vtkMRMLCopyIntMacro(ElectronApplicatorVisibility);
+  vtkMRMLCopyIntMacro(CollisionProxyTriangleBudget);
+  vtkMRMLCopyFloatMacro(CollisionProxySafetyMargin);
+  vtkMRMLCopyBooleanMacro(CollisionProxyExactConfirmation);
+  vtkMRMLCopyIntMacro(PatientBodyCollisionTriangleBudget);
+  vtkMRMLCopyFloatMacro(ClearanceTolerance);
+  vtkMRMLCopyFloatMacro(ClearanceDistanceFieldMargin);
+  vtkMRMLCopyFloatMacro(ClearanceWarningThreshold);
+  vtkMRMLCopyFloatMacro(GantryTableTopClearance);
+  vtkMRMLCopyFloatMacro(GantryPatientSupportClearance);
+  vtkMRMLCopyFloatMacro(CollimatorTableTopClearance);
+  vtkMRMLCopyFloatMacro(GantryPatientClearance);
+  vtkMRMLCopyFloatMacro(CollimatorPatientClearance);
+  vtkMRMLCopyFloatMacro(CollisionMapGantryAngleStep);
+  vtkMRMLCopyFloatMacro(CollisionMapPatientSupportAngleMinimum);
+  vtkMRMLCopyFloatMacro(CollisionMapPatientSupportAngleMaximum);
+  vtkMRMLCopyFloatMacro(CollisionMapPatientSupportAngleStep);
   vtkMRMLCopyEndMacro(); 
 
   this->EndModify(disabledModify);
@@ -201,6 +257,22 @@ void vtkMRMLRoomsEyeViewNode::PrintSelf(ostream& os, vtkIndent indent)
   vtkMRMLPrintStringMacro(TreatmentMachineDescriptorFilePath);
   vtkMRMLPrintIntMacro(ApplicatorHolderVisibility);
   vtkMRMLPrintIntMacro(ElectronApplicatorVisibility);
+  vtkMRMLPrintIntMacro(CollisionProxyTriangleBudget);
+  vtkMRMLPrintFloatMacro(CollisionProxySafetyMargin);
+  vtkMRMLPrintBooleanMacro(CollisionProxyExactConfirmation);
+  vtkMRMLPrintIntMacro(PatientBodyCollisionTriangleBudget);
+  vtkMRMLPrintFloatMacro(ClearanceTolerance);
+  vtkMRMLPrintFloatMacro(ClearanceDistanceFieldMargin);
+  vtkMRMLPrintFloatMacro(ClearanceWarningThreshold);
+  vtkMRMLPrintFloatMacro(GantryTableTopClearance);
+  vtkMRMLPrintFloatMacro(GantryPatientSupportClearance);
+  vtkMRMLPrintFloatMacro(CollimatorTableTopClearance);
+  vtkMRMLPrintFloatMacro(GantryPatientClearance);
+  vtkMRMLPrintFloatMacro(CollimatorPatientClearance);
+  vtkMRMLPrintFloatMacro(CollisionMapGantryAngleStep);
+  vtkMRMLPrintFloatMacro(CollisionMapPatientSupportAngleMinimum);
+  vtkMRMLPrintFloatMacro(CollisionMapPatientSupportAngleMaximum);
+  vtkMRMLPrintFloatMacro(CollisionMapPatientSupportAngleStep);
   vtkMRMLPrintEndMacro(); 
 }
 
@@ -579,3 +651,21 @@ void vtkMRMLRoomsEyeViewNode::SetAndObserveBeamNode(vtkMRMLRTBeamNode* node)
 
   this->SetNodeReferenceID(BEAM_REFERENCE_ROLE, (node ? node->GetID() : nullptr));
 }
+
+//----------------------------------------------------------------------------
+vtkMRMLTableNode* vtkMRMLRoomsEyeViewNode::GetCollisionMapTableNode()
+{
+  return vtkMRMLTableNode::SafeDownCast( this->GetNodeReference(COLLISION_MAP_TABLE_REFERENCE_ROLE) );
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLRoomsEyeViewNode::SetAndObserveCollisionMapTableNode(vtkMRMLTableNode* node)
+{
+  if (node && this->Scene != node->GetScene())
+    {
+    vtkErrorMacro("Cannot set reference: the referenced and referencing node are not in the same scene");
+    return;
+    }
+
+  this->SetNodeReferenceID(COLLISION_MAP_TABLE_REFERENCE_ROLE, (node ? node->GetID() : nullptr));
+}
@@ -29,6 +29,7 @@
 
 class vtkMRMLLinearTransformNode;
 class vtkMRMLSegmentationNode;
+class vtkMRMLTableNode;
 class vtkMRMLRTBeamNode;
 
 /// \ingroup SlicerRt_QtModules_RoomsEyeView
@@ -122,6 +123,11 @@ public:
   /// Set and observe patient body segmentation node
   void SetAndObservePatientBodySegmentationNode(vtkMRMLSegmentationNode* node);
 
+  /// Get collision map table node
+  vtkMRMLTableNode* GetCollisionMapTableNode();
+  /// Set and observe collision map table node
+  void SetAndObserveCollisionMapTableNode(vtkMRMLTableNode* node);
+
   /// Get patient body segment ID
   vtkGetStringMacro(PatientBodySegmentID);
   /// Set patient body segment ID
@@ -172,6 +178,55 @@ public:
   vtkGetMacro(ElectronApplicatorVisibility, int);
   vtkSetMacro(ElectronApplicatorVisibility, int);
 
+  vtkGetMacro(CollisionProxyTriangleBudget, int);
+  vtkSetMacro(CollisionProxyTriangleBudget, int);
+
+  vtkGetMacro(CollisionProxySafetyMargin, double);
+  vtkSetMacro(CollisionProxySafetyMargin, double);
+
+  vtkGetMacro(CollisionProxyExactConfirmation, bool);
+  vtkSetMacro(CollisionProxyExactConfirmation, bool);
+  vtkBooleanMacro(CollisionProxyExactConfirmation, bool);
+
+  vtkGetMacro(PatientBodyCollisionTriangleBudget, int);
+  vtkSetMacro(PatientBodyCollisionTriangleBudget, int);
+
+  vtkGetMacro(ClearanceTolerance, double);
+  vtkSetMacro(ClearanceTolerance, double);
+
+  vtkGetMacro(ClearanceDistanceFieldMargin, double);
+  vtkSetMacro(ClearanceDistanceFieldMargin, double);
+
+  vtkGetMacro(ClearanceWarningThreshold, double);
+  vtkSetMacro(ClearanceWarningThreshold, double);
+
+  vtkGetMacro(GantryTableTopClearance, double);
+  vtkSetMacro(GantryTableTopClearance, double);
+
+  vtkGetMacro(GantryPatientSupportClearance, double);
+  vtkSetMacro(GantryPatientSupportClearance, double);
+
+  vtkGetMacro(CollimatorTableTopClearance, double);
+  vtkSetMacro(CollimatorTableTopClearance, double);
+
+  vtkGetMacro(GantryPatientClearance, double);
+  vtkSetMacro(GantryPatientClearance, double);
+
+  vtkGetMacro(CollimatorPatientClearance, double);
+  vtkSetMacro(CollimatorPatientClearance, double);
+
+  vtkGetMacro(CollisionMapGantryAngleStep, double);
+  vtkSetMacro(CollisionMapGantryAngleStep, double);
+
+  vtkGetMacro(CollisionMapPatientSupportAngleMinimum, double);
+  vtkSetMacro(CollisionMapPatientSupportAngleMinimum, double);
+
+  vtkGetMacro(CollisionMapPatientSupportAngleMaximum, double);
+  vtkSetMacro(CollisionMapPatientSupportAngleMaximum, double);
+
+  vtkGetMacro(CollisionMapPatientSupportAngleStep, double);
+  vtkSetMacro(CollisionMapPatientSupportAngleStep, double);
+
 protected:
   vtkMRMLRoomsEyeViewNode();
   ~vtkMRMLRoomsEyeViewNode();
@@ -200,6 +255,44 @@ protected:
   double AdditionalModelLateralDisplacement;
   int ApplicatorHolderVisibility;
   int ElectronApplicatorVisibility;
+
+  /// Maximum number of triangles in the simplified collision proxy of each treatment machine part.
+  /// Parts with more triangles are decimated when set up. Zero or negative value disables simplification.
+  int CollisionProxyTriangleBudget;
+  /// Distance (in mm) by which the OBB tree boxes of the moving treatment machine part (gantry, collimator) collision
+  /// proxies are inflated in addition to the simplification error bound. Every checked pair contains exactly one
+  /// moving part, so parts closer than the margin are reported as colliding, unless exact confirmation is enabled.
+  double CollisionProxySafetyMargin;
+  /// Flag determining whether contacts reported for the collision proxies are confirmed using the full resolution surfaces
+  bool CollisionProxyExactConfirmation;
+  /// Maximum number of triangles in the decimated patient body surface used for collision detection.
+  /// Zero or negative value (default) means the full resolution surface is used.
+  int PatientBodyCollisionTriangleBudget;
+
+  /// Maximum error (in mm) of the computed clearances. It determines the grid spacing of the signed distance fields
+  /// of the static parts and the spacing of the points sampled on the moving parts. Halving the tolerance makes
+  /// the distance fields eight times larger.
+  double ClearanceTolerance;
+  /// Distance (in mm) by which the signed distance fields extend beyond the bounds of the static parts
+  double ClearanceDistanceFieldMargin;
+  /// Clearance (in mm) below which the clearance of a part pair is shown as a warning
+  double ClearanceWarningThreshold;
+
+  /// Minimum clearances (in mm) between the part pairs in the current pose, computed in collision detection.
+  /// Negative value means penetration, VTK_DOUBLE_MAX means that the clearance is not available
+  /// (e.g. collision detection is disabled, or a part or the patient body is missing).
+  double GantryTableTopClearance;
+  double GantryPatientSupportClearance;
+  double CollimatorTableTopClearance;
+  double GantryPatientClearance;
+  double CollimatorPatientClearance;
+
+  /// Gantry angle step (in degrees) of the collision map. The map covers the full 0-360 degree gantry rotation
+  double CollisionMapGantryAngleStep;
+  /// Patient support angle range and step (in degrees) of the collision map
+  double CollisionMapPatientSupportAngleMinimum;
+  double CollisionMapPatientSupportAngleMaximum;
+  double CollisionMapPatientSupportAngleStep;
 };
 
 #endif
@@ -30,6 +30,7 @@
 // SlicerRT includes
 #include "vtkCollisionDetectionFilter.h"
 #include "vtkMRMLRTBeamNode.h"
+#include "vtkMRMLRTPlanNode.h"
 
 // MRML includes
 #include <vtkMRMLDisplayNode.h>
@@ -37,7 +38,11 @@
 #include <vtkMRMLModelNode.h>
 #include <vtkMRMLModelDisplayNode.h>
 #include <vtkMRMLScene.h>
+#include <vtkMRMLSegmentationNode.h>
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
 #include "vtkMRMLSubjectHierarchyNode.h"
+#include <vtkMRMLTableNode.h>
 #include <vtkMRMLViewNode.h>
 
 // Slicer includes
@@ -45,23 +50,51 @@
 #include <vtkSlicerSegmentationsModuleLogic.h>
 
 // vtkSegmentationCore includes
+#include <vtkSegment.h>
+#include <vtkSegmentation.h>
 #include <vtkSegmentationConverter.h>
 
 // VTK includes
 #include <vtkAppendPolyData.h>
+#include <vtkBoundingBox.h>
+#include <vtkDoubleArray.h>
 #include <vtkGeneralTransform.h>
+#include <vtkIdList.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkImplicitPolyDataDistance.h>
+#include <vtkMath.h>
 #include <vtkMatrix4x4.h>
+#include <vtkOBBTree.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyDataReader.h>
+#include <vtkQuadricDecimation.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
+#include <vtkTable.h>
 #include <vtkTransform.h>
+#include <vtkTriangle.h>
 #include <vtkTransformFilter.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkTriangleFilter.h>
 #include <vtkVector.h>
+#include <vtkWeakPointer.h>
 
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
 // RapidJSON includes
 #include "rapidjson/document.h"     // rapidjson's DOM-style API
 #include "rapidjson/filereadstream.h"
@@ -69,10 +102,861 @@
 
 // Constants
 const char* vtkSlicerRoomsEyeViewModuleLogic::ORIENTATION_MARKER_MODEL_NODE_NAME = "RoomsEyeViewOrientationMarker";
+const char* vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_PATIENT_SUPPORT_ANGLE_COLUMN_NAME = "Patient support angle";
+const char* vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_GANTRY_ANGLE_COLUMN_NAME = "Gantry angle";
+const char* vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_COLLISIONS_COLUMN_NAME = "Collisions";
+const char* vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_MINIMUM_CLEARANCE_COLUMN_NAME = "Minimum clearance (mm)";
 //TODO: Add this dynamically to the IEC transform map
 static const char* ADDITIONALCOLLIMATORMOUNTEDDEVICES_TO_COLLIMATOR_TRANSFORM_NODE_NAME = "AdditionalCollimatorDevicesToCollimatorTransform";
 static rapidjson::Value JSON_EMPTY_VALUE;
 
+//----------------------------------------------------------------------------
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Get axis-aligned bounding box in world coordinates of a box given in local coordinates.
+/// All eight corners of the local box are transformed, so the result conservatively contains the transformed part.
+void GetWorldBoundingBox(const vtkBoundingBox& localBox, const double localToWorldMatrix[16], vtkBoundingBox& worldBox)
+{
+  worldBox.Reset();
+  if (!localBox.IsValid())
+  {
+    return;
+  }
+
+  const double* minPoint = localBox.GetMinPoint();
+  const double* maxPoint = localBox.GetMaxPoint();
+  for (int cornerIndex=0; cornerIndex<8; ++cornerIndex)
+  {
+    double corner[3] = { (cornerIndex & 1) ? maxPoint[0] : minPoint[0],
+                         (cornerIndex & 2) ? maxPoint[1] : minPoint[1],
+                         (cornerIndex & 4) ? maxPoint[2] : minPoint[2] };
+    double transformedCorner[3] = { 0.0, 0.0, 0.0 };
+    for (int i=0; i<3; ++i)
+    {
+      transformedCorner[i] = localToWorldMatrix[4*i] * corner[0] + localToWorldMatrix[4*i+1] * corner[1]
+        + localToWorldMatrix[4*i+2] * corner[2] + localToWorldMatrix[4*i+3];
+    }
+    worldBox.AddPoint(transformedCorner);
+  }
+}
+
+//----------------------------------------------------------------------------
+void GetWorldBoundingBox(const vtkBoundingBox& localBox, vtkLinearTransform* localToWorldTransform, vtkBoundingBox& worldBox)
+{
+  if (!localToWorldTransform)
+  {
+    worldBox.Reset();
+    return;
+  }
+  GetWorldBoundingBox(localBox, localToWorldTransform->GetMatrix()->GetData(), worldBox);
+}
+
+//----------------------------------------------------------------------------
+/// Get human readable list of the colliding part pairs
+std::string GetCollisionPairFlagsAsString(int flags)
+{
+  std::string pairsString;
+  const std::pair<int, const char*> pairNames[] = {
+    { vtkSlicerRoomsEyeViewModuleLogic::GantryTableTopCollision, "gantry and table top" },
+    { vtkSlicerRoomsEyeViewModuleLogic::GantryPatientSupportCollision, "gantry and patient support" },
+    { vtkSlicerRoomsEyeViewModuleLogic::CollimatorTableTopCollision, "collimator and table top" },
+    { vtkSlicerRoomsEyeViewModuleLogic::GantryPatientCollision, "gantry and patient" },
+    { vtkSlicerRoomsEyeViewModuleLogic::CollimatorPatientCollision, "collimator and patient" } };
+  for (const std::pair<int, const char*>& pairName : pairNames)
+  {
+    if (flags & pairName.first)
+    {
+      pairsString += (pairsString.empty() ? "" : ", ") + std::string(pairName.second);
+    }
+  }
+  return pairsString;
+}
+
+//----------------------------------------------------------------------------
+/// Data of the search for the first contact between the triangles of two OBB tree leaf nodes
+struct TriangleContactSearch
+{
+  vtkPolyData* PolyDataA{nullptr};
+  vtkPolyData* PolyDataB{nullptr};
+  vtkIdList* PointIdsA{nullptr};
+  vtkIdList* PointIdsB{nullptr};
+  /// Points of the current polygon of B in the coordinate frame of A
+  std::vector<double> PointsB;
+  bool ContactFound{false};
+};
+
+//----------------------------------------------------------------------------
+/// Callback of vtkOBBTree::IntersectWithOBBTree testing the cells of two overlapping leaf nodes for intersection.
+/// Polygons are tested as triangle fans. Only reads the poly data (cells must be built), so it can be used in parallel.
+int FindFirstTriangleContact(vtkOBBNode* nodeA, vtkOBBNode* nodeB, vtkMatrix4x4* transformBToA, void* searchPtr)
+{
+  TriangleContactSearch* search = static_cast<TriangleContactSearch*>(searchPtr);
+  if (search->ContactFound || !nodeA->Cells || !nodeB->Cells)
+  {
+    // Stop traversal if contact has already been found
+    return (search->ContactFound ? -1 : 0);
+  }
+
+  for (vtkIdType cellIndexB=0; cellIndexB<nodeB->Cells->GetNumberOfIds(); ++cellIndexB)
+  {
+    search->PolyDataB->GetCellPoints(nodeB->Cells->GetId(cellIndexB), search->PointIdsB);
+    vtkIdType numberOfPointsB = search->PointIdsB->GetNumberOfIds();
+    if (numberOfPointsB < 3)
+    {
+      continue;
+    }
+    search->PointsB.resize(3 * numberOfPointsB);
+    for (vtkIdType pointIndex=0; pointIndex<numberOfPointsB; ++pointIndex)
+    {
+      double pointB[4] = { 0.0, 0.0, 0.0, 1.0 };
+      search->PolyDataB->GetPoint(search->PointIdsB->GetId(pointIndex), pointB);
+      double pointBInA[4] = { 0.0, 0.0, 0.0, 1.0 };
+      transformBToA->MultiplyPoint(pointB, pointBInA);
+      std::copy(pointBInA, pointBInA + 3, search->PointsB.begin() + 3 * pointIndex);
+    }
+
+    for (vtkIdType cellIndexA=0; cellIndexA<nodeA->Cells->GetNumberOfIds(); ++cellIndexA)
+    {
+      search->PolyDataA->GetCellPoints(nodeA->Cells->GetId(cellIndexA), search->PointIdsA);
+      vtkIdType numberOfPointsA = search->PointIdsA->GetNumberOfIds();
+      if (numberOfPointsA < 3)
+      {
+        continue;
+      }
+      double pointsA[3][3] = { { 0.0 } };
+      search->PolyDataA->GetPoint(search->PointIdsA->GetId(0), pointsA[0]);
+      search->PolyDataA->GetPoint(search->PointIdsA->GetId(1), pointsA[1]);
+      for (vtkIdType fanIndexA=2; fanIndexA<numberOfPointsA; ++fanIndexA)
+      {
+        search->PolyDataA->GetPoint(search->PointIdsA->GetId(fanIndexA), pointsA[2]);
+        for (vtkIdType fanIndexB=2; fanIndexB<numberOfPointsB; ++fanIndexB)
+        {
+          if (vtkTriangle::TrianglesIntersect(pointsA[0], pointsA[1], pointsA[2],
+            &search->PointsB[0], &search->PointsB[3 * (fanIndexB - 1)], &search->PointsB[3 * fanIndexB]))
+          {
+            search->ContactFound = true;
+            return -1;
+          }
+        }
+        std::copy(pointsA[2], pointsA[2] + 3, pointsA[1]);
+      }
+    }
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+/// Get transform from the coordinate frame of surface B to that of surface A
+void GetTransformBToA(const double aToRas[16], const double bToRas[16], vtkMatrix4x4* transformBToA)
+{
+  double rasToA[16] = { 0.0 };
+  vtkMatrix4x4::Invert(aToRas, rasToA);
+  double bToA[16] = { 0.0 };
+  vtkMatrix4x4::Multiply4x4(rasToA, bToRas, bToA);
+  transformBToA->DeepCopy(bToA);
+}
+
+//----------------------------------------------------------------------------
+/// Check whether two surfaces intersect using their OBB trees
+/// \param search Search buffers, reused between calls
+/// \param transformBToA Matrix buffer, reused between calls
+bool DoSurfacesIntersect(vtkOBBTree* treeA, const double aToRas[16], vtkOBBTree* treeB, const double bToRas[16],
+  TriangleContactSearch& search, vtkMatrix4x4* transformBToA)
+{
+  GetTransformBToA(aToRas, bToRas, transformBToA);
+
+  search.PolyDataA = vtkPolyData::SafeDownCast(treeA->GetDataSet());
+  search.PolyDataB = vtkPolyData::SafeDownCast(treeB->GetDataSet());
+  search.ContactFound = false;
+  treeA->IntersectWithOBBTree(treeB, transformBToA, FindFirstTriangleContact, &search);
+  return search.ContactFound;
+}
+
+//----------------------------------------------------------------------------
+/// OBB tree of a collision proxy. The boxes of the nodes are inflated after the tree is built, so that each box
+/// contains all points within the inflation distance of the cells under the node, regardless of the shape or
+/// orientation of the surface.
+class vtkCollisionProxyOBBTree : public vtkOBBTree
+{
+public:
+  static vtkCollisionProxyOBBTree* New();
+  vtkTypeMacro(vtkCollisionProxyOBBTree, vtkOBBTree);
+
+  /// Inflate the boxes of all nodes by the given distance in every direction. Needs to be called after BuildLocator.
+  void InflateNodes(double inflation)
+  {
+    if (inflation > 0.0)
+    {
+      InflateNode(this->Tree, inflation);
+    }
+  }
+
+protected:
+  vtkCollisionProxyOBBTree() = default;
+  ~vtkCollisionProxyOBBTree() override = default;
+
+  static void InflateNode(vtkOBBNode* node, double inflation)
+  {
+    if (!node)
+    {
+      return;
+    }
+
+    // Unit vectors of the box axes. Axes of zero length (boxes of flat or line-like cells) are replaced
+    // by directions completing an orthonormal frame, so that the box is inflated in those directions too.
+    const double minimumAxisLength = 1.0e-9;
+    double directions[3][3] = { { 0.0 } };
+    double lengths[3] = { 0.0 };
+    for (int axisIndex=0; axisIndex<3; ++axisIndex)
+    {
+      std::copy(node->Axes[axisIndex], node->Axes[axisIndex] + 3, directions[axisIndex]);
+      lengths[axisIndex] = vtkMath::Normalize(directions[axisIndex]);
+    }
+    int order[3] = { 0, 1, 2 };
+    std::sort(order, order + 3, [&lengths](int a, int b) { return lengths[a] > lengths[b]; });
+    if (lengths[order[0]] < minimumAxisLength)
+    {
+      directions[order[0]][0] = 1.0;
+      directions[order[0]][1] = 0.0;
+      directions[order[0]][2] = 0.0;
+    }
+    if (lengths[order[1]] < minimumAxisLength)
+    {
+      vtkMath::Perpendiculars(directions[order[0]], directions[order[1]], directions[order[2]], 0.0);
+    }
+    else if (lengths[order[2]] < minimumAxisLength)
+    {
+      vtkMath::Cross(directions[order[0]], directions[order[1]], directions[order[2]]);
+      vtkMath::Normalize(directions[order[2]]);
+    }
+
+    for (int axisIndex=0; axisIndex<3; ++axisIndex)
+    {
+      for (int i=0; i<3; ++i)
+      {
+        node->Corner[i] -= inflation * directions[axisIndex][i];
+        node->Axes[axisIndex][i] += 2.0 * inflation * directions[axisIndex][i];
+      }
+    }
+
+    if (node->Kids)
+    {
+      InflateNode(node->Kids[0], inflation);
+      InflateNode(node->Kids[1], inflation);
+    }
+  }
+
+private:
+  vtkCollisionProxyOBBTree(const vtkCollisionProxyOBBTree&) = delete;
+  void operator=(const vtkCollisionProxyOBBTree&) = delete;
+};
+vtkStandardNewMacro(vtkCollisionProxyOBBTree);
+
+//----------------------------------------------------------------------------
+/// Callback of vtkOBBTree::IntersectWithOBBTree stopping the traversal at the first pair of overlapping leaf nodes
+int ReportLeafNodeOverlap(vtkOBBNode* vtkNotUsed(nodeA), vtkOBBNode* vtkNotUsed(nodeB),
+  vtkMatrix4x4* vtkNotUsed(transformBToA), void* overlapFoundPtr)
+{
+  *static_cast<bool*>(overlapFoundPtr) = true;
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+/// Check whether the leaf node boxes of two collision proxy OBB trees overlap.
+/// As the boxes of a collision proxy tree contain the original surface with the inflation distance around it,
+/// no overlap means that the original surfaces are farther from each other than the sum of the inflations.
+/// \param transformBToA Matrix buffer, reused between calls
+bool DoCollisionProxiesOverlap(vtkOBBTree* treeA, const double aToRas[16], vtkOBBTree* treeB, const double bToRas[16],
+  vtkMatrix4x4* transformBToA)
+{
+  GetTransformBToA(aToRas, bToRas, transformBToA);
+
+  bool overlapFound = false;
+  treeA->IntersectWithOBBTree(treeB, transformBToA, ReportLeafNodeOverlap, &overlapFound);
+  return overlapFound;
+}
+
+//----------------------------------------------------------------------------
+/// Create sample points on the triangles of a surface. Each triangle is sampled on a regular grid with edges
+/// not longer than the sample spacing, so every point of the surface is within the sample spacing from a sample.
+vtkSmartPointer<vtkPoints> CreateSurfaceSamplePoints(vtkPolyData* polyData, double sampleSpacing)
+{
+  vtkSmartPointer<vtkPoints> samplePoints = vtkSmartPointer<vtkPoints>::New();
+  if (!polyData || sampleSpacing <= 0.0)
+  {
+    return samplePoints;
+  }
+
+  vtkNew<vtkTriangleFilter> triangleFilter;
+  triangleFilter->SetInputData(polyData);
+  triangleFilter->PassVertsOff();
+  triangleFilter->PassLinesOff();
+  triangleFilter->Update();
+  vtkPolyData* triangles = triangleFilter->GetOutput();
+
+  vtkNew<vtkIdList> pointIds;
+  for (vtkIdType cellId=0; cellId<triangles->GetNumberOfCells(); ++cellId)
+  {
+    triangles->GetCellPoints(cellId, pointIds);
+    if (pointIds->GetNumberOfIds() != 3)
+    {
+      continue;
+    }
+    double points[3][3] = { { 0.0 } };
+    for (int vertexIndex=0; vertexIndex<3; ++vertexIndex)
+    {
+      triangles->GetPoint(pointIds->GetId(vertexIndex), points[vertexIndex]);
+    }
+    double longestEdgeLength = std::sqrt(std::max({ vtkMath::Distance2BetweenPoints(points[0], points[1]),
+      vtkMath::Distance2BetweenPoints(points[1], points[2]), vtkMath::Distance2BetweenPoints(points[2], points[0]) }));
+    int subdivisions = std::max(1, static_cast<int>(std::ceil(longestEdgeLength / sampleSpacing)));
+    for (int i=0; i<=subdivisions; ++i)
+    {
+      for (int j=0; i+j<=subdivisions; ++j)
+      {
+        double u = static_cast<double>(i) / subdivisions;
+        double v = static_cast<double>(j) / subdivisions;
+        double sample[3] = { 0.0, 0.0, 0.0 };
+        for (int k=0; k<3; ++k)
+        {
+          sample[k] = (1.0 - u - v) * points[0][k] + u * points[1][k] + v * points[2][k];
+        }
+        samplePoints->InsertNextPoint(sample);
+      }
+    }
+  }
+  return samplePoints;
+}
+
+//----------------------------------------------------------------------------
+/// Compute an upper bound of the distance of the points of a surface from its simplified version.
+/// As the distance from the simplified surface changes at most as much as the position does, the largest distance
+/// of the surface sample points plus the sample spacing bounds the distance of every point, not only of the vertices.
+/// \sa CreateSurfaceSamplePoints
+double ComputeSimplificationErrorBound(vtkPolyData* polyData, vtkPolyData* simplifiedPolyData, double sampleSpacing)
+{
+  vtkSmartPointer<vtkPoints> samplePoints = CreateSurfaceSamplePoints(polyData, sampleSpacing);
+  vtkNew<vtkImplicitPolyDataDistance> distanceToSimplified;
+  distanceToSimplified->SetInput(simplifiedPolyData);
+
+  double largestSampleDistance = 0.0;
+  double sample[3] = { 0.0, 0.0, 0.0 };
+  for (vtkIdType sampleId=0; sampleId<samplePoints->GetNumberOfPoints(); ++sampleId)
+  {
+    samplePoints->GetPoint(sampleId, sample);
+    largestSampleDistance = std::max(largestSampleDistance, std::fabs(distanceToSimplified->EvaluateFunction(sample)));
+  }
+  return largestSampleDistance + sampleSpacing;
+}
+
+//----------------------------------------------------------------------------
+/// Create simplified collision proxy of a treatment machine part or patient body surface.
+/// The surface is decimated to the triangle budget. The proxy itself is not inflated, instead the boxes of its
+/// OBB tree are inflated by the simplification error bound (and safety margin). \sa CreateCollisionProxyOBBTree
+/// \param simplificationError Output upper bound of the distance of any point of the surface from the proxy
+/// \return Collision proxy. If no simplification is needed, then the input surface itself.
+vtkSmartPointer<vtkPolyData> CreateCollisionProxy(vtkPolyData* polyData, int triangleBudget, double* simplificationError=nullptr)
+{
+  // Spacing (in mm) of the points sampled on the surface triangles for the simplification error bound
+  const double simplificationErrorSampleSpacing = 5.0;
+
+  if (simplificationError)
+  {
+    *simplificationError = 0.0;
+  }
+  vtkSmartPointer<vtkPolyData> proxyPolyData = polyData;
+  if (!polyData || polyData->GetNumberOfPoints() == 0 || triangleBudget <= 0 || polyData->GetNumberOfCells() <= triangleBudget)
+  {
+    return proxyPolyData;
+  }
+
+  vtkNew<vtkTriangleFilter> triangleFilter;
+  triangleFilter->SetInputData(polyData);
+  vtkNew<vtkQuadricDecimation> decimation;
+  decimation->SetInputConnection(triangleFilter->GetOutputPort());
+  triangleFilter->Update();
+  vtkIdType numberOfTriangles = triangleFilter->GetOutput()->GetNumberOfCells();
+  decimation->SetTargetReduction(1.0 - static_cast<double>(triangleBudget) / std::max<vtkIdType>(numberOfTriangles, 1));
+  decimation->Update();
+  proxyPolyData = vtkSmartPointer<vtkPolyData>::New();
+  proxyPolyData->DeepCopy(decimation->GetOutput());
+
+  if (simplificationError)
+  {
+    *simplificationError = ComputeSimplificationErrorBound(polyData, proxyPolyData, simplificationErrorSampleSpacing);
+  }
+  return proxyPolyData;
+}
+
+//----------------------------------------------------------------------------
+/// Build OBB tree of a collision proxy with the node boxes inflated by the given distance
+/// \return OBB tree, nullptr if the proxy has no cells
+vtkSmartPointer<vtkOBBTree> CreateCollisionProxyOBBTree(vtkPolyData* proxyPolyData, double inflation)
+{
+  if (!proxyPolyData || proxyPolyData->GetNumberOfCells() == 0)
+  {
+    return nullptr;
+  }
+  vtkSmartPointer<vtkCollisionProxyOBBTree> proxyOBBTree = vtkSmartPointer<vtkCollisionProxyOBBTree>::New();
+  proxyOBBTree->SetDataSet(proxyPolyData);
+  proxyOBBTree->BuildLocator();
+  proxyOBBTree->InflateNodes(inflation);
+  return proxyOBBTree;
+}
+
+//----------------------------------------------------------------------------
+/// Treatment machine part data cached across treatment machine loads
+struct TreatmentMachineCachePart
+{
+  /// Model file path and its modification time that the cached data was loaded from
+  std::string ModelFilePath;
+  long int ModelFileModifiedTime{0};
+  /// Part surface in the part coordinate frame (file to RAS transform applied).
+  /// It is private to the cache, model nodes get deep copies of it. The OBB trees and proxies are built on it.
+  vtkSmartPointer<vtkPolyData> PolyData;
+  vtkSmartPointer<vtkOBBTree> OBBTree;
+  /// Collision proxy, its simplification error bound and the triangle budget it was created with
+  vtkSmartPointer<vtkPolyData> CollisionProxy;
+  double CollisionProxyError{0.0};
+  int CollisionProxyTriangleBudget{0};
+  /// Inflated OBB tree of the collision proxy and the safety margin it was built with
+  vtkSmartPointer<vtkOBBTree> CollisionProxyOBBTree;
+  double CollisionProxySafetyMargin{0.0};
+};
+
+//----------------------------------------------------------------------------
+/// Treatment machine data cached across treatment machine loads for one descriptor file
+struct TreatmentMachineCacheEntry
+{
+  /// Modification time of the descriptor file that the entry was created from
+  long int DescriptorModifiedTime{0};
+  /// Parsed descriptor, nullptr until parsed successfully
+  std::shared_ptr<rapidjson::Document> Description;
+  TreatmentMachineCachePart Parts[vtkSlicerRoomsEyeViewModuleLogic::LastPartType];
+};
+
+//----------------------------------------------------------------------------
+/// Get cache entry of a treatment machine descriptor file. The cache is shared by all logic instances in the process.
+/// If the descriptor file was modified since the entry was created, then a new empty entry replaces it.
+std::shared_ptr<TreatmentMachineCacheEntry> GetTreatmentMachineCacheEntry(const std::string& descriptorFilePath)
+{
+  static std::mutex cacheMutex;
+  static std::map<std::string, std::shared_ptr<TreatmentMachineCacheEntry> > cache;
+
+  long int descriptorModifiedTime = vtksys::SystemTools::ModifiedTime(descriptorFilePath);
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  std::shared_ptr<TreatmentMachineCacheEntry>& entry = cache[descriptorFilePath];
+  if (!entry || entry->DescriptorModifiedTime != descriptorModifiedTime)
+  {
+    entry = std::make_shared<TreatmentMachineCacheEntry>();
+    entry->DescriptorModifiedTime = descriptorModifiedTime;
+  }
+  return entry;
+}
+
+//----------------------------------------------------------------------------
+/// Sample the signed distance from a surface on the slices of a distance field image in parallel.
+/// The implicit distance function is not thread safe, so each thread uses its own instance with its own copy of the surface.
+class SignedDistanceFieldFunctor
+{
+public:
+  SignedDistanceFieldFunctor(vtkPolyData* polyData, vtkImageData* distanceField)
+    : PolyData(polyData)
+    , DistanceField(distanceField)
+  {
+  }
+
+  void Initialize()
+  {
+    vtkNew<vtkPolyData> polyDataCopy;
+    {
+      std::lock_guard<std::mutex> lock(this->PolyDataMutex);
+      polyDataCopy->DeepCopy(this->PolyData);
+    }
+    this->LocalDistanceFunction.Local()->SetInput(polyDataCopy);
+  }
+
+  void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+  {
+    vtkImplicitPolyDataDistance* distanceFunction = this->LocalDistanceFunction.Local();
+    const double* origin = this->DistanceField->GetOrigin();
+    const double* spacing = this->DistanceField->GetSpacing();
+    const int* dimensions = this->DistanceField->GetDimensions();
+    float* distanceValues = static_cast<float*>(this->DistanceField->GetScalarPointer())
+      + beginSlice * static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+    double point[3] = { 0.0, 0.0, 0.0 };
+    for (vtkIdType k=beginSlice; k<endSlice; ++k)
+    {
+      point[2] = origin[2] + k * spacing[2];
+      for (int j=0; j<dimensions[1]; ++j)
+      {
+        point[1] = origin[1] + j * spacing[1];
+        for (int i=0; i<dimensions[0]; ++i)
+        {
+          point[0] = origin[0] + i * spacing[0];
+          *(distanceValues++) = static_cast<float>(distanceFunction->EvaluateFunction(point));
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+  }
+
+private:
+  vtkPolyData* PolyData;
+  vtkImageData* DistanceField;
+  std::mutex PolyDataMutex;
+  vtkSMPThreadLocalObject<vtkImplicitPolyDataDistance> LocalDistanceFunction;
+};
+
+//----------------------------------------------------------------------------
+/// Create signed distance field of a surface, sampled on a regular grid that covers the bounds of the surface
+/// extended by a margin. Values are negative inside the surface.
+/// \return Distance field image, nullptr if the surface is empty or the spacing is invalid
+vtkSmartPointer<vtkImageData> CreateSignedDistanceField(vtkPolyData* polyData, double spacing, double margin)
+{
+  if (!polyData || polyData->GetNumberOfCells() == 0 || spacing <= 0.0)
+  {
+    return nullptr;
+  }
+
+  double bounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  polyData->GetBounds(bounds);
+  margin = std::max(margin, 0.0);
+  double origin[3] = { 0.0, 0.0, 0.0 };
+  int dimensions[3] = { 0, 0, 0 };
+  for (int i=0; i<3; ++i)
+  {
+    origin[i] = bounds[2*i] - margin;
+    dimensions[i] = std::max(2, static_cast<int>(std::ceil((bounds[2*i+1] - bounds[2*i] + 2.0*margin) / spacing)) + 1);
+  }
+
+  vtkSmartPointer<vtkImageData> distanceField = vtkSmartPointer<vtkImageData>::New();
+  distanceField->SetOrigin(origin);
+  distanceField->SetSpacing(spacing, spacing, spacing);
+  distanceField->SetDimensions(dimensions);
+  distanceField->AllocateScalars(VTK_FLOAT, 1);
+
+  SignedDistanceFieldFunctor functor(polyData, distanceField);
+  vtkSMPTools::For(0, dimensions[2], functor);
+  return distanceField;
+}
+
+//----------------------------------------------------------------------------
+/// Get signed distance at a point from a distance field using trilinear interpolation.
+/// Outside the field the distance to the field boundary is added to the value at the closest boundary point,
+/// which is an upper bound of the real distance.
+double GetSignedDistance(vtkImageData* distanceField, const double point[3])
+{
+  const double* origin = distanceField->GetOrigin();
+  const double* spacing = distanceField->GetSpacing();
+  const int* dimensions = distanceField->GetDimensions();
+  const float* distanceValues = static_cast<const float*>(distanceField->GetScalarPointer());
+
+  int baseIndex[3] = { 0, 0, 0 };
+  double fraction[3] = { 0.0, 0.0, 0.0 };
+  double distanceOutsideSquared = 0.0;
+  for (int i=0; i<3; ++i)
+  {
+    double continuousIndex = (point[i] - origin[i]) / spacing[i];
+    if (continuousIndex < 0.0)
+    {
+      distanceOutsideSquared += continuousIndex * spacing[i] * continuousIndex * spacing[i];
+      continuousIndex = 0.0;
+    }
+    else if (continuousIndex > dimensions[i] - 1)
+    {
+      double distanceOutside = (continuousIndex - (dimensions[i] - 1)) * spacing[i];
+      distanceOutsideSquared += distanceOutside * distanceOutside;
+      continuousIndex = dimensions[i] - 1;
+    }
+    baseIndex[i] = std::min(static_cast<int>(continuousIndex), dimensions[i] - 2);
+    fraction[i] = continuousIndex - baseIndex[i];
+  }
+
+  const vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  const float* baseValue = distanceValues + baseIndex[2] * sliceSize + baseIndex[1] * dimensions[0] + baseIndex[0];
+  double distance = 0.0;
+  for (int corner=0; corner<8; ++corner)
+  {
+    int offsetI = (corner & 1);
+    int offsetJ = ((corner >> 1) & 1);
+    int offsetK = ((corner >> 2) & 1);
+    double weight = (offsetI ? fraction[0] : 1.0 - fraction[0])
+      * (offsetJ ? fraction[1] : 1.0 - fraction[1])
+      * (offsetK ? fraction[2] : 1.0 - fraction[2]);
+    distance += weight * baseValue[offsetK * sliceSize + offsetJ * dimensions[0] + offsetI];
+  }
+
+  return distance + std::sqrt(distanceOutsideSquared);
+}
+
+//----------------------------------------------------------------------------
+/// Get the minimum signed distance of a range of points from a distance field
+double GetMinimumSignedDistance(vtkPoints* points, const double pointsToField[16], vtkImageData* distanceField,
+  vtkIdType beginPointId, vtkIdType endPointId)
+{
+  double minimumDistance = VTK_DOUBLE_MAX;
+  double point[4] = { 0.0, 0.0, 0.0, 1.0 };
+  double fieldPoint[4] = { 0.0, 0.0, 0.0, 1.0 };
+  for (vtkIdType pointId=beginPointId; pointId<endPointId; ++pointId)
+  {
+    points->GetPoint(pointId, point);
+    vtkMatrix4x4::MultiplyPoint(pointsToField, point, fieldPoint);
+    minimumDistance = std::min(minimumDistance, GetSignedDistance(distanceField, fieldPoint));
+  }
+  return minimumDistance;
+}
+
+//----------------------------------------------------------------------------
+/// Compute the minimum signed distance of a set of points from a distance field in parallel
+class MinimumSignedDistanceFunctor
+{
+public:
+  MinimumSignedDistanceFunctor(vtkPoints* points, const double pointsToField[16], vtkImageData* distanceField)
+    : Points(points)
+    , DistanceField(distanceField)
+    , MinimumDistance(VTK_DOUBLE_MAX)
+  {
+    std::copy(pointsToField, pointsToField + 16, this->PointsToField);
+  }
+
+  void Initialize()
+  {
+    this->LocalMinimumDistance.Local() = VTK_DOUBLE_MAX;
+  }
+
+  void operator()(vtkIdType beginPointId, vtkIdType endPointId)
+  {
+    double& minimumDistance = this->LocalMinimumDistance.Local();
+    minimumDistance = std::min(minimumDistance,
+      GetMinimumSignedDistance(this->Points, this->PointsToField, this->DistanceField, beginPointId, endPointId));
+  }
+
+  void Reduce()
+  {
+    for (double localMinimumDistance : this->LocalMinimumDistance)
+    {
+      this->MinimumDistance = std::min(this->MinimumDistance, localMinimumDistance);
+    }
+  }
+
+  double GetMinimumDistance()
+  {
+    return this->MinimumDistance;
+  }
+
+private:
+  vtkPoints* Points;
+  vtkImageData* DistanceField;
+  double PointsToField[16];
+  double MinimumDistance;
+  vtkSMPThreadLocal<double> LocalMinimumDistance;
+};
+
+//----------------------------------------------------------------------------
+/// Coordinate frames of the parts taking part in the collision map computation
+enum CollisionMapFrame
+{
+  GantryFrame = 0,
+  CollimatorFrame,
+  PatientSupportFrame,
+  TableTopFrame,
+  PatientFrame,
+  NumberOfCollisionMapFrames
+};
+
+//----------------------------------------------------------------------------
+/// Pair of parts checked for collision in the collision map
+struct CollisionMapPartPair
+{
+  CollisionMapFrame FrameA;
+  CollisionMapFrame FrameB;
+  /// Inflated OBB trees of the collision proxies
+  vtkOBBTree* TreeA;
+  vtkOBBTree* TreeB;
+  /// OBB trees of the full resolution surfaces. Used to confirm contacts of the proxies if both are set.
+  vtkOBBTree* ExactTreeA;
+  vtkOBBTree* ExactTreeB;
+  vtkBoundingBox LocalBoxA;
+  vtkBoundingBox LocalBoxB;
+  /// Points sampled on the surface of part A and signed distance field of part B, in their own frames.
+  /// Used to compute the clearance of the pair if both are set.
+  vtkPoints* SamplePointsA;
+  vtkImageData* DistanceFieldB;
+  int Flag;
+};
+
+//----------------------------------------------------------------------------
+/// Evaluate collisions and minimum clearances for the poses of the collision map in parallel.
+/// The clearance of each pair is computed serially within a pose, the same way as in ComputeClearance.
+/// The pose dependent transforms are assembled the same way as in UpdateFixedReferenceToRASTransform,
+/// UpdateGantryToFixedReferenceTransform and UpdatePatientSupportRotationToFixedReferenceTransform,
+/// using thread-local transform objects. The part OBB trees, poly data, sample points and distance fields are only read.
+class CollisionMapFunctor
+{
+public:
+  CollisionMapFunctor(const std::vector<double>& gantryAngles, const std::vector<double>& patientSupportAngles,
+    const std::vector<CollisionMapPartPair>& pairs, vtkMatrix4x4* collimatorToGantry, vtkMatrix4x4* patientSupportToRotation,
+    vtkMatrix4x4* tableTopEccentricRotationToRotation, vtkMatrix4x4* tableTopToTableTopEccentricRotation, std::vector<int>& flags,
+    std::vector<double>& clearances)
+    : GantryAngles(gantryAngles)
+    , PatientSupportAngles(patientSupportAngles)
+    , Pairs(pairs)
+    , Flags(flags)
+    , Clearances(clearances)
+  {
+    vtkMatrix4x4::DeepCopy(this->CollimatorToGantry, collimatorToGantry);
+    vtkMatrix4x4::DeepCopy(this->PatientSupportToRotation, patientSupportToRotation);
+    vtkMatrix4x4::DeepCopy(this->TableTopEccentricRotationToRotation, tableTopEccentricRotationToRotation);
+    vtkMatrix4x4::DeepCopy(this->TableTopToTableTopEccentricRotation, tableTopToTableTopEccentricRotation);
+    vtkMatrix4x4::Invert(this->TableTopToTableTopEccentricRotation, this->TableTopEccentricRotationToTableTop);
+  }
+
+  void Initialize()
+  {
+  }
+
+  void operator()(vtkIdType beginPoseIndex, vtkIdType endPoseIndex)
+  {
+    vtkTransform* rotationTransform = this->RotationTransform.Local();
+    vtkMatrix4x4* transformBToA = this->TransformBToA.Local();
+    TriangleContactSearch search;
+    search.PointIdsA = this->PointIdsA.Local();
+    search.PointIdsB = this->PointIdsB.Local();
+
+    const vtkIdType numberOfGantryAngles = static_cast<vtkIdType>(this->GantryAngles.size());
+    for (vtkIdType poseIndex=beginPoseIndex; poseIndex<endPoseIndex; ++poseIndex)
+    {
+      double gantryAngle = this->GantryAngles[poseIndex % numberOfGantryAngles];
+      double patientSupportAngle = this->PatientSupportAngles[poseIndex / numberOfGantryAngles];
+
+      // Pose dependent rotations
+      double patientSupportRotationToFixedReference[16] = { 0.0 };
+      rotationTransform->Identity();
+      rotationTransform->RotateZ(patientSupportAngle);
+      vtkMatrix4x4::DeepCopy(patientSupportRotationToFixedReference, rotationTransform->GetMatrix());
+      double fixedReferenceToPatientSupportRotation[16] = { 0.0 };
+      vtkMatrix4x4::Invert(patientSupportRotationToFixedReference, fixedReferenceToPatientSupportRotation);
+      double gantryToFixedReference[16] = { 0.0 };
+      rotationTransform->Identity();
+      rotationTransform->RotateY(gantryAngle);
+      vtkMatrix4x4::DeepCopy(gantryToFixedReference, rotationTransform->GetMatrix());
+
+      // Part to RAS transforms
+      double frameToRas[NumberOfCollisionMapFrames][16];
+      double fixedReferenceToRas[16] = { 0.0 };
+      vtkMatrix4x4::Multiply4x4(this->TableTopEccentricRotationToTableTop, fixedReferenceToPatientSupportRotation, fixedReferenceToRas);
+      vtkMatrix4x4::Multiply4x4(fixedReferenceToRas, gantryToFixedReference, frameToRas[GantryFrame]);
+      vtkMatrix4x4::Multiply4x4(frameToRas[GantryFrame], this->CollimatorToGantry, frameToRas[CollimatorFrame]);
+      double patientSupportRotationToRas[16] = { 0.0 };
+      vtkMatrix4x4::Multiply4x4(fixedReferenceToRas, patientSupportRotationToFixedReference, patientSupportRotationToRas);
+      vtkMatrix4x4::Multiply4x4(patientSupportRotationToRas, this->PatientSupportToRotation, frameToRas[PatientSupportFrame]);
+      double tableTopEccentricRotationToRas[16] = { 0.0 };
+      vtkMatrix4x4::Multiply4x4(patientSupportRotationToRas, this->TableTopEccentricRotationToRotation, tableTopEccentricRotationToRas);
+      vtkMatrix4x4::Multiply4x4(tableTopEccentricRotationToRas, this->TableTopToTableTopEccentricRotation, frameToRas[TableTopFrame]);
+      vtkMatrix4x4::Identity(frameToRas[PatientFrame]);
+
+      int poseFlags = 0;
+      double poseClearance = VTK_DOUBLE_MAX;
+      for (const CollisionMapPartPair& pair : this->Pairs)
+      {
+        // Clearance is computed regardless of the bounding boxes, same as in CheckForCollisions
+        if (pair.SamplePointsA && pair.DistanceFieldB)
+        {
+          double fieldToRas[16] = { 0.0 };
+          vtkMatrix4x4::Invert(frameToRas[pair.FrameB], fieldToRas);
+          double samplePointsToField[16] = { 0.0 };
+          vtkMatrix4x4::Multiply4x4(fieldToRas, frameToRas[pair.FrameA], samplePointsToField);
+          poseClearance = std::min(poseClearance, GetMinimumSignedDistance(pair.SamplePointsA, samplePointsToField,
+            pair.DistanceFieldB, 0, pair.SamplePointsA->GetNumberOfPoints()));
+        }
+
+        // Broad phase
+        vtkBoundingBox worldBoxA;
+        GetWorldBoundingBox(pair.LocalBoxA, frameToRas[pair.FrameA], worldBoxA);
+        vtkBoundingBox worldBoxB;
+        GetWorldBoundingBox(pair.LocalBoxB, frameToRas[pair.FrameB], worldBoxB);
+        if (!worldBoxA.Intersects(worldBoxB))
+        {
+          continue;
+        }
+
+        // Narrow phase on the collision proxies, then confirmation on the full resolution surfaces
+        if (!DoCollisionProxiesOverlap(pair.TreeA, frameToRas[pair.FrameA], pair.TreeB, frameToRas[pair.FrameB], transformBToA))
+        {
+          continue;
+        }
+        if ( pair.ExactTreeA && pair.ExactTreeB
+          && !DoSurfacesIntersect(pair.ExactTreeA, frameToRas[pair.FrameA], pair.ExactTreeB, frameToRas[pair.FrameB], search, transformBToA) )
+        {
+          continue;
+        }
+        poseFlags |= pair.Flag;
+      }
+
+      // Each pose is written by exactly one thread
+      this->Flags[poseIndex] = poseFlags;
+      this->Clearances[poseIndex] = poseClearance;
+    }
+  }
+
+  void Reduce()
+  {
+  }
+
+private:
+  const std::vector<double>& GantryAngles;
+  const std::vector<double>& PatientSupportAngles;
+  const std::vector<CollisionMapPartPair>& Pairs;
+  std::vector<int>& Flags;
+  std::vector<double>& Clearances;
+
+  double CollimatorToGantry[16];
+  double PatientSupportToRotation[16];
+  double TableTopEccentricRotationToRotation[16];
+  double TableTopToTableTopEccentricRotation[16];
+  double TableTopEccentricRotationToTableTop[16];
+
+  vtkSMPThreadLocalObject<vtkTransform> RotationTransform;
+  vtkSMPThreadLocalObject<vtkMatrix4x4> TransformBToA;
+  vtkSMPThreadLocalObject<vtkIdList> PointIdsA;
+  vtkSMPThreadLocalObject<vtkIdList> PointIdsB;
+};
+
+//----------------------------------------------------------------------------
+/// Get indices of the samples surrounding a value in an ascending list of samples.
+/// If the value matches a sample, then both indices point to that sample. For periodic samples the last
+/// and first samples surround the values after the last sample.
+void GetSurroundingSampleIndices(const std::vector<double>& samples, double value, bool periodic, int& lowerIndex, int& upperIndex)
+{
+  const double tolerance = 1.0e-6;
+  upperIndex = static_cast<int>(std::lower_bound(samples.begin(), samples.end(), value - tolerance) - samples.begin());
+  if (upperIndex >= static_cast<int>(samples.size()))
+  {
+    lowerIndex = static_cast<int>(samples.size()) - 1;
+    upperIndex = (periodic ? 0 : lowerIndex);
+    return;
+  }
+  if (std::fabs(samples[upperIndex] - value) < tolerance)
+  {
+    lowerIndex = upperIndex;
+    return;
+  }
+  lowerIndex = upperIndex - 1;
+  if (lowerIndex < 0)
+  {
+    lowerIndex = (periodic ? static_cast<int>(samples.size()) - 1 : 0);
+  }
+}
+
+} // namespace
+
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerRoomsEyeViewModuleLogic);
@@ -87,6 +971,125 @@ public:
   vtkSlicerRoomsEyeViewModuleLogic* External; 
   rapidjson::Document* CurrentTreatmentMachineDescription{nullptr};
 
+  /// Cache entry of the current treatment machine. \sa GetTreatmentMachineCacheEntry
+  std::shared_ptr<TreatmentMachineCacheEntry> CurrentTreatmentMachineCacheEntry;
+  /// Flags indicating that the part model was loaded from file, so the cache needs to be updated when it is set up
+  bool PartCacheUpdateNeeded[LastPartType] = { false };
+  /// Surfaces of the part model nodes that are copies of the cached part surfaces
+  vtkWeakPointer<vtkPolyData> PartPolyDataCopiedFromCache[LastPartType];
+
+  /// Get cached data of a treatment machine part if the given part surface is a copy of the cached one
+  /// \return Cached part data, nullptr if there is no current cache entry or the surface is not a copy of the cached one
+  TreatmentMachineCachePart* GetCachedPart(TreatmentMachinePartType partType, vtkPolyData* partPolyData);
+
+  /// Bounding boxes of the treatment machine part models in their own (part) coordinate frame,
+  /// i.e. after applying the file to RAS transform. Computed once in SetupTreatmentMachineModels,
+  /// and used in the broad phase of collision detection. Invalid if the part is not loaded.
+  vtkBoundingBox PartLocalBoundingBoxes[LastPartType];
+
+  /// Cached patient body closed surface. It is the persistent second input of the patient collision
+  /// detection filters, so that their OBB trees are only rebuilt when the patient body actually changes.
+  vtkSmartPointer<vtkPolyData> PatientBodyPolyData;
+  /// Bounding box of the cached patient body surface in RAS
+  vtkBoundingBox PatientBodyBoundingBox;
+  /// Segmentation node ID, segment ID and modified time that the cached patient body surface was created from
+  std::string PatientBodySegmentationNodeID;
+  std::string PatientBodySegmentID;
+  vtkMTimeType PatientBodyModifiedTime{0};
+
+  /// Update cached patient body surface if the patient body segment selection or content has changed
+  /// \return True if valid patient body surface is available
+  bool UpdatePatientBodyPolyData(vtkMRMLRoomsEyeViewNode* parameterNode);
+
+  /// OBB trees of the treatment machine part models in their own coordinate frame, used for the collision map.
+  /// Built on demand, and reset when the part models are set up again.
+  vtkSmartPointer<vtkOBBTree> PartOBBTrees[LastPartType];
+  /// Simplified collision proxies of the treatment machine parts in their own coordinate frame, and the upper bounds
+  /// of the distance of the part surfaces from them. Created in SetupTreatmentMachineModels for the parts taking part
+  /// in collision detection. The proxy is the part surface itself (with zero error) if no simplification is needed.
+  vtkSmartPointer<vtkPolyData> PartCollisionProxies[LastPartType];
+  double PartCollisionProxyErrors[LastPartType] = { 0.0 };
+  /// OBB trees of the collision proxies with the node boxes inflated by the simplification error, so that they enclose
+  /// the part surface. The trees of the moving parts (gantry, collimator) are inflated by the safety margin as well,
+  /// so that the margin is applied once for each checked pair. Built on demand.
+  vtkSmartPointer<vtkOBBTree> PartCollisionProxyOBBTrees[LastPartType];
+  /// OBB tree of the cached patient body surface. Reset when the patient body surface changes.
+  vtkSmartPointer<vtkOBBTree> PatientBodyOBBTree;
+  /// Decimated patient body surface used for collision detection, the upper bound of the distance of the patient
+  /// body surface from it, and the triangle budget it was created with. Same as the patient body surface (with zero
+  /// error) if no decimation is needed. Reset when the patient body surface changes.
+  vtkSmartPointer<vtkPolyData> PatientBodyCollisionProxy;
+  double PatientBodyCollisionProxyError{0.0};
+  int PatientBodyCollisionProxyTriangleBudget{0};
+  /// OBB tree of the patient body collision proxy with the node boxes inflated by the simplification error,
+  /// so that they enclose the patient body surface. Reset together with the proxy.
+  vtkSmartPointer<vtkOBBTree> PatientBodyCollisionProxyOBBTree;
+
+  /// Get OBB tree of a treatment machine part, build it if necessary.
+  /// Also makes sure the cells of the part poly data are built, so that the tree can be used from multiple threads.
+  /// \return OBB tree, nullptr if the part model is not available
+  vtkOBBTree* GetPartOBBTree(vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType);
+  /// Get inflated OBB tree of the collision proxy of a treatment machine part, build it if necessary
+  /// \return OBB tree, nullptr if the collision proxy is not available
+  vtkOBBTree* GetPartCollisionProxyOBBTree(vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType);
+
+  /// Check collision of a treatment machine part with another part or the patient body. The inflated OBB trees of the
+  /// collision proxies are checked first, and their contacts are confirmed on the full resolution surfaces if enabled.
+  /// \param partTypeB Type of the second part, or LastPartType for the patient body
+  /// \param partBToRasTransform Transform of the second part, nullptr for identity
+  /// \return True if the parts collide (or are closer than the safety margin and exact confirmation is disabled)
+  bool DoPartsCollide(vtkMRMLRoomsEyeViewNode* parameterNode,
+    TreatmentMachinePartType partTypeA, vtkLinearTransform* partAToRasTransform,
+    TreatmentMachinePartType partTypeB, vtkLinearTransform* partBToRasTransform);
+
+  /// Confirm a contact found between the collision proxies by checking the full resolution surfaces.
+  /// \param partTypeB Type of the second part, or LastPartType for the patient body
+  /// \param partBToRasTransform Transform of the second part, nullptr for identity
+  /// \return True if the full resolution surfaces intersect or if exact confirmation is disabled
+  bool ConfirmCollisionProxyContact(vtkMRMLRoomsEyeViewNode* parameterNode,
+    TreatmentMachinePartType partTypeA, vtkLinearTransform* partAToRasTransform,
+    TreatmentMachinePartType partTypeB, vtkLinearTransform* partBToRasTransform);
+
+  /// Signed distance fields of the static parts used for clearance computation. Table top and patient support
+  /// fields are in the frame of the part, the patient body field is in RAS. Built on demand.
+  vtkSmartPointer<vtkImageData> PartDistanceFields[LastPartType];
+  vtkSmartPointer<vtkImageData> PatientBodyDistanceField;
+  /// Points sampled on the surfaces of the moving parts (gantry, collimator) for clearance computation. Built on demand.
+  vtkSmartPointer<vtkPoints> PartClearanceSamplePoints[LastPartType];
+  /// Clearance tolerance and distance field margin the current distance fields and sample points were built with
+  double ClearanceTolerance{0.0};
+  double DistanceFieldMargin{0.0};
+  /// Reset distance fields and sample points if the clearance tolerance or the distance field margin changed
+  void UpdateClearanceParameters(vtkMRMLRoomsEyeViewNode* parameterNode);
+  /// Get signed distance field of a static part, build it if necessary.
+  /// The grid spacing is chosen so that the interpolation error is at most half of the clearance tolerance.
+  /// \param partType Type of the static part, or LastPartType for the patient body
+  /// \return Distance field, nullptr if the part surface is not available
+  vtkImageData* GetDistanceField(vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType);
+  /// Get points sampled on the surface of a moving part, create them if necessary.
+  /// The sample spacing is half of the clearance tolerance. \sa CreateSurfaceSamplePoints
+  /// \return Sample points, nullptr if the part surface is not available
+  vtkPoints* GetClearanceSamplePoints(vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType);
+
+  /// Compute minimum clearance of a moving part from a static part by sampling the surface of the moving part
+  /// in the signed distance field of the static part. Within the distance field the result is within the clearance
+  /// tolerance of the exact clearance: the sampling error is at most the sample spacing, and the trilinear
+  /// interpolation error of a distance function is at most sqrt(3)/2 times the grid spacing.
+  /// \param staticPartType Type of the static part, or LastPartType for the patient body
+  /// \param staticPartToRasTransform Transform of the static part, nullptr for identity
+  /// \return Minimum clearance in mm (negative for penetration), VTK_DOUBLE_MAX if it cannot be computed
+  double ComputeClearance(vtkMRMLRoomsEyeViewNode* parameterNode,
+    TreatmentMachinePartType movingPartType, vtkLinearTransform* movingPartToRasTransform,
+    TreatmentMachinePartType staticPartType, vtkLinearTransform* staticPartToRasTransform);
+  /// Get OBB tree of the cached patient body surface, build it if necessary. \sa UpdatePatientBodyPolyData
+  vtkOBBTree* GetPatientBodyOBBTree();
+  /// Get decimated patient body surface for collision detection, create it if necessary or if the
+  /// triangle budget changed. \sa vtkMRMLRoomsEyeViewNode::PatientBodyCollisionTriangleBudget
+  /// \return Collision proxy of the cached patient body surface, nullptr if there is no patient body
+  vtkPolyData* GetPatientBodyCollisionProxy(vtkMRMLRoomsEyeViewNode* parameterNode);
+  /// Get inflated OBB tree of the patient body collision proxy, build it if necessary
+  vtkOBBTree* GetPatientBodyCollisionProxyOBBTree(vtkMRMLRoomsEyeViewNode* parameterNode);
+
   /// Utility function to get element for treatment machine part
   /// \return Json object if found, otherwise null Json object
   rapidjson::Value& GetTreatmentMachinePart(TreatmentMachinePartType partType);
@@ -97,6 +1100,14 @@ public:
   std::string GetTreatmentMachinePartModelName(vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType);
   vtkMRMLModelNode* GetTreatmentMachinePartModelNode(vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType);
   vtkMRMLModelNode* EnsureTreatmentMachinePartModelNode(vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType, bool optional=false);
+
+  /// Get PatientSupportToPatientSupportRotation transform (vertical scaling of the patient support) for the
+  /// vertical table top displacement in the parameter node. Only computes the transform, the scene is not changed.
+  /// \return Success flag
+  bool GetPatientSupportToPatientSupportRotationTransform(vtkMRMLRoomsEyeViewNode* parameterNode, vtkTransform* patientSupportScalingTransform);
+  /// Get TableTopToTableTopEccentricRotation matrix for the table top displacements in the parameter node.
+  /// Only computes the matrix, the scene is not changed.
+  void GetTableTopToTableTopEccentricRotationMatrix(vtkMRMLRoomsEyeViewNode* parameterNode, vtkMatrix4x4* tableTopToTableTopEccentricRotationMatrix);
 };
 
 //---------------------------------------------------------------------------
@@ -119,47 +1130,452 @@ vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::~vtkInternal()
 //---------------------------------------------------------------------------
 rapidjson::Value& vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetTreatmentMachinePart(TreatmentMachinePartType type)
 {
-  if (type >= TreatmentMachinePartType::LastPartType)
+  if (type >= TreatmentMachinePartType::LastPartType)
+  {
+    vtkErrorWithObjectMacro(this->External, "GetTreatmentMachinePart: Invalid part type given " << type);
+    return JSON_EMPTY_VALUE;
+  }
+  std::string typeStr = this->External->GetTreatmentMachinePartTypeAsString(type);
+  return this->GetTreatmentMachinePart(typeStr);
+}
+
+//---------------------------------------------------------------------------
+rapidjson::Value& vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetTreatmentMachinePart(std::string typeStr)
+{
+  if (this->CurrentTreatmentMachineDescription->IsNull())
+  {
+    vtkErrorWithObjectMacro(this->External, "GetTreatmentMachinePart: No treatment machine descriptor file loaded");
+    return JSON_EMPTY_VALUE;
+  }
+  rapidjson::Value::MemberIterator partsIt = this->CurrentTreatmentMachineDescription->FindMember("Part");
+  if (partsIt == this->CurrentTreatmentMachineDescription->MemberEnd() || !partsIt->value.IsArray())
+  {
+    vtkErrorWithObjectMacro(this->External, "GetTreatmentMachinePart: Failed to find parts array in treatment machine description");
+    return JSON_EMPTY_VALUE;
+  }
+  rapidjson::Value& partsArray = partsIt->value;
+
+  // Traverse parts and try to find the element with the given part type
+  for (rapidjson::SizeType index=0; index < partsArray.Size(); ++index)
+  {
+    rapidjson::Value& currentObject = partsArray[index];
+    if (currentObject.IsObject())
+    {
+      rapidjson::Value& currentType = currentObject["Type"];
+      if (currentType.IsString() && !typeStr.compare(currentType.GetString()))
+      {
+        return currentObject;
+      }
+    }
+  }
+
+  // Not found
+  return JSON_EMPTY_VALUE;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::UpdatePatientBodyPolyData(vtkMRMLRoomsEyeViewNode* parameterNode)
+{
+  vtkMRMLSegmentationNode* segmentationNode = (parameterNode ? parameterNode->GetPatientBodySegmentationNode() : nullptr);
+  const char* segmentID = (parameterNode ? parameterNode->GetPatientBodySegmentID() : nullptr);
+  vtkSegment* segment = ( (segmentationNode && segmentationNode->GetSegmentation() && segmentID)
+    ? segmentationNode->GetSegmentation()->GetSegment(segmentID) : nullptr );
+  if (!segment)
+  {
+    this->PatientBodyPolyData = nullptr;
+    this->PatientBodyOBBTree = nullptr;
+    this->PatientBodyCollisionProxy = nullptr;
+    this->PatientBodyCollisionProxyError = 0.0;
+    this->PatientBodyCollisionProxyOBBTree = nullptr;
+    this->PatientBodyDistanceField = nullptr;
+    this->PatientBodyBoundingBox.Reset();
+    this->PatientBodySegmentationNodeID.clear();
+    this->PatientBodySegmentID.clear();
+    this->PatientBodyModifiedTime = 0;
+    return false;
+  }
+
+  // Latest modification of anything the patient body surface depends on
+  vtkMTimeType modifiedTime = std::max(segmentationNode->GetMTime(), segmentationNode->GetSegmentation()->GetMTime());
+  modifiedTime = std::max(modifiedTime, segment->GetMTime());
+  std::vector<std::string> representationNames;
+  segment->GetContainedRepresentationNames(representationNames);
+  for (const std::string& representationName : representationNames)
+  {
+    vtkDataObject* representation = segment->GetRepresentation(representationName);
+    if (representation)
+    {
+      modifiedTime = std::max(modifiedTime, representation->GetMTime());
+    }
+  }
+  if (segmentationNode->GetParentTransformNode())
+  {
+    modifiedTime = std::max(modifiedTime, segmentationNode->GetParentTransformNode()->GetTransformToWorldMTime());
+  }
+
+  if ( this->PatientBodyPolyData
+    && this->PatientBodySegmentationNodeID == segmentationNode->GetID()
+    && this->PatientBodySegmentID == segmentID
+    && this->PatientBodyModifiedTime >= modifiedTime )
+  {
+    // Cached surface is up to date
+    return true;
+  }
+
+  vtkNew<vtkPolyData> patientBodyPolyData;
+  this->PatientBodyOBBTree = nullptr;
+  this->PatientBodyCollisionProxy = nullptr;
+  this->PatientBodyCollisionProxyError = 0.0;
+  this->PatientBodyCollisionProxyOBBTree = nullptr;
+  this->PatientBodyDistanceField = nullptr;
+  if (!this->External->GetPatientBodyPolyData(parameterNode, patientBodyPolyData))
+  {
+    this->PatientBodyPolyData = nullptr;
+    this->PatientBodyBoundingBox.Reset();
+    return false;
+  }
+
+  // Modify the cached poly data in place (instead of replacing it) so that it remains the input of the collision filters
+  if (!this->PatientBodyPolyData)
+  {
+    this->PatientBodyPolyData = vtkSmartPointer<vtkPolyData>::New();
+  }
+  this->PatientBodyPolyData->DeepCopy(patientBodyPolyData);
+  this->PatientBodyBoundingBox.SetBounds(this->PatientBodyPolyData->GetBounds());
+  this->PatientBodySegmentationNodeID = segmentationNode->GetID();
+  this->PatientBodySegmentID = segmentID;
+  this->PatientBodyModifiedTime = modifiedTime;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+TreatmentMachineCachePart* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetCachedPart(
+  TreatmentMachinePartType partType, vtkPolyData* partPolyData)
+{
+  if (!this->CurrentTreatmentMachineCacheEntry || !partPolyData || this->PartPolyDataCopiedFromCache[partType] != partPolyData)
+  {
+    return nullptr;
+  }
+  TreatmentMachineCachePart* cachedPart = &this->CurrentTreatmentMachineCacheEntry->Parts[partType];
+  return (cachedPart->PolyData ? cachedPart : nullptr);
+}
+
+//---------------------------------------------------------------------------
+vtkOBBTree* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetPartOBBTree(
+  vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType)
+{
+  if (this->PartOBBTrees[partType])
+  {
+    return this->PartOBBTrees[partType];
+  }
+
+  vtkMRMLModelNode* partModel = this->GetTreatmentMachinePartModelNode(parameterNode, partType);
+  vtkPolyData* partPolyData = (partModel ? partModel->GetPolyData() : nullptr);
+  if (!partPolyData || partPolyData->GetNumberOfCells() == 0)
+  {
+    return nullptr;
+  }
+
+  // Use the tree built for a previous load of the same treatment machine if possible.
+  // Otherwise build the tree on the cached surface, so that it does not refer to the surface of a model node.
+  TreatmentMachineCachePart* cachedPart = this->GetCachedPart(partType, partPolyData);
+  if (cachedPart && cachedPart->OBBTree)
+  {
+    this->PartOBBTrees[partType] = cachedPart->OBBTree;
+    return this->PartOBBTrees[partType];
+  }
+  if (cachedPart)
+  {
+    partPolyData = cachedPart->PolyData;
+  }
+
+  if (partPolyData->NeedToBuildCells())
+  {
+    partPolyData->BuildCells();
+  }
+  this->PartOBBTrees[partType] = vtkSmartPointer<vtkOBBTree>::New();
+  this->PartOBBTrees[partType]->SetDataSet(partPolyData);
+  this->PartOBBTrees[partType]->BuildLocator();
+  if (cachedPart)
+  {
+    cachedPart->OBBTree = this->PartOBBTrees[partType];
+  }
+  return this->PartOBBTrees[partType];
+}
+
+//---------------------------------------------------------------------------
+vtkOBBTree* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetPartCollisionProxyOBBTree(
+  vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType)
+{
+  if (this->PartCollisionProxyOBBTrees[partType])
+  {
+    return this->PartCollisionProxyOBBTrees[partType];
+  }
+
+  vtkPolyData* proxyPolyData = this->PartCollisionProxies[partType];
+  if (!parameterNode || !proxyPolyData || proxyPolyData->GetNumberOfCells() == 0)
+  {
+    return nullptr;
+  }
+  // Every checked pair contains exactly one moving part, so only those are inflated by the safety margin
+  double safetyMargin = 0.0;
+  if (partType == Gantry || partType == Collimator)
+  {
+    safetyMargin = std::max(parameterNode->GetCollisionProxySafetyMargin(), 0.0);
+  }
+
+  // Use the tree built for a previous load of the same treatment machine if possible
+  vtkMRMLModelNode* partModel = this->GetTreatmentMachinePartModelNode(parameterNode, partType);
+  TreatmentMachineCachePart* cachedPart = this->GetCachedPart(partType, (partModel ? partModel->GetPolyData() : nullptr));
+  if (cachedPart && cachedPart->CollisionProxy != proxyPolyData)
+  {
+    cachedPart = nullptr;
+  }
+  if (cachedPart && cachedPart->CollisionProxyOBBTree && cachedPart->CollisionProxySafetyMargin == safetyMargin)
+  {
+    this->PartCollisionProxyOBBTrees[partType] = cachedPart->CollisionProxyOBBTree;
+    return this->PartCollisionProxyOBBTrees[partType];
+  }
+
+  if (proxyPolyData->NeedToBuildCells())
+  {
+    proxyPolyData->BuildCells();
+  }
+  this->PartCollisionProxyOBBTrees[partType] = CreateCollisionProxyOBBTree(
+    proxyPolyData, this->PartCollisionProxyErrors[partType] + safetyMargin);
+  if (cachedPart)
+  {
+    cachedPart->CollisionProxyOBBTree = this->PartCollisionProxyOBBTrees[partType];
+    cachedPart->CollisionProxySafetyMargin = safetyMargin;
+  }
+  return this->PartCollisionProxyOBBTrees[partType];
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::DoPartsCollide(vtkMRMLRoomsEyeViewNode* parameterNode,
+  TreatmentMachinePartType partTypeA, vtkLinearTransform* partAToRasTransform,
+  TreatmentMachinePartType partTypeB, vtkLinearTransform* partBToRasTransform)
+{
+  if (!partAToRasTransform)
+  {
+    return false;
+  }
+  vtkOBBTree* proxyTreeA = this->GetPartCollisionProxyOBBTree(parameterNode, partTypeA);
+  vtkOBBTree* proxyTreeB = (partTypeB == LastPartType ? this->GetPatientBodyCollisionProxyOBBTree(parameterNode)
+    : this->GetPartCollisionProxyOBBTree(parameterNode, partTypeB));
+  if (!proxyTreeA || !proxyTreeB)
+  {
+    return false;
+  }
+
+  double identity[16] = { 0.0 };
+  vtkMatrix4x4::Identity(identity);
+  vtkNew<vtkMatrix4x4> transformBToA;
+  if (!DoCollisionProxiesOverlap(proxyTreeA, partAToRasTransform->GetMatrix()->GetData(),
+    proxyTreeB, (partBToRasTransform ? partBToRasTransform->GetMatrix()->GetData() : identity), transformBToA))
+  {
+    return false;
+  }
+  return this->ConfirmCollisionProxyContact(parameterNode, partTypeA, partAToRasTransform, partTypeB, partBToRasTransform);
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::ConfirmCollisionProxyContact(vtkMRMLRoomsEyeViewNode* parameterNode,
+  TreatmentMachinePartType partTypeA, vtkLinearTransform* partAToRasTransform,
+  TreatmentMachinePartType partTypeB, vtkLinearTransform* partBToRasTransform)
+{
+  if (!parameterNode || !parameterNode->GetCollisionProxyExactConfirmation() || !partAToRasTransform)
+  {
+    return true;
+  }
+  vtkOBBTree* treeA = this->GetPartOBBTree(parameterNode, partTypeA);
+  vtkOBBTree* treeB = (partTypeB == LastPartType ? this->GetPatientBodyOBBTree() : this->GetPartOBBTree(parameterNode, partTypeB));
+  if (!treeA || !treeB)
+  {
+    return true;
+  }
+
+  double identity[16] = { 0.0 };
+  vtkMatrix4x4::Identity(identity);
+  vtkNew<vtkIdList> pointIdsA;
+  vtkNew<vtkIdList> pointIdsB;
+  vtkNew<vtkMatrix4x4> transformBToA;
+  TriangleContactSearch search;
+  search.PointIdsA = pointIdsA;
+  search.PointIdsB = pointIdsB;
+  return DoSurfacesIntersect(treeA, partAToRasTransform->GetMatrix()->GetData(),
+    treeB, (partBToRasTransform ? partBToRasTransform->GetMatrix()->GetData() : identity), search, transformBToA);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::UpdateClearanceParameters(vtkMRMLRoomsEyeViewNode* parameterNode)
+{
+  if ( this->ClearanceTolerance == parameterNode->GetClearanceTolerance()
+    && this->DistanceFieldMargin == parameterNode->GetClearanceDistanceFieldMargin() )
+  {
+    return;
+  }
+  for (int partIdx=0; partIdx<LastPartType; ++partIdx)
+  {
+    this->PartDistanceFields[partIdx] = nullptr;
+    this->PartClearanceSamplePoints[partIdx] = nullptr;
+  }
+  this->PatientBodyDistanceField = nullptr;
+  this->ClearanceTolerance = parameterNode->GetClearanceTolerance();
+  this->DistanceFieldMargin = parameterNode->GetClearanceDistanceFieldMargin();
+}
+
+//---------------------------------------------------------------------------
+vtkImageData* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetDistanceField(
+  vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType)
+{
+  if (!parameterNode)
+  {
+    return nullptr;
+  }
+  this->UpdateClearanceParameters(parameterNode);
+  double spacing = this->ClearanceTolerance / std::sqrt(3.0);
+
+  if (partType == LastPartType)
+  {
+    if (!this->PatientBodyDistanceField)
+    {
+      this->PatientBodyDistanceField = CreateSignedDistanceField(this->PatientBodyPolyData, spacing, this->DistanceFieldMargin);
+    }
+    return this->PatientBodyDistanceField;
+  }
+
+  if (!this->PartDistanceFields[partType])
+  {
+    vtkMRMLModelNode* partModel = this->GetTreatmentMachinePartModelNode(parameterNode, partType);
+    this->PartDistanceFields[partType] = CreateSignedDistanceField(
+      (partModel ? partModel->GetPolyData() : nullptr), spacing, this->DistanceFieldMargin);
+  }
+  return this->PartDistanceFields[partType];
+}
+
+//---------------------------------------------------------------------------
+vtkPoints* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetClearanceSamplePoints(
+  vtkMRMLRoomsEyeViewNode* parameterNode, TreatmentMachinePartType partType)
+{
+  if (!parameterNode)
+  {
+    return nullptr;
+  }
+  this->UpdateClearanceParameters(parameterNode);
+  if (!this->PartClearanceSamplePoints[partType] && this->ClearanceTolerance > 0.0)
+  {
+    vtkMRMLModelNode* partModel = this->GetTreatmentMachinePartModelNode(parameterNode, partType);
+    if (partModel && partModel->GetPolyData())
+    {
+      this->PartClearanceSamplePoints[partType] = CreateSurfaceSamplePoints(partModel->GetPolyData(), 0.5 * this->ClearanceTolerance);
+    }
+  }
+  return this->PartClearanceSamplePoints[partType];
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::ComputeClearance(vtkMRMLRoomsEyeViewNode* parameterNode,
+  TreatmentMachinePartType movingPartType, vtkLinearTransform* movingPartToRasTransform,
+  TreatmentMachinePartType staticPartType, vtkLinearTransform* staticPartToRasTransform)
+{
+  vtkPoints* samplePoints = this->GetClearanceSamplePoints(parameterNode, movingPartType);
+  if (!samplePoints || samplePoints->GetNumberOfPoints() == 0 || !movingPartToRasTransform)
+  {
+    return VTK_DOUBLE_MAX;
+  }
+  vtkImageData* distanceField = this->GetDistanceField(parameterNode, staticPartType);
+  if (!distanceField)
+  {
+    return VTK_DOUBLE_MAX;
+  }
+
+  double rasToStaticPart[16] = { 0.0 };
+  vtkMatrix4x4::Identity(rasToStaticPart);
+  if (staticPartToRasTransform)
+  {
+    vtkMatrix4x4::Invert(staticPartToRasTransform->GetMatrix()->GetData(), rasToStaticPart);
+  }
+  double movingPartToStaticPart[16] = { 0.0 };
+  vtkMatrix4x4::Multiply4x4(rasToStaticPart, movingPartToRasTransform->GetMatrix()->GetData(), movingPartToStaticPart);
+
+  MinimumSignedDistanceFunctor functor(samplePoints, movingPartToStaticPart, distanceField);
+  vtkSMPTools::For(0, samplePoints->GetNumberOfPoints(), functor);
+  return functor.GetMinimumDistance();
+}
+
+//---------------------------------------------------------------------------
+vtkOBBTree* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetPatientBodyOBBTree()
+{
+  if (this->PatientBodyOBBTree)
+  {
+    return this->PatientBodyOBBTree;
+  }
+  if (!this->PatientBodyPolyData || this->PatientBodyPolyData->GetNumberOfCells() == 0)
+  {
+    return nullptr;
+  }
+
+  if (this->PatientBodyPolyData->NeedToBuildCells())
+  {
+    this->PatientBodyPolyData->BuildCells();
+  }
+  this->PatientBodyOBBTree = vtkSmartPointer<vtkOBBTree>::New();
+  this->PatientBodyOBBTree->SetDataSet(this->PatientBodyPolyData);
+  this->PatientBodyOBBTree->BuildLocator();
+  return this->PatientBodyOBBTree;
+}
+
+//---------------------------------------------------------------------------
+vtkPolyData* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetPatientBodyCollisionProxy(vtkMRMLRoomsEyeViewNode* parameterNode)
+{
+  if (!parameterNode || !this->PatientBodyPolyData)
   {
-    vtkErrorWithObjectMacro(this->External, "GetTreatmentMachinePart: Invalid part type given " << type);
-    return JSON_EMPTY_VALUE;
+    return nullptr;
   }
-  std::string typeStr = this->External->GetTreatmentMachinePartTypeAsString(type);
-  return this->GetTreatmentMachinePart(typeStr);
+
+  int triangleBudget = std::max(parameterNode->GetPatientBodyCollisionTriangleBudget(), 0);
+  if (this->PatientBodyCollisionProxy && this->PatientBodyCollisionProxyTriangleBudget == triangleBudget)
+  {
+    return this->PatientBodyCollisionProxy;
+  }
+
+  this->PatientBodyCollisionProxy = CreateCollisionProxy(
+    this->PatientBodyPolyData, triangleBudget, &this->PatientBodyCollisionProxyError);
+  this->PatientBodyCollisionProxyTriangleBudget = triangleBudget;
+  this->PatientBodyCollisionProxyOBBTree = nullptr;
+  return this->PatientBodyCollisionProxy;
 }
 
 //---------------------------------------------------------------------------
-rapidjson::Value& vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetTreatmentMachinePart(std::string typeStr)
+vtkOBBTree* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetPatientBodyCollisionProxyOBBTree(vtkMRMLRoomsEyeViewNode* parameterNode)
 {
-  if (this->CurrentTreatmentMachineDescription->IsNull())
+  vtkPolyData* proxyPolyData = this->GetPatientBodyCollisionProxy(parameterNode);
+  if (!proxyPolyData)
   {
-    vtkErrorWithObjectMacro(this->External, "GetTreatmentMachinePart: No treatment machine descriptor file loaded");
-    return JSON_EMPTY_VALUE;
+    return nullptr;
   }
-  rapidjson::Value::MemberIterator partsIt = this->CurrentTreatmentMachineDescription->FindMember("Part");
-  if (partsIt == this->CurrentTreatmentMachineDescription->MemberEnd() || !partsIt->value.IsArray())
+  if (proxyPolyData == this->PatientBodyPolyData)
   {
-    vtkErrorWithObjectMacro(this->External, "GetTreatmentMachinePart: Failed to find parts array in treatment machine description");
-    return JSON_EMPTY_VALUE;
+    return this->GetPatientBodyOBBTree();
   }
-  rapidjson::Value& partsArray = partsIt->value;
-
-  // Traverse parts and try to find the element with the given part type
-  for (rapidjson::SizeType index=0; index < partsArray.Size(); ++index)
+  if (this->PatientBodyCollisionProxyOBBTree)
   {
-    rapidjson::Value& currentObject = partsArray[index];
-    if (currentObject.IsObject())
-    {
-      rapidjson::Value& currentType = currentObject["Type"];
-      if (currentType.IsString() && !typeStr.compare(currentType.GetString()))
-      {
-        return currentObject;
-      }
-    }
+    return this->PatientBodyCollisionProxyOBBTree;
+  }
+  if (proxyPolyData->GetNumberOfCells() == 0)
+  {
+    return nullptr;
   }
 
-  // Not found
-  return JSON_EMPTY_VALUE;
+  if (proxyPolyData->NeedToBuildCells())
+  {
+    proxyPolyData->BuildCells();
+  }
+  // Only the simplification error is added to the patient, the gantry and collimator proxy trees it is checked
+  // against already include the safety margin
+  this->PatientBodyCollisionProxyOBBTree = CreateCollisionProxyOBBTree(proxyPolyData, this->PatientBodyCollisionProxyError);
+  return this->PatientBodyCollisionProxyOBBTree;
 }
 
 //---------------------------------------------------------------------------
@@ -288,11 +1704,40 @@ vtkMRMLModelNode* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::EnsureTreatment
     partModelFilePath = this->GetTreatmentMachinePartFullFilePath(parameterNode, partModelFilePath);
     if (vtksys::SystemTools::FileExists(partModelFilePath))
     {
-      // Create a models logic for convenient loading of components
-      vtkNew<vtkSlicerModelsLogic> modelsLogic;
-      modelsLogic->SetMRMLScene(scene);
-      partModelNode = modelsLogic->AddModel(partModelFilePath.c_str());
-      partModelNode->SetName(partName.c_str());
+      // Drop cached part data if it was loaded from another file or the file has been modified since
+      TreatmentMachineCachePart* cachedPart = nullptr;
+      if (this->CurrentTreatmentMachineCacheEntry)
+      {
+        cachedPart = &this->CurrentTreatmentMachineCacheEntry->Parts[partType];
+        long int modelFileModifiedTime = vtksys::SystemTools::ModifiedTime(partModelFilePath);
+        if (cachedPart->ModelFilePath != partModelFilePath || cachedPart->ModelFileModifiedTime != modelFileModifiedTime)
+        {
+          *cachedPart = TreatmentMachineCachePart();
+          cachedPart->ModelFilePath = partModelFilePath;
+          cachedPart->ModelFileModifiedTime = modelFileModifiedTime;
+        }
+      }
+
+      if (cachedPart && cachedPart->PolyData)
+      {
+        // Copy cached surface into a new model node. It is already in the part coordinate frame, so no storage node
+        // is added that would point to the model file; the scene creates a new one if the model is saved.
+        vtkNew<vtkPolyData> partPolyData;
+        partPolyData->DeepCopy(cachedPart->PolyData);
+        partModelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode", partName));
+        partModelNode->SetAndObservePolyData(partPolyData);
+        partModelNode->CreateDefaultDisplayNodes();
+        this->PartPolyDataCopiedFromCache[partType] = partPolyData;
+      }
+      else
+      {
+        // Create a models logic for convenient loading of components
+        vtkNew<vtkSlicerModelsLogic> modelsLogic;
+        modelsLogic->SetMRMLScene(scene);
+        partModelNode = modelsLogic->AddModel(partModelFilePath.c_str());
+        partModelNode->SetName(partName.c_str());
+        this->PartCacheUpdateNeeded[partType] = (cachedPart != nullptr);
+      }
       vtkIdType partItemID = shNode->GetItemByDataNode(partModelNode);
       shNode->SetItemParent(partItemID, rootFolderItem);
     }
@@ -305,6 +1750,58 @@ vtkMRMLModelNode* vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::EnsureTreatment
   return partModelNode;
 }
 
+//---------------------------------------------------------------------------
+bool vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetPatientSupportToPatientSupportRotationTransform(
+  vtkMRMLRoomsEyeViewNode* parameterNode, vtkTransform* patientSupportScalingTransform)
+{
+  if (!parameterNode || !patientSupportScalingTransform)
+  {
+    vtkErrorWithObjectMacro(this->External, "GetPatientSupportToPatientSupportRotationTransform: Invalid parameter node or output transform");
+    return false;
+  }
+
+  vtkMRMLModelNode* patientSupportModel = this->GetTreatmentMachinePartModelNode(parameterNode, PatientSupport);
+  vtkMRMLModelNode* tableTopModel = this->GetTreatmentMachinePartModelNode(parameterNode, TableTop);
+  if (!patientSupportModel || !patientSupportModel->GetPolyData() || !tableTopModel || !tableTopModel->GetPolyData())
+  {
+    vtkErrorWithObjectMacro(this->External, "GetPatientSupportToPatientSupportRotationTransform: Failed to access treatment machine part models");
+    return false;
+  }
+
+  // Get bounds of parts involved in computation
+  double patientSupportModelBounds[6] = { 0, 0, 0, 0, 0, 0 };
+  patientSupportModel->GetPolyData()->GetBounds(patientSupportModelBounds);
+  double tableTopModelBounds[6] = { 0, 0, 0, 0, 0, 0 };
+  tableTopModel->GetPolyData()->GetBounds(tableTopModelBounds);
+
+  // Translation to origin for in-place vertical scaling
+  patientSupportScalingTransform->Identity();
+  patientSupportScalingTransform->PostMultiply();
+  double patientSupportTranslationToOrigin[3] = { 0, 0, (-1.0) * patientSupportModelBounds[4]};
+  patientSupportScalingTransform->Translate(patientSupportTranslationToOrigin);
+
+  // Apply patient support vertical scale
+  double tableTopDisplacement = parameterNode->GetVerticalTableTopDisplacement();
+  double newPatientSupportHeight = /*tableTopModelBounds[4] + */patientSupportModelBounds[5] + tableTopDisplacement - patientSupportModelBounds[4];
+  double originalPatientSupportHeight = patientSupportModelBounds[5] - patientSupportModelBounds[4];
+  patientSupportScalingTransform->Scale(1.0, 1.0, newPatientSupportHeight / originalPatientSupportHeight);
+
+  // Translate back so that the patient support base is at the same height
+  double patientSupportTranslationFromOrigin[3] = { 0, 0, patientSupportModelBounds[4]};
+  patientSupportScalingTransform->Translate(patientSupportTranslationFromOrigin);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerRoomsEyeViewModuleLogic::vtkInternal::GetTableTopToTableTopEccentricRotationMatrix(
+  vtkMRMLRoomsEyeViewNode* parameterNode, vtkMatrix4x4* tableTopToTableTopEccentricRotationMatrix)
+{
+  tableTopToTableTopEccentricRotationMatrix->Identity();
+  tableTopToTableTopEccentricRotationMatrix->SetElement(0,3, parameterNode->GetLateralTableTopDisplacement());
+  tableTopToTableTopEccentricRotationMatrix->SetElement(1,3, parameterNode->GetLongitudinalTableTopDisplacement());
+  tableTopToTableTopEccentricRotationMatrix->SetElement(2,3, parameterNode->GetVerticalTableTopDisplacement());
+}
+
 //---------------------------------------------------------------------------
 // vtkSlicerRoomsEyeViewModuleLogic methods
 
@@ -479,22 +1976,41 @@ void vtkSlicerRoomsEyeViewModuleLogic::LoadTreatmentMachine(vtkMRMLRoomsEyeViewN
   std::string machineType = this->Internal->GetTreatmentMachineFileNameWithoutExtension(parameterNode);
 
   //
-  // Load treatment machine JSON descriptor file
-  FILE *fp = fopen(descriptorFilePath.c_str(), "r");
-  if (!fp)
+  // Load treatment machine JSON descriptor file, unless it is already parsed and has not changed since
+  std::shared_ptr<TreatmentMachineCacheEntry> cacheEntry = GetTreatmentMachineCacheEntry(descriptorFilePath);
+  for (int partIdx=0; partIdx<LastPartType; ++partIdx)
+  {
+    this->Internal->PartCacheUpdateNeeded[partIdx] = false;
+    // Model nodes already in the scene keep referring to the cached surfaces only if the cache entry is the same
+    if (cacheEntry != this->Internal->CurrentTreatmentMachineCacheEntry)
     {
-    vtkErrorMacro("LoadTreatmentMachine: Failed to load treatment machine descriptor file '" << descriptorFilePath << "'");
-    return;
+      this->Internal->PartPolyDataCopiedFromCache[partIdx] = nullptr;
     }
-  char buffer[4096];
-  rapidjson::FileReadStream fs(fp, buffer, sizeof(buffer));
-  if (this->Internal->CurrentTreatmentMachineDescription->ParseStream(fs).HasParseError())
-    {
-    vtkErrorMacro("LoadTreatmentMachine: Failed to load treatment machine descriptor file '" << descriptorFilePath << "'");
+  }
+  this->Internal->CurrentTreatmentMachineCacheEntry = cacheEntry;
+  std::shared_ptr<rapidjson::Document> description = this->Internal->CurrentTreatmentMachineCacheEntry->Description;
+  if (!description)
+  {
+    FILE *fp = fopen(descriptorFilePath.c_str(), "r");
+    if (!fp)
+      {
+      vtkErrorMacro("LoadTreatmentMachine: Failed to load treatment machine descriptor file '" << descriptorFilePath << "'");
+      return;
+      }
+    char buffer[4096];
+    rapidjson::FileReadStream fs(fp, buffer, sizeof(buffer));
+    description = std::make_shared<rapidjson::Document>();
+    if (description->ParseStream(fs).HasParseError())
+      {
+      vtkErrorMacro("LoadTreatmentMachine: Failed to load treatment machine descriptor file '" << descriptorFilePath << "'");
+      fclose(fp);
+      return;
+      }
     fclose(fp);
-    return;
-    }
-  fclose(fp);
+    this->Internal->CurrentTreatmentMachineCacheEntry->Description = description;
+  }
+  this->Internal->CurrentTreatmentMachineDescription->CopyFrom(
+    *description, this->Internal->CurrentTreatmentMachineDescription->GetAllocator());
 
   // Create subject hierarchy folder so that the treatment machine can be shown/hidden easily
   std::string subjectHierarchyFolderName = machineType + std::string("_Components");
@@ -537,6 +2053,13 @@ void vtkSlicerRoomsEyeViewModuleLogic::SetupTreatmentMachineModels(vtkMRMLRoomsE
   {
     std::string partType = this->GetTreatmentMachinePartTypeAsString((TreatmentMachinePartType)partIdx);
     vtkMRMLModelNode* partModel = this->Internal->GetTreatmentMachinePartModelNode(parameterNode, (TreatmentMachinePartType)partIdx);
+    this->Internal->PartLocalBoundingBoxes[partIdx].Reset();
+    this->Internal->PartOBBTrees[partIdx] = nullptr;
+    this->Internal->PartCollisionProxies[partIdx] = nullptr;
+    this->Internal->PartCollisionProxyErrors[partIdx] = 0.0;
+    this->Internal->PartCollisionProxyOBBTrees[partIdx] = nullptr;
+    this->Internal->PartDistanceFields[partIdx] = nullptr;
+    this->Internal->PartClearanceSamplePoints[partIdx] = nullptr;
     if (!partModel)
     {
       switch (partIdx)
@@ -552,9 +2075,14 @@ void vtkSlicerRoomsEyeViewModuleLogic::SetupTreatmentMachineModels(vtkMRMLRoomsE
     partModel->CreateDefaultDisplayNodes();
     partModel->GetDisplayNode()->SetColor((double)partColor[0] / 255.0, (double)partColor[1] / 255.0, (double)partColor[2] / 255.0);
 
-    // Apply file to RAS transform matrix
+    // Apply file to RAS transform matrix, unless the surface is attached from the cache and thus already transformed
+    TreatmentMachineCachePart* cachedPart = this->Internal->GetCachedPart((TreatmentMachinePartType)partIdx, partModel->GetPolyData());
     vtkNew<vtkMatrix4x4> fileToRASTransformMatrix;
-    if (this->GetFileToRASTransformMatrixForPartType(partType, fileToRASTransformMatrix))
+    if (cachedPart)
+    {
+      // Surface is already in the part coordinate frame
+    }
+    else if (this->GetFileToRASTransformMatrixForPartType(partType, fileToRASTransformMatrix))
     {
       vtkNew<vtkTransform> fileToRASTransform;
       fileToRASTransform->SetMatrix(fileToRASTransformMatrix);
@@ -565,11 +2093,59 @@ void vtkSlicerRoomsEyeViewModuleLogic::SetupTreatmentMachineModels(vtkMRMLRoomsE
       vtkNew<vtkPolyData> partPolyDataRAS;
       partPolyDataRAS->DeepCopy(transformPolyDataFilter->GetOutput());
       partModel->SetAndObservePolyData(partPolyDataRAS);
+
+      // Store a copy of the transformed surface in the cache if the part was just loaded from file
+      if (this->Internal->PartCacheUpdateNeeded[partIdx] && this->Internal->CurrentTreatmentMachineCacheEntry)
+      {
+        cachedPart = &this->Internal->CurrentTreatmentMachineCacheEntry->Parts[partIdx];
+        cachedPart->PolyData = vtkSmartPointer<vtkPolyData>::New();
+        cachedPart->PolyData->DeepCopy(partPolyDataRAS);
+        cachedPart->OBBTree = nullptr;
+        cachedPart->CollisionProxy = nullptr;
+        cachedPart->CollisionProxyOBBTree = nullptr;
+        this->Internal->PartPolyDataCopiedFromCache[partIdx] = partPolyDataRAS;
+      }
     }
     else
     {
       vtkErrorMacro("SetupTreatmentMachineModels: Failed to set file to RAS matrix for treatment machine part " << partType);
     }
+    this->Internal->PartCacheUpdateNeeded[partIdx] = false;
+
+    // Create collision proxy for the parts taking part in collision detection, and store the part bounds inflated by
+    // the safety margin for the broad phase of collision detection, so that it does not skip pairs within the margin.
+    // The proxy of a cached part is created from the cached surface, so that the cache does not refer to the model node.
+    vtkPolyData* collisionPolyData = partModel->GetPolyData();
+    if (partIdx == Collimator || partIdx == Gantry || partIdx == PatientSupport || partIdx == TableTop)
+    {
+      int triangleBudget = std::max(parameterNode->GetCollisionProxyTriangleBudget(), 0);
+      if (cachedPart && cachedPart->CollisionProxy && cachedPart->CollisionProxyTriangleBudget == triangleBudget)
+      {
+        this->Internal->PartCollisionProxies[partIdx] = cachedPart->CollisionProxy;
+        this->Internal->PartCollisionProxyErrors[partIdx] = cachedPart->CollisionProxyError;
+      }
+      else
+      {
+        this->Internal->PartCollisionProxies[partIdx] = CreateCollisionProxy((cachedPart ? cachedPart->PolyData.GetPointer() : collisionPolyData),
+          triangleBudget, &this->Internal->PartCollisionProxyErrors[partIdx]);
+        if (cachedPart)
+        {
+          cachedPart->CollisionProxy = this->Internal->PartCollisionProxies[partIdx];
+          cachedPart->CollisionProxyError = this->Internal->PartCollisionProxyErrors[partIdx];
+          cachedPart->CollisionProxyTriangleBudget = triangleBudget;
+          cachedPart->CollisionProxyOBBTree = nullptr;
+        }
+      }
+    }
+    if (collisionPolyData && collisionPolyData->GetNumberOfPoints() > 0)
+    {
+      this->Internal->PartLocalBoundingBoxes[partIdx].SetBounds(collisionPolyData->GetBounds());
+      // Only the moving parts are inflated by the safety margin, same as their collision proxy OBB trees
+      if (partIdx == Collimator || partIdx == Gantry)
+      {
+        this->Internal->PartLocalBoundingBoxes[partIdx].Inflate(std::max(parameterNode->GetCollisionProxySafetyMargin(), 0.0));
+      }
+    }
 
     // Setup transforms and collision detection
     if (partIdx == Collimator)
@@ -577,34 +2153,34 @@ void vtkSlicerRoomsEyeViewModuleLogic::SetupTreatmentMachineModels(vtkMRMLRoomsE
       vtkMRMLLinearTransformNode* collimatorToGantryTransformNode =
         this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::Collimator, vtkSlicerIECTransformLogic::Gantry);
       partModel->SetAndObserveTransformNodeID(collimatorToGantryTransformNode->GetID());
-      this->CollimatorTableTopCollisionDetection->SetInputData(0, partModel->GetPolyData());
+      this->CollimatorTableTopCollisionDetection->SetInputData(0, collisionPolyData);
       // Patient model is set when calculating collisions, as it can be changed dynamically
-      this->CollimatorPatientCollisionDetection->SetInputData(0, partModel->GetPolyData());
+      this->CollimatorPatientCollisionDetection->SetInputData(0, collisionPolyData);
     }
     else if (partIdx == Gantry)
     {
       vtkMRMLLinearTransformNode* gantryToFixedReferenceTransformNode =
         this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::Gantry, vtkSlicerIECTransformLogic::FixedReference);
       partModel->SetAndObserveTransformNodeID(gantryToFixedReferenceTransformNode->GetID());
-      this->GantryTableTopCollisionDetection->SetInputData(0, partModel->GetPolyData());
-      this->GantryPatientSupportCollisionDetection->SetInputData(0, partModel->GetPolyData());
+      this->GantryTableTopCollisionDetection->SetInputData(0, collisionPolyData);
+      this->GantryPatientSupportCollisionDetection->SetInputData(0, collisionPolyData);
       // Patient model is set when calculating collisions, as it can be changed dynamically
-      this->GantryPatientCollisionDetection->SetInputData(0, partModel->GetPolyData());
+      this->GantryPatientCollisionDetection->SetInputData(0, collisionPolyData);
     }
     else if (partIdx == PatientSupport)
     {
       vtkMRMLLinearTransformNode* patientSupportToPatientSupportRotationTransformNode =
         this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::PatientSupport, vtkSlicerIECTransformLogic::PatientSupportRotation);
       partModel->SetAndObserveTransformNodeID(patientSupportToPatientSupportRotationTransformNode->GetID());
-      this->GantryPatientSupportCollisionDetection->SetInputData(1, partModel->GetPolyData());
+      this->GantryPatientSupportCollisionDetection->SetInputData(1, collisionPolyData);
     }
     else if (partIdx == TableTop)
     {
       vtkMRMLLinearTransformNode* tableTopToTableTopEccentricRotationTransformNode =
         this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::TableTop, vtkSlicerIECTransformLogic::TableTopEccentricRotation);
       partModel->SetAndObserveTransformNodeID(tableTopToTableTopEccentricRotationTransformNode->GetID());
-      this->GantryTableTopCollisionDetection->SetInputData(1, partModel->GetPolyData());
-      this->CollimatorTableTopCollisionDetection->SetInputData(1, partModel->GetPolyData());
+      this->GantryTableTopCollisionDetection->SetInputData(1, collisionPolyData);
+      this->CollimatorTableTopCollisionDetection->SetInputData(1, collisionPolyData);
     }
     else if (partIdx == Body)
     {
@@ -644,6 +2220,15 @@ void vtkSlicerRoomsEyeViewModuleLogic::SetupTreatmentMachineModels(vtkMRMLRoomsE
   identityTransform->Identity();
   this->GantryPatientCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(identityTransform));
   this->CollimatorPatientCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(identityTransform));
+
+  // Only the existence of contacts is reported, so the narrow phase can stop at the first contact
+  this->GantryPatientCollisionDetection->SetCollisionModeToFirstContact();
+  this->GantryTableTopCollisionDetection->SetCollisionModeToFirstContact();
+  this->GantryPatientSupportCollisionDetection->SetCollisionModeToFirstContact();
+  this->CollimatorPatientCollisionDetection->SetCollisionModeToFirstContact();
+  this->CollimatorTableTopCollisionDetection->SetCollisionModeToFirstContact();
+  this->AdditionalModelsTableTopCollisionDetection->SetCollisionModeToFirstContact();
+  this->AdditionalModelsPatientSupportCollisionDetection->SetCollisionModeToFirstContact();
 }
 
 //----------------------------------------------------------------------------
@@ -1217,38 +2802,14 @@ void vtkSlicerRoomsEyeViewModuleLogic::UpdatePatientSupportToPatientSupportRotat
     vtkErrorMacro("UpdatePatientSupportToPatientSupportRotationTransform: Invalid scene");
     return;
   }
-  std::string machineType = this->Internal->GetTreatmentMachineFileNameWithoutExtension(parameterNode);
 
-  vtkMRMLModelNode* patientSupportModel = this->Internal->GetTreatmentMachinePartModelNode(parameterNode, PatientSupport);
-  vtkMRMLModelNode* tableTopModel = this->Internal->GetTreatmentMachinePartModelNode(parameterNode, TableTop);
-  if (!patientSupportModel || !patientSupportModel->GetPolyData() || !tableTopModel || !tableTopModel->GetPolyData())
+  vtkNew<vtkTransform> patientSupportScalingTransform;
+  if (!this->Internal->GetPatientSupportToPatientSupportRotationTransform(parameterNode, patientSupportScalingTransform))
   {
-    vtkErrorMacro("UpdatePatientSupportToPatientSupportRotationTransform: Failed to access treatment machine part models");
+    vtkErrorMacro("UpdatePatientSupportToPatientSupportRotationTransform: Failed to compute patient support scaling transform");
     return;
   }
 
-  // Get bounds of parts involved in computation
-  double patientSupportModelBounds[6] = { 0, 0, 0, 0, 0, 0 };
-  patientSupportModel->GetPolyData()->GetBounds(patientSupportModelBounds);
-  double tableTopModelBounds[6] = { 0, 0, 0, 0, 0, 0 };
-  tableTopModel->GetPolyData()->GetBounds(tableTopModelBounds);
-
-  // Translation to origin for in-place vertical scaling
-  vtkNew<vtkTransform> patientSupportScalingTransform;
-  patientSupportScalingTransform->PostMultiply();
-  double patientSupportTranslationToOrigin[3] = { 0, 0, (-1.0) * patientSupportModelBounds[4]};
-  patientSupportScalingTransform->Translate(patientSupportTranslationToOrigin);
-
-  // Apply patient support vertical scale
-  double tableTopDisplacement = parameterNode->GetVerticalTableTopDisplacement();
-  double newPatientSupportHeight = /*tableTopModelBounds[4] + */patientSupportModelBounds[5] + tableTopDisplacement - patientSupportModelBounds[4];
-  double originalPatientSupportHeight = patientSupportModelBounds[5] - patientSupportModelBounds[4];
-  patientSupportScalingTransform->Scale(1.0, 1.0, newPatientSupportHeight / originalPatientSupportHeight);
-
-  // Translate back so that the patient support base is at the same height
-  double patientSupportTranslationFromOrigin[3] = { 0, 0, patientSupportModelBounds[4]};
-  patientSupportScalingTransform->Translate(patientSupportTranslationFromOrigin);
-
   vtkMRMLLinearTransformNode* patientSupportToPatientSupportRotationTransformNode =
     this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::PatientSupport, vtkSlicerIECTransformLogic::PatientSupportRotation);
   patientSupportToPatientSupportRotationTransformNode->SetAndObserveTransformToParent(patientSupportScalingTransform);
@@ -1274,13 +2835,8 @@ void vtkSlicerRoomsEyeViewModuleLogic::UpdateTableTopToTableTopEccentricRotation
   vtkTransform* tableTopEccentricRotationToPatientSupportTransform = vtkTransform::SafeDownCast(
     tableTopToTableTopEccentricRotationTransformNode->GetTransformToParent() );
 
-  double translationArray[3] =
-    { parameterNode->GetLateralTableTopDisplacement(), parameterNode->GetLongitudinalTableTopDisplacement(), parameterNode->GetVerticalTableTopDisplacement() };
-
   vtkNew<vtkMatrix4x4> tableTopEccentricRotationToPatientSupportMatrix;
-  tableTopEccentricRotationToPatientSupportMatrix->SetElement(0,3, translationArray[0]);
-  tableTopEccentricRotationToPatientSupportMatrix->SetElement(1,3, translationArray[1]);
-  tableTopEccentricRotationToPatientSupportMatrix->SetElement(2,3, translationArray[2]);
+  this->Internal->GetTableTopToTableTopEccentricRotationMatrix(parameterNode, tableTopEccentricRotationToPatientSupportMatrix);
   tableTopEccentricRotationToPatientSupportTransform->SetMatrix(tableTopEccentricRotationToPatientSupportMatrix);
   tableTopEccentricRotationToPatientSupportTransform->Modified();
 }
@@ -1367,6 +2923,15 @@ std::string vtkSlicerRoomsEyeViewModuleLogic::CheckForCollisions(vtkMRMLRoomsEye
 
   std::string statusString = "";
 
+  // Clearances are not available unless computed below. The parameter node is modified only once,
+  // when the clearances are final.
+  int wasModified = parameterNode->StartModify();
+  parameterNode->SetGantryTableTopClearance(VTK_DOUBLE_MAX);
+  parameterNode->SetGantryPatientSupportClearance(VTK_DOUBLE_MAX);
+  parameterNode->SetCollimatorTableTopClearance(VTK_DOUBLE_MAX);
+  parameterNode->SetGantryPatientClearance(VTK_DOUBLE_MAX);
+  parameterNode->SetCollimatorPatientClearance(VTK_DOUBLE_MAX);
+
   // Get transforms used in the collision detection filters
   vtkMRMLLinearTransformNode* gantryToFixedReferenceTransformNode =
     this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::Gantry, vtkSlicerIECTransformLogic::FixedReference);
@@ -1382,6 +2947,7 @@ std::string vtkSlicerRoomsEyeViewModuleLogic::CheckForCollisions(vtkMRMLRoomsEye
   {
     statusString = "Failed to access IEC transforms";
     vtkErrorMacro("CheckForCollisions: " + statusString);
+    parameterNode->EndModify(wasModified);
     return statusString;
   }
 
@@ -1409,9 +2975,21 @@ std::string vtkSlicerRoomsEyeViewModuleLogic::CheckForCollisions(vtkMRMLRoomsEye
   {
     statusString = "Non-linear transform detected";
     vtkErrorMacro("CheckForCollisions: " + statusString);
+    parameterNode->EndModify(wasModified);
     return statusString;
   }
 
+  // Broad phase: compute world bounding boxes of the parts (inflated by the safety margin) from the current IEC transforms.
+  // Narrow phase (OBB tree based collision detection) is only performed for the pairs with overlapping boxes.
+  vtkBoundingBox gantryWorldBox;
+  GetWorldBoundingBox(this->Internal->PartLocalBoundingBoxes[Gantry], gantryToRasTransform, gantryWorldBox);
+  vtkBoundingBox patientSupportWorldBox;
+  GetWorldBoundingBox(this->Internal->PartLocalBoundingBoxes[PatientSupport], patientSupportToRasTransform, patientSupportWorldBox);
+  vtkBoundingBox collimatorWorldBox;
+  GetWorldBoundingBox(this->Internal->PartLocalBoundingBoxes[Collimator], collimatorToRasTransform, collimatorWorldBox);
+  vtkBoundingBox tableTopWorldBox;
+  GetWorldBoundingBox(this->Internal->PartLocalBoundingBoxes[TableTop], tableTopToRasTransform, tableTopWorldBox);
+
   // Get states of the treatment machine parts involved
   std::string collimatorState = this->GetStateForPartType(this->GetTreatmentMachinePartTypeAsString(Collimator));
   std::string gantryState = this->GetStateForPartType(this->GetTreatmentMachinePartTypeAsString(Gantry));
@@ -1420,37 +2998,22 @@ std::string vtkSlicerRoomsEyeViewModuleLogic::CheckForCollisions(vtkMRMLRoomsEye
 
   // If number of contacts between pieces of treatment room is greater than 0, the collision between which pieces
   // will be set to the output string and returned by the function.
-  if (gantryState == "Active" && tableTopState == "Active")
+  if ( gantryState == "Active" && tableTopState == "Active" && gantryWorldBox.Intersects(tableTopWorldBox)
+    && this->Internal->DoPartsCollide(parameterNode, Gantry, gantryToRasTransform, TableTop, tableTopToRasTransform) )
   {
-    this->GantryTableTopCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(gantryToRasTransform));
-    this->GantryTableTopCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(tableTopToRasTransform));
-    this->GantryTableTopCollisionDetection->Update();
-    if (this->GantryTableTopCollisionDetection->GetNumberOfContacts() > 0)
-    {
-      statusString = statusString + "Collision between gantry and table top\n";
-    }
+    statusString = statusString + "Collision between gantry and table top\n";
   }
 
-  if (gantryState == "Active" && patientSupportState == "Active")
+  if ( gantryState == "Active" && patientSupportState == "Active" && gantryWorldBox.Intersects(patientSupportWorldBox)
+    && this->Internal->DoPartsCollide(parameterNode, Gantry, gantryToRasTransform, PatientSupport, patientSupportToRasTransform) )
   {
-    this->GantryPatientSupportCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(gantryToRasTransform));
-    this->GantryPatientSupportCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(patientSupportToRasTransform));
-    this->GantryPatientSupportCollisionDetection->Update();
-    if (this->GantryPatientSupportCollisionDetection->GetNumberOfContacts() > 0)
-    {
-      statusString = statusString + "Collision between gantry and patient support\n";
-    }
+    statusString = statusString + "Collision between gantry and patient support\n";
   }
 
-  if (collimatorState == "Active" && tableTopState == "Active")
+  if ( collimatorState == "Active" && tableTopState == "Active" && collimatorWorldBox.Intersects(tableTopWorldBox)
+    && this->Internal->DoPartsCollide(parameterNode, Collimator, collimatorToRasTransform, TableTop, tableTopToRasTransform) )
   {
-    this->CollimatorTableTopCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(collimatorToRasTransform));
-    this->CollimatorTableTopCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(tableTopToRasTransform));
-    this->CollimatorTableTopCollisionDetection->Update();
-    if (this->CollimatorTableTopCollisionDetection->GetNumberOfContacts() > 0)
-    {
-      statusString = statusString + "Collision between collimator and table top\n";
-    }
+    statusString = statusString + "Collision between collimator and table top\n";
   }
 
   //TODO: Collision detection is disabled for additional devices, see SetupTreatmentMachineModels
@@ -1466,36 +3029,365 @@ std::string vtkSlicerRoomsEyeViewModuleLogic::CheckForCollisions(vtkMRMLRoomsEye
   //  statusString = statusString + "Collision between additional devices and patient support\n";
   //}
 
-  // Get patient body poly data
-  vtkNew<vtkPolyData> patientBodyPolyData;
-  if (this->GetPatientBodyPolyData(parameterNode, patientBodyPolyData))
+  // Get patient body poly data. The surface and its (optionally decimated) collision proxy are cached and only
+  // updated if the patient body changed, so that the OBB tree of the patient is not rebuilt on every transform change.
+  bool patientBodyAvailable = this->Internal->UpdatePatientBodyPolyData(parameterNode);
+  if (patientBodyAvailable)
   {
-    if (gantryState == "Active")
+    // Keep the patient input of the collision detection filters up to date for scripted use
+    vtkPolyData* patientBodyPolyData = this->Internal->PatientBodyPolyData;
+    if (this->GantryPatientCollisionDetection->GetInputDataObject(1, 0) != patientBodyPolyData)
     {
       this->GantryPatientCollisionDetection->SetInputData(1, patientBodyPolyData);
-      this->GantryPatientCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(gantryToRasTransform));
-      this->GantryPatientCollisionDetection->Update();
-      if (this->GantryPatientCollisionDetection->GetNumberOfContacts() > 0)
+    }
+    if (this->CollimatorPatientCollisionDetection->GetInputDataObject(1, 0) != patientBodyPolyData)
+    {
+      this->CollimatorPatientCollisionDetection->SetInputData(1, patientBodyPolyData);
+    }
+
+    const vtkBoundingBox& patientBodyWorldBox = this->Internal->PatientBodyBoundingBox;
+    if ( gantryState == "Active" && gantryWorldBox.Intersects(patientBodyWorldBox)
+      && this->Internal->DoPartsCollide(parameterNode, Gantry, gantryToRasTransform, LastPartType, nullptr) )
+    {
+      statusString = statusString + "Collision between gantry and patient\n";
+    }
+
+    if ( collimatorState == "Active" && collimatorWorldBox.Intersects(patientBodyWorldBox)
+      && this->Internal->DoPartsCollide(parameterNode, Collimator, collimatorToRasTransform, LastPartType, nullptr) )
+    {
+      statusString = statusString + "Collision between collimator and patient\n";
+    }
+  }
+
+  // Compute minimum clearances of the moving parts from the static parts. Unlike collision detection, this is done
+  // regardless of the bounding boxes, so that the clearance readout is always available.
+  double gantryTableTopClearance = VTK_DOUBLE_MAX;
+  double gantryPatientSupportClearance = VTK_DOUBLE_MAX;
+  double collimatorTableTopClearance = VTK_DOUBLE_MAX;
+  double gantryPatientClearance = VTK_DOUBLE_MAX;
+  double collimatorPatientClearance = VTK_DOUBLE_MAX;
+  if (gantryState == "Active" && tableTopState == "Active")
+  {
+    gantryTableTopClearance = this->Internal->ComputeClearance(
+      parameterNode, Gantry, gantryToRasTransform, TableTop, tableTopToRasTransform);
+  }
+  if (gantryState == "Active" && patientSupportState == "Active")
+  {
+    gantryPatientSupportClearance = this->Internal->ComputeClearance(
+      parameterNode, Gantry, gantryToRasTransform, PatientSupport, patientSupportToRasTransform);
+  }
+  if (collimatorState == "Active" && tableTopState == "Active")
+  {
+    collimatorTableTopClearance = this->Internal->ComputeClearance(
+      parameterNode, Collimator, collimatorToRasTransform, TableTop, tableTopToRasTransform);
+  }
+  if (patientBodyAvailable && gantryState == "Active")
+  {
+    gantryPatientClearance = this->Internal->ComputeClearance(
+      parameterNode, Gantry, gantryToRasTransform, LastPartType, nullptr);
+  }
+  if (patientBodyAvailable && collimatorState == "Active")
+  {
+    collimatorPatientClearance = this->Internal->ComputeClearance(
+      parameterNode, Collimator, collimatorToRasTransform, LastPartType, nullptr);
+  }
+
+  parameterNode->SetGantryTableTopClearance(gantryTableTopClearance);
+  parameterNode->SetGantryPatientSupportClearance(gantryPatientSupportClearance);
+  parameterNode->SetCollimatorTableTopClearance(collimatorTableTopClearance);
+  parameterNode->SetGantryPatientClearance(gantryPatientClearance);
+  parameterNode->SetCollimatorPatientClearance(collimatorPatientClearance);
+  parameterNode->EndModify(wasModified);
+
+  return statusString;
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkSlicerRoomsEyeViewModuleLogic::ComputeCollisionMap(vtkMRMLRoomsEyeViewNode* parameterNode)
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene || !parameterNode)
+  {
+    vtkErrorMacro("ComputeCollisionMap: Invalid scene or parameter set node");
+    return "Invalid parameters";
+  }
+
+  double gantryAngleStep = parameterNode->GetCollisionMapGantryAngleStep();
+  double patientSupportAngleMinimum = parameterNode->GetCollisionMapPatientSupportAngleMinimum();
+  double patientSupportAngleMaximum = parameterNode->GetCollisionMapPatientSupportAngleMaximum();
+  double patientSupportAngleStep = parameterNode->GetCollisionMapPatientSupportAngleStep();
+  if ( gantryAngleStep <= 0.0 || patientSupportAngleStep <= 0.0
+    || patientSupportAngleMaximum < patientSupportAngleMinimum || patientSupportAngleMaximum - patientSupportAngleMinimum >= 360.0 )
+  {
+    std::string errorMessage("Invalid collision map angle range or step");
+    vtkErrorMacro("ComputeCollisionMap: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Sample angles
+  const double angleTolerance = 1.0e-6;
+  std::vector<double> gantryAngles;
+  for (int gantryIndex=0; gantryIndex * gantryAngleStep < 360.0 - angleTolerance; ++gantryIndex)
+  {
+    gantryAngles.push_back(gantryIndex * gantryAngleStep);
+  }
+  std::vector<double> patientSupportAngles;
+  for (int patientSupportIndex=0;
+    patientSupportAngleMinimum + patientSupportIndex * patientSupportAngleStep <= patientSupportAngleMaximum + angleTolerance;
+    ++patientSupportIndex)
+  {
+    patientSupportAngles.push_back(patientSupportAngleMinimum + patientSupportIndex * patientSupportAngleStep);
+  }
+
+  // Compute the pose independent transforms from the parameter node the same way as the Update...Transform methods,
+  // but into private matrices, so that the transforms in the scene are not changed by the computation.
+  // Table top eccentric rotation is not supported, so that transform is the identity.
+  vtkNew<vtkTransform> collimatorToGantryTransform;
+  collimatorToGantryTransform->RotateZ(parameterNode->GetCollimatorRotationAngle());
+  vtkNew<vtkMatrix4x4> collimatorToGantryMatrix;
+  collimatorToGantryMatrix->DeepCopy(collimatorToGantryTransform->GetMatrix());
+  vtkNew<vtkTransform> patientSupportToPatientSupportRotationTransform;
+  if (!this->Internal->GetPatientSupportToPatientSupportRotationTransform(parameterNode, patientSupportToPatientSupportRotationTransform))
+  {
+    std::string errorMessage("Failed to compute patient support transform");
+    vtkErrorMacro("ComputeCollisionMap: " << errorMessage);
+    return errorMessage;
+  }
+  vtkNew<vtkMatrix4x4> patientSupportToPatientSupportRotationMatrix;
+  patientSupportToPatientSupportRotationMatrix->DeepCopy(patientSupportToPatientSupportRotationTransform->GetMatrix());
+  vtkNew<vtkMatrix4x4> tableTopEccentricRotationToPatientSupportRotationMatrix;
+  vtkNew<vtkMatrix4x4> tableTopToTableTopEccentricRotationMatrix;
+  this->Internal->GetTableTopToTableTopEccentricRotationMatrix(parameterNode, tableTopToTableTopEccentricRotationMatrix);
+
+  // Collect the part pairs to check, the same ones as in CheckForCollisions.
+  // Collision proxies are checked first, and their contacts are confirmed on the full resolution surfaces if requested.
+  bool exactConfirmation = parameterNode->GetCollisionProxyExactConfirmation();
+  vtkOBBTree* proxyTrees[LastPartType] = { nullptr };
+  vtkOBBTree* exactTrees[LastPartType] = { nullptr };
+  for (TreatmentMachinePartType partType : { Gantry, Collimator, PatientSupport, TableTop })
+  {
+    if (this->GetStateForPartType(this->GetTreatmentMachinePartTypeAsString(partType)) == "Active")
+    {
+      proxyTrees[partType] = this->Internal->GetPartCollisionProxyOBBTree(parameterNode, partType);
+      exactTrees[partType] = (exactConfirmation ? this->Internal->GetPartOBBTree(parameterNode, partType) : nullptr);
+    }
+  }
+  vtkOBBTree* patientBodyTree = nullptr;
+  vtkOBBTree* patientBodyExactTree = nullptr;
+  if (this->Internal->UpdatePatientBodyPolyData(parameterNode))
+  {
+    patientBodyTree = this->Internal->GetPatientBodyCollisionProxyOBBTree(parameterNode);
+    patientBodyExactTree = (exactConfirmation ? this->Internal->GetPatientBodyOBBTree() : nullptr);
+  }
+
+  std::vector<CollisionMapPartPair> pairs;
+  auto addPair = [&](CollisionMapFrame frameA, TreatmentMachinePartType partTypeA,
+    CollisionMapFrame frameB, TreatmentMachinePartType partTypeB, int flag)
+  {
+    // Part type B is LastPartType for the patient body
+    vtkOBBTree* treeA = proxyTrees[partTypeA];
+    vtkOBBTree* treeB = (partTypeB == LastPartType ? patientBodyTree : proxyTrees[partTypeB]);
+    if (!treeA || !treeB)
+    {
+      return;
+    }
+    CollisionMapPartPair pair;
+    pair.FrameA = frameA;
+    pair.FrameB = frameB;
+    pair.TreeA = treeA;
+    pair.TreeB = treeB;
+    pair.ExactTreeA = exactTrees[partTypeA];
+    pair.ExactTreeB = (partTypeB == LastPartType ? patientBodyExactTree : exactTrees[partTypeB]);
+    pair.LocalBoxA = this->Internal->PartLocalBoundingBoxes[partTypeA];
+    pair.LocalBoxB = (partTypeB == LastPartType ? this->Internal->PatientBodyBoundingBox : this->Internal->PartLocalBoundingBoxes[partTypeB]);
+    // Sample points and distance fields are built here, as they must not be built from multiple threads
+    pair.SamplePointsA = this->Internal->GetClearanceSamplePoints(parameterNode, partTypeA);
+    pair.DistanceFieldB = (pair.SamplePointsA ? this->Internal->GetDistanceField(parameterNode, partTypeB) : nullptr);
+    pair.Flag = flag;
+    pairs.push_back(pair);
+  };
+  addPair(GantryFrame, Gantry, TableTopFrame, TableTop, GantryTableTopCollision);
+  addPair(GantryFrame, Gantry, PatientSupportFrame, PatientSupport, GantryPatientSupportCollision);
+  addPair(CollimatorFrame, Collimator, TableTopFrame, TableTop, CollimatorTableTopCollision);
+  addPair(GantryFrame, Gantry, PatientFrame, LastPartType, GantryPatientCollision);
+  addPair(CollimatorFrame, Collimator, PatientFrame, LastPartType, CollimatorPatientCollision);
+
+  // Evaluate all poses
+  std::vector<int> poseFlags(gantryAngles.size() * patientSupportAngles.size(), 0);
+  std::vector<double> poseClearances(poseFlags.size(), VTK_DOUBLE_MAX);
+  CollisionMapFunctor functor(gantryAngles, patientSupportAngles, pairs, collimatorToGantryMatrix,
+    patientSupportToPatientSupportRotationMatrix, tableTopEccentricRotationToPatientSupportRotationMatrix,
+    tableTopToTableTopEccentricRotationMatrix, poseFlags, poseClearances);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(poseFlags.size()), functor);
+
+  // Get or create collision map table node
+  vtkMRMLTableNode* collisionMapTableNode = parameterNode->GetCollisionMapTableNode();
+  if (!collisionMapTableNode)
+  {
+    collisionMapTableNode = vtkMRMLTableNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLTableNode", "CollisionMap"));
+    parameterNode->SetAndObserveCollisionMapTableNode(collisionMapTableNode);
+  }
+
+  // Write map into table, one row per pose
+  vtkNew<vtkDoubleArray> patientSupportAngleColumn;
+  patientSupportAngleColumn->SetName(COLLISION_MAP_PATIENT_SUPPORT_ANGLE_COLUMN_NAME);
+  patientSupportAngleColumn->SetNumberOfValues(static_cast<vtkIdType>(poseFlags.size()));
+  vtkNew<vtkDoubleArray> gantryAngleColumn;
+  gantryAngleColumn->SetName(COLLISION_MAP_GANTRY_ANGLE_COLUMN_NAME);
+  gantryAngleColumn->SetNumberOfValues(static_cast<vtkIdType>(poseFlags.size()));
+  vtkNew<vtkIntArray> collisionsColumn;
+  collisionsColumn->SetName(COLLISION_MAP_COLLISIONS_COLUMN_NAME);
+  collisionsColumn->SetNumberOfValues(static_cast<vtkIdType>(poseFlags.size()));
+  vtkNew<vtkDoubleArray> minimumClearanceColumn;
+  minimumClearanceColumn->SetName(COLLISION_MAP_MINIMUM_CLEARANCE_COLUMN_NAME);
+  minimumClearanceColumn->SetNumberOfValues(static_cast<vtkIdType>(poseFlags.size()));
+  for (vtkIdType poseIndex=0; poseIndex<static_cast<vtkIdType>(poseFlags.size()); ++poseIndex)
+  {
+    patientSupportAngleColumn->SetValue(poseIndex, patientSupportAngles[poseIndex / gantryAngles.size()]);
+    gantryAngleColumn->SetValue(poseIndex, gantryAngles[poseIndex % gantryAngles.size()]);
+    collisionsColumn->SetValue(poseIndex, poseFlags[poseIndex]);
+    minimumClearanceColumn->SetValue(poseIndex, poseClearances[poseIndex]);
+  }
+  vtkNew<vtkTable> collisionMapTable;
+  collisionMapTable->AddColumn(patientSupportAngleColumn);
+  collisionMapTable->AddColumn(gantryAngleColumn);
+  collisionMapTable->AddColumn(collisionsColumn);
+  collisionMapTable->AddColumn(minimumClearanceColumn);
+  collisionMapTableNode->SetAndObserveTable(collisionMapTable);
+
+  return "";
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkSlicerRoomsEyeViewModuleLogic::ValidatePlanAgainstCollisionMap(
+  vtkMRMLRoomsEyeViewNode* parameterNode, vtkMRMLRTPlanNode* planNode)
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene || !parameterNode || !planNode)
+  {
+    vtkErrorMacro("ValidatePlanAgainstCollisionMap: Invalid scene, parameter set node or plan node");
+    return "Invalid parameters";
+  }
+  vtkMRMLTableNode* collisionMapTableNode = parameterNode->GetCollisionMapTableNode();
+  vtkTable* collisionMapTable = (collisionMapTableNode ? collisionMapTableNode->GetTable() : nullptr);
+  vtkDataArray* patientSupportAngleColumn = (collisionMapTable ?
+    vtkDataArray::SafeDownCast(collisionMapTable->GetColumnByName(COLLISION_MAP_PATIENT_SUPPORT_ANGLE_COLUMN_NAME)) : nullptr);
+  vtkDataArray* gantryAngleColumn = (collisionMapTable ?
+    vtkDataArray::SafeDownCast(collisionMapTable->GetColumnByName(COLLISION_MAP_GANTRY_ANGLE_COLUMN_NAME)) : nullptr);
+  vtkDataArray* collisionsColumn = (collisionMapTable ?
+    vtkDataArray::SafeDownCast(collisionMapTable->GetColumnByName(COLLISION_MAP_COLLISIONS_COLUMN_NAME)) : nullptr);
+  if (!patientSupportAngleColumn || !gantryAngleColumn || !collisionsColumn || collisionMapTable->GetNumberOfRows() < 1)
+  {
+    std::string errorMessage("Collision map is not available");
+    vtkErrorMacro("ValidatePlanAgainstCollisionMap: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Get sampled angles from the map, and arrange the flags of the poses into a grid of patient support and gantry angles
+  std::vector<double> patientSupportAngles;
+  std::vector<double> gantryAngles;
+  for (vtkIdType row=0; row<collisionMapTable->GetNumberOfRows(); ++row)
+  {
+    patientSupportAngles.push_back(patientSupportAngleColumn->GetTuple1(row));
+    gantryAngles.push_back(gantryAngleColumn->GetTuple1(row));
+  }
+  for (std::vector<double>* angles : { &patientSupportAngles, &gantryAngles })
+  {
+    std::sort(angles->begin(), angles->end());
+    angles->erase(std::unique(angles->begin(), angles->end()), angles->end());
+  }
+  std::vector<int> poseFlags(patientSupportAngles.size() * gantryAngles.size(), 0);
+  for (vtkIdType row=0; row<collisionMapTable->GetNumberOfRows(); ++row)
+  {
+    size_t patientSupportIndex = std::lower_bound(patientSupportAngles.begin(), patientSupportAngles.end(),
+      patientSupportAngleColumn->GetTuple1(row)) - patientSupportAngles.begin();
+    size_t gantryIndex = std::lower_bound(gantryAngles.begin(), gantryAngles.end(),
+      gantryAngleColumn->GetTuple1(row)) - gantryAngles.begin();
+    poseFlags[patientSupportIndex * gantryAngles.size() + gantryIndex] |= static_cast<int>(collisionsColumn->GetTuple1(row));
+  }
+
+  // Get beam poses to check. Beams in sequences are checked at every control point
+  std::vector<vtkMRMLRTBeamNode*> beams;
+  planNode->GetBeams(beams);
+  std::vector<vtkMRMLNode*> sequenceBrowserNodes;
+  scene->GetNodesByClass("vtkMRMLSequenceBrowserNode", sequenceBrowserNodes);
+  std::vector<vtkMRMLRTBeamNode*> beamPoses;
+  for (vtkMRMLRTBeamNode* beamNode : beams)
+  {
+    vtkMRMLSequenceNode* beamSequenceNode = nullptr;
+    for (vtkMRMLNode* node : sequenceBrowserNodes)
+    {
+      vtkMRMLSequenceBrowserNode* sequenceBrowserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(node);
+      if (sequenceBrowserNode && (beamSequenceNode = sequenceBrowserNode->GetSequenceNode(beamNode)))
+      {
+        break;
+      }
+    }
+    if (!beamSequenceNode)
+    {
+      beamPoses.push_back(beamNode);
+      continue;
+    }
+    for (int dataNodeIndex=0; dataNodeIndex<beamSequenceNode->GetNumberOfDataNodes(); ++dataNodeIndex)
+    {
+      vtkMRMLRTBeamNode* controlPointBeamNode = vtkMRMLRTBeamNode::SafeDownCast(beamSequenceNode->GetNthDataNode(dataNodeIndex));
+      if (controlPointBeamNode)
       {
-        statusString = statusString + "Collision between gantry and patient\n";
+        beamPoses.push_back(controlPointBeamNode);
       }
     }
+  }
+
+  // Look up poses in the map
+  std::string statusString = "";
+  for (vtkMRMLRTBeamNode* beamNode : beamPoses)
+  {
+    double gantryAngle = std::fmod(beamNode->GetGantryAngle(), 360.0);
+    gantryAngle = (gantryAngle < 0.0 ? gantryAngle + 360.0 : gantryAngle);
+    double patientSupportAngle = std::fmod(
+      GetPatientSupportRotationAngleForCouchAngle(beamNode->GetCouchAngle()) - patientSupportAngles.front(), 360.0);
+    patientSupportAngle = (patientSupportAngle < 0.0 ? patientSupportAngle + 360.0 : patientSupportAngle) + patientSupportAngles.front();
 
-    if (collimatorState == "Active")
+    std::ostringstream poseStream;
+    poseStream << beamNode->GetName() << " (gantry " << beamNode->GetGantryAngle() << ", couch " << beamNode->GetCouchAngle() << ")";
+    if (patientSupportAngle > patientSupportAngles.back() + 1.0e-6)
     {
-      this->CollimatorPatientCollisionDetection->SetInputData(1, patientBodyPolyData);
-      this->CollimatorPatientCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(collimatorToRasTransform));
-      this->CollimatorPatientCollisionDetection->Update();
-      if (this->CollimatorPatientCollisionDetection->GetNumberOfContacts() > 0)
+      statusString += "Pose outside collision map: " + poseStream.str() + "\n";
+      continue;
+    }
+
+    int lowerGantryIndex = 0;
+    int upperGantryIndex = 0;
+    GetSurroundingSampleIndices(gantryAngles, gantryAngle, true, lowerGantryIndex, upperGantryIndex);
+    int lowerPatientSupportIndex = 0;
+    int upperPatientSupportIndex = 0;
+    GetSurroundingSampleIndices(patientSupportAngles, patientSupportAngle, false, lowerPatientSupportIndex, upperPatientSupportIndex);
+
+    int flags = 0;
+    for (int gantryIndex : { lowerGantryIndex, upperGantryIndex })
+    {
+      for (int patientSupportIndex : { lowerPatientSupportIndex, upperPatientSupportIndex })
       {
-        statusString = statusString + "Collision between collimator and patient\n";
+        flags |= poseFlags[patientSupportIndex * gantryAngles.size() + gantryIndex];
       }
     }
+    if (flags)
+    {
+      statusString += "Collision between " + GetCollisionPairFlagsAsString(flags) + ": " + poseStream.str() + "\n";
+    }
   }
 
   return statusString;
 }
 
+//---------------------------------------------------------------------------
+double vtkSlicerRoomsEyeViewModuleLogic::GetPatientSupportRotationAngleForCouchAngle(double couchAngle)
+{
+  // The IEC transform logic sets PatientSupportRotationToFixedReference to RotateZ(-couchAngle),
+  // while UpdatePatientSupportRotationToFixedReferenceTransform uses RotateZ(patientSupportRotationAngle)
+  return -1.0 * couchAngle;
+}
+
 //---------------------------------------------------------------------------
 const char* vtkSlicerRoomsEyeViewModuleLogic::GetTreatmentMachinePartTypeAsString(TreatmentMachinePartType type)
 {
@@ -42,6 +42,7 @@ class vtkVector3d;
 
 class vtkMRMLRoomsEyeViewNode;
 class vtkMRMLModelNode;
+class vtkMRMLRTPlanNode;
 class vtkSlicerIECTransformLogic;
 
 /// \ingroup SlicerRt_QtModules_RoomsEyeView
@@ -66,7 +67,23 @@ public:
     LastPartType
     }; 
 
+  /// Pairs of treatment room parts checked for collision. Used as bit flags in the collision map
+  /// \sa ComputeCollisionMap
+  enum CollisionPairFlags
+    {
+    GantryTableTopCollision = 1,
+    GantryPatientSupportCollision = 2,
+    CollimatorTableTopCollision = 4,
+    GantryPatientCollision = 8,
+    CollimatorPatientCollision = 16
+    };
+
   static const char* ORIENTATION_MARKER_MODEL_NODE_NAME;
+  /// Column names of the collision map table. \sa ComputeCollisionMap
+  static const char* COLLISION_MAP_PATIENT_SUPPORT_ANGLE_COLUMN_NAME;
+  static const char* COLLISION_MAP_GANTRY_ANGLE_COLUMN_NAME;
+  static const char* COLLISION_MAP_COLLISIONS_COLUMN_NAME;
+  static const char* COLLISION_MAP_MINIMUM_CLEARANCE_COLUMN_NAME;
 
 public:
   static vtkSlicerRoomsEyeViewModuleLogic *New();
@@ -76,8 +93,13 @@ public:
 public:
   /// Load and setup components of the treatment machine into the scene based on its description.
   /// \param parameterNode Parameter node contains the treatment machine descriptor file path.
+  /// The parsed descriptor, the part surfaces in the part coordinate frames, their collision proxies and OBB trees are
+  /// cached for the process, keyed on the descriptor file path and the modification times of the descriptor and model
+  /// files. Loading a machine again only copies the cached surfaces into new model nodes and reuses the cached data.
   void LoadTreatmentMachine(vtkMRMLRoomsEyeViewNode* parameterNode);
-  /// Set up the IEC transforms and model properties on the treatment machine models
+  /// Set up the IEC transforms and model properties on the treatment machine models.
+  /// Also creates the simplified collision proxies of the parts that take part in collision detection,
+  /// based on the triangle budget in the parameter node.
   void SetupTreatmentMachineModels(vtkMRMLRoomsEyeViewNode* parameterNode);
   /// Create or get transforms taking part in the IEC logic and additional devices, and build the transform hierarchy
   void BuildRoomsEyeViewTransformHierarchy();
@@ -113,10 +135,46 @@ public:
   /// Update orientation marker based on the current transforms
   vtkMRMLModelNode* UpdateTreatmentOrientationMarker(vtkMRMLRoomsEyeViewNode* parameterNode);
 
-  /// Check for collisions between pieces of linac model using vtkCollisionDetectionFilter
+  /// Check for collisions between pieces of linac model.
+  /// World bounding boxes of the parts are checked first, and only pairs of parts whose bounding boxes overlap are
+  /// checked further. The OBB trees of the collision proxies have their boxes inflated by the simplification error
+  /// bound, so that they enclose the part surfaces, and those of the gantry and collimator also by the safety margin,
+  /// so that it is applied once for each pair; pairs whose inflated boxes overlap are reported, and confirmed on the
+  /// full resolution surfaces if enabled in the parameter node.
+  /// The collision detection filters are kept set up with the full resolution surfaces for scripted use.
+  /// The minimum clearances of the part pairs are also computed and set in the parameter node, within the clearance
+  /// tolerance set in the parameter node. Points sampled on the surface of the moving part (gantry, collimator) are
+  /// looked up in the signed distance field of the static part (table top and patient support in their own frame,
+  /// patient body), which is computed once in parallel and reused for all poses.
+  /// The parameter node is modified once, after all clearances are set.
   /// \return string indicating whether collision occurred
   std::string CheckForCollisions(vtkMRMLRoomsEyeViewNode* parameterNode);
 
+  /// Compute collision map over the full gantry rotation and the patient support angle range set in the parameter node.
+  /// Collimator angle, patient support vertical displacement and table top displacements are taken from the parameter node.
+  /// The poses are evaluated in parallel using the OBB trees of the parts on private transforms, the transforms
+  /// in the scene are not changed.
+  /// The result is stored in the collision map table node of the parameter node (created if missing), which contains
+  /// one row per pose with the patient support rotation angle, the gantry angle, and the combination of the
+  /// \sa CollisionPairFlags of the colliding part pairs (zero meaning no collision), and the minimum clearance of the
+  /// checked part pairs in mm, computed from the signed distance fields the same way as in CheckForCollisions
+  /// (VTK_DOUBLE_MAX if the clearance tolerance is not positive or no pair is checked).
+  /// Patient support angles are in the room's eye view convention. \sa GetPatientSupportRotationAngleForCouchAngle
+  /// \return Error message, empty string on success
+  std::string ComputeCollisionMap(vtkMRMLRoomsEyeViewNode* parameterNode);
+
+  /// Validate beams of a plan against the collision map of the parameter node.
+  /// For beams driven by a sequence (e.g. dynamic beams loaded from DICOM), every control point in the sequence is checked.
+  /// A pose is considered colliding if any of the surrounding poses of the collision map collides.
+  /// The couch angle of the beams is converted to patient support rotation angle. \sa GetPatientSupportRotationAngleForCouchAngle
+  /// \return String listing the colliding beams and control points, empty string if no collision is found
+  std::string ValidatePlanAgainstCollisionMap(vtkMRMLRoomsEyeViewNode* parameterNode, vtkMRMLRTPlanNode* planNode);
+
+  /// Get patient support rotation angle (as in the parameter node) for a beam couch angle.
+  /// The IEC transform logic rotates the patient support by the negative couch angle, so the patient support
+  /// rotation angle resulting in the same patient support pose is the negative of the couch angle.
+  static double GetPatientSupportRotationAngleForCouchAngle(double couchAngle);
+
 // Additional device related methods
 public:
   /// Load basic additional devices (deployed with SlicerRT)
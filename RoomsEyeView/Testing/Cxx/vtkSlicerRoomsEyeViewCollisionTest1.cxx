@@ -0,0 +1,558 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Room's eye view includes
+#include "vtkMRMLRoomsEyeViewNode.h"
+#include "vtkSlicerRoomsEyeViewModuleLogic.h"
+
+// Beams includes
+#include "vtkMRMLRTBeamNode.h"
+#include "vtkMRMLRTPlanNode.h"
+#include "vtkSlicerBeamsModuleLogic.h"
+#include "vtkSlicerIECTransformLogic.h"
+
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+
+// SegmentationCore includes
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
+
+// VTK includes
+#include <vtkAppendPolyData.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCubeSource.h>
+#include <vtkDataArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPolyDataWriter.h>
+#include <vtkSphereSource.h>
+#include <vtkTable.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cmath>
+#include <fstream>
+#include <string>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Write an axis-aligned box surface to a legacy VTK file in RAS coordinates
+  bool WriteBox(const std::string& fileName, double xMin, double xMax, double yMin, double yMax, double zMin, double zMax)
+  {
+    vtkNew<vtkCubeSource> cubeSource;
+    cubeSource->SetBounds(xMin, xMax, yMin, yMax, zMin, zMax);
+    vtkNew<vtkPolyDataWriter> writer;
+    writer->SetInputConnection(cubeSource->GetOutputPort());
+    writer->SetHeader("SPACE=RAS");
+    writer->SetFileName(fileName.c_str());
+    return writer->Write() != 0;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Write the descriptor of a treatment machine whose part models are written in the same directory.
+  /// Collimator and patient support are passive, so only the gantry and table top pair is checked.
+  bool WriteTreatmentMachineDescriptor(const std::string& directory, std::string& descriptorFilePath)
+  {
+    descriptorFilePath = directory + "/BoxMachine.json";
+    std::ofstream descriptorFile(descriptorFilePath.c_str());
+    if (!descriptorFile.is_open())
+    {
+      return false;
+    }
+    const char* identityMatrix = "[[1,0,0,0],[0,1,0,0],[0,0,1,0],[0,0,0,1]]";
+    descriptorFile << "{ \"Part\": [\n"
+      << "  { \"Type\": \"Collimator\", \"Name\": \"Collimator\", \"FilePath\": \"Collimator.vtk\", \"FileToRASTransformMatrix\": "
+      << identityMatrix << ", \"Color\": [255,255,255], \"State\": \"Passive\" },\n"
+      << "  { \"Type\": \"Gantry\", \"Name\": \"Gantry\", \"FilePath\": \"Gantry.vtk\", \"FileToRASTransformMatrix\": "
+      << identityMatrix << ", \"Color\": [255,255,255], \"State\": \"Active\" },\n"
+      << "  { \"Type\": \"PatientSupport\", \"Name\": \"PatientSupport\", \"FilePath\": \"PatientSupport.vtk\", \"FileToRASTransformMatrix\": "
+      << identityMatrix << ", \"Color\": [255,255,255], \"State\": \"Passive\" },\n"
+      << "  { \"Type\": \"TableTop\", \"Name\": \"TableTop\", \"FilePath\": \"TableTop.vtk\", \"FileToRASTransformMatrix\": "
+      << identityMatrix << ", \"Color\": [255,255,255], \"State\": \"Active\" }\n"
+      << "] }\n";
+    return descriptorFile.good();
+  }
+
+  //----------------------------------------------------------------------------
+  /// Write a treatment machine consisting of boxes.
+  /// The gantry is a 20x10x100mm box centered at 50mm along its X axis, and the table top is a thin slab at 30-70mm
+  /// along Y in RAS. At zero gantry angle the gantry only goes through the table top if the patient support rotation
+  /// turns the gantry X axis into the RAS Y axis, i.e. patient support rotation angle -90 degrees.
+  bool WriteBoxTreatmentMachine(const std::string& directory, std::string& descriptorFilePath)
+  {
+    if ( !WriteBox(directory + "/Collimator.vtk", -5.0, 5.0, -5.0, 5.0, 300.0, 310.0)
+      || !WriteBox(directory + "/Gantry.vtk", 40.0, 60.0, -5.0, 5.0, -50.0, 50.0)
+      || !WriteBox(directory + "/PatientSupport.vtk", -10.0, 10.0, 200.0, 220.0, -300.0, -200.0)
+      || !WriteBox(directory + "/TableTop.vtk", -30.0, 30.0, 30.0, 70.0, -2.0, 2.0) )
+    {
+      return false;
+    }
+    return WriteTreatmentMachineDescriptor(directory, descriptorFilePath);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Write a treatment machine whose gantry is a finely tessellated sphere of 10mm radius that, at zero gantry angle
+  /// and patient support rotation angle -90 degrees, reaches over the edge of the table top slab of the box machine
+  /// by the given penetration depth (negative value is a gap). The table top has a second, distant component, so that
+  /// the surface point with the largest X coordinate is not on the slab.
+  bool WriteSphereTreatmentMachine(const std::string& directory, double penetration, std::string& descriptorFilePath)
+  {
+    // Gantry X axis is the RAS Y axis in the pose, and the slab edge closest to the sphere is at Y=30, Z=2
+    const double radius = 10.0;
+    double offset = (radius - penetration) / std::sqrt(2.0);
+    vtkNew<vtkSphereSource> sphereSource;
+    sphereSource->SetRadius(radius);
+    sphereSource->SetCenter(30.0 - offset, 0.0, 2.0 + offset);
+    sphereSource->SetThetaResolution(64);
+    sphereSource->SetPhiResolution(64);
+    vtkNew<vtkPolyDataWriter> gantryWriter;
+    gantryWriter->SetInputConnection(sphereSource->GetOutputPort());
+    gantryWriter->SetHeader("SPACE=RAS");
+    gantryWriter->SetFileName((directory + "/Gantry.vtk").c_str());
+
+    vtkNew<vtkCubeSource> slabSource;
+    slabSource->SetBounds(-30.0, 30.0, 30.0, 70.0, -2.0, 2.0);
+    vtkNew<vtkCubeSource> distantBoxSource;
+    distantBoxSource->SetBounds(100.0, 120.0, 500.0, 520.0, -5.0, 5.0);
+    vtkNew<vtkAppendPolyData> tableTopAppend;
+    tableTopAppend->AddInputConnection(slabSource->GetOutputPort());
+    tableTopAppend->AddInputConnection(distantBoxSource->GetOutputPort());
+    vtkNew<vtkPolyDataWriter> tableTopWriter;
+    tableTopWriter->SetInputConnection(tableTopAppend->GetOutputPort());
+    tableTopWriter->SetHeader("SPACE=RAS");
+    tableTopWriter->SetFileName((directory + "/TableTop.vtk").c_str());
+
+    if ( !WriteBox(directory + "/Collimator.vtk", -5.0, 5.0, -5.0, 5.0, 300.0, 310.0)
+      || !gantryWriter->Write()
+      || !WriteBox(directory + "/PatientSupport.vtk", -10.0, 10.0, 200.0, 220.0, -300.0, -200.0)
+      || !tableTopWriter->Write() )
+    {
+      return false;
+    }
+    return WriteTreatmentMachineDescriptor(directory, descriptorFilePath);
+  }
+
+  //----------------------------------------------------------------------------
+  bool IsIdentity(vtkMRMLLinearTransformNode* transformNode)
+  {
+    vtkNew<vtkMatrix4x4> matrix;
+    transformNode->GetMatrixTransformToParent(matrix);
+    vtkNew<vtkMatrix4x4> identity;
+    for (int i=0; i<4; ++i)
+    {
+      for (int j=0; j<4; ++j)
+      {
+        if (std::fabs(matrix->GetElement(i, j) - identity->GetElement(i, j)) > 1.0e-6)
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get collision flags of a pose from the collision map table, -1 if the pose is not in the map
+  int GetCollisionMapFlags(vtkTable* table, double patientSupportAngle, double gantryAngle)
+  {
+    vtkDataArray* patientSupportAngleColumn = vtkDataArray::SafeDownCast(
+      table->GetColumnByName(vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_PATIENT_SUPPORT_ANGLE_COLUMN_NAME));
+    vtkDataArray* gantryAngleColumn = vtkDataArray::SafeDownCast(
+      table->GetColumnByName(vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_GANTRY_ANGLE_COLUMN_NAME));
+    vtkDataArray* collisionsColumn = vtkDataArray::SafeDownCast(
+      table->GetColumnByName(vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_COLLISIONS_COLUMN_NAME));
+    if (!patientSupportAngleColumn || !gantryAngleColumn || !collisionsColumn)
+    {
+      return -1;
+    }
+    for (vtkIdType row=0; row<table->GetNumberOfRows(); ++row)
+    {
+      if ( std::fabs(patientSupportAngleColumn->GetTuple1(row) - patientSupportAngle) < 1.0e-6
+        && std::fabs(gantryAngleColumn->GetTuple1(row) - gantryAngle) < 1.0e-6 )
+      {
+        return static_cast<int>(collisionsColumn->GetTuple1(row));
+      }
+    }
+    return -1;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get minimum clearance of a pose from the collision map table, NaN if the pose is not in the map
+  double GetCollisionMapMinimumClearance(vtkTable* table, double patientSupportAngle, double gantryAngle)
+  {
+    vtkDataArray* patientSupportAngleColumn = vtkDataArray::SafeDownCast(
+      table->GetColumnByName(vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_PATIENT_SUPPORT_ANGLE_COLUMN_NAME));
+    vtkDataArray* gantryAngleColumn = vtkDataArray::SafeDownCast(
+      table->GetColumnByName(vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_GANTRY_ANGLE_COLUMN_NAME));
+    vtkDataArray* minimumClearanceColumn = vtkDataArray::SafeDownCast(
+      table->GetColumnByName(vtkSlicerRoomsEyeViewModuleLogic::COLLISION_MAP_MINIMUM_CLEARANCE_COLUMN_NAME));
+    if (!patientSupportAngleColumn || !gantryAngleColumn || !minimumClearanceColumn)
+    {
+      return std::nan("");
+    }
+    for (vtkIdType row=0; row<table->GetNumberOfRows(); ++row)
+    {
+      if ( std::fabs(patientSupportAngleColumn->GetTuple1(row) - patientSupportAngle) < 1.0e-6
+        && std::fabs(gantryAngleColumn->GetTuple1(row) - gantryAngle) < 1.0e-6 )
+      {
+        return minimumClearanceColumn->GetTuple1(row);
+      }
+    }
+    return std::nan("");
+  }
+
+  //----------------------------------------------------------------------------
+  /// Load the sphere treatment machine with simplified collision proxies and no safety margin, and check whether
+  /// collision between the gantry and the table top is reported in the pose where the sphere reaches the slab edge,
+  /// both by CheckForCollisions and in the collision map
+  bool CheckSphereTreatmentMachineCollision(const std::string& directory, double penetration, bool exactConfirmation,
+    bool& collisionReported, bool& collisionMapped)
+  {
+    vtksys::SystemTools::MakeDirectory(directory);
+    std::string descriptorFilePath;
+    if (!WriteSphereTreatmentMachine(directory, penetration, descriptorFilePath))
+    {
+      std::cerr << "Failed to write treatment machine to " << directory << std::endl;
+      return false;
+    }
+
+    vtkNew<vtkMRMLScene> mrmlScene;
+    vtkNew<vtkSlicerRoomsEyeViewModuleLogic> revLogic;
+    revLogic->SetMRMLScene(mrmlScene);
+    vtkNew<vtkMRMLRoomsEyeViewNode> paramNode;
+    mrmlScene->AddNode(paramNode);
+    paramNode->SetTreatmentMachineDescriptorFilePath(descriptorFilePath.c_str());
+    paramNode->SetCollisionProxyTriangleBudget(100);
+    paramNode->SetCollisionProxySafetyMargin(0.0);
+    paramNode->SetCollisionProxyExactConfirmation(exactConfirmation);
+    revLogic->LoadTreatmentMachine(paramNode);
+
+    paramNode->SetGantryRotationAngle(0.0);
+    paramNode->SetPatientSupportRotationAngle(-90.0);
+    revLogic->UpdateGantryToFixedReferenceTransform(paramNode);
+    revLogic->UpdatePatientSupportRotationToFixedReferenceTransform(paramNode);
+    revLogic->UpdateFixedReferenceToRASTransform(paramNode);
+    std::string collisionString = revLogic->CheckForCollisions(paramNode);
+    collisionReported = (collisionString.find("gantry and table top") != std::string::npos);
+
+    std::string errorMessage = revLogic->ComputeCollisionMap(paramNode);
+    vtkMRMLTableNode* collisionMapTableNode = paramNode->GetCollisionMapTableNode();
+    if (!errorMessage.empty() || !collisionMapTableNode || !collisionMapTableNode->GetTable())
+    {
+      std::cerr << "Failed to compute collision map: " << errorMessage << std::endl;
+      return false;
+    }
+    int flags = GetCollisionMapFlags(collisionMapTableNode->GetTable(), -90.0, 0.0);
+    if (flags < 0)
+    {
+      std::cerr << "Pose is missing from the collision map" << std::endl;
+      return false;
+    }
+    collisionMapped = ((flags & vtkSlicerRoomsEyeViewModuleLogic::GantryTableTopCollision) != 0);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Load the box treatment machine with a patient body that is a finely tessellated sphere of 10mm radius reaching
+  /// over the gantry edge at X=40, Y=5 in the initial pose by the given penetration depth (negative value is a gap).
+  /// The patient body is simplified for collision detection and no safety margin is used.
+  /// \return Whether collision between the gantry and the patient is reported by CheckForCollisions
+  bool IsGantryPatientCollisionReported(const std::string& descriptorFilePath, double penetration, bool exactConfirmation)
+  {
+    const double radius = 10.0;
+    double offset = (radius - penetration) / std::sqrt(2.0);
+    vtkNew<vtkSphereSource> sphereSource;
+    sphereSource->SetRadius(radius);
+    sphereSource->SetCenter(40.0 - offset, 5.0 + offset, 0.0);
+    sphereSource->SetThetaResolution(64);
+    sphereSource->SetPhiResolution(64);
+    sphereSource->Update();
+
+    vtkNew<vtkMRMLScene> mrmlScene;
+    vtkNew<vtkSlicerRoomsEyeViewModuleLogic> revLogic;
+    revLogic->SetMRMLScene(mrmlScene);
+
+    vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+    mrmlScene->AddNode(segmentationNode);
+    segmentationNode->GetSegmentation()->SetMasterRepresentationName(
+      vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName() );
+    vtkNew<vtkSegment> bodySegment;
+    bodySegment->SetName("Body");
+    bodySegment->AddRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(),
+      sphereSource->GetOutput());
+    std::string bodySegmentID = "Body";
+    segmentationNode->GetSegmentation()->AddSegment(bodySegment, bodySegmentID);
+
+    vtkNew<vtkMRMLRoomsEyeViewNode> paramNode;
+    mrmlScene->AddNode(paramNode);
+    paramNode->SetTreatmentMachineDescriptorFilePath(descriptorFilePath.c_str());
+    paramNode->SetAndObservePatientBodySegmentationNode(segmentationNode);
+    paramNode->SetPatientBodySegmentID(bodySegmentID.c_str());
+    paramNode->SetPatientBodyCollisionTriangleBudget(100);
+    paramNode->SetCollisionProxySafetyMargin(0.0);
+    paramNode->SetCollisionProxyExactConfirmation(exactConfirmation);
+    revLogic->LoadTreatmentMachine(paramNode);
+
+    std::string collisionString = revLogic->CheckForCollisions(paramNode);
+    return (collisionString.find("gantry and patient\n") != std::string::npos);
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerRoomsEyeViewCollisionTest1(int argc, char* argv[])
+{
+  // TemporaryDirectory
+  std::string temporaryDirectory(".");
+  if (argc > 2 && std::string(argv[1]) == "-TemporaryDirectory")
+  {
+    temporaryDirectory = argv[2];
+  }
+  std::string machineDirectory = temporaryDirectory + "/RoomsEyeViewCollisionTest";
+  vtksys::SystemTools::MakeDirectory(machineDirectory);
+  std::string descriptorFilePath;
+  if (!WriteBoxTreatmentMachine(machineDirectory, descriptorFilePath))
+  {
+    std::cerr << "Failed to write treatment machine to " << machineDirectory << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerRoomsEyeViewModuleLogic> revLogic;
+  revLogic->SetMRMLScene(mrmlScene);
+  vtkNew<vtkSlicerBeamsModuleLogic> beamsLogic;
+  beamsLogic->SetMRMLScene(mrmlScene);
+
+  vtkNew<vtkMRMLRoomsEyeViewNode> paramNode;
+  mrmlScene->AddNode(paramNode);
+  paramNode->SetTreatmentMachineDescriptorFilePath(descriptorFilePath.c_str());
+  revLogic->LoadTreatmentMachine(paramNode);
+
+  //
+  // The beam couch angle and the patient support rotation angle need to result in the same patient support rotation
+  vtkNew<vtkMRMLRTBeamNode> conventionBeamNode;
+  conventionBeamNode->SetCouchAngle(30.0);
+  double isocenter[3] = { 0.0, 0.0, 0.0 };
+  revLogic->GetIECLogic()->UpdateIECTransformsFromBeam(conventionBeamNode, isocenter);
+  vtkMRMLLinearTransformNode* patientSupportRotationToFixedReferenceTransformNode = revLogic->GetIECLogic()->GetTransformNodeBetween(
+    vtkSlicerIECTransformLogic::PatientSupportRotation, vtkSlicerIECTransformLogic::FixedReference);
+  vtkNew<vtkMatrix4x4> beamPatientSupportRotationMatrix;
+  patientSupportRotationToFixedReferenceTransformNode->GetMatrixTransformToParent(beamPatientSupportRotationMatrix);
+  paramNode->SetPatientSupportRotationAngle(vtkSlicerRoomsEyeViewModuleLogic::GetPatientSupportRotationAngleForCouchAngle(30.0));
+  revLogic->UpdatePatientSupportRotationToFixedReferenceTransform(paramNode);
+  vtkNew<vtkMatrix4x4> roomsEyeViewPatientSupportRotationMatrix;
+  patientSupportRotationToFixedReferenceTransformNode->GetMatrixTransformToParent(roomsEyeViewPatientSupportRotationMatrix);
+  for (int i=0; i<4; ++i)
+  {
+    for (int j=0; j<4; ++j)
+    {
+      if (std::fabs(beamPatientSupportRotationMatrix->GetElement(i, j) - roomsEyeViewPatientSupportRotationMatrix->GetElement(i, j)) > 1.0e-6)
+      {
+        std::cerr << "Patient support rotation of couch angle 30 does not match the room's eye view patient support rotation angle "
+          << paramNode->GetPatientSupportRotationAngle() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  paramNode->SetPatientSupportRotationAngle(0.0);
+  revLogic->UpdatePatientSupportRotationToFixedReferenceTransform(paramNode);
+
+  //
+  // Collision map. Collimator angle and lateral table top displacement do not affect the gantry and table top contact,
+  // but they would change the transforms in the scene if they were applied there
+  paramNode->SetCollimatorRotationAngle(30.0);
+  paramNode->SetLateralTableTopDisplacement(5.0);
+  std::string errorMessage = revLogic->ComputeCollisionMap(paramNode);
+  vtkMRMLTableNode* collisionMapTableNode = paramNode->GetCollisionMapTableNode();
+  if (!errorMessage.empty() || !collisionMapTableNode || !collisionMapTableNode->GetTable())
+  {
+    std::cerr << "Failed to compute collision map: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkMRMLLinearTransformNode* collimatorToGantryTransformNode = revLogic->GetIECLogic()->GetTransformNodeBetween(
+    vtkSlicerIECTransformLogic::Collimator, vtkSlicerIECTransformLogic::Gantry);
+  vtkMRMLLinearTransformNode* tableTopToTableTopEccentricRotationTransformNode = revLogic->GetIECLogic()->GetTransformNodeBetween(
+    vtkSlicerIECTransformLogic::TableTop, vtkSlicerIECTransformLogic::TableTopEccentricRotation);
+  if (!IsIdentity(collimatorToGantryTransformNode) || !IsIdentity(tableTopToTableTopEccentricRotationTransformNode))
+  {
+    std::cerr << "Computing the collision map changed the transforms in the scene" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkTable* collisionMapTable = collisionMapTableNode->GetTable();
+  int collidingFlags = GetCollisionMapFlags(collisionMapTable, -90.0, 0.0);
+  int freeFlags = GetCollisionMapFlags(collisionMapTable, 90.0, 0.0);
+  if (collidingFlags != vtkSlicerRoomsEyeViewModuleLogic::GantryTableTopCollision || freeFlags != 0)
+  {
+    std::cerr << "Collision map mismatch: flags " << collidingFlags << " at patient support -90 and " << freeFlags
+      << " at patient support 90 (gantry 0), expected " << vtkSlicerRoomsEyeViewModuleLogic::GantryTableTopCollision << " and 0" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Plan validation. Couch angle 90 is patient support rotation -90, which collides at gantry 0.
+  vtkNew<vtkMRMLRTPlanNode> planNode;
+  mrmlScene->AddNode(planNode);
+  vtkNew<vtkMRMLRTBeamNode> collidingBeamNode;
+  collidingBeamNode->SetName("CollidingBeam");
+  collidingBeamNode->SetGantryAngle(0.0);
+  collidingBeamNode->SetCouchAngle(90.0);
+  mrmlScene->AddNode(collidingBeamNode);
+  planNode->AddBeam(collidingBeamNode);
+  vtkNew<vtkMRMLRTBeamNode> freeBeamNode;
+  freeBeamNode->SetName("FreeBeam");
+  freeBeamNode->SetGantryAngle(0.0);
+  freeBeamNode->SetCouchAngle(-90.0);
+  mrmlScene->AddNode(freeBeamNode);
+  planNode->AddBeam(freeBeamNode);
+
+  std::string validationResult = revLogic->ValidatePlanAgainstCollisionMap(paramNode, planNode);
+  if ( validationResult.find("CollidingBeam") == std::string::npos || validationResult.find("gantry and table top") == std::string::npos
+    || validationResult.find("FreeBeam") != std::string::npos )
+  {
+    std::cerr << "Plan validation mismatch. Result:\n" << validationResult << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Clearance. In the initial pose the closest features are the gantry edge at X=40, Y=5 and the table top edge
+  // at X=30, Y=30, which are parallel to Z, so the clearance is sqrt(10^2 + 25^2). The closest points are in the middle
+  // of the long gantry edge, far from the vertices of the gantry.
+  {
+    vtkNew<vtkMRMLScene> clearanceScene;
+    vtkNew<vtkSlicerRoomsEyeViewModuleLogic> clearanceLogic;
+    clearanceLogic->SetMRMLScene(clearanceScene);
+    vtkNew<vtkMRMLRoomsEyeViewNode> clearanceParamNode;
+    clearanceScene->AddNode(clearanceParamNode);
+    clearanceParamNode->SetTreatmentMachineDescriptorFilePath(descriptorFilePath.c_str());
+    clearanceParamNode->SetClearanceTolerance(2.0);
+    clearanceParamNode->SetClearanceDistanceFieldMargin(30.0);
+    clearanceLogic->LoadTreatmentMachine(clearanceParamNode);
+
+    // The second load of the same machine is served from the cache, but the model nodes must not share the surfaces
+    // and must not get a storage node pointing to the model file that contains the surface before the file to RAS transform
+    std::string gantryModelName = vtksys::SystemTools::GetFilenameWithoutLastExtension(descriptorFilePath) + "_"
+      + revLogic->GetTreatmentMachinePartTypeAsString(vtkSlicerRoomsEyeViewModuleLogic::Gantry);
+    vtkMRMLModelNode* gantryModelNode = vtkMRMLModelNode::SafeDownCast(mrmlScene->GetFirstNodeByName(gantryModelName.c_str()));
+    vtkMRMLModelNode* cachedGantryModelNode = vtkMRMLModelNode::SafeDownCast(clearanceScene->GetFirstNodeByName(gantryModelName.c_str()));
+    if (!gantryModelNode || !cachedGantryModelNode || !cachedGantryModelNode->GetPolyData()
+      || gantryModelNode->GetPolyData() == cachedGantryModelNode->GetPolyData() || cachedGantryModelNode->GetStorageNode())
+    {
+      std::cerr << "Gantry model " << gantryModelName << " loaded from the treatment machine cache shares its surface "
+        << "with the previously loaded model or has a storage node" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    vtkNew<vtkCallbackCommand> modifiedCallback;
+    int numberOfModifiedEvents = 0;
+    modifiedCallback->SetClientData(&numberOfModifiedEvents);
+    modifiedCallback->SetCallback([](vtkObject*, unsigned long, void* clientData, void*)
+      { ++(*static_cast<int*>(clientData)); });
+    clearanceParamNode->AddObserver(vtkCommand::ModifiedEvent, modifiedCallback);
+    std::string collisionString = clearanceLogic->CheckForCollisions(clearanceParamNode);
+    clearanceParamNode->RemoveObserver(modifiedCallback);
+
+    double expectedClearance = std::sqrt(10.0 * 10.0 + 25.0 * 25.0);
+    double clearance = clearanceParamNode->GetGantryTableTopClearance();
+    if (!collisionString.empty() || std::fabs(clearance - expectedClearance) > clearanceParamNode->GetClearanceTolerance())
+    {
+      std::cerr << "Gantry and table top clearance mismatch: " << clearance << " instead of " << expectedClearance
+        << " (tolerance " << clearanceParamNode->GetClearanceTolerance() << "). Collisions: " << collisionString << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (numberOfModifiedEvents != 1)
+    {
+      std::cerr << "Setting the clearances invoked " << numberOfModifiedEvents << " modified events instead of 1" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The collision map contains the same clearance for the initial pose, and a penetration where the gantry
+    // goes through the table top
+    errorMessage = clearanceLogic->ComputeCollisionMap(clearanceParamNode);
+    vtkMRMLTableNode* clearanceMapTableNode = clearanceParamNode->GetCollisionMapTableNode();
+    if (!errorMessage.empty() || !clearanceMapTableNode || !clearanceMapTableNode->GetTable())
+    {
+      std::cerr << "Failed to compute collision map with clearances: " << errorMessage << std::endl;
+      return EXIT_FAILURE;
+    }
+    double freeMapClearance = GetCollisionMapMinimumClearance(clearanceMapTableNode->GetTable(), 0.0, 0.0);
+    double collidingMapClearance = GetCollisionMapMinimumClearance(clearanceMapTableNode->GetTable(), -90.0, 0.0);
+    if ( !(std::fabs(freeMapClearance - expectedClearance) <= clearanceParamNode->GetClearanceTolerance())
+      || !(collidingMapClearance < 0.0) )
+    {
+      std::cerr << "Collision map clearance mismatch: " << freeMapClearance << " at patient support 0 (expected "
+        << expectedClearance << ") and " << collidingMapClearance << " at patient support -90 (expected negative)" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  //
+  // Simplified collision proxies must not hide contacts of parts that barely touch, with or without exact confirmation,
+  // and exact confirmation must reject contacts of the proxies of parts that barely miss each other
+  bool collisionReported = false;
+  bool collisionMapped = false;
+  for (bool exactConfirmation : { false, true })
+  {
+    if (!CheckSphereTreatmentMachineCollision(machineDirectory + "/Touching", 0.1, exactConfirmation, collisionReported, collisionMapped))
+    {
+      return EXIT_FAILURE;
+    }
+    if (!collisionReported || !collisionMapped)
+    {
+      std::cerr << "Touching gantry and table top not detected with exact confirmation " << (exactConfirmation ? "on" : "off")
+        << ": reported " << collisionReported << ", mapped " << collisionMapped << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (!CheckSphereTreatmentMachineCollision(machineDirectory + "/Gap", -0.1, true, collisionReported, collisionMapped))
+  {
+    return EXIT_FAILURE;
+  }
+  if (collisionReported || collisionMapped)
+  {
+    std::cerr << "Separated gantry and table top detected as colliding: reported " << collisionReported
+      << ", mapped " << collisionMapped << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // The simplified patient body must not hide its contact with a sharp gantry edge either
+  for (bool exactConfirmation : { false, true })
+  {
+    if (!IsGantryPatientCollisionReported(descriptorFilePath, 0.1, exactConfirmation))
+    {
+      std::cerr << "Touching gantry and patient not detected with exact confirmation " << (exactConfirmation ? "on" : "off") << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (IsGantryPatientCollisionReported(descriptorFilePath, -0.1, true))
+  {
+    std::cerr << "Separated gantry and patient detected as colliding" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -70,6 +70,9 @@
 #include <vtkMatrix4x4.h>
 #include <vtkTransform.h>
 
+// STD includes
+#include <vector>
+
 //-----------------------------------------------------------------------------
 /// \ingroup SlicerRt_QtModules_RoomsEyeView
 class qSlicerRoomsEyeViewModuleWidgetPrivate : public Ui_qSlicerRoomsEyeViewModule
@@ -891,14 +894,41 @@ void qSlicerRoomsEyeViewModuleWidget::checkForCollisions()
 
   std::string collisionString = d->logic()->CheckForCollisions(paramNode);
 
+  // Clearance readout
+  QString clearanceString;
+  bool clearanceWarning = false;
+  std::vector<std::pair<QString, double> > clearances = {
+    { "gantry and table top", paramNode->GetGantryTableTopClearance() },
+    { "gantry and patient support", paramNode->GetGantryPatientSupportClearance() },
+    { "collimator and table top", paramNode->GetCollimatorTableTopClearance() },
+    { "gantry and patient", paramNode->GetGantryPatientClearance() },
+    { "collimator and patient", paramNode->GetCollimatorPatientClearance() } };
+  for (const std::pair<QString, double>& clearance : clearances)
+  {
+    if (clearance.second == VTK_DOUBLE_MAX)
+    {
+      continue;
+    }
+    clearanceString += QString("\nClearance between %1: %2 mm").arg(clearance.first).arg(clearance.second, 0, 'f', 1);
+    if (clearance.second < paramNode->GetClearanceWarningThreshold())
+    {
+      clearanceWarning = true;
+    }
+  }
+
   if (collisionString.length() > 0)
   {
-    d->CollisionsDetected->setText(QString::fromStdString(collisionString));
+    d->CollisionsDetected->setText(QString::fromStdString(collisionString).trimmed() + clearanceString);
     d->CollisionsDetected->setStyleSheet("color: red");
   }
+  else if (clearanceWarning)
+  {
+    d->CollisionsDetected->setText(QString("Clearance below %1 mm").arg(paramNode->GetClearanceWarningThreshold()) + clearanceString);
+    d->CollisionsDetected->setStyleSheet("color: orange");
+  }
   else
   {
-    d->CollisionsDetected->setText(QString::fromStdString("No collisions detected"));
+    d->CollisionsDetected->setText(QString::fromStdString("No collisions detected") + clearanceString);
     d->CollisionsDetected->setStyleSheet("color: green");
   }
 }
@@ -0,0 +1,430 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkLabelmapHausdorffDistanceFilter.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  /// Squared distance value of voxels that have not been reached by any boundary voxel
+  const float UNREACHED_SQUARED_DISTANCE = VTK_FLOAT_MAX;
+
+  //----------------------------------------------------------------------------
+  /// Fill binary mask (one byte per voxel on the common extent) from a labelmap of any scalar type
+  template<class T>
+  void FillMaskFromLabelmap(vtkImageData* image, T* vtkNotUsed(typePtr), const int commonExtent[6], std::vector<unsigned char>& mask)
+  {
+    int* imageExtent = image->GetExtent();
+    int extent[6] = { 0 };
+    for (int axis=0; axis<3; ++axis)
+    {
+      extent[2*axis] = std::max(imageExtent[2*axis], commonExtent[2*axis]);
+      extent[2*axis+1] = std::min(imageExtent[2*axis+1], commonExtent[2*axis+1]);
+      if (extent[2*axis] > extent[2*axis+1])
+      {
+        return; // No overlap with the common extent
+      }
+    }
+
+    vtkIdType dimX = commonExtent[1] - commonExtent[0] + 1;
+    vtkIdType dimY = commonExtent[3] - commonExtent[2] + 1;
+    vtkIdType* increments = image->GetIncrements();
+    for (int k=extent[4]; k<=extent[5]; ++k)
+    {
+      for (int j=extent[2]; j<=extent[3]; ++j)
+      {
+        T* imagePtr = static_cast<T*>(image->GetScalarPointer(extent[0], j, k));
+        unsigned char* maskPtr = &mask[ (k-commonExtent[4])*dimX*dimY + (j-commonExtent[2])*dimX + (extent[0]-commonExtent[0]) ];
+        for (int i=extent[0]; i<=extent[1]; ++i)
+        {
+          *(maskPtr++) = ((*imagePtr) != 0 ? 1 : 0);
+          imagePtr += increments[0];
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Mark foreground voxels that have a background 6-neighbor. Outside of the image is considered background.
+  class BoundaryExtractionFunctor
+  {
+  public:
+    const unsigned char* Mask;
+    unsigned char* Boundary;
+    vtkIdType Dimensions[3];
+
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice) const
+    {
+      vtkIdType sliceSize = this->Dimensions[0] * this->Dimensions[1];
+      for (vtkIdType k=beginSlice; k<endSlice; ++k)
+      {
+        for (vtkIdType j=0; j<this->Dimensions[1]; ++j)
+        {
+          for (vtkIdType i=0; i<this->Dimensions[0]; ++i)
+          {
+            vtkIdType index = k*sliceSize + j*this->Dimensions[0] + i;
+            if (!this->Mask[index])
+            {
+              this->Boundary[index] = 0;
+              continue;
+            }
+            bool onBoundary =
+                 i == 0 || i == this->Dimensions[0]-1
+              || j == 0 || j == this->Dimensions[1]-1
+              || k == 0 || k == this->Dimensions[2]-1
+              || !this->Mask[index-1] || !this->Mask[index+1]
+              || !this->Mask[index-this->Dimensions[0]] || !this->Mask[index+this->Dimensions[0]]
+              || !this->Mask[index-sliceSize] || !this->Mask[index+sliceSize];
+            this->Boundary[index] = (onBoundary ? 1 : 0);
+          }
+        }
+      }
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  /// One separable pass of the exact squared Euclidean distance transform along a given axis.
+  /// Each line is processed with the linear-time lower envelope of parabolas algorithm
+  /// (P. Felzenszwalb, D. Huttenlocher: Distance Transforms of Sampled Functions, 2012).
+  class DistanceTransformPassFunctor
+  {
+  public:
+    float* SquaredDistances;
+    vtkIdType Dimensions[3];
+    vtkIdType Strides[3];
+    double Spacing;
+    int Axis;
+
+    void operator()(vtkIdType beginLine, vtkIdType endLine) const
+    {
+      int firstOtherAxis = (this->Axis + 1) % 3;
+      int secondOtherAxis = (this->Axis + 2) % 3;
+      vtkIdType lineLength = this->Dimensions[this->Axis];
+      vtkIdType stride = this->Strides[this->Axis];
+
+      std::vector<double> line(lineLength);
+      std::vector<vtkIdType> parabolaVertices(lineLength);
+      std::vector<double> parabolaBoundaries(lineLength + 1);
+
+      for (vtkIdType lineIndex=beginLine; lineIndex<endLine; ++lineIndex)
+      {
+        vtkIdType firstOtherIndex = lineIndex % this->Dimensions[firstOtherAxis];
+        vtkIdType secondOtherIndex = lineIndex / this->Dimensions[firstOtherAxis];
+        float* linePtr = this->SquaredDistances
+          + firstOtherIndex * this->Strides[firstOtherAxis] + secondOtherIndex * this->Strides[secondOtherAxis];
+
+        // Build lower envelope of the parabolas rooted at the reached samples
+        vtkIdType numberOfParabolas = 0;
+        for (vtkIdType q=0; q<lineLength; ++q)
+        {
+          float value = linePtr[q*stride];
+          line[q] = value;
+          if (value >= UNREACHED_SQUARED_DISTANCE)
+          {
+            continue;
+          }
+          double position = q * this->Spacing;
+          double intersection = -VTK_DOUBLE_MAX;
+          while (numberOfParabolas > 0)
+          {
+            vtkIdType vertex = parabolaVertices[numberOfParabolas-1];
+            double vertexPosition = vertex * this->Spacing;
+            intersection = ( (value + position*position) - (line[vertex] + vertexPosition*vertexPosition) )
+              / (2.0 * (position - vertexPosition));
+            if (intersection > parabolaBoundaries[numberOfParabolas-1])
+            {
+              break;
+            }
+            --numberOfParabolas;
+          }
+          parabolaVertices[numberOfParabolas] = q;
+          parabolaBoundaries[numberOfParabolas] = (numberOfParabolas == 0 ? -VTK_DOUBLE_MAX : intersection);
+          ++numberOfParabolas;
+        }
+        if (numberOfParabolas == 0)
+        {
+          continue; // No reached samples on this line, keep it unreached
+        }
+        parabolaBoundaries[numberOfParabolas] = VTK_DOUBLE_MAX;
+
+        // Evaluate lower envelope
+        vtkIdType parabolaIndex = 0;
+        for (vtkIdType q=0; q<lineLength; ++q)
+        {
+          double position = q * this->Spacing;
+          while (parabolaBoundaries[parabolaIndex+1] < position)
+          {
+            ++parabolaIndex;
+          }
+          vtkIdType vertex = parabolaVertices[parabolaIndex];
+          double offset = position - vertex * this->Spacing;
+          linePtr[q*stride] = static_cast<float>(offset*offset + line[vertex]);
+        }
+      }
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  /// Compute squared Euclidean distance (in mm^2) from each voxel to the nearest boundary voxel
+  void ComputeSquaredDistanceTransform(const std::vector<unsigned char>& boundary, const vtkIdType dimensions[3],
+    const double spacing[3], std::vector<float>& squaredDistances)
+  {
+    vtkIdType numberOfVoxels = dimensions[0] * dimensions[1] * dimensions[2];
+    squaredDistances.resize(numberOfVoxels);
+    for (vtkIdType index=0; index<numberOfVoxels; ++index)
+    {
+      squaredDistances[index] = (boundary[index] ? 0.0f : UNREACHED_SQUARED_DISTANCE);
+    }
+
+    DistanceTransformPassFunctor functor;
+    functor.SquaredDistances = squaredDistances.data();
+    for (int axis=0; axis<3; ++axis)
+    {
+      functor.Dimensions[axis] = dimensions[axis];
+    }
+    functor.Strides[0] = 1;
+    functor.Strides[1] = dimensions[0];
+    functor.Strides[2] = dimensions[0] * dimensions[1];
+    for (int axis=0; axis<3; ++axis)
+    {
+      functor.Axis = axis;
+      functor.Spacing = spacing[axis];
+      vtkIdType numberOfLines = numberOfVoxels / dimensions[axis];
+      vtkSMPTools::For(0, numberOfLines, functor);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get value at the given percentile (0..100), with the same index rounding as vtkPolyDataDistanceHistogramFilter
+  double GetPercentile(std::vector<double> values, double percentile)
+  {
+    if (values.empty())
+    {
+      return 0.0;
+    }
+    std::vector<double>::iterator nthIterator = values.begin() + vtkMath::Round( (percentile / 100.0) * (values.size() - 1) );
+    std::nth_element(values.begin(), nthIterator, values.end());
+    return *nthIterator;
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapHausdorffDistanceFilter);
+vtkCxxSetObjectMacro(vtkLabelmapHausdorffDistanceFilter, InputReferenceLabelmap, vtkOrientedImageData);
+vtkCxxSetObjectMacro(vtkLabelmapHausdorffDistanceFilter, InputCompareLabelmap, vtkOrientedImageData);
+
+//----------------------------------------------------------------------------
+vtkLabelmapHausdorffDistanceFilter::vtkLabelmapHausdorffDistanceFilter()
+  : InputReferenceLabelmap(nullptr)
+  , InputCompareLabelmap(nullptr)
+  , SurfaceDiceToleranceMm(1.0)
+{
+  this->ResetOutputs();
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapHausdorffDistanceFilter::~vtkLabelmapHausdorffDistanceFilter()
+{
+  this->SetInputReferenceLabelmap(nullptr);
+  this->SetInputCompareLabelmap(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapHausdorffDistanceFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "SurfaceDiceToleranceMm: " << this->SurfaceDiceToleranceMm << "\n";
+  os << indent << "MaximumHausdorffDistanceMm: " << this->MaximumHausdorffDistanceMm << "\n";
+  os << indent << "AverageHausdorffDistanceMm: " << this->AverageHausdorffDistanceMm << "\n";
+  os << indent << "Percent95HausdorffDistanceMm: " << this->Percent95HausdorffDistanceMm << "\n";
+  os << indent << "SurfaceDice: " << this->SurfaceDice << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapHausdorffDistanceFilter::ResetOutputs()
+{
+  this->MaximumHausdorffDistanceMm = -1.0;
+  this->AverageHausdorffDistanceMm = -1.0;
+  this->Percent95HausdorffDistanceMm = -1.0;
+  this->SurfaceDice = -1.0;
+  this->CompareToReferenceDistances.clear();
+  this->ReferenceToCompareDistances.clear();
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapHausdorffDistanceFilter::Update()
+{
+  this->ResetOutputs();
+
+  if (!this->InputReferenceLabelmap || !this->InputCompareLabelmap)
+  {
+    vtkErrorMacro("Update: Both reference and compare labelmaps need to be set");
+    return false;
+  }
+
+  // Bring compare labelmap to the lattice of the reference labelmap if necessary
+  vtkOrientedImageData* referenceLabelmap = this->InputReferenceLabelmap;
+  vtkSmartPointer<vtkOrientedImageData> compareLabelmap = this->InputCompareLabelmap;
+  if (!vtkOrientedImageDataResample::DoGeometriesMatch(referenceLabelmap, compareLabelmap))
+  {
+    vtkSmartPointer<vtkOrientedImageData> resampledCompareLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      compareLabelmap, referenceLabelmap, resampledCompareLabelmap, false, true ) )
+    {
+      vtkErrorMacro("Update: Failed to resample compare labelmap to reference geometry");
+      return false;
+    }
+    compareLabelmap = resampledCompareLabelmap;
+  }
+
+  // Common extent is the union of the two extents on the common lattice
+  int* referenceExtent = referenceLabelmap->GetExtent();
+  int* compareExtent = compareLabelmap->GetExtent();
+  int commonExtent[6] = { 0 };
+  vtkIdType dimensions[3] = { 0 };
+  for (int axis=0; axis<3; ++axis)
+  {
+    commonExtent[2*axis] = std::min(referenceExtent[2*axis], compareExtent[2*axis]);
+    commonExtent[2*axis+1] = std::max(referenceExtent[2*axis+1], compareExtent[2*axis+1]);
+    dimensions[axis] = commonExtent[2*axis+1] - commonExtent[2*axis] + 1;
+    if (dimensions[axis] <= 0)
+    {
+      vtkErrorMacro("Update: Empty input labelmap");
+      return false;
+    }
+  }
+  vtkIdType numberOfVoxels = dimensions[0] * dimensions[1] * dimensions[2];
+
+  // Create binary masks
+  std::vector<unsigned char> referenceMask(numberOfVoxels, 0);
+  std::vector<unsigned char> compareMask(numberOfVoxels, 0);
+  switch (referenceLabelmap->GetScalarType())
+  {
+    vtkTemplateMacro( FillMaskFromLabelmap(referenceLabelmap, static_cast<VTK_TT*>(nullptr), commonExtent, referenceMask) );
+  default:
+    vtkErrorMacro("Update: Unknown scalar type in reference labelmap");
+    return false;
+  }
+  switch (compareLabelmap->GetScalarType())
+  {
+    vtkTemplateMacro( FillMaskFromLabelmap(compareLabelmap.GetPointer(), static_cast<VTK_TT*>(nullptr), commonExtent, compareMask) );
+  default:
+    vtkErrorMacro("Update: Unknown scalar type in compare labelmap");
+    return false;
+  }
+
+  // Extract boundaries
+  std::vector<unsigned char> referenceBoundary(numberOfVoxels, 0);
+  std::vector<unsigned char> compareBoundary(numberOfVoxels, 0);
+  BoundaryExtractionFunctor boundaryFunctor;
+  for (int axis=0; axis<3; ++axis)
+  {
+    boundaryFunctor.Dimensions[axis] = dimensions[axis];
+  }
+  boundaryFunctor.Mask = referenceMask.data();
+  boundaryFunctor.Boundary = referenceBoundary.data();
+  vtkSMPTools::For(0, dimensions[2], boundaryFunctor);
+  boundaryFunctor.Mask = compareMask.data();
+  boundaryFunctor.Boundary = compareBoundary.data();
+  vtkSMPTools::For(0, dimensions[2], boundaryFunctor);
+
+  // Masks are not needed any more, free memory before allocating the distance maps
+  std::vector<unsigned char>().swap(referenceMask);
+  std::vector<unsigned char>().swap(compareMask);
+
+  // Compute distance transforms to both boundaries.
+  // Physical spacing is enough, as the axes of the oriented image data are orthonormal
+  double* spacing = referenceLabelmap->GetSpacing();
+  std::vector<float> referenceSquaredDistances;
+  ComputeSquaredDistanceTransform(referenceBoundary, dimensions, spacing, referenceSquaredDistances);
+  std::vector<float> compareSquaredDistances;
+  ComputeSquaredDistanceTransform(compareBoundary, dimensions, spacing, compareSquaredDistances);
+
+  // Read off distances at the boundary voxels of the other segment
+  double toleranceSquared = this->SurfaceDiceToleranceMm * this->SurfaceDiceToleranceMm;
+  vtkIdType numberOfBoundaryVoxelsWithinTolerance = 0;
+  for (vtkIdType index=0; index<numberOfVoxels; ++index)
+  {
+    if (compareBoundary[index])
+    {
+      float squaredDistance = referenceSquaredDistances[index];
+      if (squaredDistance >= UNREACHED_SQUARED_DISTANCE)
+      {
+        break; // Reference is empty
+      }
+      this->CompareToReferenceDistances.push_back(sqrt(squaredDistance));
+      numberOfBoundaryVoxelsWithinTolerance += (squaredDistance <= toleranceSquared ? 1 : 0);
+    }
+    if (referenceBoundary[index])
+    {
+      float squaredDistance = compareSquaredDistances[index];
+      if (squaredDistance >= UNREACHED_SQUARED_DISTANCE)
+      {
+        break; // Compare is empty
+      }
+      this->ReferenceToCompareDistances.push_back(sqrt(squaredDistance));
+      numberOfBoundaryVoxelsWithinTolerance += (squaredDistance <= toleranceSquared ? 1 : 0);
+    }
+  }
+  if (this->CompareToReferenceDistances.empty() || this->ReferenceToCompareDistances.empty())
+  {
+    vtkErrorMacro("Update: Reference or compare labelmap is empty");
+    this->ResetOutputs();
+    return false;
+  }
+
+  // Compute statistics
+  double compareToReferenceMaximum = 0.0;
+  double compareToReferenceSum = 0.0;
+  for (double distance : this->CompareToReferenceDistances)
+  {
+    compareToReferenceMaximum = std::max(compareToReferenceMaximum, distance);
+    compareToReferenceSum += distance;
+  }
+  double referenceToCompareMaximum = 0.0;
+  double referenceToCompareSum = 0.0;
+  for (double distance : this->ReferenceToCompareDistances)
+  {
+    referenceToCompareMaximum = std::max(referenceToCompareMaximum, distance);
+    referenceToCompareSum += distance;
+  }
+
+  this->MaximumHausdorffDistanceMm = std::max(compareToReferenceMaximum, referenceToCompareMaximum);
+  this->AverageHausdorffDistanceMm = 0.5 * (
+      compareToReferenceSum / this->CompareToReferenceDistances.size()
+    + referenceToCompareSum / this->ReferenceToCompareDistances.size() );
+  this->Percent95HausdorffDistanceMm = std::max(
+    GetPercentile(this->CompareToReferenceDistances, 95.0),
+    GetPercentile(this->ReferenceToCompareDistances, 95.0) );
+  this->SurfaceDice = (double)numberOfBoundaryVoxelsWithinTolerance
+    / (double)(this->CompareToReferenceDistances.size() + this->ReferenceToCompareDistances.size());
+
+  return true;
+}
@@ -0,0 +1,124 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkLabelmapHausdorffDistanceFilter_h
+#define __vtkLabelmapHausdorffDistanceFilter_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <vector>
+
+#include "vtkSlicerSegmentComparisonModuleLogicExport.h"
+
+class vtkOrientedImageData;
+
+/// \class vtkLabelmapHausdorffDistanceFilter
+/// \brief Compute boundary Hausdorff distances between two binary labelmaps using Euclidean distance transforms.
+///
+/// The boundary voxels of both labelmaps are extracted (zero padding is assumed outside the image),
+/// then an exact Euclidean distance transform (Felzenszwalb-Huttenlocher lower envelope of parabolas,
+/// linear in the number of voxels) is computed once for each boundary. The distances from each boundary
+/// to the other are then read off at the boundary voxels, which gives the symmetric maximum, average and
+/// 95th percentile Hausdorff distances and the surface Dice coefficient in one pass.
+///
+/// No closed surface conversion is performed. The distance transform passes are run in parallel
+/// across image slices using vtkSMPTools.
+///
+/// Like \sa vtkPolyDataDistanceHistogramFilter, this class is not part of the VTK pipeline.
+class VTK_SLICER_SEGMENTCOMPARISON_MODULE_LOGIC_EXPORT vtkLabelmapHausdorffDistanceFilter : public vtkObject
+{
+public:
+  static vtkLabelmapHausdorffDistanceFilter *New();
+  vtkTypeMacro(vtkLabelmapHausdorffDistanceFilter,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set reference binary labelmap. Any non-zero voxel is considered to be inside the segment.
+  virtual void SetInputReferenceLabelmap(vtkOrientedImageData* labelmap);
+  /// Get reference binary labelmap
+  vtkGetObjectMacro(InputReferenceLabelmap, vtkOrientedImageData);
+
+  /// Set compare binary labelmap. If its geometry differs from the reference, it is resampled
+  /// into the geometry of the reference labelmap (padded to contain both) before computation.
+  virtual void SetInputCompareLabelmap(vtkOrientedImageData* labelmap);
+  /// Get compare binary labelmap
+  vtkGetObjectMacro(InputCompareLabelmap, vtkOrientedImageData);
+
+  /// Set tolerance (in mm) within which boundary voxels are considered matching for surface Dice
+  vtkSetMacro(SurfaceDiceToleranceMm, double);
+  /// Get tolerance (in mm) within which boundary voxels are considered matching for surface Dice
+  vtkGetMacro(SurfaceDiceToleranceMm, double);
+
+  /// Compute distance transforms and boundary distance statistics
+  /// \return Success flag
+  bool Update();
+
+  /// Get maximum of the boundary distances in both directions (symmetric Hausdorff distance)
+  vtkGetMacro(MaximumHausdorffDistanceMm, double);
+  /// Get average of the two directed average boundary distances
+  /// (this corresponds to the 'average Hausdorff distance' in plastimatch)
+  vtkGetMacro(AverageHausdorffDistanceMm, double);
+  /// Get maximum of the two directed 95th percentile boundary distances
+  /// (this corresponds to the 'percent Hausdorff distance' in plastimatch)
+  vtkGetMacro(Percent95HausdorffDistanceMm, double);
+  /// Get surface Dice coefficient, i.e. the fraction of boundary voxels of both labelmaps
+  /// that are within the tolerance of the other boundary \sa SurfaceDiceToleranceMm
+  vtkGetMacro(SurfaceDice, double);
+
+  /// Get distances from each compare boundary voxel to the reference boundary (in mm)
+  const std::vector<double>& GetCompareToReferenceDistances() { return this->CompareToReferenceDistances; };
+  /// Get distances from each reference boundary voxel to the compare boundary (in mm)
+  const std::vector<double>& GetReferenceToCompareDistances() { return this->ReferenceToCompareDistances; };
+
+protected:
+  /// Reset output values
+  void ResetOutputs();
+
+protected:
+  vtkLabelmapHausdorffDistanceFilter();
+  ~vtkLabelmapHausdorffDistanceFilter() override;
+
+protected:
+  /// Reference binary labelmap
+  vtkOrientedImageData* InputReferenceLabelmap;
+  /// Compare binary labelmap
+  vtkOrientedImageData* InputCompareLabelmap;
+
+  /// Tolerance (in mm) within which boundary voxels are considered matching for surface Dice.
+  /// Default is 1 mm.
+  double SurfaceDiceToleranceMm;
+
+  /// Maximum of the boundary distances in both directions
+  double MaximumHausdorffDistanceMm;
+  /// Average of the two directed average boundary distances
+  double AverageHausdorffDistanceMm;
+  /// Maximum of the two directed 95th percentile boundary distances
+  double Percent95HausdorffDistanceMm;
+  /// Surface Dice coefficient
+  double SurfaceDice;
+
+  /// Distances from each compare boundary voxel to the reference boundary
+  std::vector<double> CompareToReferenceDistances;
+  /// Distances from each reference boundary voxel to the compare boundary
+  std::vector<double> ReferenceToCompareDistances;
+
+private:
+  vtkLabelmapHausdorffDistanceFilter(const vtkLabelmapHausdorffDistanceFilter&) = delete;
+  void operator=(const vtkLabelmapHausdorffDistanceFilter&) = delete;
+};
+
+#endif
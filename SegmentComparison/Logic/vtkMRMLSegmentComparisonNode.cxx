@@ -42,6 +42,7 @@ static const char* COMPARE_SEGMENTATION_REFERENCE_ROLE = "compareSegmentationRef
 static const char* RASTERIZATION_REFERENCE_VOLUME_REFERENCE_ROLE = "rasterizationReferenceVolumeRef";
 static const char* DICE_TABLE_REFERENCE_ROLE = "diceTableRef";
 static const char* HAUSDORFF_TABLE_REFERENCE_ROLE = "hausdorffTableRef";
+static const char* OVERLAP_MATRIX_TABLE_REFERENCE_ROLE = "overlapMatrixTableRef";
 
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLSegmentComparisonNode);
@@ -69,6 +70,9 @@ vtkMRMLSegmentComparisonNode::vtkMRMLSegmentComparisonNode()
   this->AverageHausdorffDistanceForBoundaryMm = -1.0;
   this->Percent95HausdorffDistanceForVolumeMm = -1.0;
   this->Percent95HausdorffDistanceForBoundaryMm = -1.0;
+  this->UseDistanceTransformHausdorff = false;
+  this->SurfaceDiceToleranceMm = 1.0;
+  this->SurfaceDice = -1.0;
   this->HausdorffResultsValidOff();
 
   this->HideFromEditors = false;
@@ -128,6 +132,9 @@ void vtkMRMLSegmentComparisonNode::WriteXML(ostream& of, int nIndent)
   of << " AverageHausdorffDistanceForBoundaryMm=\"" << this->AverageHausdorffDistanceForBoundaryMm << "\"";
   of << " Percent95HausdorffDistanceForVolumeMm=\"" << this->Percent95HausdorffDistanceForVolumeMm << "\"";
   of << " Percent95HausdorffDistanceForBoundaryMm=\"" << this->Percent95HausdorffDistanceForBoundaryMm << "\"";
+  of << " UseDistanceTransformHausdorff=\"" << (this->UseDistanceTransformHausdorff ? "true" : "false") << "\"";
+  of << " SurfaceDiceToleranceMm=\"" << this->SurfaceDiceToleranceMm << "\"";
+  of << " SurfaceDice=\"" << this->SurfaceDice << "\"";
 
   of << " HausdorffResultsValid=\"" << (this->HausdorffResultsValid ? "true" : "false") << "\"";
 }
@@ -242,6 +249,18 @@ void vtkMRMLSegmentComparisonNode::ReadXMLAttributes(const char** atts)
     {
       this->Percent95HausdorffDistanceForBoundaryMm = vtkVariant(attValue).ToDouble();
     }
+    else if (!strcmp(attName, "UseDistanceTransformHausdorff")) 
+      {
+      this->UseDistanceTransformHausdorff = (strcmp(attValue,"true") ? false : true);
+      }
+    else if (!strcmp(attName, "SurfaceDiceToleranceMm")) 
+      {
+      this->SurfaceDiceToleranceMm = vtkVariant(attValue).ToDouble();
+      }
+    else if (!strcmp(attName, "SurfaceDice")) 
+      {
+      this->SurfaceDice = vtkVariant(attValue).ToDouble();
+      }
     else if (!strcmp(attName, "HausdorffResultsValid")) 
       {
       this->HausdorffResultsValid = (strcmp(attValue,"true") ? false : true);
@@ -277,6 +296,9 @@ void vtkMRMLSegmentComparisonNode::Copy(vtkMRMLNode *anode)
   this->AverageHausdorffDistanceForBoundaryMm = node->AverageHausdorffDistanceForBoundaryMm;
   this->Percent95HausdorffDistanceForVolumeMm = node->Percent95HausdorffDistanceForVolumeMm;
   this->Percent95HausdorffDistanceForBoundaryMm = node->Percent95HausdorffDistanceForBoundaryMm;
+  this->UseDistanceTransformHausdorff = node->UseDistanceTransformHausdorff;
+  this->SurfaceDiceToleranceMm = node->SurfaceDiceToleranceMm;
+  this->SurfaceDice = node->SurfaceDice;
   this->HausdorffResultsValid = node->HausdorffResultsValid;
 
   this->DisableModifiedEventOff();
@@ -329,6 +351,9 @@ void vtkMRMLSegmentComparisonNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << " AverageHausdorffDistanceForBoundaryMm:   " << this->AverageHausdorffDistanceForBoundaryMm << "\n";
   os << indent << " Percent95HausdorffDistanceForVolumeMm:   " << this->Percent95HausdorffDistanceForVolumeMm << "\n";
   os << indent << " Percent95HausdorffDistanceForBoundaryMm:   " << this->Percent95HausdorffDistanceForBoundaryMm << "\n";
+  os << indent << " UseDistanceTransformHausdorff:   " << (this->UseDistanceTransformHausdorff ? "true" : "false") << "\n";
+  os << indent << " SurfaceDiceToleranceMm:   " << this->SurfaceDiceToleranceMm << "\n";
+  os << indent << " SurfaceDice:   " << this->SurfaceDice << "\n";
 
   os << indent << " HausdorffResultsValid:   " << (this->HausdorffResultsValid ? "true" : "false") << "\n";
 }
@@ -422,3 +447,21 @@ void vtkMRMLSegmentComparisonNode::SetAndObserveHausdorffTableNode(vtkMRMLTableN
 
   this->SetNodeReferenceID(HAUSDORFF_TABLE_REFERENCE_ROLE, (node ? node->GetID() : nullptr));
 }
+
+//----------------------------------------------------------------------------
+vtkMRMLTableNode* vtkMRMLSegmentComparisonNode::GetOverlapMatrixTableNode()
+{
+  return vtkMRMLTableNode::SafeDownCast( this->GetNodeReference(OVERLAP_MATRIX_TABLE_REFERENCE_ROLE) );
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSegmentComparisonNode::SetAndObserveOverlapMatrixTableNode(vtkMRMLTableNode* node)
+{
+  if (node && this->Scene != node->GetScene())
+    {
+    vtkErrorMacro("Cannot set reference: the referenced and referencing node are not in the same scene");
+    return;
+    }
+
+  this->SetNodeReferenceID(OVERLAP_MATRIX_TABLE_REFERENCE_ROLE, (node ? node->GetID() : nullptr));
+}
@@ -80,6 +80,11 @@ public:
   /// Set Hausdorff table node
   void SetAndObserveHausdorffTableNode(vtkMRMLTableNode* node);
 
+  /// Get overlap matrix table node, containing overlap metrics for all reference and compare segment pairs
+  vtkMRMLTableNode* GetOverlapMatrixTableNode();
+  /// Set overlap matrix table node
+  void SetAndObserveOverlapMatrixTableNode(vtkMRMLTableNode* node);
+
   /// Get reference segment ID
   vtkGetStringMacro(ReferenceSegmentID);
   /// Set reference segment ID
@@ -170,6 +175,22 @@ public:
   /// Set 95% Hausdorff distance for the boundary voxels
   vtkSetMacro(Percent95HausdorffDistanceForBoundaryMm, double);
 
+  /// Get/Set flag determining whether Hausdorff distances are computed from Euclidean distance
+  /// transforms of the segment boundaries instead of using plastimatch
+  vtkGetMacro(UseDistanceTransformHausdorff, bool);
+  vtkSetMacro(UseDistanceTransformHausdorff, bool);
+  vtkBooleanMacro(UseDistanceTransformHausdorff, bool);
+
+  /// Get tolerance for surface Dice computation
+  vtkGetMacro(SurfaceDiceToleranceMm, double);
+  /// Set tolerance for surface Dice computation
+  vtkSetMacro(SurfaceDiceToleranceMm, double);
+
+  /// Get surface Dice coefficient
+  vtkGetMacro(SurfaceDice, double);
+  /// Set surface Dice coefficient
+  vtkSetMacro(SurfaceDice, double);
+
   /// Get/Set results Hausdorff valid flag
   vtkGetMacro(HausdorffResultsValid, bool);
   vtkSetMacro(HausdorffResultsValid, bool);
@@ -236,6 +257,17 @@ protected:
   /// 95% Hausdorff distance for the boundary voxels
   double Percent95HausdorffDistanceForBoundaryMm;
 
+  /// Flag determining whether Hausdorff distances are computed from Euclidean distance transforms
+  /// of the segment boundaries. In this case only the boundary distances and the surface Dice are computed.
+  bool UseDistanceTransformHausdorff;
+
+  /// Tolerance within which boundary voxels are considered matching for surface Dice computation
+  double SurfaceDiceToleranceMm;
+
+  /// Surface Dice coefficient, i.e. fraction of the boundary voxels within tolerance of the other boundary.
+  /// Only computed if distance transform Hausdorff is used
+  double SurfaceDice;
+
   /// Flag telling whether the Hausdorff results are valid
   bool HausdorffResultsValid;
 };
@@ -12,9 +12,11 @@
 #include <vtkObjectFactory.h>
 #include <vtkPolyDataPointSampler.h>
 #include <vtkSmartPointer.h>
-#include <vtkSortDataArray.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 
+// STD includes
+#include <algorithm>
+
 vtkStandardNewMacro(vtkPolyDataDistanceHistogramFilter);
 
 //----------------------------------------------------------------------------
@@ -26,6 +28,10 @@ const int vtkPolyDataDistanceHistogramFilter::OUTPUT_PORT_HISTOGRAM = 0;
 //----------------------------------------------------------------------------
 vtkPolyDataDistanceHistogramFilter::vtkPolyDataDistanceHistogramFilter()
   : OutputDistances(nullptr)
+  , DistanceStatisticsValid(false)
+  , MaximumDistance(0.0)
+  , AverageDistance(0.0)
+  , StandardDeviationDistance(0.0)
   , SamplePolyDataVertices(1)
   , SamplePolyDataEdges(0)
   , SamplePolyDataFaces(0)
@@ -109,6 +115,51 @@ vtkTable* vtkPolyDataDistanceHistogramFilter::GetOutputHistogram()
   return this->OutputHistogram;
 }
 
+//----------------------------------------------------------------------------
+void vtkPolyDataDistanceHistogramFilter::UpdateDistanceStatistics()
+{
+  if (this->DistanceStatisticsValid)
+  {
+    return;
+  }
+
+  // Compute maximum norm, mean and variance in a single pass (Welford's algorithm)
+  double maximumDistance = 0.0;
+  double mean = 0.0;
+  double sumOfSquaredDifferencesFromMean = 0.0;
+  vtkIdType numberOfDistances = this->OutputDistances->GetNumberOfValues();
+  for (vtkIdType distanceIndex=0; distanceIndex<numberOfDistances; ++distanceIndex)
+  {
+    double distance = this->OutputDistances->GetValue(distanceIndex);
+    maximumDistance = std::max(maximumDistance, fabs(distance));
+    double differenceFromMean = distance - mean;
+    mean += differenceFromMean / (double)(distanceIndex + 1);
+    sumOfSquaredDifferencesFromMean += differenceFromMean * (distance - mean);
+  }
+
+  this->MaximumDistance = maximumDistance;
+  this->AverageDistance = mean;
+  this->StandardDeviationDistance = (numberOfDistances > 0 ? sqrt(sumOfSquaredDifferencesFromMean / (double)numberOfDistances) : 0.0);
+  this->DistanceStatisticsValid = true;
+}
+
+//----------------------------------------------------------------------------
+void vtkPolyDataDistanceHistogramFilter::UpdateSortedDistances()
+{
+  vtkIdType numberOfDistances = this->OutputDistances->GetNumberOfValues();
+  if (static_cast<vtkIdType>(this->SortedDistances.size()) == numberOfDistances)
+  {
+    return;
+  }
+
+  this->SortedDistances.resize(numberOfDistances);
+  for (vtkIdType distanceIndex=0; distanceIndex<numberOfDistances; ++distanceIndex)
+  {
+    this->SortedDistances[distanceIndex] = this->OutputDistances->GetValue(distanceIndex);
+  }
+  std::sort(this->SortedDistances.begin(), this->SortedDistances.end());
+}
+
 //----------------------------------------------------------------------------
 double vtkPolyDataDistanceHistogramFilter::GetMaximumHausdorffDistance()
 {
@@ -118,7 +169,8 @@ double vtkPolyDataDistanceHistogramFilter::GetMaximumHausdorffDistance()
     return 0.0;
   }
 
-  return this->OutputDistances->GetMaxNorm();
+  this->UpdateDistanceStatistics();
+  return this->MaximumDistance;
 }
   
 //----------------------------------------------------------------------------
@@ -130,14 +182,8 @@ double vtkPolyDataDistanceHistogramFilter::GetAverageHausdorffDistance()
     return 0.0;
   }
 
-  double sum = 0.0;
-  int numberOfDistances = this->OutputDistances->GetNumberOfValues();
-  for (int distanceIndex=0; distanceIndex<numberOfDistances; ++distanceIndex)
-  {
-    sum += this->OutputDistances->GetValue(distanceIndex);
-  }
-
-  return sum / (double)numberOfDistances;
+  this->UpdateDistanceStatistics();
+  return this->AverageDistance;
 }
   
 //----------------------------------------------------------------------------
@@ -149,20 +195,8 @@ double vtkPolyDataDistanceHistogramFilter::GetStandardDeviationHausdorffDistance
     return 0.0;
   }
 
-  double averageDistance = this->GetAverageHausdorffDistance();
-  double sumOfSquaredDifferencesFromAverage = 0.0;
-  int numberOfDistances = this->OutputDistances->GetNumberOfValues();
-  for (int distanceIndex=0; distanceIndex<numberOfDistances; ++distanceIndex)
-  {
-    double distance = this->OutputDistances->GetValue(distanceIndex);
-    double differenceFromAverage = averageDistance - distance;
-    double squaredDifferenceFromAverage = pow(differenceFromAverage, 2);
-    sumOfSquaredDifferencesFromAverage += squaredDifferenceFromAverage;
-  }
-
-  double averageDifferenceFromAverage = sumOfSquaredDifferencesFromAverage / (double)numberOfDistances;
-  double stdev = sqrt(averageDifferenceFromAverage);
-  return stdev;
+  this->UpdateDistanceStatistics();
+  return this->StandardDeviationDistance;
 }
   
 //----------------------------------------------------------------------------
@@ -180,33 +214,52 @@ double vtkPolyDataDistanceHistogramFilter::GetPercent95HausdorffDistance()
 //----------------------------------------------------------------------------
 double vtkPolyDataDistanceHistogramFilter::GetNthPercentileHausdorffDistance(double n)
 {
-  if (!this->OutputDistances)
+  std::vector<double> percentiles(1, n);
+  std::vector<double> distances;
+  if (!this->GetNthPercentileHausdorffDistances(percentiles, distances))
   {
-    vtkErrorMacro("GetPercentNthHausdorffDistance: Output distances has not been created! Need to call Update after setting the inputs.");
     return 0.0;
   }
+  return distances[0];
+}
 
-  if (n < 0)
+//----------------------------------------------------------------------------
+bool vtkPolyDataDistanceHistogramFilter::GetNthPercentileHausdorffDistances(const std::vector<double>& percentiles, std::vector<double>& distances)
+{
+  distances.clear();
+  if (!this->OutputDistances)
   {
-    vtkErrorMacro("GetPercentNthHausdorffDistance: N " << n << " must be equal to or greater than 0. Returning 0.0.");
-    return 0.0;
+    vtkErrorMacro("GetNthPercentileHausdorffDistances: Output distances has not been created! Need to call Update after setting the inputs.");
+    return false;
   }
 
-  if (n > 100)
+  for (double n : percentiles)
   {
-    vtkErrorMacro("GetPercentNthHausdorffDistance: N " << n << " must be equal to or less than 100. Returning 0.0.");
-    return 0.0;
+    if (n < 0)
+    {
+      vtkErrorMacro("GetNthPercentileHausdorffDistances: N " << n << " must be equal to or greater than 0.");
+      return false;
+    }
+    if (n > 100)
+    {
+      vtkErrorMacro("GetNthPercentileHausdorffDistances: N " << n << " must be equal to or less than 100.");
+      return false;
+    }
   }
 
-  vtkSmartPointer<vtkDoubleArray> sortedDistances = vtkSmartPointer<vtkDoubleArray>::New();
-  sortedDistances->DeepCopy(this->OutputDistances);
-
-  vtkSmartPointer<vtkSortDataArray> sortDataArray = vtkSmartPointer<vtkSortDataArray>::New();
-  sortDataArray->Sort(sortedDistances);
+  this->UpdateSortedDistances();
+  if (this->SortedDistances.empty())
+  {
+    vtkErrorMacro("GetNthPercentileHausdorffDistances: There are no output distances");
+    return false;
+  }
 
-  int nthPercentileIndex = vtkMath::Round( (n/ 100) * (sortedDistances->GetNumberOfValues() - 1) );
-  double percentileNthDistance = sortedDistances->GetValue( nthPercentileIndex );
-  return percentileNthDistance;
+  for (double n : percentiles)
+  {
+    int nthPercentileIndex = vtkMath::Round( (n / 100) * (this->SortedDistances.size() - 1) );
+    distances.push_back(this->SortedDistances[nthPercentileIndex]);
+  }
+  return true;
 }
 
 //----------------------------------------------------------------------------
@@ -339,6 +392,10 @@ void vtkPolyDataDistanceHistogramFilter::Update()
   //outputDistances->DeepCopy(distances);
   this->OutputDistances->DeepCopy(distances);
 
+  // Invalidate cached statistics
+  this->DistanceStatisticsValid = false;
+  this->SortedDistances.clear();
+
   // output the histogram
   this->OutputHistogram->DeepCopy(histogram);
 }
@@ -5,6 +5,9 @@
 #include <vtkDoubleArray.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <vector>
+
 #include "vtkSlicerSegmentComparisonModuleLogicExport.h"
 
 
@@ -76,6 +79,13 @@ public:
   // Get the Nth percentile of the absolute of the minimum distances \sa GetOutputDistances from the compare mesh to the reference mesh.
   /// (this corresponds to the 'percent Hausdorff distance' in plastimatch: http://plastimatch.org/doxygen/classHausdorff__distance.html )
   double GetNthPercentileHausdorffDistance(double n);
+
+  /// Get multiple percentiles of the minimum distances \sa GetOutputDistances from the compare mesh to the reference mesh.
+  /// The distances are sorted only once after each \sa Update, so subsequent percentile queries are constant time.
+  /// \param percentiles List of percentiles to query, each between 0 and 100
+  /// \param distances Output list of distances corresponding to the percentiles
+  /// \return Success flag
+  bool GetNthPercentileHausdorffDistances(const std::vector<double>& percentiles, std::vector<double>& distances);
   
   /// Set whether the filter should sample on the vertices of the input vtkPolyData objects.
   vtkSetMacro(SamplePolyDataVertices, int);
@@ -138,6 +148,13 @@ private:
   /// \param comparePolyData The compare vtkPolyData on which to compute the distances. Distances are measured from points on the comparePolyData to the referencePolyData.
   /// \param distanceArray The array in which to store the raw distances.
   void ComputeDistances(vtkPolyData* referencePolyData, vtkPolyData* comparePolyData, vtkDoubleArray* distanceArray);
+
+  /// Compute maximum, average and standard deviation of the output distances in one pass,
+  /// if they have not been computed since the last \sa Update
+  void UpdateDistanceStatistics();
+
+  /// Sort output distances into \sa SortedDistances if not done since the last \sa Update
+  void UpdateSortedDistances();
   
 protected:
   /// Compare polydata, one of the inputs to generate the distances (from the compare vtkPolyData to the reference vtkPolyData)
@@ -150,6 +167,17 @@ protected:
   /// Output distances for each reference vertex in an array
   vtkDoubleArray* OutputDistances;
 
+  /// Flag indicating whether the cached distance statistics are up to date with the output distances
+  bool DistanceStatisticsValid;
+  /// Cached maximum of the absolute of the output distances
+  double MaximumDistance;
+  /// Cached average of the output distances
+  double AverageDistance;
+  /// Cached standard deviation of the output distances
+  double StandardDeviationDistance;
+  /// Sorted copy of the output distances for percentile queries. Empty if not computed since the last \sa Update
+  std::vector<double> SortedDistances;
+
   /// Flag determining  whether the filter should sample on the vertices of the input vtkPolyData objects.
   /// All vertices from the vtkPolyData will be used, regardless of the sampling distance.
   /// Default is 1 (on).
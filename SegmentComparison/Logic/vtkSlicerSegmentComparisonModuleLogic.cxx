@@ -21,6 +21,7 @@
 // SegmentComparison includes
 #include "vtkSlicerSegmentComparisonModuleLogic.h"
 #include "vtkMRMLSegmentComparisonNode.h"
+#include "vtkLabelmapHausdorffDistanceFilter.h"
 
 // Segmentations includes
 #include "vtkMRMLSegmentationNode.h"
@@ -29,6 +30,8 @@
 // SegmentationCore includes
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
+#include "vtkSegmentation.h"
+#include "vtkSegment.h"
 
 // SlicerRT includes
 #include "PlmCommon.h"
@@ -51,6 +54,186 @@
 #include <vtkTimerLog.h>
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSMPTools.h>
+#include <vtkSMPThreadLocal.h>
+
+// STD includes
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+  /// Number of segments stored in one word of the per-voxel segment bit masks
+  const int SEGMENTS_PER_WORD = 64;
+
+  //---------------------------------------------------------------------------
+  /// Set the bit of the given segment in the per-voxel bit masks for each non-zero voxel of the labelmap.
+  /// The labelmap must be on the same lattice as the common extent.
+  template<class T>
+  void SetSegmentBitsFromLabelmap(vtkImageData* image, T* vtkNotUsed(typePtr), const int commonExtent[6],
+    int numberOfWords, int segmentIndex, std::vector<vtkTypeUInt64>& segmentBits)
+  {
+    int* imageExtent = image->GetExtent();
+    int extent[6] = { 0 };
+    for (int axis=0; axis<3; ++axis)
+    {
+      extent[2*axis] = std::max(imageExtent[2*axis], commonExtent[2*axis]);
+      extent[2*axis+1] = std::min(imageExtent[2*axis+1], commonExtent[2*axis+1]);
+      if (extent[2*axis] > extent[2*axis+1])
+      {
+        return; // No overlap with the common extent
+      }
+    }
+
+    vtkIdType dimX = commonExtent[1] - commonExtent[0] + 1;
+    vtkIdType dimY = commonExtent[3] - commonExtent[2] + 1;
+    vtkIdType* increments = image->GetIncrements();
+    int wordIndex = segmentIndex / SEGMENTS_PER_WORD;
+    vtkTypeUInt64 segmentBit = vtkTypeUInt64(1) << (segmentIndex % SEGMENTS_PER_WORD);
+    for (int k=extent[4]; k<=extent[5]; ++k)
+    {
+      for (int j=extent[2]; j<=extent[3]; ++j)
+      {
+        T* imagePtr = static_cast<T*>(image->GetScalarPointer(extent[0], j, k));
+        vtkIdType voxelIndex = (k-commonExtent[4])*dimX*dimY + (j-commonExtent[2])*dimX + (extent[0]-commonExtent[0]);
+        for (int i=extent[0]; i<=extent[1]; ++i, ++voxelIndex)
+        {
+          if ((*imagePtr) != 0)
+          {
+            segmentBits[voxelIndex*numberOfWords + wordIndex] |= segmentBit;
+          }
+          imagePtr += increments[0];
+        }
+      }
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  /// Overlap counts accumulated for all pairs of reference and compare segments
+  struct OverlapCounts
+  {
+    void Reset(int numberOfReferenceSegments, int numberOfCompareSegments)
+    {
+      this->Intersections.assign(numberOfReferenceSegments * numberOfCompareSegments, 0);
+      this->ReferenceVoxelCounts.assign(numberOfReferenceSegments, 0);
+      this->CompareVoxelCounts.assign(numberOfCompareSegments, 0);
+      this->ReferenceIjkSums.assign(3 * numberOfReferenceSegments, 0.0);
+      this->CompareIjkSums.assign(3 * numberOfCompareSegments, 0.0);
+    }
+
+    /// Number of voxels in both segments for each reference (row) and compare (column) segment
+    std::vector<vtkIdType> Intersections;
+    std::vector<vtkIdType> ReferenceVoxelCounts;
+    std::vector<vtkIdType> CompareVoxelCounts;
+    /// Sum of the IJK coordinates of the voxels of each segment, for centroid computation
+    std::vector<double> ReferenceIjkSums;
+    std::vector<double> CompareIjkSums;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Accumulate the segment contingency matrix in one sweep over the voxels, in parallel across slices
+  class OverlapMatrixFunctor
+  {
+  public:
+    const vtkTypeUInt64* ReferenceSegmentBits;
+    const vtkTypeUInt64* CompareSegmentBits;
+    int NumberOfReferenceWords;
+    int NumberOfCompareWords;
+    int NumberOfReferenceSegments;
+    int NumberOfCompareSegments;
+    vtkIdType Dimensions[3];
+
+    vtkSMPThreadLocal<OverlapCounts> ThreadLocalCounts;
+    OverlapCounts Counts;
+
+    void Initialize()
+    {
+      this->ThreadLocalCounts.Local().Reset(this->NumberOfReferenceSegments, this->NumberOfCompareSegments);
+    }
+
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+    {
+      OverlapCounts& counts = this->ThreadLocalCounts.Local();
+      std::vector<int> referenceSegmentIndices;
+      std::vector<int> compareSegmentIndices;
+      for (vtkIdType k=beginSlice; k<endSlice; ++k)
+      {
+        for (vtkIdType j=0; j<this->Dimensions[1]; ++j)
+        {
+          vtkIdType voxelIndex = (k*this->Dimensions[1] + j) * this->Dimensions[0];
+          for (vtkIdType i=0; i<this->Dimensions[0]; ++i, ++voxelIndex)
+          {
+            GetSetSegmentIndices(this->ReferenceSegmentBits + voxelIndex*this->NumberOfReferenceWords,
+              this->NumberOfReferenceWords, referenceSegmentIndices);
+            GetSetSegmentIndices(this->CompareSegmentBits + voxelIndex*this->NumberOfCompareWords,
+              this->NumberOfCompareWords, compareSegmentIndices);
+
+            for (int referenceIndex : referenceSegmentIndices)
+            {
+              ++counts.ReferenceVoxelCounts[referenceIndex];
+              counts.ReferenceIjkSums[3*referenceIndex] += i;
+              counts.ReferenceIjkSums[3*referenceIndex+1] += j;
+              counts.ReferenceIjkSums[3*referenceIndex+2] += k;
+              for (int compareIndex : compareSegmentIndices)
+              {
+                ++counts.Intersections[referenceIndex*this->NumberOfCompareSegments + compareIndex];
+              }
+            }
+            for (int compareIndex : compareSegmentIndices)
+            {
+              ++counts.CompareVoxelCounts[compareIndex];
+              counts.CompareIjkSums[3*compareIndex] += i;
+              counts.CompareIjkSums[3*compareIndex+1] += j;
+              counts.CompareIjkSums[3*compareIndex+2] += k;
+            }
+          }
+        }
+      }
+    }
+
+    void Reduce()
+    {
+      this->Counts.Reset(this->NumberOfReferenceSegments, this->NumberOfCompareSegments);
+      for (vtkSMPThreadLocal<OverlapCounts>::iterator countsIt = this->ThreadLocalCounts.begin(); countsIt != this->ThreadLocalCounts.end(); ++countsIt)
+      {
+        AddVector(countsIt->Intersections, this->Counts.Intersections);
+        AddVector(countsIt->ReferenceVoxelCounts, this->Counts.ReferenceVoxelCounts);
+        AddVector(countsIt->CompareVoxelCounts, this->Counts.CompareVoxelCounts);
+        AddVector(countsIt->ReferenceIjkSums, this->Counts.ReferenceIjkSums);
+        AddVector(countsIt->CompareIjkSums, this->Counts.CompareIjkSums);
+      }
+    }
+
+  protected:
+    static void GetSetSegmentIndices(const vtkTypeUInt64* words, int numberOfWords, std::vector<int>& segmentIndices)
+    {
+      segmentIndices.clear();
+      for (int wordIndex=0; wordIndex<numberOfWords; ++wordIndex)
+      {
+        vtkTypeUInt64 word = words[wordIndex];
+        for (int bitIndex=0; word; ++bitIndex, word >>= 1)
+        {
+          if (word & 1)
+          {
+            segmentIndices.push_back(wordIndex*SEGMENTS_PER_WORD + bitIndex);
+          }
+        }
+      }
+    }
+
+    template<class T>
+    static void AddVector(const std::vector<T>& source, std::vector<T>& target)
+    {
+      for (size_t index=0; index<source.size(); ++index)
+      {
+        target[index] += source[index];
+      }
+    }
+  };
+}
 
 //-----------------------------------------------------------------------------
 /// \ingroup SlicerRt_QtModules_SegmentComparison
@@ -60,6 +243,22 @@ public:
   static vtkSlicerSegmentComparisonModuleLogicPrivate *New();
   vtkTypeMacro(vtkSlicerSegmentComparisonModuleLogicPrivate,vtkObject);
 
+  /// Get input segments as binary labelmaps, with parent transforms applied if necessary
+  /// \return Error message, empty string if no error
+  std::string GetInputSegmentLabelmaps(
+    vtkMRMLSegmentComparisonNode* parameterNode,
+    vtkOrientedImageData* referenceSegmentLabelmap,
+    vtkOrientedImageData* compareSegmentLabelmap);
+
+  /// Get binary labelmaps of all segments in a segmentation
+  /// \param applyParentTransform Apply parent transform of the segmentation node to the labelmaps
+  /// \return Error message, empty string if no error
+  std::string GetAllSegmentLabelmaps(
+    vtkMRMLSegmentationNode* segmentationNode,
+    bool applyParentTransform,
+    std::vector<std::string>& segmentIDs,
+    std::vector<vtkSmartPointer<vtkOrientedImageData> >& segmentLabelmaps);
+
   /// Get input segments as labelmaps, then convert them to Plm_image volumes
   /// \return Error message, empty string if no error
   std::string GetInputSegmentsAsPlmVolumes(
@@ -96,16 +295,21 @@ vtkSlicerSegmentComparisonModuleLogicPrivate::~vtkSlicerSegmentComparisonModuleL
 }
 
 //---------------------------------------------------------------------------
-std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmVolumes(
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentLabelmaps(
   vtkMRMLSegmentComparisonNode* parameterNode,
-  Plm_image::Pointer& plmRefSegmentLabelmap,
-  Plm_image::Pointer& plmCmpSegmentLabelmap,
-  double &checkpointItkConvertStart )
+  vtkOrientedImageData* referenceSegmentLabelmap,
+  vtkOrientedImageData* compareSegmentLabelmap)
 {
   if (!parameterNode || !this->Logic->GetMRMLScene())
   {
     std::string errorMessage("Invalid MRML scene or parameter set node");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
+    return errorMessage;
+  }
+  if (!referenceSegmentLabelmap || !compareSegmentLabelmap)
+  {
+    std::string errorMessage("Invalid output labelmaps");
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
 
@@ -118,31 +322,29 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
   if (!referenceSegmentationNode || !referenceSegmentID)
   {
     std::string errorMessage("Invalid reference segment selection");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
   if (!compareSegmentationNode || !compareSegmentID)
   {
     std::string errorMessage("Invalid compare segment selection");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
 
   // Get segment binary labelmaps
   referenceSegmentationNode->CreateBinaryLabelmapRepresentation();
-  vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
   if (!referenceSegmentationNode->GetBinaryLabelmapRepresentation(referenceSegmentID, referenceSegmentLabelmap))
   {
     std::string errorMessage("Failed to get binary labelmap from reference segment: " + std::string(referenceSegmentID));
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
   compareSegmentationNode->CreateBinaryLabelmapRepresentation();
-  vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
   if (!compareSegmentationNode->GetBinaryLabelmapRepresentation(compareSegmentID, compareSegmentLabelmap))
   {
     std::string errorMessage("Failed to get binary labelmap from reference segment: " + std::string(compareSegmentID));
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
 
@@ -153,15 +355,73 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
     if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(referenceSegmentationNode, referenceSegmentLabelmap))
     {
       std::string errorMessage("Failed to apply parent transformation to compare segment!");
-      vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+      vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
       return errorMessage;
     }
     if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(compareSegmentationNode, compareSegmentLabelmap))
     {
       std::string errorMessage("Failed to apply parent transformation to reference segment!");
-      vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+      vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetAllSegmentLabelmaps(
+  vtkMRMLSegmentationNode* segmentationNode,
+  bool applyParentTransform,
+  std::vector<std::string>& segmentIDs,
+  std::vector<vtkSmartPointer<vtkOrientedImageData> >& segmentLabelmaps)
+{
+  segmentIDs.clear();
+  segmentLabelmaps.clear();
+  if (!segmentationNode || !segmentationNode->GetSegmentation())
+  {
+    std::string errorMessage("Invalid segmentation node");
+    vtkErrorMacro("GetAllSegmentLabelmaps: " << errorMessage);
+    return errorMessage;
+  }
+
+  segmentationNode->CreateBinaryLabelmapRepresentation();
+  segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+  {
+    vtkSmartPointer<vtkOrientedImageData> segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!segmentationNode->GetBinaryLabelmapRepresentation(*segmentIdIt, segmentLabelmap))
+    {
+      std::string errorMessage("Failed to get binary labelmap from segment: " + (*segmentIdIt));
+      vtkErrorMacro("GetAllSegmentLabelmaps: " << errorMessage);
+      return errorMessage;
+    }
+    if (applyParentTransform
+      && !vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(segmentationNode, segmentLabelmap))
+    {
+      std::string errorMessage("Failed to apply parent transformation to segment: " + (*segmentIdIt));
+      vtkErrorMacro("GetAllSegmentLabelmaps: " << errorMessage);
       return errorMessage;
     }
+    segmentLabelmaps.push_back(segmentLabelmap);
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmVolumes(
+  vtkMRMLSegmentComparisonNode* parameterNode,
+  Plm_image::Pointer& plmRefSegmentLabelmap,
+  Plm_image::Pointer& plmCmpSegmentLabelmap,
+  double &checkpointItkConvertStart )
+{
+  vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  std::string errorMessage = this->GetInputSegmentLabelmaps(parameterNode, referenceSegmentLabelmap, compareSegmentLabelmap);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
   }
 
   // Convert inputs to ITK images
@@ -464,35 +724,76 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
   double checkpointStart = timer->GetUniversalTime();
   UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
   double checkpointItkConvertStart = 0.0;
+  double checkpointHausdorffStart = 0.0;
+  UNUSED_VARIABLE(checkpointHausdorffStart); // Although it is used later, a warning is logged so needs to be suppressed
 
-  // Convert input images to the format Plastimatch can use
-  Plm_image::Pointer plmRefSegmentLabelmap;
-  Plm_image::Pointer plmCmpSegmentLabelmap;
-  std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
-  if (!inputToPlmResult.empty())
+  double maximumHausdorffDistanceForBoundaryMm = -1.0;
+  double averageHausdorffDistanceForBoundaryMm = -1.0;
+  double percent95HausdorffDistanceForBoundaryMm = -1.0;
+  if (parameterNode->GetUseDistanceTransformHausdorff())
   {
-    std::string errorMessage("Error occurred during ITK conversion");
-    vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
-    return errorMessage;
+    // Compute boundary distances directly from the segment labelmaps using distance transforms
+    vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string inputLabelmapsResult = this->LogicPrivate->GetInputSegmentLabelmaps(parameterNode, referenceSegmentLabelmap, compareSegmentLabelmap);
+    if (!inputLabelmapsResult.empty())
+    {
+      return inputLabelmapsResult;
+    }
+
+    checkpointItkConvertStart = checkpointHausdorffStart = timer->GetUniversalTime();
+    vtkSmartPointer<vtkLabelmapHausdorffDistanceFilter> hausdorffFilter = vtkSmartPointer<vtkLabelmapHausdorffDistanceFilter>::New();
+    hausdorffFilter->SetInputReferenceLabelmap(referenceSegmentLabelmap);
+    hausdorffFilter->SetInputCompareLabelmap(compareSegmentLabelmap);
+    hausdorffFilter->SetSurfaceDiceToleranceMm(parameterNode->GetSurfaceDiceToleranceMm());
+    if (!hausdorffFilter->Update())
+    {
+      std::string errorMessage("Failed to compute distance transform Hausdorff distances");
+      vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
+      return errorMessage;
+    }
+
+    maximumHausdorffDistanceForBoundaryMm = hausdorffFilter->GetMaximumHausdorffDistanceMm();
+    averageHausdorffDistanceForBoundaryMm = hausdorffFilter->GetAverageHausdorffDistanceMm();
+    percent95HausdorffDistanceForBoundaryMm = hausdorffFilter->GetPercent95HausdorffDistanceMm();
+    // Only boundary distances are computed in this mode
+    parameterNode->SetMaximumHausdorffDistanceForVolumeMm(-1.0);
+    parameterNode->SetAverageHausdorffDistanceForVolumeMm(-1.0);
+    parameterNode->SetPercent95HausdorffDistanceForVolumeMm(-1.0);
+    parameterNode->SetSurfaceDice(hausdorffFilter->GetSurfaceDice());
+  }
+  else
+  {
+    // Convert input images to the format Plastimatch can use
+    Plm_image::Pointer plmRefSegmentLabelmap;
+    Plm_image::Pointer plmCmpSegmentLabelmap;
+    std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
+    if (!inputToPlmResult.empty())
+    {
+      std::string errorMessage("Error occurred during ITK conversion");
+      vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
+      return errorMessage;
+    }
+
+    // Compute Hausdorff distances
+    checkpointHausdorffStart = timer->GetUniversalTime();
+    Hausdorff_distance hausdorff;
+    hausdorff.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
+    hausdorff.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
+    hausdorff.set_volume_boundary_behavior(ZERO_PADDING);
+    hausdorff.run();
+
+    maximumHausdorffDistanceForBoundaryMm = hausdorff.get_boundary_hausdorff();
+    averageHausdorffDistanceForBoundaryMm = hausdorff.get_avg_average_boundary_hausdorff();
+    percent95HausdorffDistanceForBoundaryMm = hausdorff.get_percent_boundary_hausdorff();
+    parameterNode->SetMaximumHausdorffDistanceForVolumeMm(hausdorff.get_hausdorff());
+    parameterNode->SetAverageHausdorffDistanceForVolumeMm(hausdorff.get_avg_average_hausdorff());
+    parameterNode->SetPercent95HausdorffDistanceForVolumeMm(hausdorff.get_percent_hausdorff());
+    parameterNode->SetSurfaceDice(-1.0);
   }
 
-  // Compute Hausdorff distances
-  double checkpointHausdorffStart = timer->GetUniversalTime();
-  UNUSED_VARIABLE(checkpointHausdorffStart); // Although it is used later, a warning is logged so needs to be suppressed
-  Hausdorff_distance hausdorff;
-  hausdorff.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
-  hausdorff.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
-  hausdorff.set_volume_boundary_behavior(ZERO_PADDING);
-  hausdorff.run();
-
-  double maximumHausdorffDistanceForBoundaryMm = hausdorff.get_boundary_hausdorff();
-  double averageHausdorffDistanceForBoundaryMm = hausdorff.get_avg_average_boundary_hausdorff();
-  double percent95HausdorffDistanceForBoundaryMm = hausdorff.get_percent_boundary_hausdorff();
-  parameterNode->SetMaximumHausdorffDistanceForVolumeMm(hausdorff.get_hausdorff());
   parameterNode->SetMaximumHausdorffDistanceForBoundaryMm(maximumHausdorffDistanceForBoundaryMm);
-  parameterNode->SetAverageHausdorffDistanceForVolumeMm(hausdorff.get_avg_average_hausdorff());
   parameterNode->SetAverageHausdorffDistanceForBoundaryMm(averageHausdorffDistanceForBoundaryMm);
-  parameterNode->SetPercent95HausdorffDistanceForVolumeMm(hausdorff.get_percent_hausdorff());
   parameterNode->SetPercent95HausdorffDistanceForBoundaryMm(percent95HausdorffDistanceForBoundaryMm);
   parameterNode->HausdorffResultsValidOn();
 
@@ -513,6 +814,10 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
     header->InsertNextValue("Maximum (mm)");
     header->InsertNextValue("Average (mm)");
     header->InsertNextValue("95% (mm)");
+    if (parameterNode->GetUseDistanceTransformHausdorff())
+    {
+      header->InsertNextValue("Surface Dice");
+    }
 
     vtkStringArray* column = vtkStringArray::SafeDownCast(tableNode->AddColumn());
     column->SetName("Metric value");
@@ -530,6 +835,10 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
     column->SetVariantValue(row++, vtkVariant(maximumHausdorffDistanceForBoundaryMm));
     column->SetVariantValue(row++, vtkVariant(averageHausdorffDistanceForBoundaryMm));
     column->SetVariantValue(row++, vtkVariant(percent95HausdorffDistanceForBoundaryMm));
+    if (parameterNode->GetUseDistanceTransformHausdorff())
+    {
+      column->SetVariantValue(row++, vtkVariant(parameterNode->GetSurfaceDice()));
+    }
 
     // Trigger UI update
     tableNode->Modified();
@@ -547,3 +856,248 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
 
   return "";
 }
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogic::ComputeOverlapMatrix(vtkMRMLSegmentComparisonNode* parameterNode)
+{
+  if (!parameterNode || !this->GetMRMLScene())
+  {
+    std::string errorMessage("Invalid MRML scene or parameter set node");
+    vtkErrorMacro("ComputeOverlapMatrix: " << errorMessage);
+    return errorMessage;
+  }
+  vtkMRMLSegmentationNode* referenceSegmentationNode = parameterNode->GetReferenceSegmentationNode();
+  vtkMRMLSegmentationNode* compareSegmentationNode = parameterNode->GetCompareSegmentationNode();
+  if (!referenceSegmentationNode || !compareSegmentationNode)
+  {
+    std::string errorMessage("Invalid input segmentation selection");
+    vtkErrorMacro("ComputeOverlapMatrix: " << errorMessage);
+    return errorMessage;
+  }
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double checkpointStart = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
+
+  // Get labelmaps of all segments. Apply parent transformation nodes if necessary
+  bool applyParentTransforms = ( referenceSegmentationNode != compareSegmentationNode
+    && referenceSegmentationNode->GetParentTransformNode() != compareSegmentationNode->GetParentTransformNode() );
+  std::vector<std::string> referenceSegmentIDs;
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > referenceLabelmaps;
+  std::string errorMessage = this->LogicPrivate->GetAllSegmentLabelmaps(
+    referenceSegmentationNode, applyParentTransforms, referenceSegmentIDs, referenceLabelmaps);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+  std::vector<std::string> compareSegmentIDs;
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > compareLabelmaps;
+  errorMessage = this->LogicPrivate->GetAllSegmentLabelmaps(
+    compareSegmentationNode, applyParentTransforms, compareSegmentIDs, compareLabelmaps);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+  if (referenceLabelmaps.empty() || compareLabelmaps.empty())
+  {
+    errorMessage = "Both reference and compare segmentations need to contain segments";
+    vtkErrorMacro("ComputeOverlapMatrix: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Determine common geometry: rasterization reference volume if selected, otherwise the reference segmentation labelmap geometry
+  vtkSmartPointer<vtkOrientedImageData> commonGeometry;
+  if (parameterNode->GetRasterizationReferenceVolumeNode())
+  {
+    commonGeometry = vtkSmartPointer<vtkOrientedImageData>::Take(
+      vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(parameterNode->GetRasterizationReferenceVolumeNode()) );
+  }
+  else
+  {
+    commonGeometry = referenceLabelmaps[0];
+  }
+  if (!commonGeometry.GetPointer())
+  {
+    errorMessage = "Failed to determine common geometry";
+    vtkErrorMacro("ComputeOverlapMatrix: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Resample labelmaps to the common lattice (each keeping its own extent), and compute the union extent
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > allLabelmaps(referenceLabelmaps);
+  allLabelmaps.insert(allLabelmaps.end(), compareLabelmaps.begin(), compareLabelmaps.end());
+  int commonExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  for (std::vector<vtkSmartPointer<vtkOrientedImageData> >::iterator labelmapIt = allLabelmaps.begin(); labelmapIt != allLabelmaps.end(); ++labelmapIt)
+  {
+    if (!vtkOrientedImageDataResample::DoGeometriesMatch(commonGeometry, *labelmapIt))
+    {
+      vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        *labelmapIt, commonGeometry, resampledLabelmap, false, true ) )
+      {
+        errorMessage = "Failed to resample segment labelmap to common geometry";
+        vtkErrorMacro("ComputeOverlapMatrix: " << errorMessage);
+        return errorMessage;
+      }
+      (*labelmapIt) = resampledLabelmap;
+    }
+    int* labelmapExtent = (*labelmapIt)->GetExtent();
+    for (int axis=0; axis<3; ++axis)
+    {
+      commonExtent[2*axis] = std::min(commonExtent[2*axis], labelmapExtent[2*axis]);
+      commonExtent[2*axis+1] = std::max(commonExtent[2*axis+1], labelmapExtent[2*axis+1]);
+    }
+  }
+  vtkIdType dimensions[3] = { 0 };
+  for (int axis=0; axis<3; ++axis)
+  {
+    dimensions[axis] = commonExtent[2*axis+1] - commonExtent[2*axis] + 1;
+    if (dimensions[axis] <= 0)
+    {
+      errorMessage = "All segments are empty";
+      vtkErrorMacro("ComputeOverlapMatrix: " << errorMessage);
+      return errorMessage;
+    }
+  }
+  vtkIdType numberOfVoxels = dimensions[0] * dimensions[1] * dimensions[2];
+
+  // Voxels outside all segments but inside the common geometry are true negatives for specificity.
+  // The segment extents are included, in case the segments extend beyond the common geometry.
+  int* commonGeometryExtent = commonGeometry->GetExtent();
+  vtkIdType numberOfCommonGeometryVoxels = 1;
+  for (int axis=0; axis<3; ++axis)
+  {
+    numberOfCommonGeometryVoxels *= std::max(commonGeometryExtent[2*axis+1], commonExtent[2*axis+1])
+      - std::min(commonGeometryExtent[2*axis], commonExtent[2*axis]) + 1;
+  }
+
+  // Rasterize all segments into per-voxel segment bit masks
+  double checkpointSweepStart = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointSweepStart); // Although it is used later, a warning is logged so needs to be suppressed
+  int numberOfReferenceSegments = static_cast<int>(referenceLabelmaps.size());
+  int numberOfCompareSegments = static_cast<int>(compareLabelmaps.size());
+  int numberOfReferenceWords = (numberOfReferenceSegments + SEGMENTS_PER_WORD - 1) / SEGMENTS_PER_WORD;
+  int numberOfCompareWords = (numberOfCompareSegments + SEGMENTS_PER_WORD - 1) / SEGMENTS_PER_WORD;
+  std::vector<vtkTypeUInt64> referenceSegmentBits(numberOfVoxels * numberOfReferenceWords, 0);
+  std::vector<vtkTypeUInt64> compareSegmentBits(numberOfVoxels * numberOfCompareWords, 0);
+  for (int segmentIndex=0; segmentIndex<numberOfReferenceSegments+numberOfCompareSegments; ++segmentIndex)
+  {
+    bool isReference = (segmentIndex < numberOfReferenceSegments);
+    vtkOrientedImageData* labelmap = allLabelmaps[segmentIndex];
+    switch (labelmap->GetScalarType())
+    {
+      vtkTemplateMacro( SetSegmentBitsFromLabelmap(labelmap, static_cast<VTK_TT*>(nullptr), commonExtent,
+        (isReference ? numberOfReferenceWords : numberOfCompareWords),
+        (isReference ? segmentIndex : segmentIndex - numberOfReferenceSegments),
+        (isReference ? referenceSegmentBits : compareSegmentBits) ) );
+    default:
+      errorMessage = "Unknown scalar type in segment labelmap";
+      vtkErrorMacro("ComputeOverlapMatrix: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
+  // Accumulate contingency matrix in a single sweep
+  OverlapMatrixFunctor overlapFunctor;
+  overlapFunctor.ReferenceSegmentBits = referenceSegmentBits.data();
+  overlapFunctor.CompareSegmentBits = compareSegmentBits.data();
+  overlapFunctor.NumberOfReferenceWords = numberOfReferenceWords;
+  overlapFunctor.NumberOfCompareWords = numberOfCompareWords;
+  overlapFunctor.NumberOfReferenceSegments = numberOfReferenceSegments;
+  overlapFunctor.NumberOfCompareSegments = numberOfCompareSegments;
+  for (int axis=0; axis<3; ++axis)
+  {
+    overlapFunctor.Dimensions[axis] = dimensions[axis];
+  }
+  vtkSMPTools::For(0, dimensions[2], overlapFunctor);
+  const OverlapCounts& counts = overlapFunctor.Counts;
+
+  // Compute metrics and write them to the output table
+  vtkMRMLTableNode* tableNode = parameterNode->GetOverlapMatrixTableNode();
+  if (!tableNode)
+  {
+    vtkSmartPointer<vtkMRMLTableNode> newTableNode = vtkSmartPointer<vtkMRMLTableNode>::New();
+    std::string tableNodeName = this->GetMRMLScene()->GenerateUniqueName("OverlapMatrix");
+    newTableNode->SetName(tableNodeName.c_str());
+    this->GetMRMLScene()->AddNode(newTableNode);
+    parameterNode->SetAndObserveOverlapMatrixTableNode(newTableNode);
+    tableNode = newTableNode;
+  }
+  tableNode->SetUseColumnNameAsColumnHeader(true);
+  tableNode->RemoveAllColumns();
+  vtkStringArray* referenceSegmentColumn = vtkStringArray::SafeDownCast(tableNode->AddColumn());
+  referenceSegmentColumn->SetName("Reference segment");
+  vtkStringArray* compareSegmentColumn = vtkStringArray::SafeDownCast(tableNode->AddColumn());
+  compareSegmentColumn->SetName("Compare segment");
+  const char* metricColumnNames[] = { "Dice coefficient", "Jaccard index", "Sensitivity", "Specificity",
+    "Reference volume (cc)", "Compare volume (cc)", "Centroid distance (mm)" };
+  const int numberOfMetricColumns = sizeof(metricColumnNames) / sizeof(metricColumnNames[0]);
+  std::vector<vtkDoubleArray*> metricColumns;
+  for (int metricIndex=0; metricIndex<numberOfMetricColumns; ++metricIndex)
+  {
+    vtkSmartPointer<vtkDoubleArray> metricColumn = vtkSmartPointer<vtkDoubleArray>::New();
+    metricColumn->SetName(metricColumnNames[metricIndex]);
+    tableNode->AddColumn(metricColumn);
+    metricColumns.push_back(metricColumn);
+  }
+
+  double* spacing = commonGeometry->GetSpacing();
+  double voxelVolumeCc = spacing[0] * spacing[1] * spacing[2] / 1000.0;
+  vtkSmartPointer<vtkMatrix4x4> ijkToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  commonGeometry->GetImageToWorldMatrix(ijkToWorldMatrix);
+  for (int referenceIndex=0; referenceIndex<numberOfReferenceSegments; ++referenceIndex)
+  {
+    vtkIdType referenceCount = counts.ReferenceVoxelCounts[referenceIndex];
+    double referenceCentroid[4] = { 0.0, 0.0, 0.0, 1.0 };
+    for (int axis=0; axis<3; ++axis)
+    {
+      referenceCentroid[axis] = commonExtent[2*axis]
+        + (referenceCount > 0 ? counts.ReferenceIjkSums[3*referenceIndex+axis] / referenceCount : 0.0);
+    }
+    ijkToWorldMatrix->MultiplyPoint(referenceCentroid, referenceCentroid);
+    vtkSegment* referenceSegment = referenceSegmentationNode->GetSegmentation()->GetSegment(referenceSegmentIDs[referenceIndex]);
+
+    for (int compareIndex=0; compareIndex<numberOfCompareSegments; ++compareIndex)
+    {
+      vtkIdType compareCount = counts.CompareVoxelCounts[compareIndex];
+      double compareCentroid[4] = { 0.0, 0.0, 0.0, 1.0 };
+      for (int axis=0; axis<3; ++axis)
+      {
+        compareCentroid[axis] = commonExtent[2*axis]
+          + (compareCount > 0 ? counts.CompareIjkSums[3*compareIndex+axis] / compareCount : 0.0);
+      }
+      ijkToWorldMatrix->MultiplyPoint(compareCentroid, compareCentroid);
+      vtkSegment* compareSegment = compareSegmentationNode->GetSegmentation()->GetSegment(compareSegmentIDs[compareIndex]);
+
+      double intersection = (double)counts.Intersections[referenceIndex*numberOfCompareSegments + compareIndex];
+      double sumOfVolumes = (double)(referenceCount + compareCount);
+      double trueNegatives = (double)numberOfCommonGeometryVoxels - (sumOfVolumes - intersection);
+      double falsePositives = (double)compareCount - intersection;
+
+      referenceSegmentColumn->InsertNextValue(referenceSegment ? referenceSegment->GetName() : referenceSegmentIDs[referenceIndex].c_str());
+      compareSegmentColumn->InsertNextValue(compareSegment ? compareSegment->GetName() : compareSegmentIDs[compareIndex].c_str());
+      metricColumns[0]->InsertNextValue(sumOfVolumes > 0 ? 2.0 * intersection / sumOfVolumes : 0.0);
+      metricColumns[1]->InsertNextValue(sumOfVolumes - intersection > 0 ? intersection / (sumOfVolumes - intersection) : 0.0);
+      metricColumns[2]->InsertNextValue(referenceCount > 0 ? intersection / referenceCount : 0.0);
+      metricColumns[3]->InsertNextValue(trueNegatives + falsePositives > 0 ? trueNegatives / (trueNegatives + falsePositives) : 0.0);
+      metricColumns[4]->InsertNextValue(referenceCount * voxelVolumeCc);
+      metricColumns[5]->InsertNextValue(compareCount * voxelVolumeCc);
+      metricColumns[6]->InsertNextValue( (referenceCount > 0 && compareCount > 0)
+        ? sqrt(vtkMath::Distance2BetweenPoints(referenceCentroid, compareCentroid)) : -1.0 );
+    }
+  }
+
+  // Trigger UI update
+  tableNode->Modified();
+
+  if (this->LogSpeedMeasurements)
+  {
+    double checkpointEnd = timer->GetUniversalTime();
+    UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
+    vtkDebugMacro("ComputeOverlapMatrix: Total overlap matrix computation time: " << checkpointEnd-checkpointStart << " s\n"
+      << "\tGetting and resampling labelmaps: " << checkpointSweepStart-checkpointStart << " s\n"
+      << "\tRasterization and overlap sweep: " << checkpointEnd-checkpointSweepStart << " s");
+  }
+
+  return "";
+}
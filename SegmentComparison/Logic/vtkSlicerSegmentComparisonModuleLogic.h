@@ -53,6 +53,16 @@ public:
   /// \return Error message, empty string if no error
   std::string ComputeHausdorffDistances(vtkMRMLSegmentComparisonNode* parameterNode);
 
+  /// Compute overlap metrics (Dice, Jaccard, sensitivity, specificity, volumes, centroid distance)
+  /// for every pair of segments in the selected reference and compare segmentations.
+  /// Specificity counts the voxels of the common geometry outside both segments as true negatives.
+  /// All segments are rasterized once onto a common geometry (the rasterization reference volume
+  /// if selected, otherwise the geometry of the reference segmentation), then the full
+  /// intersection matrix is accumulated in a single multi-threaded sweep over the voxels.
+  /// Results are written into the overlap matrix table node of the parameter node, one row per pair.
+  /// \return Error message, empty string if no error
+  std::string ComputeOverlapMatrix(vtkMRMLSegmentComparisonNode* parameterNode);
+
 public:
   vtkGetMacro(LogSpeedMeasurements, bool);
   vtkSetMacro(LogSpeedMeasurements, bool);
@@ -15,6 +15,11 @@
 #include <vtkTable.h>
 #include <vtkVariantArray.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 //-----------------------------------------------------------------------------
 int vtkPolyDataDistanceHistogramFilterTest( int argc, char* argv[] )
 {
@@ -117,5 +122,64 @@ int vtkPolyDataDistanceHistogramFilterTest( int argc, char* argv[] )
   histogramWriter->SetFileName( histogramFilename );
   histogramWriter->Write();
 
+  // Check percentiles against percentiles computed independently from the sorted raw distances.
+  // Repeat with a shifted compare sphere to make sure the cached sorted distances are refreshed on Update.
+  std::vector<double> percentiles;
+  percentiles.push_back(0.0);
+  percentiles.push_back(50.0);
+  percentiles.push_back(90.0);
+  percentiles.push_back(95.0);
+  percentiles.push_back(99.0);
+  percentiles.push_back(100.0);
+  for (int pass=0; pass<2; ++pass)
+  {
+    if (pass == 1)
+    {
+      sphereSource2->SetCenter( 0.0, 0.25, 0.0 );
+      sphereSource2->Update();
+      polyDataDistanceHistogramFilter->SetInputComparePolyData( sphereSource2->GetOutput() );
+      polyDataDistanceHistogramFilter->Update();
+    }
+
+    vtkDoubleArray* distances = polyDataDistanceHistogramFilter->GetOutputDistances();
+    std::vector<double> expectedSortedDistances;
+    for (vtkIdType distanceIndex=0; distanceIndex<distances->GetNumberOfTuples(); ++distanceIndex)
+    {
+      expectedSortedDistances.push_back(distances->GetValue(distanceIndex));
+    }
+    if (expectedSortedDistances.size() < 100)
+    {
+      errorStream << "Too few distance samples (" << expectedSortedDistances.size() << ") for percentile check." << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::sort(expectedSortedDistances.begin(), expectedSortedDistances.end());
+
+    std::vector<double> percentileDistances;
+    if (!polyDataDistanceHistogramFilter->GetNthPercentileHausdorffDistances(percentiles, percentileDistances)
+      || percentileDistances.size() != percentiles.size())
+    {
+      errorStream << "Failed to get percentile distances." << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (size_t percentileIndex=0; percentileIndex<percentiles.size(); ++percentileIndex)
+    {
+      size_t expectedIndex = static_cast<size_t>( floor(percentiles[percentileIndex] / 100.0 * (expectedSortedDistances.size() - 1) + 0.5) );
+      double expectedDistance = expectedSortedDistances[expectedIndex];
+      if (percentileDistances[percentileIndex] != expectedDistance)
+      {
+        errorStream << "Percentile " << percentiles[percentileIndex] << " mismatch in pass " << pass << ": "
+          << percentileDistances[percentileIndex] << " instead of " << expectedDistance << std::endl;
+        return EXIT_FAILURE;
+      }
+      double singlePercentileDistance = polyDataDistanceHistogramFilter->GetNthPercentileHausdorffDistance(percentiles[percentileIndex]);
+      if (singlePercentileDistance != expectedDistance)
+      {
+        errorStream << "Single percentile " << percentiles[percentileIndex] << " mismatch in pass " << pass << ": "
+          << singlePercentileDistance << " instead of " << expectedDistance << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
   return EXIT_SUCCESS;
 }
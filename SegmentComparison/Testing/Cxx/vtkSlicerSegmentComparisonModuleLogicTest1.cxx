@@ -32,15 +32,19 @@
 
 // SegmentationCore includes
 #include "vtkSegmentationConverterFactory.h"
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
 
 // MRML includes
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLTableNode.h>
 #include <vtkMRMLScene.h>
 
 // VTK includes
 #include <vtkNew.h>
 #include <vtkImageData.h>
+#include <vtkTable.h>
 
 // ITK includes
 #include "itkFactoryRegistration.h"
@@ -48,6 +52,9 @@
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <cmath>
+
 bool CheckIfResultIsWithinOneTenthPercentFromBaseline(double result, double baseline);
 
 //-----------------------------------------------------------------------------
@@ -449,6 +456,88 @@ int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
     result = EXIT_FAILURE;
   }
 
+  // Compute overlap matrix of all segment pairs
+  std::string errorMessageOverlapMatrix = segmentComparisonLogic->ComputeOverlapMatrix(paramNode);
+  vtkMRMLTableNode* overlapMatrixTableNode = paramNode->GetOverlapMatrixTableNode();
+  if (!errorMessageOverlapMatrix.empty() || !overlapMatrixTableNode || overlapMatrixTableNode->GetNumberOfRows() != 1)
+  {
+    std::cerr << "Failed to compute overlap matrix!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double resultOverlapMatrixDice = overlapMatrixTableNode->GetTable()->GetValueByName(0, "Dice coefficient").ToDouble();
+  if (resultOverlapMatrixDice < 0.0 || resultOverlapMatrixDice > 1.0
+    || (diceCoefficient == 1.0 && !CheckIfResultIsWithinOneTenthPercentFromBaseline(resultOverlapMatrixDice, 1.0)))
+  {
+    std::cerr << "Overlap matrix Dice coefficient mismatch: " << resultOverlapMatrixDice << " (Dice baseline " << diceCoefficient << ")" << std::endl;
+    result = EXIT_FAILURE;
+  }
+
+  // Compute Hausdorff distances using distance transforms of the segment labelmaps
+  paramNode->UseDistanceTransformHausdorffOn();
+  std::string errorMessageDistanceTransformHausdorff = segmentComparisonLogic->ComputeHausdorffDistances(paramNode);
+  if (!paramNode->GetHausdorffResultsValid())
+  {
+    std::cerr << "Failed to compute distance transform Hausdorff results!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double resultSurfaceDice = paramNode->GetSurfaceDice();
+  if (resultSurfaceDice < 0.0 || resultSurfaceDice > 1.0)
+  {
+    std::cerr << "Invalid surface Dice: " << resultSurfaceDice << std::endl;
+    result = EXIT_FAILURE;
+  }
+
+  // Distance transform results must match the Plastimatch results computed above within one voxel,
+  // as the two methods only differ in how distances between boundary voxels are discretized
+  vtkOrientedImageData* referenceLabelmap = vtkOrientedImageData::SafeDownCast(
+    referenceSegmentationNode->GetSegmentation()->GetSegment(referenceSegmentID)->GetRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
+  if (!referenceLabelmap)
+  {
+    std::cerr << "Failed to get reference segment labelmap!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double* referenceSpacing = referenceLabelmap->GetSpacing();
+  double voxelSizeToleranceMm = sqrt( referenceSpacing[0]*referenceSpacing[0]
+    + referenceSpacing[1]*referenceSpacing[1] + referenceSpacing[2]*referenceSpacing[2] );
+
+  double resultDistanceTransformHausdorffMaximumMm = paramNode->GetMaximumHausdorffDistanceForBoundaryMm();
+  if (fabs(resultDistanceTransformHausdorffMaximumMm - resultHausdorffMaximumMm) > voxelSizeToleranceMm)
+  {
+    std::cerr << "Distance transform Hausdorff maximum (mm) mismatch: " << resultDistanceTransformHausdorffMaximumMm
+      << " instead of " << resultHausdorffMaximumMm << " (tolerance " << voxelSizeToleranceMm << ")" << std::endl;
+    result = EXIT_FAILURE;
+  }
+  double resultDistanceTransformHausdorffAverageMm = paramNode->GetAverageHausdorffDistanceForBoundaryMm();
+  if (fabs(resultDistanceTransformHausdorffAverageMm - resultHausdorffAverageMm) > voxelSizeToleranceMm)
+  {
+    std::cerr << "Distance transform Hausdorff average (mm) mismatch: " << resultDistanceTransformHausdorffAverageMm
+      << " instead of " << resultHausdorffAverageMm << " (tolerance " << voxelSizeToleranceMm << ")" << std::endl;
+    result = EXIT_FAILURE;
+  }
+  double resultDistanceTransformHausdorff95PercentMm = paramNode->GetPercent95HausdorffDistanceForBoundaryMm();
+  if (fabs(resultDistanceTransformHausdorff95PercentMm - resultHausdorff95PercentMm) > voxelSizeToleranceMm)
+  {
+    std::cerr << "Distance transform Hausdorff 95% mismatch: " << resultDistanceTransformHausdorff95PercentMm
+      << " instead of " << resultHausdorff95PercentMm << " (tolerance " << voxelSizeToleranceMm << ")" << std::endl;
+    result = EXIT_FAILURE;
+  }
+
+  // Identical inputs must give zero distances and perfect surface overlap
+  if (hausdorffMaximumMm == 0.0)
+  {
+    if (!CheckIfResultIsWithinOneTenthPercentFromBaseline(resultDistanceTransformHausdorffMaximumMm, 0.0))
+    {
+      std::cerr << "Distance transform Hausdorff maximum (mm) mismatch: " << resultDistanceTransformHausdorffMaximumMm << " instead of 0" << std::endl;
+      result = EXIT_FAILURE;
+    }
+    if (!CheckIfResultIsWithinOneTenthPercentFromBaseline(resultSurfaceDice, 1.0))
+    {
+      std::cerr << "Surface Dice mismatch: " << resultSurfaceDice << " instead of 1" << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+
   return result;
 }
 
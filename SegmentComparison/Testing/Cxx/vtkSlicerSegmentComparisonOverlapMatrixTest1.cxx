@@ -0,0 +1,191 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SegmentComparison includes
+#include "vtkSlicerSegmentComparisonModuleLogic.h"
+#include "vtkMRMLSegmentComparisonNode.h"
+
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  /// Add a segment containing an axis-aligned box of voxels (inclusive IJK bounds) on a 20x20x20 1mm grid
+  void AddBoxSegment(vtkMRMLSegmentationNode* segmentationNode, const char* name,
+    int iMin, int iMax, int jMin, int jMax, int kMin, int kMax)
+  {
+    vtkNew<vtkOrientedImageData> labelmap;
+    labelmap->SetExtent(0, 19, 0, 19, 0, 19);
+    labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    labelmap->GetPointData()->GetScalars()->Fill(0);
+    for (int k=kMin; k<=kMax; ++k)
+    {
+      for (int j=jMin; j<=jMax; ++j)
+      {
+        for (int i=iMin; i<=iMax; ++i)
+        {
+          *static_cast<unsigned char*>(labelmap->GetScalarPointer(i, j, k)) = 1;
+        }
+      }
+    }
+
+    vtkNew<vtkSegment> segment;
+    segment->SetName(name);
+    segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap);
+    segmentationNode->GetSegmentation()->AddSegment(segment);
+  }
+
+  //---------------------------------------------------------------------------
+  bool CheckOverlapMatrixValue(vtkTable* table, int row, const char* columnName, double expectedValue)
+  {
+    double value = table->GetValueByName(row, columnName).ToDouble();
+    if (fabs(value - expectedValue) > 1e-6)
+    {
+      std::cerr << "Overlap matrix row " << row << " (" << table->GetValueByName(row, "Reference segment").ToString()
+        << " - " << table->GetValueByName(row, "Compare segment").ToString() << ") " << columnName
+        << " mismatch: " << value << " instead of " << expectedValue << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerSegmentComparisonOverlapMatrixTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+
+  // Reference: two adjacent 10mm cubes A (i 0-9) and B (i 10-19)
+  vtkNew<vtkMRMLSegmentationNode> referenceSegmentationNode;
+  mrmlScene->AddNode(referenceSegmentationNode);
+  referenceSegmentationNode->GetSegmentation()->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() );
+  AddBoxSegment(referenceSegmentationNode, "A", 0, 9, 0, 9, 0, 9);
+  AddBoxSegment(referenceSegmentationNode, "B", 10, 19, 0, 9, 0, 9);
+
+  // Compare: cube C straddling A and B (i 5-14) and slab D covering a quarter of A
+  vtkNew<vtkMRMLSegmentationNode> compareSegmentationNode;
+  mrmlScene->AddNode(compareSegmentationNode);
+  compareSegmentationNode->GetSegmentation()->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() );
+  AddBoxSegment(compareSegmentationNode, "C", 5, 14, 0, 9, 0, 9);
+  AddBoxSegment(compareSegmentationNode, "D", 0, 4, 0, 9, 0, 4);
+
+  vtkNew<vtkMRMLSegmentComparisonNode> paramNode;
+  mrmlScene->AddNode(paramNode);
+  paramNode->SetAndObserveReferenceSegmentationNode(referenceSegmentationNode);
+  paramNode->SetAndObserveCompareSegmentationNode(compareSegmentationNode);
+
+  vtkNew<vtkSlicerSegmentComparisonModuleLogic> segmentComparisonLogic;
+  segmentComparisonLogic->SetMRMLScene(mrmlScene);
+
+  std::string errorMessage = segmentComparisonLogic->ComputeOverlapMatrix(paramNode);
+  vtkMRMLTableNode* overlapMatrixTableNode = paramNode->GetOverlapMatrixTableNode();
+  if (!errorMessage.empty() || !overlapMatrixTableNode || overlapMatrixTableNode->GetNumberOfRows() != 4)
+  {
+    std::cerr << "Failed to compute overlap matrix: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkTable* table = overlapMatrixTableNode->GetTable();
+
+  // Rows are ordered by reference segment, then compare segment: A-C, A-D, B-C, B-D.
+  // Voxel counts: A=B=C=1000, D=250. Intersections: A-C=500, A-D=250, B-C=500, B-D=0.
+  // The common geometry is the 8000 voxel grid of the reference, so true negatives are 8000 minus the union.
+  bool success = true;
+  success &= CheckOverlapMatrixValue(table, 0, "Dice coefficient", 0.5);
+  success &= CheckOverlapMatrixValue(table, 0, "Jaccard index", 1.0/3.0);
+  success &= CheckOverlapMatrixValue(table, 0, "Sensitivity", 0.5);
+  success &= CheckOverlapMatrixValue(table, 0, "Specificity", 6500.0/7000.0);
+  success &= CheckOverlapMatrixValue(table, 0, "Reference volume (cc)", 1.0);
+  success &= CheckOverlapMatrixValue(table, 0, "Compare volume (cc)", 1.0);
+  success &= CheckOverlapMatrixValue(table, 0, "Centroid distance (mm)", 5.0);
+
+  success &= CheckOverlapMatrixValue(table, 1, "Dice coefficient", 0.4);
+  success &= CheckOverlapMatrixValue(table, 1, "Jaccard index", 0.25);
+  success &= CheckOverlapMatrixValue(table, 1, "Sensitivity", 0.25);
+  success &= CheckOverlapMatrixValue(table, 1, "Specificity", 1.0);
+  success &= CheckOverlapMatrixValue(table, 1, "Compare volume (cc)", 0.25);
+  success &= CheckOverlapMatrixValue(table, 1, "Centroid distance (mm)", sqrt(2.0 * 2.5 * 2.5));
+
+  success &= CheckOverlapMatrixValue(table, 2, "Dice coefficient", 0.5);
+  success &= CheckOverlapMatrixValue(table, 2, "Jaccard index", 1.0/3.0);
+  success &= CheckOverlapMatrixValue(table, 2, "Sensitivity", 0.5);
+  success &= CheckOverlapMatrixValue(table, 2, "Specificity", 6500.0/7000.0);
+  success &= CheckOverlapMatrixValue(table, 2, "Centroid distance (mm)", 5.0);
+
+  success &= CheckOverlapMatrixValue(table, 3, "Dice coefficient", 0.0);
+  success &= CheckOverlapMatrixValue(table, 3, "Jaccard index", 0.0);
+  success &= CheckOverlapMatrixValue(table, 3, "Sensitivity", 0.0);
+  success &= CheckOverlapMatrixValue(table, 3, "Specificity", 6750.0/7000.0);
+  success &= CheckOverlapMatrixValue(table, 3, "Centroid distance (mm)", sqrt(12.5*12.5 + 2.5*2.5));
+  if (!success)
+  {
+    return EXIT_FAILURE;
+  }
+
+  // More segments than fit in one word of the per-voxel segment masks.
+  // Each extra compare segment is a 125 voxel corner of B.
+  const int numberOfCompareSegments = 70;
+  for (int segmentIndex=2; segmentIndex<numberOfCompareSegments; ++segmentIndex)
+  {
+    std::stringstream segmentName;
+    segmentName << "Extra_" << segmentIndex;
+    AddBoxSegment(compareSegmentationNode, segmentName.str().c_str(), 15, 19, 0, 4, 0, 4);
+  }
+  errorMessage = segmentComparisonLogic->ComputeOverlapMatrix(paramNode);
+  if (!errorMessage.empty() || overlapMatrixTableNode->GetNumberOfRows() != 2 * numberOfCompareSegments)
+  {
+    std::cerr << "Failed to compute overlap matrix with " << numberOfCompareSegments << " compare segments: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Rows are A-C, A-D, A-Extra_2, ..., B-C, B-D, B-Extra_2, ...
+  success &= CheckOverlapMatrixValue(table, 0, "Dice coefficient", 0.5);
+  success &= CheckOverlapMatrixValue(table, numberOfCompareSegments + 1, "Dice coefficient", 0.0);
+  success &= CheckOverlapMatrixValue(table, numberOfCompareSegments - 1, "Dice coefficient", 0.0);
+  success &= CheckOverlapMatrixValue(table, numberOfCompareSegments - 1, "Specificity", 6875.0/7000.0);
+  success &= CheckOverlapMatrixValue(table, 2 * numberOfCompareSegments - 1, "Dice coefficient", 250.0/1125.0);
+  success &= CheckOverlapMatrixValue(table, 2 * numberOfCompareSegments - 1, "Sensitivity", 0.125);
+  success &= CheckOverlapMatrixValue(table, 2 * numberOfCompareSegments - 1, "Specificity", 1.0);
+  if (!success)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}